@@ -1,13 +1,29 @@
 #version 410 core
 
 uniform mat4 model;
+uniform mat4 model_normal;
 uniform mat4 view;
 uniform mat4 projection;
 
-#define MAXIMUM_NUMBER_OF_MODEL_NODES 253
+#define MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES 256
+#define NUMBER_OF_NODE_PALETTE_ROWS 3
 #define MAXIMUM_NODE_INFLUENCE 4
 
-uniform mat4 node_matrices[MAXIMUM_NUMBER_OF_MODEL_NODES];
+#define NODE_PALETTE_MODE_NONE 0
+#define NODE_PALETTE_MODE_UNIFORM_BUFFER 1
+#define NODE_PALETTE_MODE_TEXTURE_BUFFER 2
+
+// The top three rows of each node's affine transform
+layout(std140) uniform node_palette
+{
+    vec4 node_palette_rows[MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES * NUMBER_OF_NODE_PALETTE_ROWS];
+};
+
+// The same rows, for palettes too large for the uniform block
+uniform samplerBuffer node_palette_texture;
+uniform int node_palette_texel_offset;
+
+uniform int node_palette_mode;
 
 in vec3 position;
 in vec3 normal;
@@ -23,30 +39,55 @@ out vec2 frag_texcoord;
 out mat3 frag_tbn;
 out mat3 frag_view_tbn;
 
+vec4 get_node_palette_row(int node_index, int row_index)
+{
+    int row_offset = node_index * NUMBER_OF_NODE_PALETTE_ROWS + row_index;
+
+    if (node_palette_mode == NODE_PALETTE_MODE_TEXTURE_BUFFER)
+        return texelFetch(node_palette_texture, node_palette_texel_offset + row_offset);
+
+    return node_palette_rows[row_offset];
+}
+
 void main()
 {
-    mat4 transform = mat4(0.0);
+    mat4 transform = mat4(1.0);
+    mat3 skin_normal_matrix = mat3(1.0);
 
-    transform += node_matrices[node_indices[0]] * node_weights[0];
-    transform += node_matrices[node_indices[1]] * node_weights[1];
-    transform += node_matrices[node_indices[2]] * node_weights[2];
-    transform += node_matrices[node_indices[3]] * node_weights[3];
-    
-    if (transform == mat4(0.0))
-        transform = mat4(1.0);
+    if (node_palette_mode != NODE_PALETTE_MODE_NONE)
+    {
+        vec4 rows[NUMBER_OF_NODE_PALETTE_ROWS] = vec4[](vec4(0.0), vec4(0.0), vec4(0.0));
+
+        for (int influence_index = 0; influence_index < MAXIMUM_NODE_INFLUENCE; influence_index++)
+        {
+            if (node_indices[influence_index] < 0 || node_weights[influence_index] == 0.0)
+                continue;
+
+            for (int row_index = 0; row_index < NUMBER_OF_NODE_PALETTE_ROWS; row_index++)
+                rows[row_index] += get_node_palette_row(node_indices[influence_index], row_index) * node_weights[influence_index];
+        }
+
+        if (rows[0] != vec4(0.0) || rows[1] != vec4(0.0) || rows[2] != vec4(0.0))
+        {
+            transform = transpose(mat4(rows[0], rows[1], rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+            skin_normal_matrix = transpose(inverse(mat3(transform)));
+        }
+    }
 
     frag_position = vec3(model * transform * vec4(position, 1.0));
     frag_normal = normal;
     frag_texcoord = texcoord;
     
-    mat3 normal_matrix = transpose(inverse(mat3(model * transform)));
+    // model_normal is already the inverse-transpose of model, so only a skinned vertex needs an inverse here
+    mat3 normal_matrix = mat3(model_normal) * skin_normal_matrix;
 
     frag_tbn = mat3(
         normalize(normal_matrix * tangent),
         normalize(normal_matrix * bitangent),
         normalize(normal_matrix * normal));
 
-    mat3 view_normal_matrix = transpose(inverse(mat3(view * model * transform)));    
+    // The view matrix only rotates and translates, so it is its own inverse-transpose
+    mat3 view_normal_matrix = mat3(view) * normal_matrix;
     vec3 T = normalize(view_normal_matrix * tangent);
     vec3 N = normalize(view_normal_matrix * normal);
     T = normalize(T - dot(T, N) * N);
@@ -0,0 +1,78 @@
+#version 410 core
+
+#define MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES 256
+#define NUMBER_OF_NODE_PALETTE_ROWS 3
+#define MAXIMUM_NODE_INFLUENCE 4
+
+#define NODE_PALETTE_MODE_NONE 0
+#define NODE_PALETTE_MODE_UNIFORM_BUFFER 1
+#define NODE_PALETTE_MODE_TEXTURE_BUFFER 2
+
+// The top three rows of each node's affine transform
+layout(std140) uniform node_palette
+{
+    vec4 node_palette_rows[MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES * NUMBER_OF_NODE_PALETTE_ROWS];
+};
+
+// The same rows, for palettes too large for the uniform block
+uniform samplerBuffer node_palette_texture;
+uniform int node_palette_texel_offset;
+
+uniform int node_palette_mode;
+
+in vec3 position;
+in vec3 normal;
+in vec2 texcoord;
+in vec3 tangent;
+in vec3 bitangent;
+in ivec4 node_indices;
+in vec4 node_weights;
+
+// Captured in the layout of a rigid vertex
+out vec3 skinned_position;
+out vec3 skinned_normal;
+out vec2 skinned_texcoord;
+out vec3 skinned_tangent;
+out vec3 skinned_bitangent;
+
+vec4 get_node_palette_row(int node_index, int row_index)
+{
+    int row_offset = node_index * NUMBER_OF_NODE_PALETTE_ROWS + row_index;
+
+    if (node_palette_mode == NODE_PALETTE_MODE_TEXTURE_BUFFER)
+        return texelFetch(node_palette_texture, node_palette_texel_offset + row_offset);
+
+    return node_palette_rows[row_offset];
+}
+
+void main()
+{
+    mat4 transform = mat4(1.0);
+
+    if (node_palette_mode != NODE_PALETTE_MODE_NONE)
+    {
+        vec4 rows[NUMBER_OF_NODE_PALETTE_ROWS] = vec4[](vec4(0.0), vec4(0.0), vec4(0.0));
+
+        for (int influence_index = 0; influence_index < MAXIMUM_NODE_INFLUENCE; influence_index++)
+        {
+            if (node_indices[influence_index] < 0 || node_weights[influence_index] == 0.0)
+                continue;
+
+            for (int row_index = 0; row_index < NUMBER_OF_NODE_PALETTE_ROWS; row_index++)
+                rows[row_index] += get_node_palette_row(node_indices[influence_index], row_index) * node_weights[influence_index];
+        }
+
+        if (rows[0] != vec4(0.0) || rows[1] != vec4(0.0) || rows[2] != vec4(0.0))
+            transform = transpose(mat4(rows[0], rows[1], rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+    }
+
+    mat3 normal_matrix = transpose(inverse(mat3(transform)));
+
+    skinned_position = vec3(transform * vec4(position, 1.0));
+    skinned_texcoord = texcoord;
+
+    // Left unnormalized like the source vertices; model.vs normalizes after its own transform
+    skinned_normal = normal_matrix * normal;
+    skinned_tangent = normal_matrix * tangent;
+    skinned_bitangent = normal_matrix * bitangent;
+}
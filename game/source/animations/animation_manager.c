@@ -4,33 +4,103 @@ ANIMATION_MANAGER.C
 */
 
 #include <assert.h>
+#include <stdalign.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <GL/glew.h>
+
 #include "common/common.h"
+#include "memory/heap.h"
+#include "profiler/profiler.h"
 #include "models/models.h"
+#include "animations/animation_baking.h"
 #include "animations/animation_data.h"
 #include "animations/animation_manager.h"
 
+/* ---------- private constants */
+
+enum
+{
+    // Forces an evaluation on the next update
+    ANIMATION_MANAGER_EVALUATE_NEXT_UPDATE = 1 << 20,
+};
+
+/* ---------- private types */
+
+struct animation_lod_definition
+{
+    // The smallest projected screen size, as a fraction of the viewport height, the level of detail is used at
+    float minimum_screen_size;
+
+    // The number of updates between evaluations
+    int update_interval;
+
+    // Nodes with fewer levels of descendants than this, such as finger tips and face bones, keep their default state
+    int minimum_node_height;
+};
+
+/* ---------- private variables */
+
+static const struct animation_lod_definition animation_lod_definitions[NUMBER_OF_ANIMATION_LODS] =
+{
+    [_animation_lod_full] = { 0.25f, 1, 0 },
+    [_animation_lod_reduced] = { 0.08f, 2, 1 },
+    [_animation_lod_minimal] = { 0.0f, 4, 2 },
+};
+
 /* ---------- private prototypes */
 
+static int animation_manager_get_next_active_animation(
+    struct animation_manager *manager,
+    struct model_data *model,
+    int animation_index);
+
+static void animation_manager_allocate_node_states(
+    struct model_data *model,
+    struct animation_state *state);
+
+static void animation_manager_free_node_states(
+    struct model_data *model,
+    struct animation_state *state);
+
+static void animation_manager_build_lod_node_masks(
+    struct model_data *model);
+
 static void animation_manager_update_animation(
     struct animation_manager *manager,
     struct model_data *model,
     int animation_index,
-    float delta_ticks);
+    float delta_ticks,
+    bool evaluate);
 
 static void animation_manager_compute_node_orientations(
+    struct animation_manager *manager,
     struct model_data *model,
     struct animation_data *animation,
-    struct animation_state *state);
+    struct animation_state *state,
+    float time);
+
+static void animation_manager_initialize_morph_states(
+    struct animation_manager *manager,
+    struct model_data *model);
+
+static void animation_manager_evaluate_morphs(
+    struct animation_manager *manager,
+    struct model_data *model);
+
+static void animation_manager_build_pose_cache_key(
+    struct animation_manager *manager,
+    struct model_data *model);
+
+static void animation_manager_evaluate_pose(
+    struct animation_manager *manager,
+    struct model_data *model);
 
 static void animation_manager_compute_node_matrices(
     struct animation_manager *manager,
-    struct model_data *model,
-    int node_index,
-    mat4 transform);
+    struct model_data *model);
 
 /* ---------- public code */
 
@@ -41,6 +111,8 @@ void animation_manager_initialize(
     assert(manager);
     memset(manager, 0, sizeof(*manager));
 
+    manager->model_index = -1;
+
     struct model_data *model = model_get_data(model_index);
     
     if (!model)
@@ -49,9 +121,33 @@ void animation_manager_initialize(
     }
 
     manager->model_index = model_index;
-    assert(manager->active_animations_bit_vector = calloc(BIT_VECTOR_LENGTH_IN_WORDS(model->animation_count), sizeof(unsigned int)));
-    assert(manager->states = calloc(model->animation_count, sizeof(*manager->states)));
-    assert(manager->node_matrices = calloc(model->node_count, sizeof(*manager->node_matrices)));
+    assert(manager->active_animations_bit_vector = heap_allocate_zeroed(BIT_VECTOR_LENGTH_IN_WORDS(model->animation_count), sizeof(unsigned int)));
+    assert(manager->states = heap_allocate_zeroed(model->animation_count, sizeof(*manager->states)));
+    assert(manager->blend_layers = heap_allocate_zeroed(model->animation_count, sizeof(*manager->blend_layers)));
+    assert(manager->node_transforms = heap_allocate_zeroed(model->node_count, sizeof(*manager->node_transforms)));
+    assert(manager->node_matrices = heap_allocate_zeroed(model->node_count, sizeof(*manager->node_matrices)));
+
+    animation_pose_buffer_initialize(&manager->blended_pose, model->node_count, NULL);
+    animation_pose_buffer_initialize(&manager->previous_pose, model->node_count, NULL);
+    animation_pose_buffer_initialize(&manager->evaluated_pose, model->node_count, NULL);
+
+    manager->lod = _animation_lod_full;
+    manager->updates_since_evaluation = ANIMATION_MANAGER_EVALUATE_NEXT_UPDATE;
+
+    if (model->node_count && !model->animation_lod_node_masks[0])
+        animation_manager_build_lod_node_masks(model);
+
+    animation_manager_initialize_morph_states(manager, model);
+
+    if (model->animation_count && model->node_count && !model->animation_node_state_pool.element_size)
+    {
+        // One element holds a pose buffer's storage followed by a key cursor for every node, padded so consecutive elements stay aligned
+        size_t element_size = animation_pose_buffer_get_storage_size(model->node_count) + (model->node_count * sizeof(struct animation_channel_cursor));
+        size_t element_alignment = alignof(max_align_t);
+        element_size = (element_size + element_alignment - 1) & ~(element_alignment - 1);
+
+        handle_pool_initialize(&model->animation_node_state_pool, element_size, ANIMATION_NODE_STATE_POOL_BLOCK_SIZE);
+    }
     
     for (int state_index = 0; state_index < model->animation_count; state_index++)
     {
@@ -63,7 +159,7 @@ void animation_manager_initialize(
         state->fade_in_duration = 0.0f;
         state->fade_out_duration = 0.0f;
 
-        assert(state->node_states = calloc(model->node_count, sizeof(*state->node_states)));
+        state->node_state_handle = -1;
     }
 }
 
@@ -73,17 +169,43 @@ void animation_manager_dispose(
     assert(manager);
 
     struct model_data *model = model_get_data(manager->model_index);
-    assert(model);
 
-    for (int state_index = 0; state_index < model->animation_count; state_index++)
+    if (!model)
     {
-        struct animation_state *state = manager->states + state_index;
-        free(state->node_states);
+        return;
     }
 
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+    {
+        animation_manager_free_node_states(model, manager->states + animation_index);
+    }
+
+    animation_pose_buffer_dispose(&manager->blended_pose);
+    animation_pose_buffer_dispose(&manager->previous_pose);
+    animation_pose_buffer_dispose(&manager->evaluated_pose);
+
     free(manager->active_animations_bit_vector);
     free(manager->states);
+    free(manager->blend_layers);
+    free(manager->node_transforms);
     free(manager->node_matrices);
+
+    for (int morph_state_index = 0; morph_state_index < manager->morph_state_count; morph_state_index++)
+    {
+        struct animation_morph_state *morph_state = manager->morph_states + morph_state_index;
+
+        glDeleteVertexArrays(1, &morph_state->vertex_array);
+        glDeleteBuffers(1, &morph_state->vertex_buffer);
+
+        free(morph_state->weights);
+        animation_morph_accumulator_dispose(&morph_state->accumulator);
+        free(morph_state->vertex_data);
+    }
+
+    free(manager->morph_states);
+    free(manager->mesh_morph_state_indices);
 }
 
 struct animation_state *animation_manager_get_animation_state(
@@ -106,7 +228,9 @@ void animation_manager_set_animation_flags(
     unsigned int flags)
 {
     struct animation_state *state = animation_manager_get_animation_state(manager, animation_index);
-    state->flags = flags;
+
+    // The finished bit tracks finished_animation_count, so only the manager changes it
+    state->flags = (flags & ~BIT(_animation_state_finished_bit)) | (state->flags & BIT(_animation_state_finished_bit));
 }
 
 bool animation_manager_is_animation_looping(
@@ -143,6 +267,23 @@ void animation_manager_set_animation_paused(
     SET_BIT(state->flags, _animation_state_paused_bit, paused);
 }
 
+bool animation_manager_is_animation_additive(
+    struct animation_manager *manager,
+    int animation_index)
+{
+    struct animation_state *state = animation_manager_get_animation_state(manager, animation_index);
+    return TEST_BIT(state->flags, _animation_state_additive_bit);
+}
+
+void animation_manager_set_animation_additive(
+    struct animation_manager *manager,
+    int animation_index,
+    bool additive)
+{
+    struct animation_state *state = animation_manager_get_animation_state(manager, animation_index);
+    SET_BIT(state->flags, _animation_state_additive_bit, additive);
+}
+
 bool animation_manager_is_animation_active(
     struct animation_manager *manager,
     int animation_index)
@@ -171,8 +312,28 @@ void animation_manager_set_animation_active(
     state->time = 0.0f;
     state->weight = 1.0f;
 
+    if (TEST_BIT(state->flags, _animation_state_finished_bit))
+    {
+        SET_BIT(state->flags, _animation_state_finished_bit, false);
+        manager->finished_animation_count--;
+    }
+
+    if (animation_manager_is_animation_active(manager, animation_index) == active)
+        return;
+
+    struct model_data *model = model_get_data(manager->model_index);
+
+    if (active)
+        animation_manager_allocate_node_states(model, state);
+    else
+        animation_manager_free_node_states(model, state);
+
     BIT_VECTOR_SET_BIT(manager->active_animations_bit_vector, animation_index, active);
     manager->active_animation_count += active ? 1 : -1;
+
+    // Show the change on the next update rather than interpolating towards it
+    manager->updates_since_evaluation = ANIMATION_MANAGER_EVALUATE_NEXT_UPDATE;
+    manager->has_previous_pose = false;
 }
 
 void animation_manager_set_animation_state_time(
@@ -217,32 +378,334 @@ void animation_manager_update(
     struct animation_manager *manager,
     float delta_ticks)
 {
+    PROFILER_FUNCTION();
+
     assert(manager);
 
     struct model_data *model = model_get_data(manager->model_index);
 
     if (!model)
         return;
+
+    manager->pose_source = NULL;
+
+    const struct animation_lod_definition *lod_definition = animation_lod_definitions + manager->lod;
+
+    // Clip times advance every update; only sampling and blending wait for an evaluation
+    manager->evaluated = ++manager->updates_since_evaluation >= lod_definition->update_interval;
+
+    if (manager->evaluated)
+        manager->updates_since_evaluation = 0;
+
+    // Pose-sharing managers sample through the pose cache instead
+    bool sample = manager->evaluated && !manager->shares_poses;
     
-    for (int animation_index = 0; animation_index < model->animation_count; animation_index++)
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
     {
-        animation_manager_update_animation(manager, model, animation_index, delta_ticks);
+        if (!TEST_BIT(manager->states[animation_index].flags, _animation_state_finished_bit))
+            animation_manager_update_animation(manager, model, animation_index, delta_ticks, sample);
     }
 
-    if (!model->nodes)
+    // Morph weights belong to this object alone, even when its pose is shared
+    if (manager->evaluated && manager->morph_state_count)
+        animation_manager_evaluate_morphs(manager, model);
+
+    if (manager->shares_poses)
+    {
+        animation_manager_build_pose_cache_key(manager, model);
+
+        // Evaluated later by animation_pose_cache_evaluate
+        if (manager->has_pose_cache_key)
+            return;
+
+        // Playing too many clips to have a key, so the manager evaluates its own pose
+        for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+            animation_index != -1;
+            animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+        {
+            struct animation_state *state = manager->states + animation_index;
+
+            if (!TEST_BIT(state->flags, _animation_state_finished_bit))
+                animation_manager_compute_node_orientations(manager, model, model->animations + animation_index, state, state->time);
+        }
+    }
+
+    if (manager->evaluated)
+        animation_manager_evaluate_pose(manager, model);
+
+    animation_manager_compute_node_matrices(manager, model);
+}
+
+bool animation_manager_is_sharing_poses(
+    struct animation_manager *manager)
+{
+    assert(manager);
+    return manager->shares_poses;
+}
+
+void animation_manager_set_sharing_poses(
+    struct animation_manager *manager,
+    bool sharing)
+{
+    assert(manager);
+
+    manager->shares_poses = sharing;
+    manager->has_pose_cache_key = false;
+    manager->pose_source = NULL;
+    manager->updates_since_evaluation = ANIMATION_MANAGER_EVALUATE_NEXT_UPDATE;
+    manager->has_previous_pose = false;
+
+    struct model_data *model = model_get_data(manager->model_index);
+
+    if (!sharing || !model)
         return;
-    
-    int root_node_index = model_get_root_node(model);
-    animation_manager_compute_node_matrices(manager, model, root_node_index, GLM_MAT4_IDENTITY);
+
+    // Snap desynchronization offsets to bucket boundaries, so objects started a whole number of buckets apart
+    // keep falling into the same buckets as each other
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+    {
+        struct animation_data *animation = model->animations + animation_index;
+        struct animation_state *state = manager->states + animation_index;
+
+        float ticks_per_bucket = animation->ticks_per_second / (float)ANIMATION_POSE_CACHE_BUCKETS_PER_SECOND;
+        state->time = floorf(state->time / ticks_per_bucket) * ticks_per_bucket;
+    }
+}
+
+void animation_manager_evaluate_shared_pose(
+    struct animation_manager *manager)
+{
+    PROFILER_FUNCTION();
+
+    assert(manager);
+    assert(manager->shares_poses && manager->has_pose_cache_key);
+
+    struct model_data *model = model_get_data(manager->model_index);
+    assert(model);
+
+    // Sample at the key's snapped times and weights alone, so every manager with the same key gets the same pose
+    for (int layer_index = 0; layer_index < manager->pose_cache_key.layer_count; layer_index++)
+    {
+        const struct animation_pose_cache_layer *layer = manager->pose_cache_key.layers + layer_index;
+        struct animation_data *animation = model->animations + layer->animation_index;
+        struct animation_state *state = manager->states + layer->animation_index;
+
+        float ticks_per_bucket = animation->ticks_per_second / (float)ANIMATION_POSE_CACHE_BUCKETS_PER_SECOND;
+        float time = fminf((float)layer->bucket_index * ticks_per_bucket, animation->duration);
+
+        state->weight = (float)layer->weight_step / (float)ANIMATION_POSE_CACHE_WEIGHT_STEPS;
+        animation_manager_compute_node_orientations(manager, model, animation, state, time);
+    }
+
+    manager->evaluated = true;
+    manager->has_previous_pose = false;
+
+    animation_manager_evaluate_pose(manager, model);
+    animation_manager_compute_node_matrices(manager, model);
+}
+
+mat4 *animation_manager_get_node_transforms(
+    const struct animation_manager *manager)
+{
+    assert(manager);
+    return (manager->pose_source ? manager->pose_source : manager)->node_transforms;
+}
+
+mat4 *animation_manager_get_node_matrices(
+    const struct animation_manager *manager)
+{
+    assert(manager);
+    return (manager->pose_source ? manager->pose_source : manager)->node_matrices;
+}
+
+struct animation_morph_state *animation_manager_get_morph_state(
+    struct animation_manager *manager,
+    int mesh_index)
+{
+    assert(manager);
+
+    if (!manager->mesh_morph_state_indices || manager->mesh_morph_state_indices[mesh_index] == -1)
+        return NULL;
+
+    return manager->morph_states + manager->mesh_morph_state_indices[mesh_index];
+}
+
+enum animation_lod animation_manager_get_lod_for_screen_size(
+    float screen_size)
+{
+    for (enum animation_lod lod = _animation_lod_full; lod < NUMBER_OF_ANIMATION_LODS - 1; lod++)
+    {
+        if (screen_size >= animation_lod_definitions[lod].minimum_screen_size)
+            return lod;
+    }
+
+    return NUMBER_OF_ANIMATION_LODS - 1;
+}
+
+void animation_manager_select_lod(
+    struct animation_manager *manager,
+    float screen_size)
+{
+    assert(manager);
+
+    manager->screen_size = screen_size;
+
+    // A shared pose is evaluated once for every object that uses it, so it is always worth full detail
+    manager->lod = manager->shares_poses ? _animation_lod_full : animation_manager_get_lod_for_screen_size(screen_size);
+}
+
+void animation_manager_accumulate_lod_counters(
+    struct animation_manager *manager,
+    struct animation_lod_counters *counters)
+{
+    assert(manager);
+    assert(counters);
+
+    struct model_data *model = model_get_data(manager->model_index);
+
+    if (!model || !manager->active_animation_count)
+        return;
+
+    counters->object_counts[manager->lod]++;
+
+    if (manager->evaluated)
+        counters->evaluated_object_count++;
+    else
+        counters->interpolated_object_count++;
+
+    if (animation_lod_definitions[manager->lod].minimum_node_height > 0)
+    {
+        const unsigned int *node_mask = model->animation_lod_node_masks[manager->lod];
+        int sampled_node_count = 0;
+
+        for (int word_index = 0; word_index < BIT_VECTOR_LENGTH_IN_WORDS(model->node_count); word_index++)
+            sampled_node_count += __builtin_popcount(node_mask[word_index]);
+
+        counters->masked_node_count += model->node_count - sampled_node_count;
+    }
+}
+
+void animation_manager_release_finished_animations(
+    struct animation_manager *manager)
+{
+    assert(manager);
+
+    if (!manager->finished_animation_count)
+        return;
+
+    struct model_data *model = model_get_data(manager->model_index);
+    assert(model);
+
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+    {
+        if (TEST_BIT(manager->states[animation_index].flags, _animation_state_finished_bit))
+            animation_manager_set_animation_active(manager, animation_index, false);
+    }
+
+    assert(!manager->finished_animation_count);
 }
 
 /* ---------- private code */
 
+static int animation_manager_get_next_active_animation(
+    struct animation_manager *manager,
+    struct model_data *model,
+    int animation_index)
+{
+    int bit_index = animation_index + 1;
+
+    if (bit_index >= model->animation_count)
+        return -1;
+
+    int word_count = BIT_VECTOR_LENGTH_IN_WORDS(model->animation_count);
+    int word_index = BIT_VECTOR_WORD_INDEX(bit_index);
+
+    // Mask off the bits before the starting bit, then skip whole empty words
+    unsigned int word = manager->active_animations_bit_vector[word_index] & (~0u << BIT_VECTOR_WORD_BIT_INDEX(bit_index));
+
+    while (!word)
+    {
+        if (++word_index >= word_count)
+            return -1;
+
+        word = manager->active_animations_bit_vector[word_index];
+    }
+
+    return (word_index * WORD_BIT) + __builtin_ctz(word);
+}
+
+static void animation_manager_allocate_node_states(
+    struct model_data *model,
+    struct animation_state *state)
+{
+    assert(state->node_state_handle == -1);
+
+    if (!model->node_count)
+        return;
+
+    state->node_state_handle = handle_pool_allocate(&model->animation_node_state_pool);
+
+    float *storage = handle_pool_get(&model->animation_node_state_pool, state->node_state_handle);
+    animation_pose_buffer_initialize(&state->pose, model->node_count, storage);
+
+    state->node_cursors = (struct animation_channel_cursor *)((char *)storage + animation_pose_buffer_get_storage_size(model->node_count));
+    animation_channel_cursors_initialize(state->node_cursors, model->node_count);
+}
+
+static void animation_manager_free_node_states(
+    struct model_data *model,
+    struct animation_state *state)
+{
+    if (state->node_state_handle != -1)
+        handle_pool_free(&model->animation_node_state_pool, state->node_state_handle);
+
+    state->node_state_handle = -1;
+    animation_pose_buffer_dispose(&state->pose);
+    state->node_cursors = NULL;
+}
+
+static void animation_manager_build_lod_node_masks(
+    struct model_data *model)
+{
+    // Each node's height: the most levels of descendants below it, 0 for leaves.
+    // Children follow their parents, so one backward pass sees every child before its parent.
+    int *node_heights = heap_allocate_zeroed(model->node_count, sizeof(*node_heights));
+    assert(node_heights);
+
+    for (int node_index = model->node_count - 1; node_index >= 0; node_index--)
+    {
+        int parent_node_index = model->node_parent_indices[node_index];
+
+        if (parent_node_index != -1 && node_heights[parent_node_index] < node_heights[node_index] + 1)
+            node_heights[parent_node_index] = node_heights[node_index] + 1;
+    }
+
+    for (int lod = 0; lod < NUMBER_OF_ANIMATION_LODS; lod++)
+    {
+        unsigned int *node_mask = heap_allocate_zeroed(BIT_VECTOR_LENGTH_IN_WORDS(model->node_count), sizeof(*node_mask));
+        assert(node_mask);
+
+        for (int node_index = 0; node_index < model->node_count; node_index++)
+            BIT_VECTOR_SET_BIT(node_mask, node_index, node_heights[node_index] >= animation_lod_definitions[lod].minimum_node_height);
+
+        model->animation_lod_node_masks[lod] = node_mask;
+    }
+
+    free(node_heights);
+}
+
 static void animation_manager_update_animation(
     struct animation_manager *manager,
     struct model_data *model,
     int animation_index,
-    float delta_ticks)
+    float delta_ticks,
+    bool evaluate)
 {
     struct animation_data *animation = model->animations + animation_index;
     struct animation_state *state = manager->states + animation_index;
@@ -254,243 +717,280 @@ static void animation_manager_update_animation(
     else
         state->weight = 1.0f;
     
-    if (BIT_VECTOR_TEST_BIT(manager->active_animations_bit_vector, animation_index))
-    {
-        state->time += (animation->ticks_per_second * state->speed) * delta_ticks;
+    state->time += (animation->ticks_per_second * state->speed) * delta_ticks;
 
-        if (TEST_BIT(state->flags, _animation_state_looping_bit))
-        {
-            state->time = fmodf(state->time, animation->duration);
-        }
-        else if (state->time >= animation->duration)
-        {
-            animation_manager_set_animation_active(manager, animation_index, false);
-        }
+    if (TEST_BIT(state->flags, _animation_state_looping_bit))
+    {
+        state->time = fmodf(state->time, animation->duration);
+    }
+    else if (state->time >= animation->duration)
+    {
+        // Finished animations are not sampled again, but their node states belong to a pool shared with every other
+        // object of the model, so they are only given back by animation_manager_release_finished_animations
+        SET_BIT(state->flags, _animation_state_finished_bit, true);
+        manager->finished_animation_count++;
+        return;
     }
 
-    animation_manager_compute_node_orientations(model, animation, state);
+    if (evaluate)
+        animation_manager_compute_node_orientations(manager, model, animation, state, state->time);
 }
 
 static void animation_manager_compute_node_orientations(
+    struct animation_manager *manager,
     struct model_data *model,
     struct animation_data *animation,
-    struct animation_state *state)
+    struct animation_state *state,
+    float time)
 {
-    for (int node_index = 0; node_index < model->node_count; node_index++)
+    const unsigned int *node_mask = animation_lod_definitions[manager->lod].minimum_node_height > 0 ? model->animation_lod_node_masks[manager->lod] : NULL;
+
+    // Baked clips need no key search, so their cursors go unused
+    if (animation_is_baked(animation))
+        animation_sample_baked_pose(animation, &model->default_pose, time, node_mask, &state->pose);
+    else
+        animation_sample_pose(animation, &model->default_pose, time, state->node_cursors, node_mask, &state->pose);
+}
+
+static void animation_manager_initialize_morph_states(
+    struct animation_manager *manager,
+    struct model_data *model)
+{
+    for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
     {
-        struct model_node *node = model->nodes + node_index;
-        struct animation_node_state *node_state = state->node_states + node_index;
+        if (model->meshes[mesh_index].morphs.target_count)
+            manager->morph_state_count++;
+    }
+
+    if (!manager->morph_state_count)
+        return;
+
+    assert(manager->morph_states = heap_allocate_zeroed(manager->morph_state_count, sizeof(*manager->morph_states)));
+    assert(manager->mesh_morph_state_indices = heap_allocate(model->mesh_count * sizeof(*manager->mesh_morph_state_indices)));
+
+    int morph_state_index = 0;
+
+    for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
+    {
+        struct model_mesh *mesh = model->meshes + mesh_index;
+
+        manager->mesh_morph_state_indices[mesh_index] = -1;
+
+        if (!mesh->morphs.target_count)
+            continue;
+
+        const struct vertex_definition *vertex_definition = vertex_definition_get(mesh->vertex_type);
+        struct animation_morph_state *morph_state = manager->morph_states + morph_state_index;
 
-        int animation_count = 0;
+        morph_state->mesh_index = mesh_index;
 
-        mat4 position_matrix = GLM_MAT4_IDENTITY_INIT;
-        mat4 rotation_matrix = GLM_MAT4_IDENTITY_INIT;
-        mat4 scaling_matrix = GLM_MAT4_IDENTITY_INIT;
+        assert(morph_state->weights = heap_allocate_zeroed(mesh->morphs.target_count, sizeof(*morph_state->weights)));
+        animation_morph_accumulator_initialize(&morph_state->accumulator, &mesh->morphs);
 
-        for (int channel_index = 0; channel_index < animation->channel_count; channel_index++)
+        // The renderer uploads the whole copy when it first creates the object's buffer
+        size_t vertex_data_size = (size_t)mesh->vertex_count * vertex_definition->size;
+        assert(morph_state->vertex_data = heap_allocate(vertex_data_size));
+        memcpy(morph_state->vertex_data, mesh->vertex_data, vertex_data_size);
+
+        manager->mesh_morph_state_indices[mesh_index] = morph_state_index++;
+    }
+}
+
+static void animation_manager_evaluate_morphs(
+    struct animation_manager *manager,
+    struct model_data *model)
+{
+    for (int morph_state_index = 0; morph_state_index < manager->morph_state_count; morph_state_index++)
+    {
+        struct animation_morph_state *morph_state = manager->morph_states + morph_state_index;
+        memset(morph_state->weights, 0, model->meshes[morph_state->mesh_index].morphs.target_count * sizeof(*morph_state->weights));
+    }
+
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+    {
+        struct animation_data *animation = model->animations + animation_index;
+        struct animation_state *state = manager->states + animation_index;
+
+        if (TEST_BIT(state->flags, _animation_state_finished_bit))
+            continue;
+
+        for (int i = 0; i < animation->morph_channel_count; i++)
         {
-            struct animation_channel *channel = animation->channels + channel_index;
-            assert(channel->type == _animation_channel_type_node);
+            const struct animation_channel *channel = animation->channels + animation->morph_channel_indices[i];
 
-            if (channel->node_index != node_index)
+            if (channel->mesh_index == -1 || manager->mesh_morph_state_indices[channel->mesh_index] == -1)
                 continue;
 
-            if (channel->position_key_count == 1)
-            {
-                mat4 current_position_matrix;
-                glm_mat4_identity(current_position_matrix);
-                glm_translate(current_position_matrix, channel->position_keys[0].position);
-                glm_mat4_mul(position_matrix, current_position_matrix, position_matrix);
-                animation_count++;
-            }
-            else
-            {
-                for (int position_key_index = 0; position_key_index < channel->position_key_count; position_key_index++)
-                {
-                    struct animation_position_key *position_key = channel->position_keys + position_key_index;
-
-                    int next_position_key_index = position_key_index + 1;
-                    if (next_position_key_index >= channel->position_key_count)
-                        next_position_key_index = 0;
-                    
-                    struct animation_position_key *next_position_key = channel->position_keys + next_position_key_index;
-
-                    if (state->time < position_key->time)
-                    {
-                        float scale_factor = (state->time - position_key->time) / (next_position_key->time - position_key->time);
-
-                        vec3 interpolated_position;
-                        glm_vec3_mix(position_key->position, next_position_key->position, scale_factor, interpolated_position);
-
-                        mat4 current_position_matrix;
-                        glm_mat4_identity(current_position_matrix);
-                        glm_translate(current_position_matrix, interpolated_position);
-                        glm_mat4_mul(position_matrix, current_position_matrix, position_matrix);
-                        animation_count++;
-                        break;
-                    }
-                }
-            }
-
-            if (channel->rotation_key_count == 1)
-            {
-                mat4 current_rotation_matrix;
-                glm_mat4_identity(current_rotation_matrix);
-                glm_quat_mat4(channel->rotation_keys[0].rotation, current_rotation_matrix);
-                glm_mat4_mul(rotation_matrix, current_rotation_matrix, rotation_matrix);
-                animation_count++;
-            }
-            else
-            {
-                for (int rotation_key_index = 0; rotation_key_index < channel->rotation_key_count; rotation_key_index++)
-                {
-                    struct animation_rotation_key *rotation_key = channel->rotation_keys + rotation_key_index;
-
-                    int next_rotation_key_index = rotation_key_index + 1;
-                    if (next_rotation_key_index >= channel->rotation_key_count)
-                        next_rotation_key_index = 0;
-                    
-                    struct animation_rotation_key *next_rotation_key = channel->rotation_keys + next_rotation_key_index;
-
-                    if (state->time < rotation_key->time)
-                    {
-                        float scale_factor = (state->time - rotation_key->time) / (next_rotation_key->time - rotation_key->time);
-
-                        vec4 interpolated_rotation;
-                        glm_quat_slerp(rotation_key->rotation, next_rotation_key->rotation, scale_factor, interpolated_rotation);
-
-                        mat4 current_rotation_matrix;
-                        glm_mat4_identity(current_rotation_matrix);
-                        glm_quat_mat4(interpolated_rotation, current_rotation_matrix);
-                        glm_mat4_mul(rotation_matrix, current_rotation_matrix, rotation_matrix);
-                        animation_count++;
-                        break;
-                    }
-                }
-            }
-
-            if (channel->scaling_key_count == 1)
-            {
-                mat4 current_scaling_matrix;
-                glm_mat4_identity(current_scaling_matrix);
-                glm_scale(current_scaling_matrix, channel->scaling_keys[0].scaling);
-                glm_mat4_mul(scaling_matrix, current_scaling_matrix, scaling_matrix);
-                animation_count++;
-            }
-            else
-            {
-                for (int scaling_key_index = 0; scaling_key_index < channel->scaling_key_count; scaling_key_index++)
-                {
-                    struct animation_scaling_key *scaling_key = channel->scaling_keys + scaling_key_index;
-
-                    int next_scaling_key_index = scaling_key_index + 1;
-                    if (next_scaling_key_index >= channel->scaling_key_count)
-                        next_scaling_key_index = 0;
-                    
-                    struct animation_scaling_key *next_scaling_key = channel->scaling_keys + next_scaling_key_index;
-
-                    if (state->time < scaling_key->time)
-                    {
-                        float scale_factor = (state->time - scaling_key->time) / (next_scaling_key->time - scaling_key->time);
-
-                        vec3 interpolated_scaling;
-                        glm_vec3_mix(scaling_key->scaling, next_scaling_key->scaling, scale_factor, interpolated_scaling);
-
-                        mat4 current_scaling_matrix;
-                        glm_mat4_identity(current_scaling_matrix);
-                        glm_scale(current_scaling_matrix, interpolated_scaling);
-                        glm_mat4_mul(scaling_matrix, current_scaling_matrix, scaling_matrix);
-                        animation_count++;
-                        break;
-                    }
-                }
-            }
+            struct animation_morph_state *morph_state = manager->morph_states + manager->mesh_morph_state_indices[channel->mesh_index];
+            animation_morph_channel_sample(channel, state->time, state->weight, morph_state->weights);
         }
+    }
 
-        mat4 local_transform;
+    // Position and normal lead both vertex layouts, so one pair of offsets serves either
+    static_assert(offsetof(struct vertex_rigid, position) == offsetof(struct vertex_skinned, position));
+    static_assert(offsetof(struct vertex_rigid, normal) == offsetof(struct vertex_skinned, normal));
 
-        if (animation_count == 0)
-        {
-            glm_mat4_copy(node->default_transform, local_transform);
-        }
-        else
+    for (int morph_state_index = 0; morph_state_index < manager->morph_state_count; morph_state_index++)
+    {
+        struct animation_morph_state *morph_state = manager->morph_states + morph_state_index;
+        struct model_mesh *mesh = model->meshes + morph_state->mesh_index;
+
+        int vertex_start;
+        int vertex_end;
+
+        if (!animation_morph_accumulate(&mesh->morphs, morph_state->weights, &morph_state->accumulator, &vertex_start, &vertex_end))
+            continue;
+
+        int first_vertex;
+        int vertex_count;
+
+        animation_morph_apply(
+            &mesh->morphs,
+            &morph_state->accumulator,
+            vertex_start,
+            vertex_end,
+            mesh->vertex_data,
+            morph_state->vertex_data,
+            vertex_definition_get(mesh->vertex_type)->size,
+            offsetof(struct vertex_rigid, position),
+            offsetof(struct vertex_rigid, normal),
+            &first_vertex,
+            &vertex_count);
+
+        if (!vertex_count)
+            continue;
+
+        // Grow the pending upload to cover both the span already waiting and the new one
+        if (morph_state->dirty_vertex_count)
         {
-            glm_mul(scaling_matrix, rotation_matrix, local_transform);
-            glm_mul(position_matrix, local_transform, local_transform);
+            int dirty_vertex_end = morph_state->dirty_vertex_start + morph_state->dirty_vertex_count;
+
+            if (dirty_vertex_end < first_vertex + vertex_count)
+                dirty_vertex_end = first_vertex + vertex_count;
+
+            if (first_vertex > morph_state->dirty_vertex_start)
+                first_vertex = morph_state->dirty_vertex_start;
+
+            vertex_count = dirty_vertex_end - first_vertex;
         }
 
-        glm_decompose(local_transform, node_state->position, rotation_matrix, node_state->scale);
-        glm_mat4_quat(rotation_matrix, node_state->rotation);
+        morph_state->dirty_vertex_start = first_vertex;
+        morph_state->dirty_vertex_count = vertex_count;
     }
 }
 
-static void animation_manager_compute_node_matrices(
+static void animation_manager_build_pose_cache_key(
     struct animation_manager *manager,
-    struct model_data *model,
-    int node_index,
-    mat4 parent_transform)
+    struct model_data *model)
 {
-    struct model_node *node = model->nodes + node_index;
+    struct animation_pose_cache_key *key = &manager->pose_cache_key;
+    memset(key, 0, sizeof(*key));
 
-    int animation_count = 0;
+    key->model_index = manager->model_index;
+    manager->has_pose_cache_key = true;
 
-    vec3 total_position;
-    vec4 total_rotation;
-    vec3 total_scale;
-
-    for (int animation_index = 0; animation_index < model->animation_count; animation_index++)
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
     {
-        if (!animation_manager_is_animation_active(manager, animation_index))
-            continue;
-        
+        struct animation_data *animation = model->animations + animation_index;
         struct animation_state *state = manager->states + animation_index;
-        struct animation_node_state *node_state = state->node_states + node_index;
 
-        if (animation_count == 0)
+        if (TEST_BIT(state->flags, _animation_state_finished_bit))
+            continue;
+
+        if (key->layer_count == MAXIMUM_NUMBER_OF_POSE_CACHE_LAYERS)
         {
-            glm_vec3_copy(node_state->position, total_position);
-            glm_vec4_copy(node_state->rotation, total_rotation);
-            glm_vec3_copy(node_state->scale, total_scale);
+            manager->has_pose_cache_key = false;
+            return;
         }
-        else
+
+        float buckets_per_tick = (float)ANIMATION_POSE_CACHE_BUCKETS_PER_SECOND / animation->ticks_per_second;
+
+        key->layers[key->layer_count++] = (struct animation_pose_cache_layer)
         {
-            glm_vec3_mix(node_state->position, total_position, 0.5f * state->weight, total_position);
-            glm_quat_slerp(node_state->rotation, total_rotation, 0.5f * state->weight, total_rotation);
-            glm_vec3_mix(node_state->scale, total_scale, 0.5f * state->weight, total_scale);
-        }
+            .animation_index = animation_index,
+            .bucket_index = (int)floorf(state->time * buckets_per_tick),
+            .weight_step = (short)lroundf(state->weight * ANIMATION_POSE_CACHE_WEIGHT_STEPS),
+            .additive = TEST_BIT(state->flags, _animation_state_additive_bit) != 0,
+        };
+    }
+}
 
-        animation_count++;
+static void animation_manager_evaluate_pose(
+    struct animation_manager *manager,
+    struct model_data *model)
+{
+    int layer_count = 0;
+
+    for (int animation_index = animation_manager_get_next_active_animation(manager, model, -1);
+        animation_index != -1;
+        animation_index = animation_manager_get_next_active_animation(manager, model, animation_index))
+    {
+        struct animation_state *state = manager->states + animation_index;
+
+        // Finished clips stay active until they are released, but their poses are stale
+        if (TEST_BIT(state->flags, _animation_state_finished_bit))
+            continue;
+
+        manager->blend_layers[layer_count++] = (struct animation_blend_layer)
+        {
+            .pose = &state->pose,
+            .weight = state->weight,
+            .mode = TEST_BIT(state->flags, _animation_state_additive_bit) ? _animation_blend_mode_additive : _animation_blend_mode_override,
+        };
     }
 
-    mat4 local_transform;
+    // The latest evaluation becomes the pose to interpolate from
+    struct animation_pose_buffer previous_pose = manager->previous_pose;
+    manager->previous_pose = manager->evaluated_pose;
+    manager->evaluated_pose = previous_pose;
+
+    animation_pose_blend(manager->blend_layers, layer_count, &model->default_pose, &manager->evaluated_pose);
 
-    if (animation_count == 0)
+    if (!manager->has_previous_pose)
     {
-        glm_mat4_copy(node->default_transform, local_transform);
+        animation_pose_buffer_copy(&manager->previous_pose, &manager->evaluated_pose);
+        manager->has_previous_pose = true;
     }
-    else
+}
+
+static void animation_manager_compute_node_matrices(
+    struct animation_manager *manager,
+    struct model_data *model)
+{
+    const struct animation_pose_buffer *pose = &manager->evaluated_pose;
+    int update_interval = animation_lod_definitions[manager->lod].update_interval;
+
+    if (update_interval > 1)
     {
-        mat4 position_matrix = GLM_MAT4_IDENTITY_INIT;
-        mat4 rotation_matrix = GLM_MAT4_IDENTITY_INIT;
-        mat4 scaling_matrix = GLM_MAT4_IDENTITY_INIT;
+        // Reaches the evaluated pose on the update before the next evaluation
+        float factor = fminf((float)(manager->updates_since_evaluation + 1) / (float)update_interval, 1.0f);
 
-        glm_translate(position_matrix, total_position);
-        glm_quat_mat4(total_rotation, rotation_matrix);
-        glm_scale(scaling_matrix, total_scale);
+        struct animation_blend_layer layer =
+        {
+            .pose = &manager->evaluated_pose,
+            .weight = factor,
+            .mode = _animation_blend_mode_override,
+        };
 
-        glm_mat4_mul(position_matrix, rotation_matrix, local_transform);
-        glm_mat4_mul(local_transform, scaling_matrix, local_transform);
+        animation_pose_blend(&layer, 1, &manager->previous_pose, &manager->blended_pose);
+        pose = &manager->blended_pose;
     }
 
-    mat4 global_transform;
-    glm_mat4_mul(parent_transform, local_transform, global_transform);
+    // The only matrices built from the pose, once per node after blending
+    animation_pose_buffer_to_matrices(pose, manager->node_transforms);
 
-    glm_mat4_mul(global_transform, node->offset_matrix, manager->node_matrices[node_index]);
-    
-    for (int child_node_index = node->first_child_index;
-        child_node_index != -1;
-        child_node_index = model->nodes[child_node_index].next_sibling_index)
+    // Parents always precede their children, so a single forward pass turns every local transform into a model-space one
+    for (int node_index = 0; node_index < model->node_count; node_index++)
     {
-        animation_manager_compute_node_matrices(manager, model, child_node_index, global_transform);
+        int parent_node_index = model->node_parent_indices[node_index];
+
+        if (parent_node_index != -1)
+            glm_mat4_mul(manager->node_transforms[parent_node_index], manager->node_transforms[node_index], manager->node_transforms[node_index]);
+
+        glm_mat4_mul(manager->node_transforms[node_index], model->nodes[node_index].offset_matrix, manager->node_matrices[node_index]);
     }
 }
@@ -7,25 +7,38 @@ ANIMATION_MANAGER.H
 
 #include <cglm/cglm.h>
 
+#include "animations/animation_blending.h"
+#include "animations/animation_morphs.h"
+#include "animations/animation_poses.h"
+#include "animations/animation_pose_cache.h"
+
 /* ---------- constants */
 
+enum
+{
+    ANIMATION_NODE_STATE_POOL_BLOCK_SIZE = 8,
+};
+
 enum animation_state_flags
 {
     _animation_state_looping_bit,
     _animation_state_paused_bit,
     _animation_state_fade_in_bit,
     _animation_state_fade_out_bit,
+    _animation_state_additive_bit,
+    _animation_state_finished_bit,
 };
 
-/* ---------- structures */
-
-struct animation_node_state
+enum animation_lod
 {
-    vec3 position;
-    vec4 rotation;
-    vec3 scale;
+    _animation_lod_full,
+    _animation_lod_reduced,
+    _animation_lod_minimal,
+    NUMBER_OF_ANIMATION_LODS
 };
 
+/* ---------- structures */
+
 struct animation_state
 {
     unsigned int flags;
@@ -37,18 +50,80 @@ struct animation_state
     float fade_in_duration;
     float fade_out_duration;
 
-    struct animation_node_state *node_states;
+    // Allocated from the model's animation node state pool while the animation is active, otherwise -1
+    int node_state_handle;
+    struct animation_pose_buffer pose;
+    struct animation_channel_cursor *node_cursors;
+};
+
+/**
+ * A model mesh's morph target weights for one object, and the object's own copy of the mesh's vertices with them applied.
+ */
+struct animation_morph_state
+{
+    int mesh_index;
+
+    float *weights;
+    struct animation_morph_accumulator accumulator;
+    void *vertex_data;
+
+    // The span of vertex_data written since the renderer last uploaded it
+    int dirty_vertex_start;
+    int dirty_vertex_count;
+
+    // Created and uploaded to by the renderer, which draws these instead of the mesh's own buffers
+    unsigned int vertex_array;
+    unsigned int vertex_buffer;
+};
+
+struct animation_lod_counters
+{
+    int object_counts[NUMBER_OF_ANIMATION_LODS];
+    int evaluated_object_count;
+    int interpolated_object_count;
+    int masked_node_count;
 };
 
 struct animation_manager
 {
     int model_index;
 
+    // The level of detail chosen from the object's projected screen size, as a fraction of the viewport height
+    enum animation_lod lod;
+    float screen_size;
+
+    // Coarser levels of detail only evaluate their animations every few updates, and interpolate from the
+    // previously evaluated pose to the latest one over the updates in between
+    int updates_since_evaluation;
+    bool evaluated;
+    bool has_previous_pose;
+    struct animation_pose_buffer previous_pose;
+    struct animation_pose_buffer evaluated_pose;
+
+    // Managers that share poses are evaluated through the pose cache at snapped clip times and weights. When another
+    // manager evaluated the same key this frame, pose_source points at it and its node matrices are used instead.
+    bool shares_poses;
+    bool has_pose_cache_key;
+    struct animation_pose_cache_key pose_cache_key;
+    const struct animation_manager *pose_source;
+
     int active_animation_count;
+    int finished_animation_count;
     unsigned int *active_animations_bit_vector;
 
     struct animation_state *states;
+
+    // One blend layer per animation, filled from the active states each update
+    struct animation_blend_layer *blend_layers;
+    struct animation_pose_buffer blended_pose;
     
+    // One morph state per mesh with morph targets, and the index of each model mesh's morph state or -1
+    int morph_state_count;
+    struct animation_morph_state *morph_states;
+    int *mesh_morph_state_indices;
+
+    // Model-space node transforms, and the same transforms premultiplied into each node's offset matrix for skinning
+    mat4 *node_transforms;
     mat4 *node_matrices;
 };
 
@@ -67,6 +142,9 @@ void animation_manager_set_animation_looping(struct animation_manager *manager,
 bool animation_manager_is_animation_paused(struct animation_manager *manager, int animation_index);
 void animation_manager_set_animation_paused(struct animation_manager *manager, int animation_index, bool paused);
 
+bool animation_manager_is_animation_additive(struct animation_manager *manager, int animation_index);
+void animation_manager_set_animation_additive(struct animation_manager *manager, int animation_index, bool additive);
+
 bool animation_manager_is_animation_active(struct animation_manager *manager, int animation_index);
 void animation_manager_set_animation_active(struct animation_manager *manager, int animation_index, bool active);
 
@@ -76,4 +154,18 @@ void animation_manager_set_animation_state_speed(struct animation_manager *manag
 void animation_manager_set_animation_fade_in_duration(struct animation_manager *manager, int animation_index, float duration);
 void animation_manager_set_animation_fade_out_duration(struct animation_manager *manager, int animation_index, float duration);
 
+enum animation_lod animation_manager_get_lod_for_screen_size(float screen_size);
+void animation_manager_select_lod(struct animation_manager *manager, float screen_size);
+void animation_manager_accumulate_lod_counters(struct animation_manager *manager, struct animation_lod_counters *counters);
+
+bool animation_manager_is_sharing_poses(struct animation_manager *manager);
+void animation_manager_set_sharing_poses(struct animation_manager *manager, bool sharing);
+void animation_manager_evaluate_shared_pose(struct animation_manager *manager);
+
+mat4 *animation_manager_get_node_transforms(const struct animation_manager *manager);
+mat4 *animation_manager_get_node_matrices(const struct animation_manager *manager);
+
+struct animation_morph_state *animation_manager_get_morph_state(struct animation_manager *manager, int mesh_index);
+
 void animation_manager_update(struct animation_manager *manager, float delta_ticks);
+void animation_manager_release_finished_animations(struct animation_manager *manager);
@@ -0,0 +1,134 @@
+/*
+ANIMATION_POSE_CACHE.C
+    Shared animation pose cache code.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "jobs/jobs.h"
+#include "memory/dynamic_arrays.h"
+#include "memory/hash_maps.h"
+#include "profiler/profiler.h"
+#include "animations/animation_manager.h"
+#include "animations/animation_pose_cache.h"
+
+/* ---------- private constants */
+
+enum
+{
+    ANIMATION_POSE_CACHE_EVALUATION_BATCH_SIZE = 4,
+};
+
+/* ---------- private variables */
+
+struct
+{
+    // Hashed keys, mapped to the index of the manager that evaluates them
+    struct hash_map evaluation_indices_by_hash;
+    DYNAMIC_ARRAY(struct animation_manager *) evaluating_managers;
+
+    int request_count;
+} static animation_pose_cache_globals;
+
+/* ---------- private prototypes */
+
+static unsigned int animation_pose_cache_hash_key(const struct animation_pose_cache_key *key);
+static void animation_pose_cache_evaluate_batch(void *data, int start_index, int end_index);
+
+/* ---------- public code */
+
+void animation_pose_cache_initialize(void)
+{
+    memset(&animation_pose_cache_globals, 0, sizeof(animation_pose_cache_globals));
+}
+
+void animation_pose_cache_dispose(void)
+{
+    hash_map_dispose(&animation_pose_cache_globals.evaluation_indices_by_hash);
+    dynamic_array_dispose(&animation_pose_cache_globals.evaluating_managers);
+}
+
+void animation_pose_cache_begin_frame(void)
+{
+    hash_map_clear(&animation_pose_cache_globals.evaluation_indices_by_hash);
+    dynamic_array_clear(&animation_pose_cache_globals.evaluating_managers);
+
+    animation_pose_cache_globals.request_count = 0;
+}
+
+void animation_pose_cache_request(
+    struct animation_manager *manager)
+{
+    assert(manager);
+    assert(manager->shares_poses);
+
+    animation_pose_cache_globals.request_count++;
+
+    int evaluation_count = animation_pose_cache_globals.evaluating_managers.count;
+    int evaluation_index = hash_map_insert(&animation_pose_cache_globals.evaluation_indices_by_hash, animation_pose_cache_hash_key(&manager->pose_cache_key), evaluation_count);
+
+    if (evaluation_index != evaluation_count)
+    {
+        struct animation_manager *source = animation_pose_cache_globals.evaluating_managers.elements[evaluation_index];
+
+        // A different key with the same hash is evaluated on its own
+        if (!memcmp(&source->pose_cache_key, &manager->pose_cache_key, sizeof(manager->pose_cache_key)))
+        {
+            manager->pose_source = source;
+            return;
+        }
+    }
+
+    manager->pose_source = NULL;
+    dynamic_array_push(&animation_pose_cache_globals.evaluating_managers, &manager);
+}
+
+void animation_pose_cache_evaluate(void)
+{
+    PROFILER_FUNCTION();
+
+    jobs_parallel_for(
+        animation_pose_cache_globals.evaluating_managers.count,
+        ANIMATION_POSE_CACHE_EVALUATION_BATCH_SIZE,
+        animation_pose_cache_evaluate_batch,
+        NULL);
+}
+
+void animation_pose_cache_get_statistics(
+    int *out_request_count,
+    int *out_evaluation_count)
+{
+    assert(out_request_count);
+    assert(out_evaluation_count);
+
+    *out_request_count = animation_pose_cache_globals.request_count;
+    *out_evaluation_count = animation_pose_cache_globals.evaluating_managers.count;
+}
+
+/* ---------- private code */
+
+static unsigned int animation_pose_cache_hash_key(
+    const struct animation_pose_cache_key *key)
+{
+    const unsigned char *bytes = (const unsigned char *)key;
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(*key); i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+
+    // Zero marks an empty hash map entry
+    return hash ? hash : 1;
+}
+
+static void animation_pose_cache_evaluate_batch(
+    void *data,
+    int start_index,
+    int end_index)
+{
+    (void)data;
+
+    for (int evaluation_index = start_index; evaluation_index < end_index; evaluation_index++)
+        animation_manager_evaluate_shared_pose(animation_pose_cache_globals.evaluating_managers.elements[evaluation_index]);
+}
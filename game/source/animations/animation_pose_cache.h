@@ -0,0 +1,69 @@
+/*
+ANIMATION_POSE_CACHE.H
+    Shared animation pose cache declarations.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+
+/* ---------- constants */
+
+enum
+{
+    // Objects playing more clips at once than this evaluate their own poses
+    MAXIMUM_NUMBER_OF_POSE_CACHE_LAYERS = 4,
+
+    // Clip times snap to this many buckets per second of playback, and objects in the same bucket share a pose
+    ANIMATION_POSE_CACHE_BUCKETS_PER_SECOND = 30,
+
+    // Blend weights snap to multiples of 1 / ANIMATION_POSE_CACHE_WEIGHT_STEPS
+    ANIMATION_POSE_CACHE_WEIGHT_STEPS = 32,
+};
+
+/* ---------- types */
+
+struct animation_manager;
+
+struct animation_pose_cache_layer
+{
+    int animation_index;
+    int bucket_index;
+    short weight_step;
+    short additive;
+};
+
+/**
+ * Everything a shared pose depends on. Keys are compared bytewise, so they are always zeroed before being filled.
+ */
+struct animation_pose_cache_key
+{
+    int model_index;
+    int layer_count;
+    struct animation_pose_cache_layer layers[MAXIMUM_NUMBER_OF_POSE_CACHE_LAYERS];
+};
+
+/* ---------- prototypes/ANIMATION_POSE_CACHE.C */
+
+void animation_pose_cache_initialize(void);
+void animation_pose_cache_dispose(void);
+
+/**
+ * Forgets every pose of the previous frame. Called before the first request of a frame.
+ */
+void animation_pose_cache_begin_frame(void);
+
+/**
+ * Looks up the pose of a pose-sharing animation manager's key for the frame. The first manager to request a key
+ * evaluates the pose for every later manager with the same key, which point at its node matrices.
+ * Must be called from one thread, and in the same order every frame for results to be deterministic.
+ * @param manager The animation manager, after animation_manager_update has built its key.
+ */
+void animation_pose_cache_request(struct animation_manager *manager);
+
+/**
+ * Evaluates every pose requested this frame, in parallel, and waits for them to finish.
+ */
+void animation_pose_cache_evaluate(void);
+
+void animation_pose_cache_get_statistics(int *out_request_count, int *out_evaluation_count);
@@ -94,4 +94,9 @@ void camera_update(struct camera_data *camera)
         camera->near_clip,
         camera->far_clip,
         camera->projection);
+
+    mat4 view_projection;
+    glm_mat4_mul(camera->projection, camera->view, view_projection);
+
+    frustum_from_matrix(&camera->frustum, view_projection);
 }
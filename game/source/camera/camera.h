@@ -6,6 +6,8 @@ CAMERA.H
 #pragma once
 #include <cglm/cglm.h>
 
+#include "geometry/frustums.h"
+
 /* ---------- types */
 
 struct camera_data
@@ -25,6 +27,9 @@ struct camera_data
 
     mat4 view;
     mat4 projection;
+
+    // The planes of the view volume, in world space
+    struct frustum frustum;
 };
 
 /* ---------- prototypes/CAMERA.C */
@@ -11,10 +11,12 @@ GAME.C
 #include <SDL.h>
 
 #include "common/common.h"
+#include "common/string_ids.h"
 #include "camera/camera.h"
 #include "game/game.h"
 #include "objects/objects.h"
 #include "objects/lights.h"
+#include "animations/animation_baking.h"
 
 /* ---------- private constants */
 
@@ -52,6 +54,11 @@ struct
     int flashlight_light_index;
     int weapon_object_index;
     int grunt_object_index;
+
+    string_id first_person_moving_id;
+    string_id first_person_ready_id;
+    string_id first_person_reload_empty_id;
+    string_id first_person_melee_strike_1_id;
 } game_globals;
 
 /* ---------- private prototypes */
@@ -69,8 +76,11 @@ struct camera_data *game_get_player_camera(void)
 void game_initialize(void)
 {
     memset(&game_globals, 0, sizeof(game_globals));
-    
-    // TODO
+
+    game_globals.first_person_moving_id = string_id_intern("first_person moving");
+    game_globals.first_person_ready_id = string_id_intern("first_person ready");
+    game_globals.first_person_reload_empty_id = string_id_intern("first_person reload_empty");
+    game_globals.first_person_melee_strike_1_id = string_id_intern("first_person melee_strike_1");
 }
 
 void game_dispose(void)
@@ -94,21 +104,23 @@ void game_load_content(void)
     // Initialize grunt character
     game_globals.grunt_object_index = object_new();
     struct object_data *grunt = object_get_data(game_globals.grunt_object_index);
-    glm_vec3_copy((vec3){-5, 0, 0}, grunt->position);
-    glm_vec3_copy((vec3){0.1f, 0.1f, 0.1f}, grunt->scale);
+    object_set_position(game_globals.grunt_object_index, (vec3){-5, 0, 0});
+    object_set_scale(game_globals.grunt_object_index, (vec3){0.1f, 0.1f, 0.1f});
     grunt->model_index = model_import_from_file(_vertex_type_skinned, "../assets/models/grunt.fbx");
+    model_bake_animation(grunt->model_index, 0, ANIMATION_BAKING_DEFAULT_FRAMES_PER_SECOND);
     object_initialize(game_globals.grunt_object_index);
-    animation_manager_set_animation_looping(&grunt->animations, 0, true);
+    animation_manager_set_animation_looping(grunt->animations, 0, true);
+    animation_manager_set_sharing_poses(grunt->animations, true);
 
     // Initialize first person weapons
     game_globals.weapon_object_index = object_new();
     struct object_data *weapon = object_get_data(game_globals.weapon_object_index);
-    glm_vec3_copy((vec3){0.01f, 0.01f, 0.01f}, weapon->scale);
+    object_set_scale(game_globals.weapon_object_index, (vec3){0.01f, 0.01f, 0.01f});
     weapon->model_index = model_import_from_file(_vertex_type_skinned, "../assets/models/assault_rifle.fbx");
     object_initialize(game_globals.weapon_object_index);
 
-    int moving_animation_index = model_find_animation_by_name(weapon->model_index, "first_person moving");
-    animation_manager_set_animation_looping(&weapon->animations, moving_animation_index, true);
+    int moving_animation_index = model_find_animation(weapon->model_index, game_globals.first_person_moving_id);
+    animation_manager_set_animation_looping(weapon->animations, moving_animation_index, true);
     
     // Initialize the player camera
     camera_initialize(&game_globals.camera);
@@ -313,15 +325,15 @@ static void game_update_camera(float delta_ticks)
     
     struct object_data *weapon_object = object_get_data(game_globals.weapon_object_index);
     
-    int moving_animation_index = model_find_animation_by_name(weapon_object->model_index, "first_person moving");
-    bool moving_animation_active = animation_manager_is_animation_active(&weapon_object->animations, moving_animation_index);
+    int moving_animation_index = model_find_animation(weapon_object->model_index, game_globals.first_person_moving_id);
+    bool moving_animation_active = animation_manager_is_animation_active(weapon_object->animations, moving_animation_index);
 
     if (!moving_animation_active && movement_amount != 0.0f)
-        animation_manager_set_animation_active(&weapon_object->animations, moving_animation_index, moving_animation_active = true);
+        animation_manager_set_animation_active(weapon_object->animations, moving_animation_index, moving_animation_active = true);
     else if (moving_animation_active && movement_amount == 0.0f)
-        animation_manager_set_animation_active(&weapon_object->animations, moving_animation_index, moving_animation_active = false);
+        animation_manager_set_animation_active(weapon_object->animations, moving_animation_index, moving_animation_active = false);
 
-    animation_manager_set_animation_state_speed(&weapon_object->animations, moving_animation_index, movement_amount);
+    animation_manager_set_animation_state_speed(weapon_object->animations, moving_animation_index, movement_amount);
 
     // Apply the camera updates
     camera_update(&game_globals.camera);
@@ -335,9 +347,9 @@ static void game_update_objects(void)
 
     struct object_data *grunt_object = object_get_data(game_globals.grunt_object_index);
 
-    if (!animation_manager_is_animation_active(&grunt_object->animations, 0))
+    if (!animation_manager_is_animation_active(grunt_object->animations, 0))
     {
-        animation_manager_set_animation_active(&grunt_object->animations, 0, true);
+        animation_manager_set_animation_active(grunt_object->animations, 0, true);
     }
 
     // --------------------------------------------------------------------------------
@@ -346,29 +358,28 @@ static void game_update_objects(void)
 
     struct object_data *weapon_object = object_get_data(game_globals.weapon_object_index);
 
-    int ready_animation_index = model_find_animation_by_name(weapon_object->model_index, "first_person ready");
-    bool ready_animation_active = animation_manager_is_animation_active(&weapon_object->animations, ready_animation_index);
+    int ready_animation_index = model_find_animation(weapon_object->model_index, game_globals.first_person_ready_id);
+    bool ready_animation_active = animation_manager_is_animation_active(weapon_object->animations, ready_animation_index);
 
-    int reload_empty_animation_index = model_find_animation_by_name(weapon_object->model_index, "first_person reload_empty");
-    bool reload_empty_animation_active = animation_manager_is_animation_active(&weapon_object->animations, reload_empty_animation_index);
+    int reload_empty_animation_index = model_find_animation(weapon_object->model_index, game_globals.first_person_reload_empty_id);
+    bool reload_empty_animation_active = animation_manager_is_animation_active(weapon_object->animations, reload_empty_animation_index);
 
-    int melee_strike_1_animation_index = model_find_animation_by_name(weapon_object->model_index, "first_person melee_strike_1");
-    bool melee_strike_1_animation_active = animation_manager_is_animation_active(&weapon_object->animations, melee_strike_1_animation_index);
+    int melee_strike_1_animation_index = model_find_animation(weapon_object->model_index, game_globals.first_person_melee_strike_1_id);
+    bool melee_strike_1_animation_active = animation_manager_is_animation_active(weapon_object->animations, melee_strike_1_animation_index);
     
-    // Move the view model to the camera position + camera velocity
-    glm_vec3_copy(game_globals.camera.position, weapon_object->position);
-
-    // Apply the view model position offset
-    glm_vec3_add(weapon_object->position, (vec3){0.0f, 0.0f, -0.015f}, weapon_object->position);
+    // Move the view model to the camera position + camera velocity, with the view model position offset applied
+    vec3 weapon_position;
+    glm_vec3_add(game_globals.camera.position, (vec3){0.0f, 0.0f, -0.015f}, weapon_position);
+    object_set_position(game_globals.weapon_object_index, weapon_position);
 
     // Rotate the view model in the same direction as the camera
-    glm_vec3_copy((vec3){0.0f, -game_globals.camera.rotation[1], game_globals.camera.rotation[0]}, weapon_object->rotation);
+    object_set_rotation(game_globals.weapon_object_index, (vec3){0.0f, -game_globals.camera.rotation[1], game_globals.camera.rotation[0]});
 
     // Play the ready animation at startup if it hasn't already played
     if (!TEST_BIT(game_globals.flags, _game_played_initial_ready_animation_bit))
     {
         SET_BIT(game_globals.flags, _game_played_initial_ready_animation_bit, true);
-        animation_manager_set_animation_active(&weapon_object->animations, ready_animation_index, ready_animation_active = true);
+        animation_manager_set_animation_active(weapon_object->animations, ready_animation_index, ready_animation_active = true);
     }
 
     const uint8_t *keys = SDL_GetKeyboardState(NULL);
@@ -381,7 +392,7 @@ static void game_update_objects(void)
     else if (TEST_BIT(game_globals.flags, _game_input_1_bit))
     {
         SET_BIT(game_globals.flags, _game_input_1_bit, false);
-        animation_manager_set_animation_active(&weapon_object->animations, ready_animation_index, ready_animation_active = true);
+        animation_manager_set_animation_active(weapon_object->animations, ready_animation_index, ready_animation_active = true);
     }
 
     // Manual animation playback 2
@@ -392,7 +403,7 @@ static void game_update_objects(void)
     else if (TEST_BIT(game_globals.flags, _game_input_2_bit))
     {
         SET_BIT(game_globals.flags, _game_input_2_bit, false);
-        animation_manager_set_animation_active(&weapon_object->animations, reload_empty_animation_index, reload_empty_animation_active = true);
+        animation_manager_set_animation_active(weapon_object->animations, reload_empty_animation_index, reload_empty_animation_active = true);
     }
 
     // Manual animation playback 3
@@ -403,7 +414,7 @@ static void game_update_objects(void)
     else if (TEST_BIT(game_globals.flags, _game_input_3_bit))
     {
         SET_BIT(game_globals.flags, _game_input_3_bit, false);
-        animation_manager_set_animation_active(&weapon_object->animations, melee_strike_1_animation_index, melee_strike_1_animation_active = true);
+        animation_manager_set_animation_active(weapon_object->animations, melee_strike_1_animation_index, melee_strike_1_animation_active = true);
     }
 
     // --------------------------------------------------------------------------------
@@ -16,9 +16,56 @@ MODEL_IMPORT.C
 #include <GL/glew.h>
 
 #include "common/common.h"
+#include "common/string_ids.h"
+#include "memory/dynamic_arrays.h"
+#include "memory/hash_maps.h"
+#include "profiler/profiler.h"
+#include "animations/animation_compression.h"
 #include "models/models.h"
 #include "textures/dds.h"
 
+/* ---------- private types */
+
+struct model_import_context
+{
+    const char *directory_path;
+    enum vertex_type vertex_type;
+    const struct aiScene *scene;
+
+    DYNAMIC_ARRAY(struct material_data) materials;
+    DYNAMIC_ARRAY(struct model_node) nodes;
+    DYNAMIC_ARRAY(struct model_marker) markers;
+    DYNAMIC_ARRAY(struct model_mesh) meshes;
+    DYNAMIC_ARRAY(struct animation_data) animations;
+
+    struct hash_map node_indices_by_name;
+    struct hash_map marker_indices_by_name;
+    struct hash_map animation_indices_by_name;
+
+    // The model mesh each scene mesh became a part of and the index of its first morph target there, or -1
+    int *scene_mesh_model_mesh_indices;
+    int *scene_mesh_morph_target_starts;
+};
+
+struct model_import_morph_target
+{
+    // The part's vertices, which the deltas cover three floats per vertex
+    int vertex_start;
+    int vertex_count;
+    float *position_deltas;
+    float *normal_deltas;
+};
+
+struct model_import_mesh
+{
+    enum vertex_type vertex_type;
+
+    struct dynamic_array vertices;
+    DYNAMIC_ARRAY(int) indices;
+    DYNAMIC_ARRAY(struct model_mesh_part) parts;
+    DYNAMIC_ARRAY(struct model_import_morph_target) morph_targets;
+};
+
 /* ---------- private code */
 
 static inline char *material_get_assimp_string(
@@ -98,7 +145,21 @@ static inline void material_import_assimp_textures(
 {
     struct aiString string;
 
-    for (int i = 0, count = aiGetMaterialTextureCount(in_material, texture_type); i < count; i++)
+    int count = aiGetMaterialTextureCount(in_material, texture_type);
+
+    if (count == 0)
+        return;
+
+    DYNAMIC_ARRAY(struct material_texture) textures =
+    {
+        .count = out_material->texture_count,
+        .capacity = out_material->texture_count,
+        .elements = out_material->textures,
+    };
+
+    dynamic_array_reserve(&textures, textures.count + count);
+
+    for (int i = 0; i < count; i++)
     {
         if (texture_usage == _material_texture_usage_opacity)
         {
@@ -123,8 +184,10 @@ static inline void material_import_assimp_textures(
             texture.index = dds_import_file_as_texture2d(string.data);
         }
         
-        mempush(&out_material->texture_count, (void **)&out_material->textures, &texture, sizeof(texture), realloc);
+        dynamic_array_push(&textures, &texture);
     }
+
+    dynamic_array_release(&textures, &out_material->texture_count, &out_material->textures);
 }
 
 static void material_import_assimp_base_properties(
@@ -264,7 +327,7 @@ static void material_import_assimp_ambient_occlussion_properties(
 
 static void model_import_assimp_material(
     const struct aiMaterial *in_material,
-    struct model_data *out_model)
+    struct model_import_context *context)
 {
     struct material_data material;
     memset(&material, 0, sizeof(material));
@@ -279,12 +342,170 @@ static void model_import_assimp_material(
     material_import_assimp_emissive_properties(in_material, &material);
     material_import_assimp_ambient_occlussion_properties(in_material, &material);
 
-    mempush(&out_model->material_count, (void **)&out_model->materials, &material, sizeof(material), realloc);
+    dynamic_array_push(&context->materials, &material);
+}
+
+static int model_import_find_node_by_name(
+    struct model_import_context *context,
+    const char *node_name)
+{
+    assert(node_name);
+    return hash_map_find(&context->node_indices_by_name, string_id_find(node_name));
+}
+
+static int model_import_add_node(
+    struct model_import_context *context,
+    int parent_node_index,
+    struct model_node *child_node)
+{
+    // Nodes are stored parent-before-child so hierarchy evaluation is a single forward pass
+    assert(parent_node_index >= -1 && parent_node_index < context->nodes.count);
+    
+    child_node->parent_index = parent_node_index;
+
+    int child_node_index = context->nodes.count;
+    dynamic_array_push(&context->nodes, child_node);
+
+    hash_map_insert(&context->node_indices_by_name, string_id_intern(child_node->name), child_node_index);
+    
+    return child_node_index;
+}
+
+static int model_import_add_assimp_bone(
+    struct model_import_context *context,
+    const struct hash_map *bone_indices_by_name,
+    struct aiBone **bones,
+    int bone_index)
+{
+    const struct aiBone *in_bone = bones[bone_index];
+
+    int node_index = model_import_find_node_by_name(context, in_bone->mName.data);
+
+    if (node_index != -1)
+        return node_index;
+
+    int parent_node_index = -1;
+
+    if (in_bone->mNode && in_bone->mNode->mParent != in_bone->mArmature)
+    {
+        // Add the parent bone first, even when it only appears in a later mesh
+        int parent_bone_index = hash_map_find(bone_indices_by_name, string_id_find(in_bone->mNode->mParent->mName.data));
+
+        if (parent_bone_index != -1)
+            parent_node_index = model_import_add_assimp_bone(context, bone_indices_by_name, bones, parent_bone_index);
+    }
+
+    struct model_node node =
+    {
+        .name = strdup(in_bone->mName.data),
+        .parent_index = -1,
+        .offset_matrix = GLM_MAT4_IDENTITY_INIT,
+        .default_transform = GLM_MAT4_IDENTITY_INIT,
+    };
+
+    if (in_bone->mNode)
+        glm_mat4_copy((vec4 *)&in_bone->mNode->mTransformation, node.default_transform);
+    
+    glm_mat4_transpose(node.default_transform);
+
+    glm_mat4_copy((vec4 *)&in_bone->mOffsetMatrix, node.offset_matrix);
+    glm_mat4_transpose(node.offset_matrix);
+
+    return model_import_add_node(context, parent_node_index, &node);
+}
+
+static void model_import_assimp_bones(
+    struct model_import_context *context)
+{
+    const struct aiScene *scene = context->scene;
+
+    DYNAMIC_ARRAY(struct aiBone *) bones = { 0 };
+    struct hash_map bone_indices_by_name = { 0 };
+
+    for (unsigned int mesh_index = 0; mesh_index < scene->mNumMeshes; mesh_index++)
+    {
+        struct aiMesh *in_mesh = scene->mMeshes[mesh_index];
+
+        for (unsigned int bone_index = 0; bone_index < in_mesh->mNumBones; bone_index++)
+        {
+            struct aiBone *in_bone = in_mesh->mBones[bone_index];
+
+            if (hash_map_insert(&bone_indices_by_name, string_id_intern(in_bone->mName.data), bones.count) == bones.count)
+                dynamic_array_push(&bones, &in_bone);
+        }
+    }
+
+    for (int bone_index = 0; bone_index < bones.count; bone_index++)
+        model_import_add_assimp_bone(context, &bone_indices_by_name, bones.elements, bone_index);
+
+    hash_map_dispose(&bone_indices_by_name);
+    dynamic_array_dispose(&bones);
+}
+
+static int model_import_find_marker_by_name(
+    struct model_import_context *context,
+    const char *marker_name)
+{
+    assert(marker_name);
+    return hash_map_find(&context->marker_indices_by_name, string_id_find(marker_name));
+}
+
+static const struct aiNode *model_import_find_assimp_node_by_name(
+    const struct aiNode *in_node,
+    const char *node_name)
+{
+    if (strcmp(in_node->mName.data, node_name) == 0)
+        return in_node;
+
+    for (unsigned int child_index = 0; child_index < in_node->mNumChildren; child_index++)
+    {
+        const struct aiNode *in_child_node = model_import_find_assimp_node_by_name(in_node->mChildren[child_index], node_name);
+
+        if (in_child_node)
+            return in_child_node;
+    }
+
+    return NULL;
+}
+
+static int model_import_find_scene_mesh_by_name(
+    struct model_import_context *context,
+    const char *mesh_name)
+{
+    const struct aiScene *scene = context->scene;
+
+    for (unsigned int mesh_index = 0; mesh_index < scene->mNumMeshes; mesh_index++)
+    {
+        if (strcmp(scene->mMeshes[mesh_index]->mName.data, mesh_name) == 0)
+            return mesh_index;
+    }
+
+    // Some exporters name mesh and morph channels after the node holding the mesh instead
+    const struct aiNode *in_node = model_import_find_assimp_node_by_name(scene->mRootNode, mesh_name);
+
+    if (in_node && in_node->mNumMeshes)
+        return in_node->mMeshes[0];
+
+    return -1;
+}
+
+static int model_import_get_morph_target_index(
+    struct model_import_context *context,
+    int scene_mesh_index,
+    int anim_mesh_index)
+{
+    if (scene_mesh_index == -1 || context->scene_mesh_model_mesh_indices[scene_mesh_index] == -1)
+        return -1;
+
+    if (anim_mesh_index < 0 || anim_mesh_index >= (int)context->scene->mMeshes[scene_mesh_index]->mNumAnimMeshes)
+        return -1;
+
+    return context->scene_mesh_morph_target_starts[scene_mesh_index] + anim_mesh_index;
 }
 
 static void model_import_assimp_animation(
     const struct aiAnimation *in_animation,
-    struct model_data *out_model)
+    struct model_import_context *context)
 {
     struct animation_data animation;
     memset(&animation, 0, sizeof(animation));
@@ -301,6 +522,15 @@ static void model_import_assimp_animation(
     animation.duration = in_animation->mDuration;
     animation.ticks_per_second = in_animation->mTicksPerSecond;
 
+    int maximum_channel_count = in_animation->mNumChannels + in_animation->mNumMeshChannels + in_animation->mNumMorphMeshChannels;
+
+    DYNAMIC_ARRAY(struct animation_channel) channels = { 0 };
+    dynamic_array_reserve(&channels, maximum_channel_count);
+
+    // Node keys are read raw, then compressed into the channels once the clip's ranges are known
+    struct animation_raw_channel *raw_channels = calloc(maximum_channel_count, sizeof(*raw_channels));
+    assert(!maximum_channel_count || raw_channels);
+
     for (unsigned int channel_index = 0; channel_index < in_animation->mNumChannels; channel_index++)
     {
         struct aiNodeAnim *in_channel = in_animation->mChannels[channel_index];
@@ -308,80 +538,61 @@ static void model_import_assimp_animation(
         if (strncmp("Armature", in_channel->mNodeName.data, in_channel->mNodeName.length) == 0)
             continue; // blender hack
 
-        struct animation_channel channel;
-        memset(&channel, 0, sizeof(channel));
+        struct animation_raw_channel *raw_channel = raw_channels + channels.count;
+        struct animation_channel *channel = dynamic_array_push(&channels, NULL);
         
-        channel.type = _animation_channel_type_node;
-        
-        channel.node_index = model_find_node_by_name(out_model, in_channel->mNodeName.data);
-        assert(channel.node_index != -1);
+        channel->type = _animation_channel_type_node;
         
+        channel->node_index = model_import_find_node_by_name(context, in_channel->mNodeName.data);
+        assert(channel->node_index != -1);
+
+        animation_raw_channel_initialize(raw_channel, in_channel->mNumPositionKeys, in_channel->mNumRotationKeys, in_channel->mNumScalingKeys);
+
         for (unsigned int position_key_index = 0; position_key_index < in_channel->mNumPositionKeys; position_key_index++)
         {
             struct aiVectorKey *in_position_key = in_channel->mPositionKeys + position_key_index;
 
-            struct animation_position_key position_key =
-            {
-                .time = in_position_key->mTime,
-                .position =
-                {
-                    in_position_key->mValue.x,
-                    in_position_key->mValue.y,
-                    in_position_key->mValue.z
-                }
-            };
-
-            mempush(&channel.position_key_count, (void **)&channel.position_keys, &position_key, sizeof(position_key), realloc);
+            raw_channel->position_key_times[position_key_index] = in_position_key->mTime;
+            raw_channel->position_key_values[position_key_index][0] = in_position_key->mValue.x;
+            raw_channel->position_key_values[position_key_index][1] = in_position_key->mValue.y;
+            raw_channel->position_key_values[position_key_index][2] = in_position_key->mValue.z;
         }
 
         for (unsigned int rotation_key_index = 0; rotation_key_index < in_channel->mNumRotationKeys; rotation_key_index++)
         {
             struct aiQuatKey *in_rotation_key = in_channel->mRotationKeys + rotation_key_index;
 
-            struct animation_rotation_key rotation_key =
-            {
-                .time = in_rotation_key->mTime,
-                .rotation =
-                {
-                    in_rotation_key->mValue.x,
-                    in_rotation_key->mValue.y,
-                    in_rotation_key->mValue.z,
-                    in_rotation_key->mValue.w,
-                }
-            };
-
-            mempush(&channel.rotation_key_count, (void **)&channel.rotation_keys, &rotation_key, sizeof(rotation_key), realloc);
+            raw_channel->rotation_key_times[rotation_key_index] = in_rotation_key->mTime;
+            raw_channel->rotation_key_values[rotation_key_index][0] = in_rotation_key->mValue.x;
+            raw_channel->rotation_key_values[rotation_key_index][1] = in_rotation_key->mValue.y;
+            raw_channel->rotation_key_values[rotation_key_index][2] = in_rotation_key->mValue.z;
+            raw_channel->rotation_key_values[rotation_key_index][3] = in_rotation_key->mValue.w;
         }
 
         for (unsigned int scaling_key_index = 0; scaling_key_index < in_channel->mNumScalingKeys; scaling_key_index++)
         {
             struct aiVectorKey *in_scaling_key = in_channel->mScalingKeys + scaling_key_index;
 
-            struct animation_scaling_key scaling_key =
-            {
-                .time = in_scaling_key->mTime,
-                .scaling =
-                {
-                    in_scaling_key->mValue.x,
-                    in_scaling_key->mValue.y,
-                    in_scaling_key->mValue.z
-                }
-            };
-
-            mempush(&channel.scaling_key_count, (void **)&channel.scaling_keys, &scaling_key, sizeof(scaling_key), realloc);
+            raw_channel->scaling_key_times[scaling_key_index] = in_scaling_key->mTime;
+            raw_channel->scaling_key_values[scaling_key_index][0] = in_scaling_key->mValue.x;
+            raw_channel->scaling_key_values[scaling_key_index][1] = in_scaling_key->mValue.y;
+            raw_channel->scaling_key_values[scaling_key_index][2] = in_scaling_key->mValue.z;
         }
-
-        mempush(&animation.channel_count, (void **)&animation.channels, &channel, sizeof(channel), realloc);
     }
 
-    for (unsigned int channel_index = 0; channel_index < in_animation->mNumMorphMeshChannels; channel_index++)
+    for (unsigned int channel_index = 0; channel_index < in_animation->mNumMeshChannels; channel_index++)
     {
         struct aiMeshAnim *in_channel = in_animation->mMeshChannels[channel_index];
 
-        struct animation_channel channel;
-        memset(&channel, 0, sizeof(channel));
-        channel.type = _animation_channel_type_mesh;
-        channel.mesh_index = -1;
+        struct animation_channel *channel = dynamic_array_push(&channels, NULL);
+        channel->type = _animation_channel_type_mesh;
+
+        // Keys are remapped from the scene mesh's animation meshes to the model mesh's morph targets
+        int scene_mesh_index = model_import_find_scene_mesh_by_name(context, in_channel->mName.data);
+        channel->mesh_index = scene_mesh_index != -1 ? context->scene_mesh_model_mesh_indices[scene_mesh_index] : -1;
+
+        DYNAMIC_ARRAY(struct animation_mesh_key) mesh_keys = { 0 };
+        dynamic_array_reserve(&mesh_keys, in_channel->mNumKeys);
 
         for (unsigned int mesh_key_index = 0; mesh_key_index < in_channel->mNumKeys; mesh_key_index++)
         {
@@ -390,67 +601,175 @@ static void model_import_assimp_animation(
             struct animation_mesh_key mesh_key =
             {
                 .time = in_mesh_key->mTime,
-                .mesh_index = (int)in_mesh_key->mValue,
+                .mesh_index = model_import_get_morph_target_index(context, scene_mesh_index, (int)in_mesh_key->mValue),
             };
 
-            mempush(&channel.mesh_key_count, (void **)&channel.mesh_keys, &mesh_key, sizeof(mesh_key), realloc);
+            dynamic_array_push(&mesh_keys, &mesh_key);
         }
 
-        mempush(&animation.channel_count, (void **)&animation.channels, &channel, sizeof(channel), realloc);
+        dynamic_array_release(&mesh_keys, &channel->mesh_key_count, &channel->mesh_keys);
     }
 
-    for (unsigned int channel_index = 0; channel_index < in_animation->mNumMeshChannels; channel_index++)
+    for (unsigned int channel_index = 0; channel_index < in_animation->mNumMorphMeshChannels; channel_index++)
     {
         struct aiMeshMorphAnim *in_channel = in_animation->mMorphMeshChannels[channel_index];
 
-        struct animation_channel channel;
-        memset(&channel, 0, sizeof(channel));
-        channel.type = _animation_channel_type_morph;
-        channel.mesh_index = -1;
+        struct animation_channel *channel = dynamic_array_push(&channels, NULL);
+        channel->type = _animation_channel_type_morph;
+
+        int scene_mesh_index = model_import_find_scene_mesh_by_name(context, in_channel->mName.data);
+        channel->mesh_index = scene_mesh_index != -1 ? context->scene_mesh_model_mesh_indices[scene_mesh_index] : -1;
+
+        DYNAMIC_ARRAY(struct animation_morph_key) morph_keys = { 0 };
+        dynamic_array_reserve(&morph_keys, in_channel->mNumKeys);
 
         for (unsigned int morph_key_index = 0; morph_key_index < in_channel->mNumKeys; morph_key_index++)
         {
             struct aiMeshMorphKey *in_morph_key = in_channel->mKeys + morph_key_index;
 
-            struct animation_morph_key morph_key;
-            memset(&morph_key, 0, sizeof(morph_key));
-            morph_key.time = in_morph_key->mTime;
+            struct animation_morph_key *morph_key = dynamic_array_push(&morph_keys, NULL);
+            morph_key->time = in_morph_key->mTime;
+
+            DYNAMIC_ARRAY(int) values = { 0 };
+            DYNAMIC_ARRAY(float) weights = { 0 };
+            dynamic_array_reserve(&values, in_morph_key->mNumValuesAndWeights);
+            dynamic_array_reserve(&weights, in_morph_key->mNumValuesAndWeights);
 
             for (unsigned int i = 0; i < in_morph_key->mNumValuesAndWeights; i++)
             {
-                mempush_multiple(
-                    2,
-                    &morph_key.count,
-                    (void *[]){
-                        &morph_key.values,
-                        &morph_key.weights
-                    },
-                    (void *[]){
-                        &in_morph_key->mValues[i],
-                        &in_morph_key->mWeights[i]
-                    },
-                    (size_t[]){
-                        sizeof(in_morph_key->mValues[i]),
-                        sizeof(in_morph_key->mWeights[i])
-                    },
-                    realloc);
+                *dynamic_array_push(&values, NULL) = model_import_get_morph_target_index(context, scene_mesh_index, (int)in_morph_key->mValues[i]);
+                *dynamic_array_push(&weights, NULL) = (float)in_morph_key->mWeights[i];
             }
 
-            mempush(&channel.morph_key_count, (void **)&channel.morph_keys, &morph_key, sizeof(morph_key), realloc);
+            dynamic_array_release(&values, &morph_key->count, &morph_key->values);
+            dynamic_array_release(&weights, &morph_key->count, &morph_key->weights);
         }
 
-        mempush(&animation.channel_count, (void **)&animation.channels, &channel, sizeof(channel), realloc);
+        dynamic_array_release(&morph_keys, &channel->morph_key_count, &channel->morph_keys);
+    }
+
+    dynamic_array_release(&channels, &animation.channel_count, &animation.channels);
+
+    animation_compress(&animation, raw_channels, NULL, NULL);
+
+    for (int channel_index = 0; channel_index < animation.channel_count; channel_index++)
+        animation_raw_channel_dispose(raw_channels + channel_index);
+
+    free(raw_channels);
+
+    DYNAMIC_ARRAY(int) morph_channel_indices = { 0 };
+
+    for (int channel_index = 0; channel_index < animation.channel_count; channel_index++)
+    {
+        if (animation.channels[channel_index].type != _animation_channel_type_node)
+            dynamic_array_push(&morph_channel_indices, &channel_index);
+    }
+
+    dynamic_array_release(&morph_channel_indices, &animation.morph_channel_count, &animation.morph_channel_indices);
+
+    animation.node_channel_indices = malloc(context->nodes.count * sizeof(*animation.node_channel_indices));
+    assert(animation.node_channel_indices);
+
+    for (int node_index = 0; node_index < context->nodes.count; node_index++)
+        animation.node_channel_indices[node_index] = -1;
+
+    for (int channel_index = 0; channel_index < animation.channel_count; channel_index++)
+    {
+        struct animation_channel *channel = animation.channels + channel_index;
+
+        if (channel->type != _animation_channel_type_node)
+            continue;
+
+        assert(animation.node_channel_indices[channel->node_index] == -1);
+        animation.node_channel_indices[channel->node_index] = channel_index;
     }
 
-    mempush(&out_model->animation_count, (void **)&out_model->animations, &animation, sizeof(animation), realloc);
+    hash_map_insert(&context->animation_indices_by_name, string_id_intern(animation.name), context->animations.count);
+    dynamic_array_push(&context->animations, &animation);
+}
+
+static void model_import_assimp_morph_target(
+    const struct aiMesh *in_mesh,
+    const struct aiAnimMesh *in_anim_mesh,
+    int vertex_start,
+    struct model_import_mesh *out_mesh)
+{
+    struct model_import_morph_target *target = dynamic_array_push(&out_mesh->morph_targets, NULL);
+
+    target->vertex_start = vertex_start;
+    target->vertex_count = in_mesh->mNumVertices;
+    target->position_deltas = calloc(in_mesh->mNumVertices * 3, sizeof(*target->position_deltas));
+    target->normal_deltas = calloc(in_mesh->mNumVertices * 3, sizeof(*target->normal_deltas));
+    assert(!in_mesh->mNumVertices || (target->position_deltas && target->normal_deltas));
+
+    unsigned int vertex_count = in_anim_mesh->mNumVertices < in_mesh->mNumVertices ? in_anim_mesh->mNumVertices : in_mesh->mNumVertices;
+
+    // Animation meshes hold whole replacement vertices, which are stored as differences from the base mesh
+    for (unsigned int vertex_index = 0; vertex_index < vertex_count; vertex_index++)
+    {
+        if (in_anim_mesh->mVertices)
+        {
+            struct aiVector3D position = in_mesh->mVertices[vertex_index];
+            struct aiVector3D target_position = in_anim_mesh->mVertices[vertex_index];
+
+            target->position_deltas[(vertex_index * 3) + 0] = target_position.x - position.x;
+            target->position_deltas[(vertex_index * 3) + 1] = target_position.y - position.y;
+            target->position_deltas[(vertex_index * 3) + 2] = target_position.z - position.z;
+        }
+
+        if (in_anim_mesh->mNormals && in_mesh->mNormals)
+        {
+            struct aiVector3D normal = in_mesh->mNormals[vertex_index];
+            struct aiVector3D target_normal = in_anim_mesh->mNormals[vertex_index];
+
+            target->normal_deltas[(vertex_index * 3) + 0] = target_normal.x - normal.x;
+            target->normal_deltas[(vertex_index * 3) + 1] = target_normal.y - normal.y;
+            target->normal_deltas[(vertex_index * 3) + 2] = target_normal.z - normal.z;
+        }
+    }
+}
+
+static void model_import_mesh_morphs(
+    struct model_import_mesh *mesh,
+    struct model_mesh *out_mesh)
+{
+    int target_count = mesh->morph_targets.count;
+
+    float **position_deltas = malloc(target_count * sizeof(*position_deltas));
+    float **normal_deltas = malloc(target_count * sizeof(*normal_deltas));
+    assert(position_deltas && normal_deltas);
+
+    // Spread each part's targets over the whole mesh, then keep only the vertices they move
+    for (int target_index = 0; target_index < target_count; target_index++)
+    {
+        struct model_import_morph_target *target = mesh->morph_targets.elements + target_index;
+
+        position_deltas[target_index] = calloc(out_mesh->vertex_count * 3, sizeof(**position_deltas));
+        normal_deltas[target_index] = calloc(out_mesh->vertex_count * 3, sizeof(**normal_deltas));
+        assert(position_deltas[target_index] && normal_deltas[target_index]);
+
+        memcpy(position_deltas[target_index] + (target->vertex_start * 3), target->position_deltas, target->vertex_count * 3 * sizeof(**position_deltas));
+        memcpy(normal_deltas[target_index] + (target->vertex_start * 3), target->normal_deltas, target->vertex_count * 3 * sizeof(**normal_deltas));
+    }
+
+    animation_morph_set_build(&out_mesh->morphs, out_mesh->vertex_count, target_count, (const float *const *)position_deltas, (const float *const *)normal_deltas);
+
+    for (int target_index = 0; target_index < target_count; target_index++)
+    {
+        free(position_deltas[target_index]);
+        free(normal_deltas[target_index]);
+    }
+
+    free(position_deltas);
+    free(normal_deltas);
 }
 
 static void model_import_assimp_mesh(
     // const struct aiScene *in_scene,
     // const struct aiNode *in_node,
     const struct aiMesh *in_mesh,
-    struct model_data *out_model,
-    struct model_mesh *out_mesh)
+    struct model_import_context *context,
+    struct model_import_mesh *out_mesh)
 {
     if (in_mesh->mName.length && in_mesh->mName.data[0] == '#')
     {
@@ -460,53 +779,26 @@ static void model_import_assimp_mesh(
     struct model_mesh_part part =
     {
         .material_index = in_mesh->mMaterialIndex,
-        .vertex_start = out_mesh->vertex_count,
+        .vertex_start = out_mesh->vertices.count,
         .vertex_count = 0,
-        .index_start = out_mesh->index_count,
+        .index_start = out_mesh->indices.count,
         .index_count = 0,
     };
 
-    int node_indices[in_mesh->mNumVertices][4];
-    memset(node_indices, -1, sizeof(int) * in_mesh->mNumVertices * 4);
+    int (*node_indices)[4] = malloc(sizeof(*node_indices) * in_mesh->mNumVertices);
+    assert(node_indices);
+    memset(node_indices, -1, sizeof(*node_indices) * in_mesh->mNumVertices);
 
-    float node_weights[in_mesh->mNumVertices][4];
-    memset(node_weights, 0, sizeof(float) * in_mesh->mNumVertices * 4);
+    float (*node_weights)[4] = calloc(in_mesh->mNumVertices, sizeof(*node_weights));
+    assert(node_weights);
 
     for (unsigned int bone_index = 0; bone_index < in_mesh->mNumBones; bone_index++)
     {
         struct aiBone *in_bone = in_mesh->mBones[bone_index];
 
-        int node_index = model_find_node_by_name(out_model, in_bone->mName.data);
-
-        if (node_index == -1)
-        {
-            struct model_node node =
-            {
-                .name = strdup(in_bone->mName.data),
-                .parent_index = -1,
-                .first_child_index = -1,
-                .next_sibling_index = -1,
-                .offset_matrix = GLM_MAT4_IDENTITY_INIT,
-                .default_transform = GLM_MAT4_IDENTITY_INIT,
-            };
-
-            if (in_bone->mNode)
-                glm_mat4_copy((vec4 *)&in_bone->mNode->mTransformation, node.default_transform);
-            
-            glm_mat4_transpose(node.default_transform);
-
-            glm_mat4_copy((vec4 *)&in_bone->mOffsetMatrix, node.offset_matrix);
-            glm_mat4_transpose(node.offset_matrix);
-            
-            int parent_node_index = -1;
-            
-            if (in_bone->mNode && in_bone->mNode->mParent != in_bone->mArmature)
-                parent_node_index = model_find_node_by_name(out_model, in_bone->mNode->mParent->mName.data);
-            
-            node_index = model_node_add_child_node(out_model, parent_node_index, &node);
-        }
-
-        assert(node_index >= 0 && node_index < out_model->node_count);
+        // Every bone was added up front by model_import_assimp_bones
+        int node_index = model_import_find_node_by_name(context, in_bone->mName.data);
+        assert(node_index >= 0 && node_index < context->nodes.count);
 
         for (unsigned int weight_index = 0; weight_index < in_bone->mNumWeights; weight_index++)
         {
@@ -529,6 +821,9 @@ static void model_import_assimp_mesh(
             }
         }
     }
+
+    const struct vertex_definition *vertex_definition = vertex_definition_get(out_mesh->vertex_type);
+    void *vertices = dynamic_array_push_multiple_generic(&out_mesh->vertices, vertex_definition->size, NULL, in_mesh->mNumVertices);
     
     for (unsigned int vertex_index = 0; vertex_index < in_mesh->mNumVertices; vertex_index++)
     {
@@ -542,27 +837,25 @@ static void model_import_assimp_mesh(
         {
         case _vertex_type_rigid:
             {
-                struct vertex_rigid vertex;
-                glm_vec3_copy((vec3){position.x, position.y, position.z}, vertex.position);
-                glm_vec3_copy((vec3){normal.x, normal.y, normal.z}, vertex.normal);
-                glm_vec2_copy((vec2){texcoord.x, -texcoord.y}, vertex.texcoord);
-                glm_vec3_copy((vec3){tangent.x, tangent.y, tangent.z}, vertex.tangent);
-                glm_vec3_copy((vec3){bitangent.x, bitangent.y, bitangent.z}, vertex.bitangent);
-                mempush(&out_mesh->vertex_count, &out_mesh->vertex_data, &vertex, sizeof(vertex), realloc);
+                struct vertex_rigid *vertex = (struct vertex_rigid *)vertices + vertex_index;
+                glm_vec3_copy((vec3){position.x, position.y, position.z}, vertex->position);
+                glm_vec3_copy((vec3){normal.x, normal.y, normal.z}, vertex->normal);
+                glm_vec2_copy((vec2){texcoord.x, -texcoord.y}, vertex->texcoord);
+                glm_vec3_copy((vec3){tangent.x, tangent.y, tangent.z}, vertex->tangent);
+                glm_vec3_copy((vec3){bitangent.x, bitangent.y, bitangent.z}, vertex->bitangent);
             }
             break;
         
         case _vertex_type_skinned:
             {
-                struct vertex_skinned vertex;
-                glm_vec3_copy((vec3){position.x, position.y, position.z}, vertex.position);
-                glm_vec3_copy((vec3){normal.x, normal.y, normal.z}, vertex.normal);
-                glm_vec2_copy((vec2){texcoord.x, -texcoord.y}, vertex.texcoord);
-                glm_vec3_copy((vec3){tangent.x, tangent.y, tangent.z}, vertex.tangent);
-                glm_vec3_copy((vec3){bitangent.x, bitangent.y, bitangent.z}, vertex.bitangent);
-                memcpy(vertex.node_indices, node_indices[vertex_index], sizeof(vertex.node_indices));
-                memcpy(vertex.node_weights, node_weights[vertex_index], sizeof(vertex.node_weights));
-                mempush(&out_mesh->vertex_count, &out_mesh->vertex_data, &vertex, sizeof(vertex), realloc);
+                struct vertex_skinned *vertex = (struct vertex_skinned *)vertices + vertex_index;
+                glm_vec3_copy((vec3){position.x, position.y, position.z}, vertex->position);
+                glm_vec3_copy((vec3){normal.x, normal.y, normal.z}, vertex->normal);
+                glm_vec2_copy((vec2){texcoord.x, -texcoord.y}, vertex->texcoord);
+                glm_vec3_copy((vec3){tangent.x, tangent.y, tangent.z}, vertex->tangent);
+                glm_vec3_copy((vec3){bitangent.x, bitangent.y, bitangent.z}, vertex->bitangent);
+                memcpy(vertex->node_indices, node_indices[vertex_index], sizeof(vertex->node_indices));
+                memcpy(vertex->node_weights, node_weights[vertex_index], sizeof(vertex->node_weights));
             }
             break;
         
@@ -574,88 +867,137 @@ static void model_import_assimp_mesh(
         part.vertex_count++;
     }
 
+    free(node_indices);
+    free(node_weights);
+
+    for (unsigned int anim_mesh_index = 0; anim_mesh_index < in_mesh->mNumAnimMeshes; anim_mesh_index++)
+        model_import_assimp_morph_target(in_mesh, in_mesh->mAnimMeshes[anim_mesh_index], part.vertex_start, out_mesh);
+
+    // Faces are triangulated on import, so three indices per face is an upper bound
+    dynamic_array_reserve(&out_mesh->indices, out_mesh->indices.count + (in_mesh->mNumFaces * 3));
+
     for (unsigned int face_index = 0; face_index < in_mesh->mNumFaces; face_index++)
     {
         struct aiFace face = in_mesh->mFaces[face_index];
 
+        int *indices = dynamic_array_push_multiple(&out_mesh->indices, NULL, face.mNumIndices);
+
         for (unsigned int index_index = 0; index_index < face.mNumIndices; index_index++)
         {
-            int vertex_index = part.vertex_start + face.mIndices[index_index];
-            mempush(&out_mesh->index_count, (void **)&out_mesh->indices, &vertex_index, sizeof(int), realloc);
+            indices[index_index] = part.vertex_start + face.mIndices[index_index];
         }
 
         part.index_count += face.mNumIndices;
     }
 
-    mempush(&out_mesh->part_count, (void **)&out_mesh->parts, &part, sizeof(part), realloc);
+    dynamic_array_push(&out_mesh->parts, &part);
 }
 
 static void model_import_assimp_node(
-    const char *directory_path,
-    enum vertex_type vertex_type,
-    const struct aiScene *in_scene,
-    const struct aiNode *in_node,
-    struct model_data *out_model)
+    struct model_import_context *context,
+    const struct aiNode *in_node)
 {
-    struct model_mesh mesh;
+    struct model_import_mesh mesh;
     memset(&mesh, 0, sizeof(mesh));
 
-    mesh.vertex_type = vertex_type;
+    mesh.vertex_type = context->vertex_type;
+
+    const struct vertex_definition *vertex_definition = vertex_definition_get(mesh.vertex_type);
+    int vertex_count = 0;
+
+    for (unsigned int mesh_index = 0; mesh_index < in_node->mNumMeshes; mesh_index++)
+    {
+        vertex_count += context->scene->mMeshes[in_node->mMeshes[mesh_index]]->mNumVertices;
+    }
+
+    dynamic_array_reserve_generic(&mesh.vertices, vertex_definition->size, vertex_count);
+    dynamic_array_reserve(&mesh.parts, in_node->mNumMeshes);
 
     for (unsigned int mesh_index = 0; mesh_index < in_node->mNumMeshes; mesh_index++)
     {
-        struct aiMesh *in_mesh = in_scene->mMeshes[in_node->mMeshes[mesh_index]];
+        struct aiMesh *in_mesh = context->scene->mMeshes[in_node->mMeshes[mesh_index]];
 
-        model_import_assimp_mesh(/*in_scene, in_node,*/ in_mesh, out_model, &mesh);
+        context->scene_mesh_morph_target_starts[in_node->mMeshes[mesh_index]] = mesh.morph_targets.count;
+        model_import_assimp_mesh(/*in_scene, in_node,*/ in_mesh, context, &mesh);
     }
     
-    if (mesh.vertex_data)
+    if (mesh.vertices.count)
+    {
+        for (unsigned int mesh_index = 0; mesh_index < in_node->mNumMeshes; mesh_index++)
+            context->scene_mesh_model_mesh_indices[in_node->mMeshes[mesh_index]] = context->meshes.count;
+
+        struct model_mesh *out_mesh = dynamic_array_push(&context->meshes, NULL);
+
+        out_mesh->vertex_type = mesh.vertex_type;
+        dynamic_array_release_generic(&mesh.vertices, vertex_definition->size, &out_mesh->vertex_count, &out_mesh->vertex_data);
+        dynamic_array_release(&mesh.indices, &out_mesh->index_count, &out_mesh->indices);
+        dynamic_array_release(&mesh.parts, &out_mesh->part_count, &out_mesh->parts);
+
+        if (mesh.morph_targets.count)
+            model_import_mesh_morphs(&mesh, out_mesh);
+    }
+    else
+    {
+        dynamic_array_dispose(&mesh.vertices);
+        dynamic_array_dispose(&mesh.indices);
+        dynamic_array_dispose(&mesh.parts);
+    }
+
+    for (int target_index = 0; target_index < mesh.morph_targets.count; target_index++)
     {
-        mempush(&out_model->mesh_count, (void **)&out_model->meshes, &mesh, sizeof(mesh), realloc);
+        free(mesh.morph_targets.elements[target_index].position_deltas);
+        free(mesh.morph_targets.elements[target_index].normal_deltas);
     }
 
+    dynamic_array_dispose(&mesh.morph_targets);
+
     for (unsigned int child_index = 0; child_index < in_node->mNumChildren; child_index++)
     {
-        model_import_assimp_node(directory_path, vertex_type, in_scene, in_node->mChildren[child_index], out_model);
+        model_import_assimp_node(context, in_node->mChildren[child_index]);
     }
 }
 
 static void model_import_markers_from_assimp_node(
-    const char *directory_path,
-    enum vertex_type vertex_type,
-    const struct aiScene *in_scene,
-    const struct aiNode *in_node,
-    struct model_data *out_model)
+    struct model_import_context *context,
+    const struct aiNode *in_node)
 {
-    struct model_mesh mesh;
-    memset(&mesh, 0, sizeof(mesh));
-
-    mesh.vertex_type = vertex_type;
-
     for (unsigned int mesh_index = 0; mesh_index < in_node->mNumMeshes; mesh_index++)
     {
-        struct aiMesh *in_mesh = in_scene->mMeshes[in_node->mMeshes[mesh_index]];
+        struct aiMesh *in_mesh = context->scene->mMeshes[in_node->mMeshes[mesh_index]];
 
         if ((in_mesh->mName.length && in_mesh->mName.data[0] == '#') &&
-            model_find_marker_by_name(out_model, in_mesh->mName.data + 1) == -1)
+            model_import_find_marker_by_name(context, in_mesh->mName.data + 1) == -1)
         {
             struct model_marker marker;
             memset(&marker, 0, sizeof(marker));
 
             assert(marker.name = strndup(in_mesh->mName.data + 1, in_mesh->mName.length - 1));
-            marker.node_index = model_find_node_by_name(out_model, in_node->mParent->mName.data);
+            marker.node_index = model_import_find_node_by_name(context, in_node->mParent->mName.data);
 
+            // The marker's node holds its offset from the node it is attached to
             mat4 marker_matrix;
-            glm_mat4_copy((vec4 *)&in_node->mParent->mTransformation, marker_matrix);
+            glm_mat4_copy((vec4 *)&in_node->mTransformation, marker_matrix);
             glm_mat4_transpose(marker_matrix);
 
+            // Markers under a node that is not a bone are placed relative to the model's origin instead
+            if (marker.node_index == -1)
+            {
+                for (const struct aiNode *in_parent = in_node->mParent; in_parent; in_parent = in_parent->mParent)
+                {
+                    mat4 parent_matrix;
+                    glm_mat4_copy((vec4 *)&in_parent->mTransformation, parent_matrix);
+                    glm_mat4_transpose(parent_matrix);
+                    glm_mat4_mul(parent_matrix, marker_matrix, marker_matrix);
+                }
+            }
+
             vec4 marker_translation;
             mat4 marker_rotation_matrix;
-            glm_vec3_copy(*(vec3 *)&marker_translation, marker.position);
+            vec3 marker_scale;
+            glm_decompose(marker_matrix, marker_translation, marker_rotation_matrix, marker_scale);
+            glm_vec3_copy(marker_translation, marker.position);
             glm_euler_angles(marker_rotation_matrix, marker.rotation);
 
-            // TODO: get position/rotation from marker_transform
-
             // printf("marker \"%s\":\n"
             //     "\tnode_index: %i (from node \"%s\")\n"
             //     "\tposition: { x: %f, y: %f, z: %f }\n"
@@ -665,15 +1007,92 @@ static void model_import_markers_from_assimp_node(
             //     marker.position[0], marker.position[1], marker.position[2],
             //     marker.rotation[0], marker.rotation[1], marker.rotation[2]);
 
-            mempush(&out_model->marker_count, (void **)&out_model->markers, &marker, sizeof(marker), realloc);
+            hash_map_insert(&context->marker_indices_by_name, string_id_intern(marker.name), context->markers.count);
+            dynamic_array_push(&context->markers, &marker);
             return;
         }
     }
     
     for (unsigned int child_index = 0; child_index < in_node->mNumChildren; child_index++)
     {
-        model_import_markers_from_assimp_node(directory_path, vertex_type, in_scene, in_node->mChildren[child_index], out_model);
+        model_import_markers_from_assimp_node(context, in_node->mChildren[child_index]);
+    }
+}
+
+static void model_import_compute_bounds(
+    struct model_data *model)
+{
+    aabb_clear(&model->bounds);
+    aabb_clear(&model->unskinned_bounds);
+
+    for (int node_index = 0; node_index < model->node_count; node_index++)
+        aabb_clear(&model->nodes[node_index].skinned_bounds);
+
+    for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
+    {
+        struct model_mesh *mesh = model->meshes + mesh_index;
+        const struct vertex_definition *vertex_definition = vertex_definition_get(mesh->vertex_type);
+
+        // Positions are the first member of every vertex type
+        aabb_clear(&mesh->bounds);
+        aabb_add_points(&mesh->bounds, mesh->vertex_data, vertex_definition->size, mesh->vertex_count);
+        bounding_sphere_from_points(mesh->vertex_data, vertex_definition->size, mesh->vertex_count, &mesh->bounding_sphere);
+
+        aabb_add_aabb(&model->bounds, &mesh->bounds);
+
+        for (int part_index = 0; part_index < mesh->part_count; part_index++)
+        {
+            struct model_mesh_part *part = mesh->parts + part_index;
+            const char *part_vertices = (const char *)mesh->vertex_data + (part->vertex_start * vertex_definition->size);
+
+            aabb_clear(&part->bounds);
+            aabb_add_points(&part->bounds, part_vertices, vertex_definition->size, part->vertex_count);
+            bounding_sphere_from_points(part_vertices, vertex_definition->size, part->vertex_count, &part->bounding_sphere);
+        }
+
+        if (mesh->vertex_type != _vertex_type_skinned)
+        {
+            aabb_add_aabb(&model->unskinned_bounds, &mesh->bounds);
+            continue;
+        }
+
+        // A skinned vertex is a weighted average of its position in each influencing node's space, so the union of
+        // every node's bounds, each moved by its node, always contains it
+        for (int vertex_index = 0; vertex_index < mesh->vertex_count; vertex_index++)
+        {
+            struct vertex_skinned *vertex = (struct vertex_skinned *)mesh->vertex_data + vertex_index;
+            bool skinned = false;
+
+            for (int influence_index = 0; influence_index < 4; influence_index++)
+            {
+                int node_index = vertex->node_indices[influence_index];
+
+                if (node_index < 0 || node_index >= model->node_count || vertex->node_weights[influence_index] <= 0.0f)
+                    continue;
+
+                struct model_node *node = model->nodes + node_index;
+
+                vec3 node_position;
+                glm_mat4_mulv3(node->offset_matrix, vertex->position, 1.0f, node_position);
+                aabb_add_point(&node->skinned_bounds, node_position);
+
+                skinned = true;
+            }
+
+            if (!skinned)
+                aabb_add_point(&model->unskinned_bounds, vertex->position);
+        }
+    }
+
+    model->has_skinned_bounds = false;
+
+    for (int node_index = 0; node_index < model->node_count; node_index++)
+    {
+        if (!aabb_is_empty(&model->nodes[node_index].skinned_bounds))
+            model->has_skinned_bounds = true;
     }
+
+    bounding_sphere_from_aabb(&model->bounds, &model->bounding_sphere);
 }
 
 /* ---------- public code */
@@ -682,6 +1101,8 @@ int model_import_from_file(
     enum vertex_type vertex_type,
     const char *file_path)
 {
+    PROFILER_FUNCTION();
+
     assert(file_path);
 
     const struct aiScene *scene = aiImportFile(
@@ -721,26 +1142,83 @@ int model_import_from_file(
         directory_path = strdup("./");
     }
 
-    int model_index = model_new();
-    struct model_data *model = model_get_data(model_index);
+    struct model_import_context context;
+    memset(&context, 0, sizeof(context));
+
+    context.directory_path = directory_path;
+    context.vertex_type = vertex_type;
+    context.scene = scene;
+
+    dynamic_array_reserve(&context.materials, scene->mNumMaterials);
 
     for (unsigned int material_index = 0; material_index < scene->mNumMaterials; material_index++)
     {
         struct aiMaterial *material = scene->mMaterials[material_index];
-        model_import_assimp_material(material, model);
+        model_import_assimp_material(material, &context);
+    }
+
+    context.scene_mesh_model_mesh_indices = malloc(scene->mNumMeshes * sizeof(*context.scene_mesh_model_mesh_indices));
+    context.scene_mesh_morph_target_starts = malloc(scene->mNumMeshes * sizeof(*context.scene_mesh_morph_target_starts));
+    assert(!scene->mNumMeshes || (context.scene_mesh_model_mesh_indices && context.scene_mesh_morph_target_starts));
+
+    for (unsigned int mesh_index = 0; mesh_index < scene->mNumMeshes; mesh_index++)
+    {
+        context.scene_mesh_model_mesh_indices[mesh_index] = -1;
+        context.scene_mesh_morph_target_starts[mesh_index] = -1;
     }
 
-    model_import_assimp_node(directory_path, vertex_type, scene, scene->mRootNode, model);
-    model_import_markers_from_assimp_node(directory_path, vertex_type, scene, scene->mRootNode, model);
+    model_import_assimp_bones(&context);
+    model_import_assimp_node(&context, scene->mRootNode);
+    model_import_markers_from_assimp_node(&context, scene->mRootNode);
+
+    dynamic_array_reserve(&context.animations, scene->mNumAnimations);
 
     for (unsigned int animation_index = 0; animation_index < scene->mNumAnimations; animation_index++)
     {
         struct aiAnimation *animation = scene->mAnimations[animation_index];
-        model_import_assimp_animation(animation, model);
+        model_import_assimp_animation(animation, &context);
     }
 
     aiReleaseImport(scene);
     free(directory_path);
+    free(context.scene_mesh_model_mesh_indices);
+    free(context.scene_mesh_morph_target_starts);
+
+    int model_index = model_new();
+    struct model_data *model = model_get_data(model_index);
+
+    dynamic_array_release(&context.materials, &model->material_count, &model->materials);
+    dynamic_array_release(&context.nodes, &model->node_count, &model->nodes);
+    dynamic_array_release(&context.markers, &model->marker_count, &model->markers);
+    dynamic_array_release(&context.meshes, &model->mesh_count, &model->meshes);
+    dynamic_array_release(&context.animations, &model->animation_count, &model->animations);
+
+    model_import_compute_bounds(model);
+
+    model->node_parent_indices = malloc(model->node_count * sizeof(*model->node_parent_indices));
+    assert(!model->node_count || model->node_parent_indices);
+
+    animation_pose_buffer_initialize(&model->default_pose, model->node_count, NULL);
+
+    for (int node_index = 0; node_index < model->node_count; node_index++)
+    {
+        struct model_node *node = model->nodes + node_index;
+        struct animation_node_state node_state;
+
+        model->node_parent_indices[node_index] = node->parent_index;
+
+        vec4 position;
+        mat4 rotation_matrix;
+        glm_decompose(node->default_transform, position, rotation_matrix, node_state.scale);
+        glm_vec3_copy(position, node_state.position);
+        glm_mat4_quat(rotation_matrix, node_state.rotation);
+
+        animation_pose_buffer_set_node_state(&model->default_pose, node_index, &node_state);
+    }
+
+    model->node_indices_by_name = context.node_indices_by_name;
+    model->marker_indices_by_name = context.marker_indices_by_name;
+    model->animation_indices_by_name = context.animation_indices_by_name;
     
     return model_index;
 }
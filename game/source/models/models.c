@@ -7,15 +7,19 @@ MODELS.C
 #include <stdlib.h>
 #include <string.h>
 
+#include <GL/glew.h>
+
 #include "common/common.h"
+#include "memory/handle_pools.h"
 #include "models/models.h"
+#include "rasterizer/rasterizer_textures.h"
+#include "animations/animation_baking.h"
 
 /* ---------- private variables */
 
 struct
 {
-    int model_count;
-    struct model_data *models;
+    struct handle_pool models;
 } static model_globals;
 
 /* ---------- public code */
@@ -23,35 +27,124 @@ struct
 void models_initialize(void)
 {
     memset(&model_globals, 0, sizeof(model_globals));
+
+    handle_pool_initialize(&model_globals.models, sizeof(struct model_data), DEFAULT_HANDLE_POOL_BLOCK_SIZE);
 }
 
 void models_dispose(void)
 {
-    for (int model_index = 0; model_index < model_globals.model_count; model_index++)
+    int model_index;
+
+    while ((model_index = handle_pool_iterate(&model_globals.models, -1)) != -1)
     {
         model_delete(model_index);
     }
 
-    free(model_globals.models);
+    handle_pool_dispose(&model_globals.models);
 }
 
 int model_new(void)
 {
-    struct model_data model;
-    memset(&model, 0, sizeof(model));
-    
-    int model_index = model_globals.model_count;
-    mempush(&model_globals.model_count, (void **)&model_globals.models, &model, sizeof(model), realloc);
-    
-    return model_index;
+    return handle_pool_allocate(&model_globals.models);
 }
 
 void model_delete(int model_index)
 {
+    if (model_index == -1)
+        return;
+
     struct model_data *model = model_get_data(model_index);
     assert(model);
 
-    // TODO
+    for (int material_index = 0; material_index < model->material_count; material_index++)
+    {
+        struct material_data *material = model->materials + material_index;
+
+        for (int texture_index = 0; texture_index < material->texture_count; texture_index++)
+            texture_delete(material->textures[texture_index].index);
+
+        free(material->textures);
+
+        free(material->base_properties.name);
+        free(material->base_properties.global_background_image);
+        free(material->base_properties.global_shaderlang);
+        free(material->base_properties.shader_vertex);
+        free(material->base_properties.shader_fragment);
+        free(material->base_properties.shader_geo);
+        free(material->base_properties.shader_tesselation);
+        free(material->base_properties.shader_primitive);
+        free(material->base_properties.shader_compute);
+    }
+
+    for (int node_index = 0; node_index < model->node_count; node_index++)
+        free(model->nodes[node_index].name);
+
+    for (int marker_index = 0; marker_index < model->marker_count; marker_index++)
+        free(model->markers[marker_index].name);
+
+    for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
+    {
+        struct model_mesh *mesh = model->meshes + mesh_index;
+
+        glDeleteVertexArrays(1, &mesh->vertex_array);
+        glDeleteBuffers(1, &mesh->vertex_buffer);
+        glDeleteBuffers(1, &mesh->index_buffer);
+
+        free(mesh->vertex_data);
+        free(mesh->indices);
+        free(mesh->parts);
+        animation_morph_set_dispose(&mesh->morphs);
+    }
+
+    for (int animation_index = 0; animation_index < model->animation_count; animation_index++)
+    {
+        struct animation_data *animation = model->animations + animation_index;
+
+        for (int channel_index = 0; channel_index < animation->channel_count; channel_index++)
+        {
+            struct animation_channel *channel = animation->channels + channel_index;
+
+            for (int key_index = 0; key_index < channel->morph_key_count; key_index++)
+            {
+                free(channel->morph_keys[key_index].values);
+                free(channel->morph_keys[key_index].weights);
+            }
+
+            free(channel->position_key_times);
+            free(channel->position_key_values);
+            free(channel->rotation_key_times);
+            free(channel->rotation_key_values);
+            free(channel->scaling_key_times);
+            free(channel->scaling_key_values);
+            free(channel->mesh_keys);
+            free(channel->morph_keys);
+        }
+
+        free(animation->name);
+        free(animation->channels);
+        free(animation->node_channel_indices);
+        free(animation->morph_channel_indices);
+        animation_unbake(animation);
+    }
+
+    free(model->materials);
+    free(model->nodes);
+    free(model->markers);
+    free(model->meshes);
+    free(model->animations);
+    free(model->node_parent_indices);
+    animation_pose_buffer_dispose(&model->default_pose);
+
+    hash_map_dispose(&model->node_indices_by_name);
+    hash_map_dispose(&model->marker_indices_by_name);
+    hash_map_dispose(&model->animation_indices_by_name);
+
+    handle_pool_dispose(&model->animation_node_state_pool);
+
+    for (int lod = 0; lod < NUMBER_OF_ANIMATION_LODS; lod++)
+        free(model->animation_lod_node_masks[lod]);
+
+    handle_pool_free(&model_globals.models, model_index);
 }
 
 struct model_data *model_get_data(int model_index)
@@ -59,8 +152,10 @@ struct model_data *model_get_data(int model_index)
     if (model_index == -1)
         return NULL;
     
-    assert(model_index >= 0 && model_index < model_globals.model_count);
-    return model_globals.models + model_index;
+    struct model_data *model = handle_pool_get(&model_globals.models, model_index);
+    assert(model);
+
+    return model;
 }
 
 void model_iterator_new(struct model_iterator *iterator)
@@ -75,124 +170,86 @@ int model_iterator_next(struct model_iterator *iterator)
 {
     assert(iterator);
 
-    if (++iterator->index >= model_globals.model_count)
-    {
-        iterator->data = NULL;
-        iterator->index = -1;
-        return -1;
-    }
+    int model_index = handle_pool_iterate(&model_globals.models, iterator->index);
 
-    int model_index = iterator->index;
-    iterator->data = model_globals.models + model_index;
+    iterator->index = model_index;
+    iterator->data = handle_pool_get(&model_globals.models, model_index);
     
     return model_index;
 }
 
-int model_get_root_node(
-    struct model_data *model)
+int model_find_node(
+    struct model_data *model,
+    string_id node_name_id)
 {
     assert(model);
-
-    for (int node_index = 0; node_index < model->node_count; node_index++)
-    {
-        struct model_node *node = model->nodes + node_index;
-
-        if (node->parent_index == -1)
-            return node_index;
-    }
-
-    return -1;
+    return hash_map_find(&model->node_indices_by_name, node_name_id);
 }
 
 int model_find_node_by_name(
     struct model_data *model,
     const char *node_name)
 {
-    assert(model);
     assert(node_name);
-
-    for (int node_index = 0; node_index < model->node_count; node_index++)
-    {
-        struct model_node *node = model->nodes + node_index;
-
-        if (strcmp(node_name, node->name) == 0)
-            return node_index;
-    }
-
-    return -1;
+    return model_find_node(model, string_id_find(node_name));
 }
 
-int model_node_add_child_node(
+int model_find_marker(
     struct model_data *model,
-    int node_index,
-    struct model_node *child_node)
+    string_id marker_name_id)
 {
-    assert(model->node_count < MAXIMUM_NUMBER_OF_MODEL_NODES);
-    
-    child_node->parent_index = node_index;
-
-    int child_node_index = model->node_count;
-    mempush(&model->node_count, (void **)&model->nodes, child_node, sizeof(*child_node), realloc);
-
-    if (node_index == -1)
-        return child_node_index;
-
-    struct model_node *node = model->nodes + node_index;
-
-    if (node->first_child_index == -1)
-    {
-        node->first_child_index = child_node_index;
-        return child_node_index;
-    }
-
-    for (node = model->nodes + node->first_child_index; ; node = model->nodes + node->next_sibling_index)
-    {
-        if (node->next_sibling_index == -1)
-        {
-            node->next_sibling_index = child_node_index;
-            break;
-        }
-    }
-    
-    return child_node_index;
+    assert(model);
+    return hash_map_find(&model->marker_indices_by_name, marker_name_id);
 }
 
 int model_find_marker_by_name(
     struct model_data *model,
     const char *marker_name)
 {
-    assert(model);
     assert(marker_name);
-
-    for (int marker_index = 0; marker_index < model->marker_count; marker_index++)
-    {
-        struct model_marker *marker = model->markers + marker_index;
-
-        if (strcmp(marker_name, marker->name) == 0)
-            return marker_index;
-    }
-
-    return -1;
+    return model_find_marker(model, string_id_find(marker_name));
 }
 
-int model_find_animation_by_name(
+int model_find_animation(
     int model_index,
-    const char *animation_name)
+    string_id animation_name_id)
 {
     if (model_index == -1)
         return -1;
     
     struct model_data *model = model_get_data(model_index);
     assert(model);
+
+    return hash_map_find(&model->animation_indices_by_name, animation_name_id);
+}
+
+int model_find_animation_by_name(
+    int model_index,
+    const char *animation_name)
+{
     assert(animation_name);
+    return model_find_animation(model_index, string_id_find(animation_name));
+}
 
-    for (int animation_index = 0; animation_index < model->animation_count; animation_index++)
-    {
-        struct animation_data *animation = model->animations + animation_index;
+void model_bake_animation(
+    int model_index,
+    int animation_index,
+    float frames_per_second)
+{
+    struct model_data *model = model_get_data(model_index);
+    assert(model);
+    assert(animation_index >= 0 && animation_index < model->animation_count);
 
-        if (strcmp(animation_name, animation->name) == 0)
-            return animation_index;
-    }
+    animation_bake(model->animations + animation_index, &model->default_pose, frames_per_second);
+}
+
+void model_unbake_animation(
+    int model_index,
+    int animation_index)
+{
+    struct model_data *model = model_get_data(model_index);
+    assert(model);
+    assert(animation_index >= 0 && animation_index < model->animation_count);
 
-    return -1;
+    animation_unbake(model->animations + animation_index);
 }
@@ -9,14 +9,22 @@ MODELS.H
 
 #include <cglm/cglm.h>
 
+#include "common/string_ids.h"
+#include "memory/handle_pools.h"
+#include "memory/hash_maps.h"
 #include "models/model_materials.h"
 #include "rasterizer/rasterizer_vertices.h"
 #include "animations/animation_data.h"
+#include "animations/animation_manager.h"
+#include "animations/animation_morphs.h"
+#include "animations/animation_poses.h"
+#include "geometry/bounding_volumes.h"
 
 /* ---------- constants */
 
 enum
 {
+    // The most node matrices a skinned draw can upload; models themselves may have any number of nodes
     MAXIMUM_NUMBER_OF_MODEL_NODES = 256,
 };
 
@@ -34,6 +42,30 @@ struct model_data
     struct model_marker *markers;
     struct model_mesh *meshes;
     struct animation_data *animations;
+
+    // Each node's parent index, or -1 for roots. Nodes are ordered parent-before-child.
+    int *node_parent_indices;
+
+    // The bounds of every mesh in the bind pose
+    struct aabb bounds;
+    struct bounding_sphere bounding_sphere;
+
+    // Whether any node has skinned bounds, and the bounds of the skinned vertices no node moves
+    bool has_skinned_bounds;
+    struct aabb unskinned_bounds;
+
+    // Each node's default_transform decomposed, which nodes fall back to when no animation channel drives them
+    struct animation_pose_buffer default_pose;
+
+    struct hash_map node_indices_by_name;
+    struct hash_map marker_indices_by_name;
+    struct hash_map animation_indices_by_name;
+
+    // Per-node pose storage handed out to animation states while they are active
+    struct handle_pool animation_node_state_pool;
+
+    // A bit vector per animation level of detail of the nodes it samples, built by the first animation manager of the model
+    unsigned int *animation_lod_node_masks[NUMBER_OF_ANIMATION_LODS];
 };
 
 struct model_iterator
@@ -46,12 +78,14 @@ struct model_node
 {
     char *name;
 
+    // Always less than the node's own index, or -1 for a root
     int parent_index;
-    int first_child_index;
-    int next_sibling_index;
     
     mat4 offset_matrix;
     mat4 default_transform;
+
+    // The vertices this node skins, in the node's own space, or empty when it skins none
+    struct aabb skinned_bounds;
 };
 
 struct model_marker
@@ -60,6 +94,7 @@ struct model_marker
 
     int node_index;
 
+    // The offset from the marker's node, or from the model's origin when node_index is -1, with rotation as XYZ euler angles in radians
     vec3 position;
     vec3 rotation;
 };
@@ -75,11 +110,17 @@ struct model_mesh
 
     int part_count;
     struct model_mesh_part *parts;
+
+    // The morph targets of every part, with each part's targets following the previous part's
+    struct animation_morph_set morphs;
+
+    // In the bind pose, before any morph target
+    struct aabb bounds;
+    struct bounding_sphere bounding_sphere;
     
     unsigned int vertex_array;
     unsigned int vertex_buffer;
     unsigned int index_buffer;
-    unsigned int uniform_buffer;
 };
 
 struct model_mesh_part
@@ -91,6 +132,10 @@ struct model_mesh_part
 
     int index_start;
     int index_count;
+
+    // In the bind pose, before any morph target
+    struct aabb bounds;
+    struct bounding_sphere bounding_sphere;
 };
 
 /* ---------- prototypes/MODELS.C */
@@ -106,15 +151,18 @@ struct model_data *model_get_data(int model_index);
 void model_iterator_new(struct model_iterator *iterator);
 int model_iterator_next(struct model_iterator *iterator);
 
-int model_get_root_node(struct model_data *model);
+int model_find_node(struct model_data *model, string_id node_name_id);
 int model_find_node_by_name(struct model_data *model, const char *node_name);
 
-int model_node_add_child_node(struct model_data *model, int node_index, struct model_node *child_node);
-
+int model_find_marker(struct model_data *model, string_id marker_name_id);
 int model_find_marker_by_name(struct model_data *model, const char *marker_name);
 
+int model_find_animation(int model_index, string_id animation_name_id);
 int model_find_animation_by_name(int model_index, const char *animation_name);
 
+void model_bake_animation(int model_index, int animation_index, float frames_per_second);
+void model_unbake_animation(int model_index, int animation_index);
+
 /* ---------- prototypes/MODEL_IMPORT.C */
 
 int model_import_from_file(enum vertex_type vertex_type, const char *file_path);
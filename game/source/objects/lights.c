@@ -11,14 +11,14 @@ LIGHTS.C
 #include <string.h>
 
 #include "common/common.h"
+#include "memory/handle_pools.h"
 #include "objects/lights.h"
 
 /* ---------- private variables */
 
 struct
 {
-    int light_count;
-    struct light_data *lights;
+    struct handle_pool lights;
 } static light_globals;
 
 /* ---------- public code */
@@ -26,28 +26,26 @@ struct
 void lights_initialize(void)
 {
     memset(&light_globals, 0, sizeof(light_globals));
+
+    handle_pool_initialize(&light_globals.lights, sizeof(struct light_data), DEFAULT_HANDLE_POOL_BLOCK_SIZE);
 }
 
 void lights_dispose(void)
 {
-    free(light_globals.lights);
+    handle_pool_dispose(&light_globals.lights);
 }
 
 int light_new(void)
 {
-    struct light_data light;
-    memset(&light, 0, sizeof(light));
-
-    int light_index = light_globals.light_count;
-    mempush(&light_globals.light_count, (void **)&light_globals.lights, &light, sizeof(light), realloc);
-
-    return light_index;
+    return handle_pool_allocate(&light_globals.lights);
 }
 
 void light_delete(int light_index)
 {
-    assert(light_index >= 0 && light_index < light_globals.light_count);
-    // TODO
+    if (light_index == -1)
+        return;
+
+    handle_pool_free(&light_globals.lights, light_index);
 }
 
 struct light_data *light_get_data(int light_index)
@@ -55,8 +53,10 @@ struct light_data *light_get_data(int light_index)
     if (light_index == -1)
         return NULL;
     
-    assert(light_index >= 0 && light_index < light_globals.light_count);
-    return light_globals.lights + light_index;
+    struct light_data *light = handle_pool_get(&light_globals.lights, light_index);
+    assert(light);
+
+    return light;
 }
 
 void light_iterator_new(struct light_iterator *iterator)
@@ -71,15 +71,10 @@ int light_iterator_next(struct light_iterator *iterator)
 {
     assert(iterator);
 
-    if (++iterator->index >= light_globals.light_count)
-    {
-        iterator->data = NULL;
-        iterator->index = -1;
-        return -1;
-    }
+    int light_index = handle_pool_iterate(&light_globals.lights, iterator->index);
 
-    int light_index = iterator->index;
-    iterator->data = light_globals.lights + light_index;
+    iterator->index = light_index;
+    iterator->data = handle_pool_get(&light_globals.lights, light_index);
     
     return light_index;
 }
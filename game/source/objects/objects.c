@@ -8,58 +8,160 @@ OBJECTS.C
 #include <string.h>
 
 #include "common/common.h"
+#include "jobs/jobs.h"
+#include "memory/dynamic_arrays.h"
+#include "memory/handle_pools.h"
+#include "memory/heap.h"
+#include "profiler/profiler.h"
+#include "game/game.h"
+#include "animations/animation_pose_cache.h"
 #include "objects/objects.h"
 
+/* ---------- private constants */
+
+enum
+{
+    // Enough objects per job that a batch outweighs the cost of scheduling it
+    OBJECT_UPDATE_BATCH_SIZE = 8,
+};
+
+// How far an object can move past its bounds before its proxy in the spatial tree has to be reinserted
+#define OBJECT_SPATIAL_TREE_MARGIN 0.25f
+
 /* ---------- private variables */
 
 struct
 {
-    int object_count;
-    struct object_data *objects;
+    // Maps each object handle to the object's position in the arrays below
+    struct handle_pool handles;
+
+    // Only live objects, packed in parallel arrays; deleting an object moves the last object into its place
+    DYNAMIC_ARRAY(int) object_indices;
+    DYNAMIC_ARRAY(struct object_data) objects;
+    DYNAMIC_ARRAY(struct object_cold_data) cold_objects;
+
+    // Incremented by every objects_update_transforms, so each object is only visited once per call
+    unsigned int transform_update_index;
+
+    // Every object with bounds, and the proxies whose bounds changed in the current objects_update_transforms
+    struct aabb_tree spatial_tree;
+    DYNAMIC_ARRAY(int) moved_proxy_indices;
+    DYNAMIC_ARRAY(struct aabb) moved_proxy_bounds;
+
+    struct animation_lod_counters animation_lod_counters;
 } static object_globals;
 
+/* ---------- private types */
+
+struct objects_update_context
+{
+    float delta_ticks;
+    const struct camera_data *camera;
+};
+
+/* ---------- private prototypes */
+
+static void objects_update_batch(void *data, int start_index, int end_index);
+static float object_get_screen_size(const struct object_data *object, const struct camera_data *camera);
+static int object_get_position(int object_index);
+static void object_update_world_matrix(struct object_data *object);
+static void object_get_local_matrix(const struct object_data *object, mat4 out_matrix);
+static bool object_update_world_bounds(struct object_data *object);
+static void objects_update_spatial_tree(void);
+
 /* ---------- public code */
 
 void objects_initialize(void)
 {
     memset(&object_globals, 0, sizeof(object_globals));
+
+    handle_pool_initialize(&object_globals.handles, sizeof(int), DEFAULT_HANDLE_POOL_BLOCK_SIZE);
+    aabb_tree_initialize(&object_globals.spatial_tree, OBJECT_SPATIAL_TREE_MARGIN);
+
+    animation_pose_cache_initialize();
 }
 
 void objects_dispose(void)
 {
-    for (int object_index = 0; object_index < object_globals.object_count; object_index++)
+    while (object_globals.object_indices.count)
     {
-        object_delete(object_index);
+        object_delete(object_globals.object_indices.elements[object_globals.object_indices.count - 1]);
     }
 
-    free(object_globals.objects);
+    handle_pool_dispose(&object_globals.handles);
+    dynamic_array_dispose(&object_globals.object_indices);
+    dynamic_array_dispose(&object_globals.objects);
+    dynamic_array_dispose(&object_globals.cold_objects);
+
+    aabb_tree_dispose(&object_globals.spatial_tree);
+    dynamic_array_dispose(&object_globals.moved_proxy_indices);
+    dynamic_array_dispose(&object_globals.moved_proxy_bounds);
+
+    animation_pose_cache_dispose();
 }
 
 void objects_update(float delta_ticks)
 {
-    struct object_iterator iterator;
-    object_iterator_new(&iterator);
+    PROFILER_FUNCTION();
 
-    while (object_iterator_next(&iterator) != -1)
+    // Objects only write their own state while updating, so batches run on any thread in any order,
+    // and every batch has finished before anything reads the results
+    struct objects_update_context context =
     {
-        struct object_data *object = iterator.data;
+        .delta_ticks = delta_ticks,
+        .camera = game_get_player_camera(),
+    };
+
+    jobs_parallel_for(object_globals.objects.count, OBJECT_UPDATE_BATCH_SIZE, objects_update_batch, &context);
+
+    memset(&object_globals.animation_lod_counters, 0, sizeof(object_globals.animation_lod_counters));
+    animation_pose_cache_begin_frame();
+
+    // Pose cache requests and finished animations, which give their node states back to pools shared between objects,
+    // are handled here on one thread, in object order, so both come out the same every run
+    for (int i = 0; i < object_globals.objects.count; i++)
+    {
+        struct animation_manager *animations = object_globals.objects.elements[i].animations;
+
+        if (animations->shares_poses && animations->has_pose_cache_key)
+            animation_pose_cache_request(animations);
 
-        animation_manager_update(&object->animations, delta_ticks);
-        // TODO: compute node transforms from position/rotation/scale/animations
+        animation_manager_accumulate_lod_counters(animations, &object_globals.animation_lod_counters);
+        animation_manager_release_finished_animations(animations);
     }
+
+    animation_pose_cache_evaluate();
+}
+
+const struct animation_lod_counters *objects_get_animation_lod_counters(void)
+{
+    return &object_globals.animation_lod_counters;
 }
 
 int object_new(void)
 {
-    struct object_data object;
-    memset(&object, 0, sizeof(object));
+    int object_index = handle_pool_allocate(&object_globals.handles);
 
-    object.model_index = -1;
-    
-    glm_vec3_copy((vec3){1, 1, 1}, object.scale);
+    int *position = handle_pool_get(&object_globals.handles, object_index);
+    assert(position);
+
+    *position = object_globals.objects.count;
+
+    dynamic_array_push(&object_globals.object_indices, &object_index);
+    dynamic_array_push(&object_globals.cold_objects, NULL);
+
+    struct object_data *object = dynamic_array_push(&object_globals.objects, NULL);
+
+    object->model_index = -1;
+    object->parent_object_index = -1;
+    object->parent_marker_index = -1;
+    object->spatial_proxy_index = -1;
     
-    int object_index = object_globals.object_count;
-    mempush(&object_globals.object_count, (void **)&object_globals.objects, &object, sizeof(object), realloc);
+    glm_vec3_copy((vec3){1, 1, 1}, object->scale);
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
+
+    assert(object->animations = heap_allocate_zeroed(1, sizeof(*object->animations)));
+    animation_manager_initialize(object->animations, -1);
     
     return object_index;
 }
@@ -71,10 +173,52 @@ void object_delete(int object_index)
         return;
     }
     
-    struct object_data *object = object_get_data(object_index);
-    assert(object);
+    int position = object_get_position(object_index);
+    struct object_data *object = object_globals.objects.elements + position;
+
+    // Objects sharing this object's pose fall back to their own until the next update,
+    // and objects attached to this object are left where they are in the world
+    for (int i = 0; i < object_globals.objects.count; i++)
+    {
+        struct object_data *other_object = object_globals.objects.elements + i;
 
-    animation_manager_dispose(&object->animations);
+        if (other_object->animations->pose_source == object->animations)
+            other_object->animations->pose_source = NULL;
+
+        if (other_object->parent_object_index == object_index)
+        {
+            other_object->parent_object_index = -1;
+            other_object->parent_marker_index = -1;
+
+            glm_vec3_copy(other_object->world_matrix[3], other_object->position);
+            SET_BIT(other_object->flags, _object_transform_dirty_bit, true);
+        }
+    }
+
+    if (object->spatial_proxy_index != -1)
+        aabb_tree_remove(&object_globals.spatial_tree, object->spatial_proxy_index);
+
+    animation_manager_dispose(object->animations);
+    free(object->animations);
+
+    int last_position = object_globals.objects.count - 1;
+
+    if (position != last_position)
+    {
+        int moved_object_index = object_globals.object_indices.elements[last_position];
+
+        object_globals.object_indices.elements[position] = moved_object_index;
+        object_globals.objects.elements[position] = object_globals.objects.elements[last_position];
+        object_globals.cold_objects.elements[position] = object_globals.cold_objects.elements[last_position];
+
+        *(int *)handle_pool_get(&object_globals.handles, moved_object_index) = position;
+    }
+
+    object_globals.object_indices.count--;
+    object_globals.objects.count--;
+    object_globals.cold_objects.count--;
+
+    handle_pool_free(&object_globals.handles, object_index);
 }
 
 void object_initialize(int object_index)
@@ -87,7 +231,11 @@ void object_initialize(int object_index)
     struct object_data *object = object_get_data(object_index);
     assert(object);
 
-    animation_manager_initialize(&object->animations, object->model_index);
+    animation_manager_dispose(object->animations);
+    animation_manager_initialize(object->animations, object->model_index);
+
+    // The object's bounds come from its model
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
 }
 
 struct object_data *object_get_data(int object_index)
@@ -95,8 +243,77 @@ struct object_data *object_get_data(int object_index)
     if (object_index == -1)
         return NULL;
     
-    assert(object_index >= 0 && object_index < object_globals.object_count);
-    return object_globals.objects + object_index;
+    return object_globals.objects.elements + object_get_position(object_index);
+}
+
+struct object_cold_data *object_get_cold_data(int object_index)
+{
+    if (object_index == -1)
+        return NULL;
+    
+    return object_globals.cold_objects.elements + object_get_position(object_index);
+}
+
+void object_set_position(int object_index, vec3 position)
+{
+    struct object_data *object = object_get_data(object_index);
+    assert(object);
+
+    glm_vec3_copy(position, object->position);
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
+}
+
+void object_set_rotation(int object_index, vec3 rotation)
+{
+    struct object_data *object = object_get_data(object_index);
+    assert(object);
+
+    glm_vec3_copy(rotation, object->rotation);
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
+}
+
+void object_set_scale(int object_index, vec3 scale)
+{
+    struct object_data *object = object_get_data(object_index);
+    assert(object);
+
+    glm_vec3_copy(scale, object->scale);
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
+}
+
+void object_set_parent(int object_index, int parent_object_index, int parent_marker_index)
+{
+    struct object_data *object = object_get_data(object_index);
+    assert(object);
+
+    // An object can not end up attached to itself
+    for (int ancestor_index = parent_object_index;
+        ancestor_index != -1;
+        ancestor_index = object_get_data(ancestor_index)->parent_object_index)
+    {
+        assert(ancestor_index != object_index);
+    }
+
+    object->parent_object_index = parent_object_index;
+    object->parent_marker_index = parent_object_index != -1 ? parent_marker_index : -1;
+    SET_BIT(object->flags, _object_transform_dirty_bit, true);
+}
+
+void objects_update_transforms(void)
+{
+    PROFILER_FUNCTION();
+
+    object_globals.transform_update_index++;
+
+    for (int i = 0; i < object_globals.objects.count; i++)
+        object_update_world_matrix(object_globals.objects.elements + i);
+
+    objects_update_spatial_tree();
+}
+
+const struct aabb_tree *objects_get_spatial_tree(void)
+{
+    return &object_globals.spatial_tree;
 }
 
 void object_iterator_new(struct object_iterator *iterator)
@@ -105,21 +322,250 @@ void object_iterator_new(struct object_iterator *iterator)
 
     iterator->data = NULL;
     iterator->index = -1;
+    iterator->position = -1;
 }
 
 int object_iterator_next(struct object_iterator *iterator)
 {
     assert(iterator);
 
-    if (++iterator->index >= object_globals.object_count)
+    if (++iterator->position >= object_globals.objects.count)
     {
         iterator->data = NULL;
         iterator->index = -1;
+        iterator->position = object_globals.objects.count;
+
         return -1;
     }
 
-    int object_index = iterator->index;
-    iterator->data = object_globals.objects + object_index;
+    iterator->index = object_globals.object_indices.elements[iterator->position];
+    iterator->data = object_globals.objects.elements + iterator->position;
     
-    return object_index;
+    return iterator->index;
+}
+
+/* ---------- private code */
+
+static void objects_update_batch(
+    void *data,
+    int start_index,
+    int end_index)
+{
+    const struct objects_update_context *context = data;
+
+    for (int i = start_index; i < end_index; i++)
+    {
+        struct object_data *object = object_globals.objects.elements + i;
+
+        animation_manager_select_lod(object->animations, object_get_screen_size(object, context->camera));
+        animation_manager_update(object->animations, context->delta_ticks);
+    }
+}
+
+static float object_get_screen_size(
+    const struct object_data *object,
+    const struct camera_data *camera)
+{
+    // Measured from the world bounds of the last transform update, so attached objects use where they really are
+    const struct bounding_sphere *sphere = &object->world_bounding_sphere;
+
+    // Objects whose bounds have never been computed get full detail until they are
+    if (!camera || sphere->radius <= 0.0f)
+        return 1.0f;
+
+    float radius = sphere->radius;
+    float distance = glm_vec3_distance((float *)sphere->center, (float *)camera->position);
+
+    // The camera is inside the object's bounds
+    if (distance <= radius)
+        return 1.0f;
+
+    // The projected diameter over the viewport height
+    return radius / (distance * tanf(camera->field_of_view * 0.5f));
+}
+
+static int object_get_position(
+    int object_index)
+{
+    int *position = handle_pool_get(&object_globals.handles, object_index);
+    assert(position);
+
+    return *position;
+}
+
+static void object_update_world_matrix(
+    struct object_data *object)
+{
+    if (object->transform_update_index == object_globals.transform_update_index)
+        return;
+
+    object->transform_update_index = object_globals.transform_update_index;
+
+    struct object_data *parent = object_get_data(object->parent_object_index);
+
+    // Parents are brought up to date first, wherever they are in the arrays
+    if (parent)
+        object_update_world_matrix(parent);
+
+    // Markers follow animated nodes, which can move every update without the parent's transform changing
+    bool parent_moved = parent &&
+        (parent->world_matrix_revision != object->parent_world_matrix_revision || object->parent_marker_index != -1);
+
+    if (!TEST_BIT(object->flags, _object_transform_dirty_bit) && !parent_moved)
+        return;
+
+    mat4 local_matrix;
+    object_get_local_matrix(object, local_matrix);
+
+    if (parent)
+    {
+        mat4 parent_matrix;
+        glm_mat4_copy(parent->world_matrix, parent_matrix);
+
+        struct model_data *parent_model = model_get_data(parent->model_index);
+        mat4 *node_transforms = animation_manager_get_node_transforms(parent->animations);
+
+        if (parent_model && object->parent_marker_index != -1)
+        {
+            struct model_marker *marker = parent_model->markers + object->parent_marker_index;
+
+            if (node_transforms && marker->node_index != -1)
+                glm_mat4_mul(parent_matrix, node_transforms[marker->node_index], parent_matrix);
+
+            mat4 marker_matrix;
+            glm_euler(marker->rotation, marker_matrix);
+            glm_vec3_copy(marker->position, marker_matrix[3]);
+            glm_mat4_mul(parent_matrix, marker_matrix, parent_matrix);
+        }
+
+        glm_mat4_mul(parent_matrix, local_matrix, object->world_matrix);
+        object->parent_world_matrix_revision = parent->world_matrix_revision;
+    }
+    else
+    {
+        glm_mat4_copy(local_matrix, object->world_matrix);
+    }
+
+    glm_mat4_inv(object->world_matrix, object->normal_matrix);
+    glm_mat4_transpose(object->normal_matrix);
+
+    object->world_matrix_revision++;
+    SET_BIT(object->flags, _object_transform_dirty_bit, false);
+}
+
+static void objects_update_spatial_tree(void)
+{
+    dynamic_array_clear(&object_globals.moved_proxy_indices);
+    dynamic_array_clear(&object_globals.moved_proxy_bounds);
+
+    for (int i = 0; i < object_globals.objects.count; i++)
+    {
+        struct object_data *object = object_globals.objects.elements + i;
+
+        bool bounds_changed = object_update_world_bounds(object);
+
+        if (aabb_is_empty(&object->world_bounds))
+        {
+            if (object->spatial_proxy_index != -1)
+            {
+                aabb_tree_remove(&object_globals.spatial_tree, object->spatial_proxy_index);
+                object->spatial_proxy_index = -1;
+            }
+        }
+        else if (object->spatial_proxy_index == -1)
+        {
+            object->spatial_proxy_index = aabb_tree_insert(&object_globals.spatial_tree, &object->world_bounds, object_globals.object_indices.elements[i]);
+        }
+        else if (bounds_changed)
+        {
+            dynamic_array_push(&object_globals.moved_proxy_indices, &object->spatial_proxy_index);
+            dynamic_array_push(&object_globals.moved_proxy_bounds, &object->world_bounds);
+        }
+    }
+
+    aabb_tree_move_batch(
+        &object_globals.spatial_tree,
+        object_globals.moved_proxy_indices.count,
+        object_globals.moved_proxy_indices.elements,
+        object_globals.moved_proxy_bounds.elements);
+}
+
+static bool object_update_world_bounds(
+    struct object_data *object)
+{
+    struct model_data *model = model_get_data(object->model_index);
+
+    if (!model)
+    {
+        aabb_clear(&object->world_bounds);
+        object->world_bounding_sphere = (struct bounding_sphere){ 0 };
+        return true;
+    }
+
+    mat4 *node_transforms = animation_manager_get_node_transforms(object->animations);
+    bool animated = model->has_skinned_bounds && node_transforms;
+
+    // Unanimated bounds only move with the object
+    if (!animated && object->bounds_world_matrix_revision == object->world_matrix_revision)
+        return false;
+
+    object->bounds_world_matrix_revision = object->world_matrix_revision;
+
+    if (!animated)
+    {
+        aabb_transform(&model->bounds, object->world_matrix, &object->world_bounds);
+        bounding_sphere_transform(&model->bounding_sphere, object->world_matrix, &object->world_bounding_sphere);
+        return true;
+    }
+
+    struct aabb model_bounds = model->unskinned_bounds;
+
+    for (int node_index = 0; node_index < model->node_count; node_index++)
+    {
+        struct model_node *node = model->nodes + node_index;
+
+        if (aabb_is_empty(&node->skinned_bounds))
+            continue;
+
+        struct aabb node_bounds;
+        aabb_transform(&node->skinned_bounds, node_transforms[node_index], &node_bounds);
+        aabb_add_aabb(&model_bounds, &node_bounds);
+    }
+
+    aabb_transform(&model_bounds, object->world_matrix, &object->world_bounds);
+    bounding_sphere_from_aabb(&object->world_bounds, &object->world_bounding_sphere);
+
+    return true;
+}
+
+static void object_get_local_matrix(
+    const struct object_data *object,
+    mat4 out_matrix)
+{
+    mat4 position_matrix;
+    glm_mat4_identity(position_matrix);
+    glm_translate(position_matrix, (float *)object->position);
+
+    mat4 yaw_matrix;
+    glm_mat4_identity(yaw_matrix);
+    glm_rotate(yaw_matrix, glm_rad(object->rotation[0]), (vec3){1, 0, 0});
+
+    mat4 pitch_matrix;
+    glm_mat4_identity(pitch_matrix);
+    glm_rotate(pitch_matrix, glm_rad(object->rotation[1]), (vec3){0, 1, 0});
+
+    mat4 roll_matrix;
+    glm_mat4_identity(roll_matrix);
+    glm_rotate(roll_matrix, glm_rad(object->rotation[2]), (vec3){0, 0, 1});
+
+    mat4 rotation_matrix;
+    glm_mat4_mul(yaw_matrix, pitch_matrix, rotation_matrix);
+    glm_mat4_mul(roll_matrix, rotation_matrix, rotation_matrix);
+
+    mat4 scale_matrix;
+    glm_mat4_identity(scale_matrix);
+    glm_scale(scale_matrix, (float *)object->scale);
+
+    glm_mat4_mul(position_matrix, rotation_matrix, out_matrix);
+    glm_mat4_mul(out_matrix, scale_matrix, out_matrix);
 }
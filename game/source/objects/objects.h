@@ -7,6 +7,7 @@ OBJECTS.H
 
 #include <cglm/cglm.h>
 
+#include "geometry/aabb_trees.h"
 #include "models/models.h"
 #include "animations/animation_manager.h"
 
@@ -14,30 +15,65 @@ OBJECTS.H
 
 enum object_flags
 {
+    // Set by the transform setters, and cleared once the world matrix has been recomputed
+    _object_transform_dirty_bit,
     NUMBER_OF_OBJECT_FLAGS
 };
 
 /* ---------- structures */
 
+/**
+ * The state of an object read by every update and every frame. Live objects are packed together, so the address
+ * of an object's data is only valid until the next object_new or object_delete.
+ */
 struct object_data
 {
-    char name[32];
-
     unsigned int flags;
 
+    // Relative to the parent, or to the world without one. Only written through the transform setters.
     vec3 position;
     vec3 rotation;
     vec3 scale;
 
+    // The object an object is attached to, and the marker of the parent's model it follows, or -1 for either
+    int parent_object_index;
+    int parent_marker_index;
+
+    // Cached by objects_update_transforms, and only recomputed when the object's or its parent's transform changed.
+    // The normal matrix is the inverse-transpose of the world matrix.
+    mat4 world_matrix;
+    mat4 normal_matrix;
+    unsigned int world_matrix_revision;
+    unsigned int parent_world_matrix_revision;
+    unsigned int transform_update_index;
+
+    // Conservative world-space bounds of the object's model, grown to fit its animated nodes each update
+    struct aabb world_bounds;
+    struct bounding_sphere world_bounding_sphere;
+    unsigned int bounds_world_matrix_revision;
+
+    // The object's proxy in the spatial tree, or -1 while it has no bounds
+    int spatial_proxy_index;
+
     int model_index;
-    struct animation_manager animations;
-    mat4 node_matrices[MAXIMUM_NUMBER_OF_MODEL_NODES];
+
+    // Allocated on its own, so other managers can keep pointing at it while objects move
+    struct animation_manager *animations;
+};
+
+/**
+ * The state of an object only read by tools and debugging, kept apart from the data walked every frame.
+ */
+struct object_cold_data
+{
+    char name[32];
 };
 
 struct object_iterator
 {
     struct object_data *data;
     int index;
+    int position;
 };
 
 /* ---------- prototypes/OBJECTS.C */
@@ -46,11 +82,40 @@ void objects_initialize(void);
 void objects_dispose(void);
 void objects_update(float delta_ticks);
 
+const struct animation_lod_counters *objects_get_animation_lod_counters(void);
+
 int object_new(void);
 void object_delete(int object_index);
 void object_initialize(int object_index);
 
 struct object_data *object_get_data(int object_index);
+struct object_cold_data *object_get_cold_data(int object_index);
+
+void object_set_position(int object_index, vec3 position);
+void object_set_rotation(int object_index, vec3 rotation);
+void object_set_scale(int object_index, vec3 scale);
+
+/**
+ * Attaches an object to another, so its transform becomes relative to the other object's.
+ * @param object_index The object to attach.
+ * @param parent_object_index The object to attach to, or -1 to detach.
+ * @param parent_marker_index The marker of the parent's model to follow, or -1 to follow the parent's origin.
+ */
+void object_set_parent(int object_index, int parent_object_index, int parent_marker_index);
+
+/**
+ * Recomputes the world matrices of the objects whose transform, or whose parent's, changed since the last call,
+ * and the world bounds of those objects and of every object with animated nodes.
+ */
+void objects_update_transforms(void);
+
+/**
+ * Gets the tree of every object's world bounds, which is brought up to date by objects_update_transforms once a frame
+ * before rendering. Queries made while updating see the bounds the previous frame was rendered with.
+ * Each proxy's user data is its object's index, and queries may report objects up to the tree's margin outside
+ * of what was asked for.
+ */
+const struct aabb_tree *objects_get_spatial_tree(void);
 
 void object_iterator_new(struct object_iterator *iterator);
 int object_iterator_next(struct object_iterator *iterator);
@@ -9,6 +9,7 @@ RASTERIZER_RENDER_TARGETS.C
 #include <string.h>
 
 #include "common/common.h"
+#include "memory/heap.h"
 #include "rasterizer/rasterizer_render_targets.h"
 #include "rasterizer/rasterizer_textures.h"
 
@@ -275,7 +276,7 @@ void framebuffer_attach_texture(
         (void **)&framebuffer->attachments,
         &attachment,
         sizeof(attachment),
-        realloc);
+        heap_reallocate);
 }
 
 void framebuffer_attach_renderbuffer(
@@ -300,7 +301,7 @@ void framebuffer_attach_renderbuffer(
         (void **)&framebuffer->attachments,
         &attachment,
         sizeof(attachment),
-        realloc);
+        heap_reallocate);
 }
 
 void framebuffer_build(
@@ -338,7 +339,7 @@ void framebuffer_build(
                     attachment_id = GL_COLOR_ATTACHMENT0 + attachment_index;
                 }
                 
-                assert(attachments = realloc(attachments, sizeof(GLenum) * (color_attachment_count + depth_attachment_count)));
+                assert(attachments = heap_reallocate(attachments, sizeof(GLenum) * (color_attachment_count + depth_attachment_count)));
                 attachments[color_attachment_count + depth_attachment_count - 1] = attachment_id;
 
                 switch (texture->type)
@@ -11,6 +11,8 @@ RASTERIZER_SHADERS.H
 #include <GL/glew.h>
 
 #include "common/common.h"
+#include "memory/arenas.h"
+#include "memory/handle_pools.h"
 
 #include "rasterizer/rasterizer_shaders.h"
 #include "rasterizer/rasterizer_textures.h"
@@ -26,8 +28,7 @@ enum shader_constants
 
 struct
 {
-    int shader_count;
-    struct shader_data *shaders;
+    struct handle_pool shaders;
 } static shader_globals;
 
 /* ---------- private prototypes */
@@ -49,11 +50,20 @@ void shader_unbind_texture(
 void shaders_initialize(void)
 {
     memset(&shader_globals, 0, sizeof(shader_globals));
+
+    handle_pool_initialize(&shader_globals.shaders, sizeof(struct shader_data), DEFAULT_HANDLE_POOL_BLOCK_SIZE);
 }
 
 void shaders_dispose(void)
 {
-    free(shader_globals.shaders);
+    int shader_index;
+
+    while ((shader_index = handle_pool_iterate(&shader_globals.shaders, -1)) != -1)
+    {
+        shader_delete(shader_index);
+    }
+
+    handle_pool_dispose(&shader_globals.shaders);
 }
 
 int shader_new(
@@ -68,37 +78,63 @@ int shader_new(
         GL_FRAGMENT_SHADER,
         fragment_shader_path);
 
-    struct shader_data shader;
-    memset(&shader, 0, sizeof(shader));
+    int shader_index = handle_pool_allocate(&shader_globals.shaders);
+
+    struct shader_data *shader = shader_get_data(shader_index);
     
-    shader.program = glCreateProgram();
+    shader->program = glCreateProgram();
 
-    glAttachShader(shader.program, vertex_shader);
-    glAttachShader(shader.program, fragment_shader);
+    glAttachShader(shader->program, vertex_shader);
+    glAttachShader(shader->program, fragment_shader);
 
-    glLinkProgram(shader.program);
-    glUseProgram(shader.program);
+    glLinkProgram(shader->program);
+    glUseProgram(shader->program);
 
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
+    
+    return shader_index;
+}
+
+int shader_new_transform_feedback(
+    const char *vertex_shader_path,
+    int varying_count,
+    const char *const *varyings)
+{
+    GLuint vertex_shader = shader_import_and_compile_file(
+        GL_VERTEX_SHADER,
+        vertex_shader_path);
 
-    int shader_index = shader_globals.shader_count;
+    int shader_index = handle_pool_allocate(&shader_globals.shaders);
+
+    struct shader_data *shader = shader_get_data(shader_index);
+
+    shader->program = glCreateProgram();
+
+    glAttachShader(shader->program, vertex_shader);
+
+    // Captured varyings must be declared before linking
+    glTransformFeedbackVaryings(shader->program, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
+
+    glLinkProgram(shader->program);
+    glUseProgram(shader->program);
+
+    glDeleteShader(vertex_shader);
 
-    mempush(
-        &shader_globals.shader_count,
-        (void **)&shader_globals.shaders,
-        &shader,
-        sizeof(shader),
-        realloc);
-    
     return shader_index;
 }
 
 void shader_delete(
     int shader_index)
 {
-    assert(shader_index >= 0 && shader_index < shader_globals.shader_count);
-    // TODO
+    struct shader_data *shader = shader_get_data(shader_index);
+    
+    if (!shader)
+        return;
+
+    glDeleteProgram(shader->program);
+
+    handle_pool_free(&shader_globals.shaders, shader_index);
 }
 
 struct shader_data *shader_get_data(
@@ -107,8 +143,10 @@ struct shader_data *shader_get_data(
     if (shader_index == -1)
         return NULL;
     
-    assert(shader_index >= 0 && shader_index < shader_globals.shader_count);
-    return shader_globals.shaders + shader_index;
+    struct shader_data *shader = handle_pool_get(&shader_globals.shaders, shader_index);
+    assert(shader);
+
+    return shader;
 }
 
 void shader_use(
@@ -206,14 +244,11 @@ void shader_set_bool_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_bool(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_int(
@@ -241,14 +276,11 @@ void shader_set_int_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_int(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_uint(
@@ -276,14 +308,11 @@ void shader_set_uint_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_uint(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_float(
@@ -311,14 +340,11 @@ void shader_set_float_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_float(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_vec2(
@@ -346,14 +372,11 @@ void shader_set_vec2_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_vec2(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_vec3(
@@ -381,14 +404,11 @@ void shader_set_vec3_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_vec3(shader_index, value, name);
-
-    free(name);
 }
 
 void shader_set_mat4(
@@ -416,14 +436,11 @@ void shader_set_mat4_v(
     va_list va;
     va_start(va, fmt);
 
-    char *name;
-    vasprintf(&name, fmt, va);
+    const char *name = frame_arena_vformat(fmt, va);
 
     va_end(va);
     
     shader_set_mat4(shader_index, value, name);
-
-    free(name);
 }
 
 int shader_bind_texture(
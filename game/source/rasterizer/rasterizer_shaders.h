@@ -25,6 +25,15 @@ void shaders_initialize(void);
 void shaders_dispose(void);
 
 int shader_new(const char *vertex_shader_path, const char *fragment_shader_path);
+
+/**
+ * Creates a vertex-only shader whose outputs are captured into a buffer with transform feedback.
+ * @param vertex_shader_path The path of the vertex shader.
+ * @param varying_count The number of captured vertex shader outputs.
+ * @param varyings The names of the captured outputs, interleaved into each captured vertex in this order.
+ * @returns The index of the new shader.
+ */
+int shader_new_transform_feedback(const char *vertex_shader_path, int varying_count, const char *const *varyings);
 void shader_delete(int shader_index);
 
 struct shader_data *shader_get_data(int shader_index);
@@ -11,15 +11,14 @@ RASTERIZER_TEXTURES.C
 #include <GL/glew.h>
 
 #include "common/common.h"
+#include "memory/handle_pools.h"
 #include "rasterizer/rasterizer_textures.h"
 
 /* ---------- private variables */
 
 struct
 {
-    int texture_count;
-    int *textures_in_use;
-    struct texture_data *textures;
+    struct handle_pool textures;
 } static texture_globals;
 
 /* ---------- public code */
@@ -27,14 +26,20 @@ struct
 void textures_initialize(void)
 {
     memset(&texture_globals, 0, sizeof(texture_globals));
+
+    handle_pool_initialize(&texture_globals.textures, sizeof(struct texture_data), DEFAULT_HANDLE_POOL_BLOCK_SIZE);
 }
 
 void textures_dispose(void)
 {
-    for (int i = 0; i < texture_globals.texture_count; i++)
+    int texture_index;
+
+    while ((texture_index = handle_pool_iterate(&texture_globals.textures, -1)) != -1)
     {
-        texture_delete(i);
+        texture_delete(texture_index);
     }
+
+    handle_pool_dispose(&texture_globals.textures);
 }
 
 const char *texture_type_to_string(
@@ -57,37 +62,10 @@ const char *texture_type_to_string(
 int texture_allocate(
     enum texture_type type)
 {
-    struct texture_data texture;
-    memset(&texture, 0, sizeof(texture));
-
-    texture.type = type;
-
-    int texture_index = -1;
-
-    for (int i = 0; i < texture_globals.texture_count; i++)
-    {
-        if (!BIT_VECTOR_TEST_BIT(texture_globals.textures_in_use, i))
-        {
-            texture_index = i;
-            break;
-        }
-    }
+    int texture_index = handle_pool_allocate(&texture_globals.textures);
 
-    if (texture_index == -1)
-    {
-        texture_index = texture_globals.texture_count;
-
-        mempush(
-            &texture_globals.texture_count,
-            (void **)&texture_globals.textures,
-            &texture,
-            sizeof(texture),
-            realloc);
-        
-        texture_globals.textures_in_use = realloc(texture_globals.textures_in_use, BIT_VECTOR_LENGTH_IN_WORDS(texture_globals.texture_count));
-    }
-    
-    BIT_VECTOR_SET_BIT(texture_globals.textures_in_use, texture_index, true);
+    struct texture_data *texture = texture_get_data(texture_index);
+    texture->type = type;
 
     return texture_index;
 }
@@ -126,7 +104,7 @@ void texture_delete(
 
     glDeleteTextures(1, &texture->id);
 
-    BIT_VECTOR_SET_BIT(texture_globals.textures_in_use, texture_index, false);
+    handle_pool_free(&texture_globals.textures, texture_index);
 }
 
 struct texture_data *texture_get_data(
@@ -135,8 +113,10 @@ struct texture_data *texture_get_data(
     if (texture_index == -1)
         return NULL;
     
-    assert(texture_index >= 0 && texture_index < texture_globals.texture_count);
-    return texture_globals.textures + texture_index;
+    struct texture_data *texture = handle_pool_get(&texture_globals.textures, texture_index);
+    assert(texture);
+
+    return texture;
 }
 
 int texture_get_target(
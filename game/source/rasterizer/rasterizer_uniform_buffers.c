@@ -0,0 +1,188 @@
+/*
+RASTERIZER_UNIFORM_BUFFERS.C
+    Rasterizer uniform buffer code.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "rasterizer/rasterizer_uniform_buffers.h"
+
+/* ---------- private constants */
+
+enum
+{
+    // Texture buffer texels are RGBA32F, so offsets must also land on whole texels
+    UNIFORM_RING_BUFFER_TEXEL_SIZE = 16,
+};
+
+/* ---------- private prototypes */
+
+static void uniform_ring_buffer_allocate(struct uniform_ring_buffer *ring, size_t segment_size);
+static void uniform_ring_buffer_delete_fences(struct uniform_ring_buffer *ring);
+
+/* ---------- public code */
+
+void uniform_ring_buffer_initialize(
+    struct uniform_ring_buffer *ring,
+    size_t segment_size)
+{
+    assert(ring);
+    memset(ring, 0, sizeof(*ring));
+
+    GLint offset_alignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+
+    ring->offset_alignment = (size_t)offset_alignment;
+
+    while (ring->offset_alignment % UNIFORM_RING_BUFFER_TEXEL_SIZE)
+        ring->offset_alignment *= 2;
+
+    glGenBuffers(1, &ring->buffer);
+    glGenTextures(1, &ring->texture);
+
+    uniform_ring_buffer_allocate(ring, segment_size);
+}
+
+void uniform_ring_buffer_dispose(
+    struct uniform_ring_buffer *ring)
+{
+    assert(ring);
+
+    if (ring->mapped_data)
+        uniform_ring_buffer_unmap(ring);
+
+    uniform_ring_buffer_delete_fences(ring);
+
+    glDeleteTextures(1, &ring->texture);
+    glDeleteBuffers(1, &ring->buffer);
+
+    memset(ring, 0, sizeof(*ring));
+}
+
+void uniform_ring_buffer_map(
+    struct uniform_ring_buffer *ring,
+    size_t size)
+{
+    assert(ring);
+    assert(!ring->mapped_data);
+
+    if (size > ring->segment_size)
+    {
+        // Reallocating orphans the old storage, so draws still reading it are unaffected
+        size_t segment_size = ring->segment_size;
+
+        while (segment_size < size)
+            segment_size *= 2;
+
+        uniform_ring_buffer_delete_fences(ring);
+        uniform_ring_buffer_allocate(ring, segment_size);
+    }
+
+    GLsync *fence = ring->segment_fences + ring->segment_index;
+
+    if (*fence)
+    {
+        while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            ;
+
+        glDeleteSync(*fence);
+        *fence = NULL;
+    }
+
+    ring->mapped_size = size;
+    ring->used_size = 0;
+
+    if (!size)
+        return;
+
+    // The fence already guarantees the GPU is done with the segment, so the driver need not synchronize
+    glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+    ring->mapped_data = glMapBufferRange(
+        GL_UNIFORM_BUFFER,
+        ring->segment_index * ring->segment_size,
+        size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    assert(ring->mapped_data);
+}
+
+size_t uniform_ring_buffer_push(
+    struct uniform_ring_buffer *ring,
+    size_t size,
+    void **out_data)
+{
+    assert(ring);
+    assert(out_data);
+
+    size_t aligned_size = uniform_ring_buffer_get_aligned_size(ring, size);
+    assert(ring->used_size + aligned_size <= ring->mapped_size);
+
+    size_t offset = ring->used_size;
+    ring->used_size += aligned_size;
+
+    *out_data = ring->mapped_data + offset;
+
+    return (ring->segment_index * ring->segment_size) + offset;
+}
+
+void uniform_ring_buffer_unmap(
+    struct uniform_ring_buffer *ring)
+{
+    assert(ring);
+
+    if (!ring->mapped_data)
+        return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+
+    ring->mapped_data = NULL;
+}
+
+void uniform_ring_buffer_end_frame(
+    struct uniform_ring_buffer *ring)
+{
+    assert(ring);
+    assert(!ring->mapped_data);
+
+    ring->segment_fences[ring->segment_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring->segment_index = (ring->segment_index + 1) % UNIFORM_RING_BUFFER_SEGMENT_COUNT;
+}
+
+size_t uniform_ring_buffer_get_aligned_size(
+    const struct uniform_ring_buffer *ring,
+    size_t size)
+{
+    assert(ring);
+    return (size + ring->offset_alignment - 1) & ~(ring->offset_alignment - 1);
+}
+
+/* ---------- private code */
+
+static void uniform_ring_buffer_allocate(
+    struct uniform_ring_buffer *ring,
+    size_t segment_size)
+{
+    ring->segment_size = uniform_ring_buffer_get_aligned_size(ring, segment_size);
+    ring->segment_index = 0;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+    glBufferData(GL_UNIFORM_BUFFER, ring->segment_size * UNIFORM_RING_BUFFER_SEGMENT_COUNT, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, ring->texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ring->buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+static void uniform_ring_buffer_delete_fences(
+    struct uniform_ring_buffer *ring)
+{
+    for (int segment_index = 0; segment_index < UNIFORM_RING_BUFFER_SEGMENT_COUNT; segment_index++)
+    {
+        if (ring->segment_fences[segment_index])
+            glDeleteSync(ring->segment_fences[segment_index]);
+
+        ring->segment_fences[segment_index] = NULL;
+    }
+}
@@ -0,0 +1,73 @@
+/*
+RASTERIZER_UNIFORM_BUFFERS.H
+    Rasterizer uniform buffer declarations.
+*/
+
+#pragma once
+#include <stddef.h>
+#include <GL/glew.h>
+
+/* ---------- constants */
+
+enum
+{
+    // Each frame writes its own segment, so the GPU can still be reading the previous frames' segments
+    UNIFORM_RING_BUFFER_SEGMENT_COUNT = 3,
+};
+
+/* ---------- structures */
+
+/**
+ * A uniform buffer split into one segment per frame in flight. Every frame maps its segment once, pushes its data,
+ * and binds ranges of it by offset. The same storage is also viewed as an RGBA32F texture buffer, for data too
+ * large for a uniform block.
+ */
+struct uniform_ring_buffer
+{
+    size_t segment_size;
+    size_t offset_alignment;
+
+    int segment_index;
+    size_t mapped_size;
+    size_t used_size;
+    char *mapped_data;
+
+    GLsync segment_fences[UNIFORM_RING_BUFFER_SEGMENT_COUNT];
+
+    GLuint buffer;
+    GLuint texture;
+};
+
+/* ---------- prototypes/RASTERIZER_UNIFORM_BUFFERS.C */
+
+void uniform_ring_buffer_initialize(struct uniform_ring_buffer *ring, size_t segment_size);
+void uniform_ring_buffer_dispose(struct uniform_ring_buffer *ring);
+
+/**
+ * Maps the current frame's segment for writing, growing every segment first if it is too small.
+ * Waits for the GPU to finish the frame that last used the segment.
+ * @param ring The ring buffer to map.
+ * @param size The number of bytes the frame will push, including alignment padding.
+ */
+void uniform_ring_buffer_map(struct uniform_ring_buffer *ring, size_t size);
+
+/**
+ * Reserves space in the mapped segment.
+ * @param ring The mapped ring buffer.
+ * @param size The number of bytes to reserve.
+ * @param out_data The address to write the reserved bytes to.
+ * @returns The offset of the reserved bytes in the buffer, aligned for binding as a uniform block and as texels.
+ */
+size_t uniform_ring_buffer_push(struct uniform_ring_buffer *ring, size_t size, void **out_data);
+
+void uniform_ring_buffer_unmap(struct uniform_ring_buffer *ring);
+
+/**
+ * Fences the current segment behind every command issued so far and moves on to the next segment.
+ */
+void uniform_ring_buffer_end_frame(struct uniform_ring_buffer *ring);
+
+/**
+ * Gets the size of a push of a number of bytes, padded to the ring buffer's offset alignment.
+ */
+size_t uniform_ring_buffer_get_aligned_size(const struct uniform_ring_buffer *ring, size_t size);
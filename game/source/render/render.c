@@ -18,16 +18,22 @@ RENDER.C
 #include "common/common.h"
 #include "camera/camera.h"
 #include "game/game.h"
+#include "geometry/frustums.h"
 #include "models/models.h"
 #include "objects/objects.h"
 #include "textures/dds.h"
 
 #include "objects/lights.h"
+#include "memory/dynamic_arrays.h"
+#include "memory/handle_pools.h"
+#include "memory/heap.h"
+#include "profiler/profiler.h"
 #include "render/render.h"
 
 #include "rasterizer/rasterizer_render_targets.h"
 #include "rasterizer/rasterizer_shaders.h"
 #include "rasterizer/rasterizer_textures.h"
+#include "rasterizer/rasterizer_uniform_buffers.h"
 
 /* ---------- private prototypes */
 
@@ -37,7 +43,106 @@ static void render_quad(void);
 static void render_set_lighting_uniforms(int shader_index);
 static void render_set_material_uniforms(int shader_index, struct material_data *material);
 
-static void render_object(int shader_index, int object_index);
+static void render_object(int shader_index, int object_index, const struct frustum *frustum, struct render_culling_counters *counters);
+static void render_upload_morph_vertices(struct model_mesh *mesh, struct animation_morph_state *morph_state);
+
+/* ---------- node palettes */
+
+enum
+{
+    // Node matrices are uploaded as the top three rows of each affine transform
+    NUMBER_OF_NODE_PALETTE_ROWS = 3,
+    NODE_PALETTE_NODE_SIZE = NUMBER_OF_NODE_PALETTE_ROWS * sizeof(vec4),
+
+    // Must match the node_palette uniform block in model.vs; larger palettes are read through the texture buffer
+    MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES = 256,
+    NODE_PALETTE_UNIFORM_BLOCK_SIZE = MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES * NODE_PALETTE_NODE_SIZE,
+
+    NODE_PALETTE_UNIFORM_BLOCK_BINDING = 0,
+
+    // The last texture unit, which shader_bind_texture only reaches once every other unit is taken
+    NODE_PALETTE_TEXTURE_UNIT = 31,
+
+    // Enough for a few dozen fully-animated objects before the ring buffer has to grow
+    DEFAULT_NODE_PALETTE_SEGMENT_SIZE = 1024 * 1024,
+};
+
+enum render_node_palette_mode
+{
+    _render_node_palette_mode_none,
+    _render_node_palette_mode_uniform_buffer,
+    _render_node_palette_mode_texture_buffer,
+    NUMBER_OF_RENDER_NODE_PALETTE_MODES
+};
+
+struct render_node_palette
+{
+    int object_index;
+    int node_count;
+    size_t offset;
+};
+
+static void render_initialize_node_palettes(void);
+static void render_upload_node_palettes(void);
+static enum render_node_palette_mode render_bind_node_palette(int shader_index, int object_index);
+
+/* ---------- culling */
+
+struct render_culling_data
+{
+    // The world bounding spheres of the objects the spatial tree finds in the frustum, in structure-of-arrays form
+    // so the batch test can narrow the tree's conservative answer down
+    DYNAMIC_ARRAY(int) object_indices;
+    DYNAMIC_ARRAY(float) centers_x;
+    DYNAMIC_ARRAY(float) centers_y;
+    DYNAMIC_ARRAY(float) centers_z;
+    DYNAMIC_ARRAY(float) radii;
+    DYNAMIC_ARRAY(bool) visible;
+
+    // The objects inside the camera's frustum this frame
+    DYNAMIC_ARRAY(int) visible_object_indices;
+
+    struct render_culling_counters counters[NUMBER_OF_RENDER_CULLING_PASSES];
+};
+
+static void render_cull_camera(void);
+static void render_gather_object_bounds(const struct frustum *frustum);
+static bool render_gather_object_bounds_callback(void *data, int proxy_index, int object_index);
+static void render_cull_objects(const struct frustum *frustum, struct render_culling_counters *counters);
+
+/* ---------- skinning pass */
+
+struct render_skinned_mesh
+{
+    // The mesh's (or the object's morphed) skinned vertices, read by the skinning shader
+    GLuint source_vertex_array;
+
+    // The skinned vertices as rigid vertices, read by every pass that draws the object
+    GLuint vertex_array;
+    GLuint vertex_buffer;
+};
+
+struct render_skinned_object
+{
+    int object_index;
+    int model_index;
+    int mesh_count;
+    struct render_skinned_mesh *meshes;
+};
+
+struct render_skinning_pass_data
+{
+    int shader_index;
+
+    // Indexed by the handle index of each object
+    DYNAMIC_ARRAY(struct render_skinned_object) objects;
+};
+
+static void render_initialize_skinning_pass(void);
+static void render_skinning_pass(void);
+static struct render_skinned_object *render_get_skinned_object(int object_index, struct model_data *model, int model_index);
+static void render_initialize_skinned_mesh(struct render_skinned_mesh *skinned_mesh, struct model_mesh *mesh, struct animation_morph_state *morph_state);
+static bool render_draws_skinned_mesh(enum render_node_palette_mode node_palette_mode, struct model_mesh *mesh);
 
 /* ---------- geometry pass */
 
@@ -240,6 +345,12 @@ static void render_hdr_pass(void);
 
 /* ---------- private variables */
 
+enum render_flags
+{
+    _render_skinning_pass_bit,
+    NUMBER_OF_RENDER_FLAGS
+};
+
 struct
 {
     unsigned int flags;
@@ -253,6 +364,12 @@ struct
     GLuint quad_vertex_array;
     GLuint quad_vertex_buffer;
 
+    struct uniform_ring_buffer node_palette_buffer;
+    DYNAMIC_ARRAY(struct render_node_palette) node_palettes;
+
+    struct render_culling_data culling;
+
+    struct render_skinning_pass_data skinning_pass;
     struct render_geometry_pass_data geometry_pass;
     struct render_depth_pass_data depth_pass;
     struct render_occlusion_pass_data occlusion_pass;
@@ -274,6 +391,8 @@ void render_initialize(void)
     render_globals.screen_height = 720;
     render_globals.sample_count = 4;
 
+    SET_BIT(render_globals.flags, _render_skinning_pass_bit, true);
+
     glewExperimental = GL_TRUE;
     glewInit();
 
@@ -285,6 +404,8 @@ void render_initialize(void)
     glFrontFace(GL_CCW);
 
     render_initialize_quad();
+    render_initialize_node_palettes();
+    render_initialize_skinning_pass();
     
     render_initialize_geometry_pass();
     render_initialize_depth_pass();
@@ -351,11 +472,6 @@ void render_load_content(void)
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->index_count * sizeof(int), mesh->indices, GL_STATIC_DRAW);
 
-            // TODO: rasterizer uniform buffer
-            glGenBuffers(1, &mesh->uniform_buffer);
-            glBindBuffer(GL_UNIFORM_BUFFER, mesh->uniform_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4) * MAXIMUM_NUMBER_OF_MODEL_NODES, NULL, GL_STATIC_DRAW);
-
             shader_bind_vertex_attributes(render_globals.geometry_pass.shader_index, mesh->vertex_type);
         }
     }
@@ -363,6 +479,13 @@ void render_load_content(void)
 
 void render_update(float delta_ticks)
 {
+    // Objects may have been moved since they were updated
+    objects_update_transforms();
+
+    render_upload_node_palettes();
+    render_cull_camera();
+
+    render_skinning_pass();
     render_geometry_pass();
     render_depth_pass();
     render_occlusion_pass();
@@ -373,6 +496,24 @@ void render_update(float delta_ticks)
     render_blur_pass();
     render_hdr_pass();
     render_quad();
+
+    uniform_ring_buffer_end_frame(&render_globals.node_palette_buffer);
+}
+
+bool render_get_skinning_pass_enabled(void)
+{
+    return TEST_BIT(render_globals.flags, _render_skinning_pass_bit);
+}
+
+void render_set_skinning_pass_enabled(bool enabled)
+{
+    SET_BIT(render_globals.flags, _render_skinning_pass_bit, enabled);
+}
+
+const struct render_culling_counters *render_get_culling_counters(enum render_culling_pass pass)
+{
+    assert(pass >= 0 && pass < NUMBER_OF_RENDER_CULLING_PASSES);
+    return render_globals.culling.counters + pass;
 }
 
 /* ---------- private code */
@@ -510,7 +651,7 @@ static void render_set_material_uniforms(int shader_index, struct material_data
     }
 }
 
-static void render_object(int shader_index, int object_index)
+static void render_object(int shader_index, int object_index, const struct frustum *frustum, struct render_culling_counters *counters)
 {
     struct object_data *object = object_get_data(object_index);
     
@@ -526,53 +667,45 @@ static void render_object(int shader_index, int object_index)
         return;
     }
 
-    mat4 position_matrix;
-    glm_mat4_identity(position_matrix);
-    glm_translate(position_matrix, object->position);
-
-    mat4 yaw_matrix;
-    glm_mat4_identity(yaw_matrix);
-    glm_rotate(yaw_matrix, glm_rad(object->rotation[0]), (vec3){1, 0, 0});
-
-    mat4 pitch_matrix;
-    glm_mat4_identity(pitch_matrix);
-    glm_rotate(pitch_matrix, glm_rad(object->rotation[1]), (vec3){0, 1, 0});
-
-    mat4 roll_matrix;
-    glm_mat4_identity(roll_matrix);
-    glm_rotate(roll_matrix, glm_rad(object->rotation[2]), (vec3){0, 0, 1});
+    struct camera_data *camera = game_get_player_camera();
 
-    mat4 rotation_matrix;
-    glm_mat4_identity(rotation_matrix);
-    glm_mat4_mul(yaw_matrix, pitch_matrix, rotation_matrix);
-    glm_mat4_mul(roll_matrix, rotation_matrix, rotation_matrix);
+    shader_use(shader_index);
 
-    mat4 scale_matrix;
-    glm_mat4_identity(scale_matrix);
-    glm_scale(scale_matrix, object->scale);
+    shader_set_mat4(shader_index, object->world_matrix, "model");
+    shader_set_mat4(shader_index, object->normal_matrix, "model_normal");
+    shader_set_mat4(shader_index, camera->view, "view");
+    shader_set_mat4(shader_index, camera->projection, "projection");
 
-    mat4 model_matrix;
-    glm_mat4_mul(position_matrix, rotation_matrix, model_matrix);
-    glm_mat4_mul(model_matrix, scale_matrix, model_matrix);
-
-    struct camera_data *camera = game_get_player_camera();
+    enum render_node_palette_mode node_palette_mode = render_bind_node_palette(shader_index, object_index);
 
     for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
     {
         struct model_mesh *mesh = model->meshes + mesh_index;
 
-        shader_use(shader_index);
+        struct animation_morph_state *morph_state = animation_manager_get_morph_state(object->animations, mesh_index);
 
-        shader_set_mat4(shader_index, model_matrix, "model");
-        shader_set_mat4(shader_index, camera->view, "view");
-        shader_set_mat4(shader_index, camera->projection, "projection");
+        if (render_draws_skinned_mesh(node_palette_mode, mesh))
+        {
+            // Already skinned this frame by the skinning pass
+            struct render_skinned_object *skinned_object = render_get_skinned_object(object_index, model, object->model_index);
 
-        for (int node_index = 0; node_index < model->node_count; node_index++)
+            shader_set_int(shader_index, _render_node_palette_mode_none, "node_palette_mode");
+            glBindVertexArray(skinned_object->meshes[mesh_index].vertex_array);
+        }
+        else if (morph_state)
         {
-            shader_set_mat4_v(shader_index, object->animations.node_matrices[node_index], "node_matrices[%i]", node_index);
+            shader_set_int(shader_index, node_palette_mode, "node_palette_mode");
+            render_upload_morph_vertices(mesh, morph_state);
+            glBindVertexArray(morph_state->vertex_array);
         }
-        
-        glBindVertexArray(mesh->vertex_array);
+        else
+        {
+            shader_set_int(shader_index, node_palette_mode, "node_palette_mode");
+            glBindVertexArray(mesh->vertex_array);
+        }
+
+        // Part bounds are only exact for meshes drawn in their bind pose
+        bool cull_parts = mesh->part_count > 1 && node_palette_mode == _render_node_palette_mode_none && !morph_state;
 
         for (int part_index = 0; part_index < mesh->part_count; part_index++)
         {
@@ -581,6 +714,20 @@ static void render_object(int shader_index, int object_index)
             if (part->material_index == -1)
                 continue;
 
+            if (cull_parts)
+            {
+                struct bounding_sphere part_sphere;
+                bounding_sphere_transform(&part->bounding_sphere, object->world_matrix, &part_sphere);
+
+                if (!frustum_test_sphere(frustum, &part_sphere))
+                {
+                    counters->culled_part_count++;
+                    continue;
+                }
+            }
+
+            counters->submitted_part_count++;
+
             struct material_data *material = model->materials + part->material_index;
             render_set_material_uniforms(shader_index, material);
 
@@ -591,6 +738,373 @@ static void render_object(int shader_index, int object_index)
     }
 }
 
+static void render_upload_morph_vertices(struct model_mesh *mesh, struct animation_morph_state *morph_state)
+{
+    const struct vertex_definition *vertex_definition = vertex_definition_get(mesh->vertex_type);
+
+    if (!morph_state->vertex_array)
+    {
+        // The object's own vertices, drawn with the mesh's shared index buffer
+        glGenVertexArrays(1, &morph_state->vertex_array);
+        glBindVertexArray(morph_state->vertex_array);
+
+        glGenBuffers(1, &morph_state->vertex_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, morph_state->vertex_buffer);
+        glBufferData(GL_ARRAY_BUFFER, mesh->vertex_count * vertex_definition->size, morph_state->vertex_data, GL_DYNAMIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
+
+        shader_bind_vertex_attributes(render_globals.geometry_pass.shader_index, mesh->vertex_type);
+
+        morph_state->dirty_vertex_count = 0;
+        return;
+    }
+
+    if (!morph_state->dirty_vertex_count)
+        return;
+
+    // Only the vertices the morph targets moved since the last upload
+    size_t offset = (size_t)morph_state->dirty_vertex_start * vertex_definition->size;
+
+    glBindBuffer(GL_ARRAY_BUFFER, morph_state->vertex_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, (size_t)morph_state->dirty_vertex_count * vertex_definition->size, (const char *)morph_state->vertex_data + offset);
+
+    morph_state->dirty_vertex_count = 0;
+}
+
+static void render_initialize_node_palettes(void)
+{
+    uniform_ring_buffer_initialize(&render_globals.node_palette_buffer, DEFAULT_NODE_PALETTE_SEGMENT_SIZE);
+}
+
+static void render_upload_node_palettes(void)
+{
+    PROFILER_FUNCTION();
+
+    struct uniform_ring_buffer *ring = &render_globals.node_palette_buffer;
+
+    static struct object_iterator iterator;
+    size_t required_size = 0;
+
+    object_iterator_new(&iterator);
+
+    while (object_iterator_next(&iterator) != -1)
+    {
+        struct model_data *model = model_get_data(iterator.data->model_index);
+
+        if (model && model->node_count)
+            required_size += uniform_ring_buffer_get_aligned_size(ring, (size_t)model->node_count * NODE_PALETTE_NODE_SIZE);
+    }
+
+    if (!required_size)
+    {
+        dynamic_array_clear(&render_globals.node_palettes);
+        uniform_ring_buffer_map(ring, 0);
+        return;
+    }
+
+    // A full uniform block is always bound, so the last palette needs room behind it for the whole block
+    uniform_ring_buffer_map(ring, required_size + NODE_PALETTE_UNIFORM_BLOCK_SIZE);
+
+    object_iterator_new(&iterator);
+
+    while (object_iterator_next(&iterator) != -1)
+    {
+        int slot_index = HANDLE_INDEX(iterator.index);
+
+        if (slot_index >= render_globals.node_palettes.count)
+            dynamic_array_push_multiple(&render_globals.node_palettes, NULL, slot_index + 1 - render_globals.node_palettes.count);
+
+        struct render_node_palette *palette = render_globals.node_palettes.elements + slot_index;
+        palette->object_index = -1;
+
+        struct model_data *model = model_get_data(iterator.data->model_index);
+
+        if (!model || !model->node_count)
+            continue;
+
+        mat4 *node_matrices = animation_manager_get_node_matrices(iterator.data->animations);
+
+        if (!node_matrices)
+            continue;
+
+        vec4 *rows;
+        palette->object_index = iterator.index;
+        palette->node_count = model->node_count;
+        palette->offset = uniform_ring_buffer_push(ring, (size_t)model->node_count * NODE_PALETTE_NODE_SIZE, (void **)&rows);
+
+        for (int node_index = 0; node_index < model->node_count; node_index++)
+        {
+            mat4 *node_matrix = node_matrices + node_index;
+
+            for (int row_index = 0; row_index < NUMBER_OF_NODE_PALETTE_ROWS; row_index++, rows++)
+            {
+                (*rows)[0] = (*node_matrix)[0][row_index];
+                (*rows)[1] = (*node_matrix)[1][row_index];
+                (*rows)[2] = (*node_matrix)[2][row_index];
+                (*rows)[3] = (*node_matrix)[3][row_index];
+            }
+        }
+    }
+
+    uniform_ring_buffer_unmap(ring);
+
+    // The buffer may have been reallocated, but the texture view keeps following it
+    glActiveTexture(GL_TEXTURE0 + NODE_PALETTE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, ring->texture);
+}
+
+static enum render_node_palette_mode render_bind_node_palette(int shader_index, int object_index)
+{
+    int slot_index = HANDLE_INDEX(object_index);
+    struct render_node_palette *palette = NULL;
+
+    if (slot_index < render_globals.node_palettes.count &&
+        render_globals.node_palettes.elements[slot_index].object_index == object_index)
+    {
+        palette = render_globals.node_palettes.elements + slot_index;
+    }
+
+    if (!palette)
+        return _render_node_palette_mode_none;
+
+    if (palette->node_count > MAXIMUM_NUMBER_OF_UNIFORM_NODE_PALETTE_NODES)
+    {
+        shader_set_int(shader_index, (int)(palette->offset / sizeof(vec4)), "node_palette_texel_offset");
+        return _render_node_palette_mode_texture_buffer;
+    }
+
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER,
+        NODE_PALETTE_UNIFORM_BLOCK_BINDING,
+        render_globals.node_palette_buffer.buffer,
+        palette->offset,
+        NODE_PALETTE_UNIFORM_BLOCK_SIZE);
+
+    return _render_node_palette_mode_uniform_buffer;
+}
+
+/* ---------- culling */
+
+static void render_cull_camera(void)
+{
+    PROFILER_FUNCTION();
+
+    struct render_culling_data *culling = &render_globals.culling;
+    memset(culling->counters, 0, sizeof(culling->counters));
+
+    struct camera_data *camera = game_get_player_camera();
+
+    render_gather_object_bounds(&camera->frustum);
+    render_cull_objects(&camera->frustum, culling->counters + _render_culling_pass_geometry);
+
+    dynamic_array_clear(&culling->visible_object_indices);
+
+    for (int position = 0; position < culling->object_indices.count; position++)
+    {
+        if (culling->visible.elements[position])
+            dynamic_array_push(&culling->visible_object_indices, culling->object_indices.elements + position);
+    }
+}
+
+static void render_gather_object_bounds(const struct frustum *frustum)
+{
+    struct render_culling_data *culling = &render_globals.culling;
+
+    dynamic_array_clear(&culling->object_indices);
+    dynamic_array_clear(&culling->centers_x);
+    dynamic_array_clear(&culling->centers_y);
+    dynamic_array_clear(&culling->centers_z);
+    dynamic_array_clear(&culling->radii);
+
+    aabb_tree_query_frustum(objects_get_spatial_tree(), frustum, render_gather_object_bounds_callback, culling);
+
+    dynamic_array_reserve(&culling->visible, culling->object_indices.count);
+    culling->visible.count = culling->object_indices.count;
+}
+
+static bool render_gather_object_bounds_callback(void *data, int proxy_index, int object_index)
+{
+    (void)proxy_index;
+
+    struct render_culling_data *culling = data;
+    struct bounding_sphere *sphere = &object_get_data(object_index)->world_bounding_sphere;
+
+    dynamic_array_push(&culling->object_indices, &object_index);
+    dynamic_array_push(&culling->centers_x, sphere->center + 0);
+    dynamic_array_push(&culling->centers_y, sphere->center + 1);
+    dynamic_array_push(&culling->centers_z, sphere->center + 2);
+    dynamic_array_push(&culling->radii, &sphere->radius);
+
+    return true;
+}
+
+static void render_cull_objects(const struct frustum *frustum, struct render_culling_counters *counters)
+{
+    struct render_culling_data *culling = &render_globals.culling;
+
+    int visible_count = frustum_test_spheres(
+        frustum,
+        culling->centers_x.elements,
+        culling->centers_y.elements,
+        culling->centers_z.elements,
+        culling->radii.elements,
+        culling->object_indices.count,
+        culling->visible.elements);
+
+    // Objects the tree never reported were culled too
+    counters->submitted_object_count += visible_count;
+    counters->culled_object_count += objects_get_spatial_tree()->proxy_count - visible_count;
+}
+
+/* ---------- skinning pass */
+
+static void render_initialize_skinning_pass(void)
+{
+    // In the order of the members of struct vertex_rigid
+    static const char *const skinned_varyings[] =
+    {
+        "skinned_position",
+        "skinned_normal",
+        "skinned_texcoord",
+        "skinned_tangent",
+        "skinned_bitangent",
+    };
+
+    render_globals.skinning_pass.shader_index = shader_new_transform_feedback(
+        "../assets/shaders/skinning.vs",
+        sizeof(skinned_varyings) / sizeof(skinned_varyings[0]),
+        skinned_varyings);
+
+    struct shader_data *shader = shader_get_data(render_globals.skinning_pass.shader_index);
+    glUniformBlockBinding(shader->program, glGetUniformBlockIndex(shader->program, "node_palette"), NODE_PALETTE_UNIFORM_BLOCK_BINDING);
+
+    shader_set_int(render_globals.skinning_pass.shader_index, NODE_PALETTE_TEXTURE_UNIT, "node_palette_texture");
+}
+
+static void render_skinning_pass(void)
+{
+    PROFILER_FUNCTION();
+
+    if (!TEST_BIT(render_globals.flags, _render_skinning_pass_bit))
+        return;
+
+    int shader_index = render_globals.skinning_pass.shader_index;
+    shader_use(shader_index);
+
+    // Vertices are only captured, never rasterized
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    struct render_culling_data *culling = &render_globals.culling;
+
+    for (int visible_index = 0; visible_index < culling->visible_object_indices.count; visible_index++)
+    {
+        int object_index = culling->visible_object_indices.elements[visible_index];
+        struct object_data *object = object_get_data(object_index);
+        struct model_data *model = model_get_data(object->model_index);
+
+        enum render_node_palette_mode node_palette_mode = render_bind_node_palette(shader_index, object_index);
+
+        if (node_palette_mode == _render_node_palette_mode_none)
+            continue;
+
+        shader_set_int(shader_index, node_palette_mode, "node_palette_mode");
+
+        struct render_skinned_object *skinned_object = render_get_skinned_object(object_index, model, object->model_index);
+
+        for (int mesh_index = 0; mesh_index < model->mesh_count; mesh_index++)
+        {
+            struct model_mesh *mesh = model->meshes + mesh_index;
+
+            if (!render_draws_skinned_mesh(node_palette_mode, mesh))
+                continue;
+
+            struct animation_morph_state *morph_state = animation_manager_get_morph_state(object->animations, mesh_index);
+
+            if (morph_state)
+                render_upload_morph_vertices(mesh, morph_state);
+
+            struct render_skinned_mesh *skinned_mesh = skinned_object->meshes + mesh_index;
+
+            if (!skinned_mesh->vertex_array)
+                render_initialize_skinned_mesh(skinned_mesh, mesh, morph_state);
+
+            glBindVertexArray(skinned_mesh->source_vertex_array);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, skinned_mesh->vertex_buffer);
+
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, mesh->vertex_count);
+            glEndTransformFeedback();
+        }
+    }
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+}
+
+static struct render_skinned_object *render_get_skinned_object(int object_index, struct model_data *model, int model_index)
+{
+    int slot_index = HANDLE_INDEX(object_index);
+
+    if (slot_index >= render_globals.skinning_pass.objects.count)
+        dynamic_array_push_multiple(&render_globals.skinning_pass.objects, NULL, slot_index + 1 - render_globals.skinning_pass.objects.count);
+
+    struct render_skinned_object *skinned_object = render_globals.skinning_pass.objects.elements + slot_index;
+
+    if (skinned_object->meshes && skinned_object->object_index == object_index && skinned_object->model_index == model_index)
+        return skinned_object;
+
+    // The slot belonged to a deleted object, or the object changed models
+    for (int mesh_index = 0; mesh_index < skinned_object->mesh_count; mesh_index++)
+    {
+        struct render_skinned_mesh *skinned_mesh = skinned_object->meshes + mesh_index;
+
+        glDeleteVertexArrays(1, &skinned_mesh->source_vertex_array);
+        glDeleteVertexArrays(1, &skinned_mesh->vertex_array);
+        glDeleteBuffers(1, &skinned_mesh->vertex_buffer);
+    }
+
+    free(skinned_object->meshes);
+
+    skinned_object->object_index = object_index;
+    skinned_object->model_index = model_index;
+    skinned_object->mesh_count = model->mesh_count;
+    assert(skinned_object->meshes = heap_allocate_zeroed(model->mesh_count ? model->mesh_count : 1, sizeof(*skinned_object->meshes)));
+
+    return skinned_object;
+}
+
+static void render_initialize_skinned_mesh(struct render_skinned_mesh *skinned_mesh, struct model_mesh *mesh, struct animation_morph_state *morph_state)
+{
+    const struct vertex_definition *vertex_definition = vertex_definition_get(_vertex_type_rigid);
+
+    glGenVertexArrays(1, &skinned_mesh->source_vertex_array);
+    glBindVertexArray(skinned_mesh->source_vertex_array);
+
+    glBindBuffer(GL_ARRAY_BUFFER, morph_state ? morph_state->vertex_buffer : mesh->vertex_buffer);
+    shader_bind_vertex_attributes(render_globals.skinning_pass.shader_index, _vertex_type_skinned);
+
+    // Drawn with the mesh's shared index buffer
+    glGenVertexArrays(1, &skinned_mesh->vertex_array);
+    glBindVertexArray(skinned_mesh->vertex_array);
+
+    glGenBuffers(1, &skinned_mesh->vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, skinned_mesh->vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, mesh->vertex_count * vertex_definition->size, NULL, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
+
+    shader_bind_vertex_attributes(render_globals.geometry_pass.shader_index, _vertex_type_rigid);
+}
+
+static bool render_draws_skinned_mesh(enum render_node_palette_mode node_palette_mode, struct model_mesh *mesh)
+{
+    return TEST_BIT(render_globals.flags, _render_skinning_pass_bit) &&
+        node_palette_mode != _render_node_palette_mode_none &&
+        mesh->vertex_type == _vertex_type_skinned &&
+        mesh->vertex_array;
+}
+
 /* ---------- geometry pass */
 
 static void render_initialize_geometry_pass(void)
@@ -604,6 +1118,12 @@ static void render_initialize_geometry_pass(void)
     render_globals.geometry_pass.emissive_texture_index = -1;
     render_globals.geometry_pass.view_normal_texture_index = -1;
 
+    struct shader_data *shader = shader_get_data(render_globals.geometry_pass.shader_index);
+    glUniformBlockBinding(shader->program, glGetUniformBlockIndex(shader->program, "node_palette"), NODE_PALETTE_UNIFORM_BLOCK_BINDING);
+
+    shader_use(render_globals.geometry_pass.shader_index);
+    shader_set_int(render_globals.geometry_pass.shader_index, NODE_PALETTE_TEXTURE_UNIT, "node_palette_texture");
+
     render_resize_geometry_pass();
 }
 
@@ -650,14 +1170,20 @@ static void render_resize_geometry_pass(void)
 
 static void render_geometry_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.geometry_pass.framebuffer, 0, 0, render_globals.screen_width, render_globals.screen_height);
 
-    static struct object_iterator iterator;
-    object_iterator_new(&iterator);
+    struct render_culling_data *culling = &render_globals.culling;
+    struct camera_data *camera = game_get_player_camera();
 
-    while (object_iterator_next(&iterator) != -1)
+    for (int visible_index = 0; visible_index < culling->visible_object_indices.count; visible_index++)
     {
-        render_object(render_globals.geometry_pass.shader_index, iterator.index);
+        render_object(
+            render_globals.geometry_pass.shader_index,
+            culling->visible_object_indices.elements[visible_index],
+            &camera->frustum,
+            culling->counters + _render_culling_pass_geometry);
     }
 }
 
@@ -684,6 +1210,8 @@ static void render_resize_depth_pass(void)
 
 static void render_depth_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.depth_pass.framebuffer, 0, 0, render_globals.screen_width, render_globals.screen_height);
     framebuffer_copy(
         &render_globals.geometry_pass.framebuffer, _render_geometry_pass_depth_buffer, 0, 0, render_globals.screen_width, render_globals.screen_height,
@@ -748,6 +1276,8 @@ static void render_resize_occlusion_pass(void)
 
 static void render_occlusion_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.occlusion_pass.framebuffer, 0, 0, render_globals.screen_width, render_globals.screen_height);
 
     shader_use(render_globals.occlusion_pass.shader_index);
@@ -789,6 +1319,8 @@ static void render_resize_shadow_pass(void)
 
 static void render_shadow_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.shadow_pass.framebuffer, 0, 0, render_globals.shadow_pass.texture_width, render_globals.shadow_pass.texture_height);
     
     // TODO: render objects from each light's perspective
@@ -823,6 +1355,8 @@ static void render_resize_lighting_pass(void)
 
 static void render_lighting_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.lighting_pass.framebuffer, 0, 0, render_globals.screen_width, render_globals.screen_height);
 
     shader_use(render_globals.lighting_pass.shader_index);
@@ -875,6 +1409,8 @@ static void render_resize_transparent_pass(void)
 
 static void render_transparent_pass(void)
 {
+    PROFILER_FUNCTION();
+
     // TODO
 }
 
@@ -901,6 +1437,8 @@ static void render_resize_postprocess_pass(void)
 
 static void render_postprocess_pass(void)
 {
+    PROFILER_FUNCTION();
+
     // TODO
 }
 
@@ -928,6 +1466,8 @@ static void render_resize_blur_pass(void)
 
 static void render_blur_pass(void)
 {
+    PROFILER_FUNCTION();
+
     bool blur_horizontal = true;
     const int blur_pass_count = 1;
 
@@ -979,6 +1519,8 @@ static void render_resize_hdr_pass(void)
 
 static void render_hdr_pass(void)
 {
+    PROFILER_FUNCTION();
+
     framebuffer_clear(&render_globals.hdr_pass.framebuffer, 0, 0, render_globals.screen_width, render_globals.screen_height);
 
     shader_use(render_globals.hdr_pass.shader_index);
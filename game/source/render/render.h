@@ -4,8 +4,35 @@ RENDER.H
 */
 
 #pragma once
+#include <stdbool.h>
 #include <cglm/cglm.h>
 
+/* ---------- constants */
+
+/**
+ * The passes that frustum cull objects. The geometry pass is the only pass that draws objects; the skinning pass
+ * reuses its visible objects, and the depth, shadow and transparent passes draw none.
+ */
+enum render_culling_pass
+{
+    _render_culling_pass_geometry,
+    NUMBER_OF_RENDER_CULLING_PASSES
+};
+
+/* ---------- types */
+
+/**
+ * How many objects and mesh parts a pass drew, and how many it skipped because they were outside its frustum.
+ */
+struct render_culling_counters
+{
+    int submitted_object_count;
+    int culled_object_count;
+
+    int submitted_part_count;
+    int culled_part_count;
+};
+
 /* ---------- prototypes/RENDER.C */
 
 void render_initialize(void);
@@ -13,3 +40,15 @@ void render_dispose(void);
 void render_handle_screen_resize(int width, int height);
 void render_load_content(void);
 void render_update(float delta_ticks);
+
+/**
+ * Whether skinned meshes are skinned once per frame into their own vertex buffers before any pass draws them,
+ * instead of being skinned again in the vertex shader of every pass.
+ */
+bool render_get_skinning_pass_enabled(void);
+void render_set_skinning_pass_enabled(bool enabled);
+
+/**
+ * Gets the culling counters of a pass for the last frame.
+ */
+const struct render_culling_counters *render_get_culling_counters(enum render_culling_pass pass);
@@ -9,9 +9,16 @@ SHELL.C
 #include <SDL.h>
 
 #include "common/common.h"
+#include "common/string_ids.h"
+#include "jobs/jobs.h"
+#include "memory/arenas.h"
+#include "memory/heap.h"
+#include "profiler/profiler.h"
 #include "models/models.h"
 #include "objects/objects.h"
+#include "animations/animation_pose_cache.h"
 #include "rasterizer/rasterizer_shaders.h"
+#include "rasterizer/rasterizer_textures.h"
 #include "objects/lights.h"
 #include "game/game.h"
 #include "render/render.h"
@@ -32,6 +39,14 @@ struct shell_component
 
 static const struct shell_component shell_components[] =
 {
+    {
+        "textures",
+        textures_initialize,
+        textures_dispose,
+        NULL,
+        NULL,
+        NULL,
+    },
     {
         "lights",
         lights_initialize,
@@ -87,6 +102,14 @@ enum
     NUMBER_OF_SHELL_COMPONENTS = sizeof(shell_components) / sizeof(struct shell_component)
 };
 
+enum
+{
+    SHELL_SKINNING_PASS_KEY = SDL_SCANCODE_F8,
+    SHELL_PROFILER_TRACE_KEY = SDL_SCANCODE_F9,
+};
+
+#define SHELL_PROFILER_TRACE_FILE_PATH "profile.json"
+
 enum shell_flags
 {
     _shell_capture_mouse_bit,
@@ -105,6 +128,8 @@ struct
     uint64_t frame_count;
     uint64_t last_frame_time;
     uint64_t last_fps_display_time;
+    unsigned int last_heap_allocation_count;
+    unsigned int frame_heap_allocation_count;
 } static shell_globals;
 
 /* ---------- private prototypes */
@@ -114,6 +139,8 @@ static inline void shell_dispose(void);
 static inline void shell_load_content(void);
 static inline void shell_handle_screen_resize(void);
 static inline void shell_update(void);
+static void shell_toggle_skinning_pass(void);
+static void shell_dump_profiler(void);
 
 /* ---------- public code */
 
@@ -163,6 +190,10 @@ static inline void shell_initialize(void)
 
     SDL_GL_SetSwapInterval(0);
 
+    profiler_set_thread_name("main");
+    frame_arena_initialize(DEFAULT_FRAME_ARENA_SIZE);
+    jobs_initialize(-1);
+
     for (int i = 0; i < NUMBER_OF_SHELL_COMPONENTS; i++)
         if (shell_components[i].initialize)
             shell_components[i].initialize();
@@ -174,6 +205,14 @@ static inline void shell_dispose(void)
         if (shell_components[i].dispose)
             shell_components[i].dispose();
 
+    jobs_dispose();
+
+    profiler_write_chrome_trace(SHELL_PROFILER_TRACE_FILE_PATH);
+    profiler_dispose();
+
+    frame_arena_dispose();
+    string_ids_dispose();
+
     SDL_GL_DeleteContext(shell_globals.gl_context);
     SDL_DestroyWindow(shell_globals.window);
     SDL_Quit();
@@ -201,6 +240,16 @@ static inline void shell_handle_screen_resize(void)
 
 static inline void shell_update(void)
 {
+    frame_arena_reset();
+    profiler_end_frame();
+
+    // Counted after the reset, so the frame arena growing to fit the last frame is charged to that frame
+    unsigned int heap_allocation_count = heap_get_allocation_count();
+    shell_globals.frame_heap_allocation_count += heap_allocation_count - shell_globals.last_heap_allocation_count;
+    shell_globals.last_heap_allocation_count = heap_allocation_count;
+
+    PROFILER_FUNCTION();
+
     SDL_CaptureMouse(TEST_BIT(shell_globals.flags, _shell_capture_mouse_bit) ? SDL_TRUE : SDL_FALSE);
     SDL_SetRelativeMouseMode(TEST_BIT(shell_globals.flags, _shell_capture_mouse_bit) ? SDL_TRUE : SDL_FALSE);
 
@@ -212,12 +261,15 @@ static inline void shell_update(void)
     if (((double)(frame_start_time - shell_globals.last_fps_display_time) / (double)SDL_GetPerformanceFrequency()) >= 1.0)
     {
         char fps_string[256];
-        snprintf(fps_string, sizeof(fps_string), "fps: %llu", shell_globals.frame_count);
+        snprintf(fps_string, sizeof(fps_string), "fps: %llu, heap allocations: %u",
+            shell_globals.frame_count,
+            shell_globals.frame_heap_allocation_count);
 
         SDL_SetWindowTitle(shell_globals.window, fps_string);
 
         shell_globals.last_fps_display_time = SDL_GetPerformanceCounter();
         shell_globals.frame_count = 0;
+        shell_globals.frame_heap_allocation_count = 0;
     }
 
     double delta_ticks = ((double)(frame_start_time - shell_globals.last_frame_time) / (double)SDL_GetPerformanceFrequency());
@@ -240,6 +292,10 @@ static inline void shell_update(void)
         case SDL_KEYUP:
             if (event.key.keysym.scancode == SDL_SCANCODE_M)
                 SET_BIT(shell_globals.flags, _shell_capture_mouse_bit, !TEST_BIT(shell_globals.flags, _shell_capture_mouse_bit));
+            else if (event.key.keysym.scancode == SHELL_SKINNING_PASS_KEY)
+                shell_toggle_skinning_pass();
+            else if (event.key.keysym.scancode == SHELL_PROFILER_TRACE_KEY)
+                shell_dump_profiler();
             break;
         
         case SDL_QUIT:
@@ -248,8 +304,15 @@ static inline void shell_update(void)
     }
 
     for (int i = 0; i < NUMBER_OF_SHELL_COMPONENTS; i++)
+    {
         if (shell_components[i].update)
+        {
+            PROFILER_ZONE(shell_components[i].name);
             shell_components[i].update(delta_ticks);
+        }
+    }
+
+    jobs_execute_main_thread_jobs();
     
     SDL_GL_SwapWindow(shell_globals.window);
 
@@ -258,3 +321,70 @@ static inline void shell_update(void)
     shell_globals.last_frame_time = frame_start_time;
     shell_globals.frame_count++;
 }
+
+static void shell_toggle_skinning_pass(void)
+{
+    bool enabled = !render_get_skinning_pass_enabled();
+    render_set_skinning_pass_enabled(enabled);
+
+    printf("skinning pass %s\n", enabled ? "enabled" : "disabled");
+}
+
+static void shell_dump_profiler(void)
+{
+    int zone_count;
+    const struct profiler_frame_zone *zones = profiler_get_frame_zones(&zone_count);
+
+    printf("last frame:\n");
+
+    for (int zone_index = 0; zone_index < zone_count; zone_index++)
+    {
+        const struct profiler_frame_zone *zone = zones + zone_index;
+
+        printf("\t%-40s %6i calls %10.3f ms total %10.3f ms max\n",
+            zone->name,
+            zone->call_count,
+            (double)zone->total_time / 1000000.0,
+            (double)zone->maximum_time / 1000000.0);
+    }
+
+    const struct animation_lod_counters *animation_lod_counters = objects_get_animation_lod_counters();
+
+    printf("animation lod:\n");
+    printf("\t%i full, %i reduced, %i minimal\n",
+        animation_lod_counters->object_counts[_animation_lod_full],
+        animation_lod_counters->object_counts[_animation_lod_reduced],
+        animation_lod_counters->object_counts[_animation_lod_minimal]);
+    printf("\t%i evaluated, %i interpolated, %i nodes masked\n",
+        animation_lod_counters->evaluated_object_count,
+        animation_lod_counters->interpolated_object_count,
+        animation_lod_counters->masked_node_count);
+
+    int pose_cache_request_count;
+    int pose_cache_evaluation_count;
+    animation_pose_cache_get_statistics(&pose_cache_request_count, &pose_cache_evaluation_count);
+
+    printf("\t%i shared pose requests, %i evaluated\n", pose_cache_request_count, pose_cache_evaluation_count);
+
+    static const char *const culling_pass_names[NUMBER_OF_RENDER_CULLING_PASSES] =
+    {
+        [_render_culling_pass_geometry] = "geometry",
+    };
+
+    printf("culling:\n");
+
+    for (int pass = 0; pass < NUMBER_OF_RENDER_CULLING_PASSES; pass++)
+    {
+        const struct render_culling_counters *culling_counters = render_get_culling_counters(pass);
+
+        printf("\t%-10s %6i objects submitted, %6i culled, %6i parts submitted, %6i culled\n",
+            culling_pass_names[pass],
+            culling_counters->submitted_object_count,
+            culling_counters->culled_object_count,
+            culling_counters->submitted_part_count,
+            culling_counters->culled_part_count);
+    }
+
+    if (profiler_write_chrome_trace(SHELL_PROFILER_TRACE_FILE_PATH))
+        printf("wrote profiler trace to \"%s\"\n", SHELL_PROFILER_TRACE_FILE_PATH);
+}
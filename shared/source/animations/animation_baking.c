@@ -0,0 +1,161 @@
+/*
+ANIMATION_BAKING.C
+    Animation clip baking code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_baking.h"
+
+/* ---------- public code */
+
+void animation_bake(
+    struct animation_data *animation,
+    const struct animation_pose_buffer *default_pose,
+    float frames_per_second)
+{
+    assert(animation);
+    assert(default_pose);
+    assert(frames_per_second > 0.0f);
+    assert(animation->ticks_per_second > 0.0f);
+
+    animation_unbake(animation);
+
+    // Spread the frames evenly so the first lands on time 0 and the last exactly on the duration
+    float frames_per_tick = frames_per_second / animation->ticks_per_second;
+    int frame_count = 1 + (int)ceilf(animation->duration * frames_per_tick);
+
+    animation->baked_frame_count = frame_count;
+    animation->baked_frames_per_tick = frame_count > 1 ? (float)(frame_count - 1) / animation->duration : 0.0f;
+    animation->baked_frames = calloc((size_t)animation->channel_count * frame_count, sizeof(*animation->baked_frames));
+    assert(!animation->channel_count || animation->baked_frames);
+
+    for (int channel_index = 0; channel_index < animation->channel_count; channel_index++)
+    {
+        const struct animation_channel *channel = animation->channels + channel_index;
+
+        if (channel->type != _animation_channel_type_node)
+            continue;
+
+        struct animation_baked_frame *frames = animation->baked_frames + ((size_t)channel_index * frame_count);
+
+        struct animation_channel_cursor cursor;
+        animation_channel_cursors_initialize(&cursor, 1);
+
+        for (int frame_index = 0; frame_index < frame_count; frame_index++)
+        {
+            float time = frame_count > 1 ? ((float)frame_index / animation->baked_frames_per_tick) : 0.0f;
+
+            struct animation_node_state node_state;
+            animation_pose_buffer_get_node_state(default_pose, channel->node_index, &node_state);
+            animation_channel_sample(animation, channel, time, &cursor, &node_state);
+
+            // Keep neighboring frames in the same hemisphere so sampling can blend them without checking
+            if (frame_index > 0)
+            {
+                const float *previous_rotation = frames[frame_index - 1].rotation;
+                float dot = 0.0f;
+
+                for (int i = 0; i < 4; i++)
+                    dot += previous_rotation[i] * node_state.rotation[i];
+
+                if (dot < 0.0f)
+                {
+                    for (int i = 0; i < 4; i++)
+                        node_state.rotation[i] = -node_state.rotation[i];
+                }
+            }
+
+            struct animation_baked_frame *frame = frames + frame_index;
+            memcpy(frame->rotation, node_state.rotation, sizeof(frame->rotation));
+            memcpy(frame->position, node_state.position, sizeof(frame->position));
+            memcpy(frame->scale, node_state.scale, sizeof(frame->scale));
+        }
+    }
+}
+
+void animation_unbake(
+    struct animation_data *animation)
+{
+    assert(animation);
+
+    free(animation->baked_frames);
+
+    animation->baked_frame_count = 0;
+    animation->baked_frames_per_tick = 0.0f;
+    animation->baked_frames = NULL;
+}
+
+bool animation_is_baked(
+    const struct animation_data *animation)
+{
+    assert(animation);
+    return animation->baked_frames != NULL;
+}
+
+size_t animation_get_baked_size(
+    const struct animation_data *animation)
+{
+    assert(animation);
+    return (size_t)animation->channel_count * animation->baked_frame_count * sizeof(*animation->baked_frames);
+}
+
+void animation_sample_baked_pose(
+    const struct animation_data *animation,
+    const struct animation_pose_buffer *default_pose,
+    float time,
+    const unsigned int *node_mask,
+    struct animation_pose_buffer *out_pose)
+{
+    assert(animation);
+    assert(animation_is_baked(animation));
+    assert(default_pose);
+    assert(out_pose);
+    assert(default_pose->node_count == out_pose->node_count);
+
+    animation_pose_buffer_copy(out_pose, default_pose);
+
+    // The same two frames and factor serve every node
+    int frame_count = animation->baked_frame_count;
+    float frame_position = fminf(fmaxf(time * animation->baked_frames_per_tick, 0.0f), (float)(frame_count - 1));
+    int frame_index = (int)frame_position;
+    int next_frame_index = frame_index + 1 < frame_count ? frame_index + 1 : frame_index;
+    float factor = frame_position - (float)frame_index;
+
+    for (int node_index = 0; node_index < out_pose->node_count; node_index++)
+    {
+        int channel_index = animation->node_channel_indices[node_index];
+
+        if (channel_index == -1 || (node_mask && !BIT_VECTOR_TEST_BIT(node_mask, node_index)))
+            continue;
+
+        const struct animation_baked_frame *frames = animation->baked_frames + ((size_t)channel_index * frame_count);
+        const struct animation_baked_frame *frame = frames + frame_index;
+        const struct animation_baked_frame *next_frame = frames + next_frame_index;
+
+        for (int i = 0; i < 3; i++)
+        {
+            out_pose->position[i][node_index] = frame->position[i] + ((next_frame->position[i] - frame->position[i]) * factor);
+            out_pose->scale[i][node_index] = frame->scale[i] + ((next_frame->scale[i] - frame->scale[i]) * factor);
+        }
+
+        // Frames are a fraction of a second apart and already share a hemisphere, so a normalized lerp stands in for a slerp
+        float rotation[4];
+        float length_squared = 0.0f;
+
+        for (int i = 0; i < 4; i++)
+        {
+            rotation[i] = frame->rotation[i] + ((next_frame->rotation[i] - frame->rotation[i]) * factor);
+            length_squared += rotation[i] * rotation[i];
+        }
+
+        float inverse_length = length_squared > 0.0f ? 1.0f / sqrtf(length_squared) : 0.0f;
+
+        for (int i = 0; i < 4; i++)
+            out_pose->rotation[i][node_index] = rotation[i] * inverse_length;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ANIMATION_BAKING.H
+    Animation clip baking declarations.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "animations/animation_data.h"
+#include "animations/animation_poses.h"
+
+/* ---------- constants */
+
+#define ANIMATION_BAKING_DEFAULT_FRAMES_PER_SECOND 30.0f
+
+/* ---------- prototypes/ANIMATION_BAKING.C */
+
+/**
+ * Resamples every node channel of an animation at a fixed rate into a dense table of frames.
+ * The keys are kept, so the animation can be unbaked again.
+ * @param animation The animation to bake. Rebaking replaces its existing frames.
+ * @param default_pose The default state of each node, for components a channel has no keys for.
+ * @param frames_per_second The rate to resample at, in frames per second of playback.
+ */
+void animation_bake(struct animation_data *animation, const struct animation_pose_buffer *default_pose, float frames_per_second);
+
+/**
+ * Frees an animation's baked frames, returning it to sampling from its keys.
+ */
+void animation_unbake(struct animation_data *animation);
+
+bool animation_is_baked(const struct animation_data *animation);
+
+/**
+ * Gets the number of bytes an animation's baked frames take.
+ */
+size_t animation_get_baked_size(const struct animation_data *animation);
+
+/**
+ * Samples a local pose for every node from a baked animation: one index and a blend between two frames per node,
+ * with no key search. Nodes the animation has no channel for take their default state.
+ * @param animation The baked animation to sample.
+ * @param default_pose The default state of each node.
+ * @param time The time to sample at, in ticks.
+ * @param node_mask A bit vector of the nodes to sample, or NULL to sample every node. Unsampled nodes take their default state.
+ * @param out_pose The pose buffer to write the pose to, with the same node count as the default pose.
+ */
+void animation_sample_baked_pose(
+    const struct animation_data *animation,
+    const struct animation_pose_buffer *default_pose,
+    float time,
+    const unsigned int *node_mask,
+    struct animation_pose_buffer *out_pose);
@@ -0,0 +1,339 @@
+/*
+ANIMATION_BLENDING.C
+    Animation pose blending code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+
+#include "animations/animation_blending.h"
+
+/* ---------- private types */
+
+// Pose buffers are padded to ANIMATION_POSE_NODE_COUNT_GRANULARITY nodes, so any of these widths divides them evenly.
+// Define ANIMATION_BLENDING_SCALAR to force the portable path.
+#if defined(__AVX__) && !defined(ANIMATION_BLENDING_SCALAR)
+
+#include <immintrin.h>
+
+#define ANIMATION_BLEND_VECTOR_WIDTH 8
+
+typedef __m256 animation_blend_vector;
+
+static inline animation_blend_vector animation_blend_vector_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void animation_blend_vector_store(float *p, animation_blend_vector a) { _mm256_storeu_ps(p, a); }
+static inline animation_blend_vector animation_blend_vector_set(float a) { return _mm256_set1_ps(a); }
+static inline animation_blend_vector animation_blend_vector_add(animation_blend_vector a, animation_blend_vector b) { return _mm256_add_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_sub(animation_blend_vector a, animation_blend_vector b) { return _mm256_sub_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_mul(animation_blend_vector a, animation_blend_vector b) { return _mm256_mul_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_div(animation_blend_vector a, animation_blend_vector b) { return _mm256_div_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_sqrt(animation_blend_vector a) { return _mm256_sqrt_ps(a); }
+
+// Negates a where b is negative
+static inline animation_blend_vector animation_blend_vector_sign(animation_blend_vector a, animation_blend_vector b)
+{
+    return _mm256_xor_ps(a, _mm256_and_ps(b, _mm256_set1_ps(-0.0f)));
+}
+
+#elif (defined(__SSE__) || defined(_M_X64)) && !defined(ANIMATION_BLENDING_SCALAR)
+
+#include <xmmintrin.h>
+
+#define ANIMATION_BLEND_VECTOR_WIDTH 4
+
+typedef __m128 animation_blend_vector;
+
+static inline animation_blend_vector animation_blend_vector_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void animation_blend_vector_store(float *p, animation_blend_vector a) { _mm_storeu_ps(p, a); }
+static inline animation_blend_vector animation_blend_vector_set(float a) { return _mm_set1_ps(a); }
+static inline animation_blend_vector animation_blend_vector_add(animation_blend_vector a, animation_blend_vector b) { return _mm_add_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_sub(animation_blend_vector a, animation_blend_vector b) { return _mm_sub_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_mul(animation_blend_vector a, animation_blend_vector b) { return _mm_mul_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_div(animation_blend_vector a, animation_blend_vector b) { return _mm_div_ps(a, b); }
+static inline animation_blend_vector animation_blend_vector_sqrt(animation_blend_vector a) { return _mm_sqrt_ps(a); }
+
+// Negates a where b is negative
+static inline animation_blend_vector animation_blend_vector_sign(animation_blend_vector a, animation_blend_vector b)
+{
+    return _mm_xor_ps(a, _mm_and_ps(b, _mm_set1_ps(-0.0f)));
+}
+
+#else
+
+#define ANIMATION_BLEND_VECTOR_WIDTH 1
+
+typedef float animation_blend_vector;
+
+static inline animation_blend_vector animation_blend_vector_load(const float *p) { return *p; }
+static inline void animation_blend_vector_store(float *p, animation_blend_vector a) { *p = a; }
+static inline animation_blend_vector animation_blend_vector_set(float a) { return a; }
+static inline animation_blend_vector animation_blend_vector_add(animation_blend_vector a, animation_blend_vector b) { return a + b; }
+static inline animation_blend_vector animation_blend_vector_sub(animation_blend_vector a, animation_blend_vector b) { return a - b; }
+static inline animation_blend_vector animation_blend_vector_mul(animation_blend_vector a, animation_blend_vector b) { return a * b; }
+static inline animation_blend_vector animation_blend_vector_div(animation_blend_vector a, animation_blend_vector b) { return a / b; }
+static inline animation_blend_vector animation_blend_vector_sqrt(animation_blend_vector a) { return sqrtf(a); }
+
+// Negates a where b is negative
+static inline animation_blend_vector animation_blend_vector_sign(animation_blend_vector a, animation_blend_vector b)
+{
+    return signbit(b) ? -a : a;
+}
+
+#endif
+
+static_assert(ANIMATION_POSE_NODE_COUNT_GRANULARITY % ANIMATION_BLEND_VECTOR_WIDTH == 0);
+
+/* ---------- private prototypes */
+
+static inline animation_blend_vector animation_blend_vector_madd(animation_blend_vector a, animation_blend_vector b, animation_blend_vector c);
+static inline void animation_blend_quaternion_normalize(animation_blend_vector q[4]);
+static inline void animation_blend_quaternion_multiply(const animation_blend_vector a[4], const animation_blend_vector b[4], animation_blend_vector out[4]);
+
+static void animation_pose_blend_overrides(const struct animation_blend_layer *layers, int layer_count, float total_weight, const struct animation_pose_buffer *base_pose, struct animation_pose_buffer *out_pose);
+static void animation_pose_blend_additive(const struct animation_blend_layer *layer, const struct animation_pose_buffer *base_pose, struct animation_pose_buffer *out_pose);
+
+/* ---------- public code */
+
+void animation_pose_blend(
+    const struct animation_blend_layer *layers,
+    int layer_count,
+    const struct animation_pose_buffer *base_pose,
+    struct animation_pose_buffer *out_pose)
+{
+    assert(layer_count >= 0);
+    assert(!layer_count || layers);
+    assert(base_pose);
+    assert(out_pose);
+    assert(base_pose->padded_node_count == out_pose->padded_node_count);
+
+    float total_override_weight = 0.0f;
+    int override_layer_count = 0;
+
+    for (int layer_index = 0; layer_index < layer_count; layer_index++)
+    {
+        const struct animation_blend_layer *layer = layers + layer_index;
+
+        assert(layer->pose);
+        assert(layer->pose != out_pose);
+        assert(layer->pose->padded_node_count == out_pose->padded_node_count);
+        assert(layer->mode >= 0 && layer->mode < NUMBER_OF_ANIMATION_BLEND_MODES);
+
+        if (layer->mode == _animation_blend_mode_override && layer->weight > 0.0f)
+        {
+            total_override_weight += layer->weight;
+            override_layer_count++;
+        }
+    }
+
+    if (override_layer_count)
+        animation_pose_blend_overrides(layers, layer_count, total_override_weight, base_pose, out_pose);
+    else if (out_pose != base_pose)
+        animation_pose_buffer_copy(out_pose, base_pose);
+
+    for (int layer_index = 0; layer_index < layer_count; layer_index++)
+    {
+        const struct animation_blend_layer *layer = layers + layer_index;
+
+        if (layer->mode == _animation_blend_mode_additive && layer->weight > 0.0f)
+            animation_pose_blend_additive(layer, base_pose, out_pose);
+    }
+}
+
+/* ---------- private code */
+
+static inline animation_blend_vector animation_blend_vector_madd(
+    animation_blend_vector a,
+    animation_blend_vector b,
+    animation_blend_vector c)
+{
+    return animation_blend_vector_add(animation_blend_vector_mul(a, b), c);
+}
+
+static inline void animation_blend_quaternion_normalize(
+    animation_blend_vector q[4])
+{
+    animation_blend_vector length_squared = animation_blend_vector_mul(q[0], q[0]);
+    length_squared = animation_blend_vector_madd(q[1], q[1], length_squared);
+    length_squared = animation_blend_vector_madd(q[2], q[2], length_squared);
+    length_squared = animation_blend_vector_madd(q[3], q[3], length_squared);
+
+    animation_blend_vector inverse_length = animation_blend_vector_div(animation_blend_vector_set(1.0f), animation_blend_vector_sqrt(length_squared));
+
+    for (int i = 0; i < 4; i++)
+        q[i] = animation_blend_vector_mul(q[i], inverse_length);
+}
+
+static inline void animation_blend_quaternion_multiply(
+    const animation_blend_vector a[4],
+    const animation_blend_vector b[4],
+    animation_blend_vector out[4])
+{
+    // Components are (x, y, z, w)
+    animation_blend_vector x = animation_blend_vector_mul(a[3], b[0]);
+    x = animation_blend_vector_madd(a[0], b[3], x);
+    x = animation_blend_vector_madd(a[1], b[2], x);
+    x = animation_blend_vector_sub(x, animation_blend_vector_mul(a[2], b[1]));
+
+    animation_blend_vector y = animation_blend_vector_mul(a[3], b[1]);
+    y = animation_blend_vector_sub(y, animation_blend_vector_mul(a[0], b[2]));
+    y = animation_blend_vector_madd(a[1], b[3], y);
+    y = animation_blend_vector_madd(a[2], b[0], y);
+
+    animation_blend_vector z = animation_blend_vector_mul(a[3], b[2]);
+    z = animation_blend_vector_madd(a[0], b[1], z);
+    z = animation_blend_vector_sub(z, animation_blend_vector_mul(a[1], b[0]));
+    z = animation_blend_vector_madd(a[2], b[3], z);
+
+    animation_blend_vector w = animation_blend_vector_mul(a[3], b[3]);
+    w = animation_blend_vector_sub(w, animation_blend_vector_mul(a[0], b[0]));
+    w = animation_blend_vector_sub(w, animation_blend_vector_mul(a[1], b[1]));
+    w = animation_blend_vector_sub(w, animation_blend_vector_mul(a[2], b[2]));
+
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+    out[3] = w;
+}
+
+static void animation_pose_blend_overrides(
+    const struct animation_blend_layer *layers,
+    int layer_count,
+    float total_weight,
+    const struct animation_pose_buffer *base_pose,
+    struct animation_pose_buffer *out_pose)
+{
+    // The base pose fills in whatever weight the layers leave below one, and weights above one are normalized
+    float base_weight = total_weight < 1.0f ? 1.0f - total_weight : 0.0f;
+    float inverse_total_weight = 1.0f / (total_weight + base_weight);
+
+    for (int node_index = 0; node_index < out_pose->padded_node_count; node_index += ANIMATION_BLEND_VECTOR_WIDTH)
+    {
+        animation_blend_vector base_rotation[4];
+        animation_blend_vector position[3];
+        animation_blend_vector rotation[4];
+        animation_blend_vector scale[3];
+
+        animation_blend_vector weight = animation_blend_vector_set(base_weight);
+
+        for (int i = 0; i < 4; i++)
+        {
+            base_rotation[i] = animation_blend_vector_load(base_pose->rotation[i] + node_index);
+            rotation[i] = animation_blend_vector_mul(base_rotation[i], weight);
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            position[i] = animation_blend_vector_mul(animation_blend_vector_load(base_pose->position[i] + node_index), weight);
+            scale[i] = animation_blend_vector_mul(animation_blend_vector_load(base_pose->scale[i] + node_index), weight);
+        }
+
+        for (int layer_index = 0; layer_index < layer_count; layer_index++)
+        {
+            const struct animation_blend_layer *layer = layers + layer_index;
+
+            if (layer->mode != _animation_blend_mode_override || layer->weight <= 0.0f)
+                continue;
+
+            const struct animation_pose_buffer *pose = layer->pose;
+            weight = animation_blend_vector_set(layer->weight);
+
+            for (int i = 0; i < 3; i++)
+            {
+                position[i] = animation_blend_vector_madd(animation_blend_vector_load(pose->position[i] + node_index), weight, position[i]);
+                scale[i] = animation_blend_vector_madd(animation_blend_vector_load(pose->scale[i] + node_index), weight, scale[i]);
+            }
+
+            // Accumulate every rotation in the base rotation's hemisphere so opposite-signed equivalents don't cancel out
+            animation_blend_vector layer_rotation[4];
+            animation_blend_vector dot = animation_blend_vector_set(0.0f);
+
+            for (int i = 0; i < 4; i++)
+            {
+                layer_rotation[i] = animation_blend_vector_load(pose->rotation[i] + node_index);
+                dot = animation_blend_vector_madd(layer_rotation[i], base_rotation[i], dot);
+            }
+
+            animation_blend_vector signed_weight = animation_blend_vector_sign(weight, dot);
+
+            for (int i = 0; i < 4; i++)
+                rotation[i] = animation_blend_vector_madd(layer_rotation[i], signed_weight, rotation[i]);
+        }
+
+        animation_blend_quaternion_normalize(rotation);
+
+        weight = animation_blend_vector_set(inverse_total_weight);
+
+        for (int i = 0; i < 3; i++)
+        {
+            animation_blend_vector_store(out_pose->position[i] + node_index, animation_blend_vector_mul(position[i], weight));
+            animation_blend_vector_store(out_pose->scale[i] + node_index, animation_blend_vector_mul(scale[i], weight));
+        }
+
+        for (int i = 0; i < 4; i++)
+            animation_blend_vector_store(out_pose->rotation[i] + node_index, rotation[i]);
+    }
+}
+
+static void animation_pose_blend_additive(
+    const struct animation_blend_layer *layer,
+    const struct animation_pose_buffer *base_pose,
+    struct animation_pose_buffer *out_pose)
+{
+    const struct animation_pose_buffer *pose = layer->pose;
+
+    animation_blend_vector weight = animation_blend_vector_set(layer->weight);
+    animation_blend_vector inverse_weight = animation_blend_vector_set(1.0f - layer->weight);
+    animation_blend_vector one = animation_blend_vector_set(1.0f);
+
+    for (int node_index = 0; node_index < out_pose->padded_node_count; node_index += ANIMATION_BLEND_VECTOR_WIDTH)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            animation_blend_vector base_position = animation_blend_vector_load(base_pose->position[i] + node_index);
+            animation_blend_vector delta_position = animation_blend_vector_sub(animation_blend_vector_load(pose->position[i] + node_index), base_position);
+            animation_blend_vector position = animation_blend_vector_madd(delta_position, weight, animation_blend_vector_load(out_pose->position[i] + node_index));
+            animation_blend_vector_store(out_pose->position[i] + node_index, position);
+
+            // Scale is a factor, so the layer contributes its ratio to the base scale rather than a difference
+            animation_blend_vector base_scale = animation_blend_vector_load(base_pose->scale[i] + node_index);
+            animation_blend_vector scale_ratio = animation_blend_vector_div(animation_blend_vector_load(pose->scale[i] + node_index), base_scale);
+            animation_blend_vector scale_factor = animation_blend_vector_madd(animation_blend_vector_sub(scale_ratio, one), weight, one);
+            animation_blend_vector_store(out_pose->scale[i] + node_index, animation_blend_vector_mul(animation_blend_vector_load(out_pose->scale[i] + node_index), scale_factor));
+        }
+
+        animation_blend_vector layer_rotation[4];
+        animation_blend_vector inverse_base_rotation[4];
+        animation_blend_vector out_rotation[4];
+
+        for (int i = 0; i < 4; i++)
+        {
+            layer_rotation[i] = animation_blend_vector_load(pose->rotation[i] + node_index);
+            inverse_base_rotation[i] = animation_blend_vector_load(base_pose->rotation[i] + node_index);
+            out_rotation[i] = animation_blend_vector_load(out_pose->rotation[i] + node_index);
+        }
+
+        // The base rotation is a unit quaternion, so its conjugate is its inverse
+        for (int i = 0; i < 3; i++)
+            inverse_base_rotation[i] = animation_blend_vector_sub(animation_blend_vector_set(0.0f), inverse_base_rotation[i]);
+
+        animation_blend_vector delta_rotation[4];
+        animation_blend_quaternion_multiply(layer_rotation, inverse_base_rotation, delta_rotation);
+
+        // Scale the delta by normalized lerp from identity, taking the short way round
+        animation_blend_vector signed_weight = animation_blend_vector_sign(weight, delta_rotation[3]);
+
+        for (int i = 0; i < 3; i++)
+            delta_rotation[i] = animation_blend_vector_mul(delta_rotation[i], signed_weight);
+
+        delta_rotation[3] = animation_blend_vector_madd(delta_rotation[3], signed_weight, inverse_weight);
+        animation_blend_quaternion_normalize(delta_rotation);
+
+        animation_blend_vector rotation[4];
+        animation_blend_quaternion_multiply(delta_rotation, out_rotation, rotation);
+        animation_blend_quaternion_normalize(rotation);
+
+        for (int i = 0; i < 4; i++)
+            animation_blend_vector_store(out_pose->rotation[i] + node_index, rotation[i]);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ANIMATION_BLENDING.H
+    Animation pose blending declarations.
+*/
+
+#pragma once
+
+#include "animations/animation_poses.h"
+
+/* ---------- types */
+
+enum animation_blend_mode
+{
+    // Blends toward the layer's pose by its weight; weights beyond a total of one are normalized
+    _animation_blend_mode_override,
+
+    // Adds the layer's difference from the base pose, scaled by its weight, on top of the override result
+    _animation_blend_mode_additive,
+
+    NUMBER_OF_ANIMATION_BLEND_MODES
+};
+
+struct animation_blend_layer
+{
+    const struct animation_pose_buffer *pose;
+    float weight;
+    enum animation_blend_mode mode;
+};
+
+/* ---------- prototypes/ANIMATION_BLENDING.C */
+
+/**
+ * Blends any number of pose layers over a base pose, a whole component array at a time.
+ * Override layers are blended first; the base pose takes whatever weight they leave below one.
+ * Additive layers are then applied relative to the base pose, in layer order.
+ * @param layers The layers to blend.
+ * @param layer_count The number of layers.
+ * @param base_pose The pose to blend over, usually the model's default pose.
+ * @param out_pose The pose buffer to write the blended pose to. May not alias a layer's pose.
+ */
+void animation_pose_blend(
+    const struct animation_blend_layer *layers,
+    int layer_count,
+    const struct animation_pose_buffer *base_pose,
+    struct animation_pose_buffer *out_pose);
@@ -0,0 +1,530 @@
+/*
+ANIMATION_COMPRESSION.C
+    Animation clip compression code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "animations/animation_compression.h"
+#include "animations/animation_poses.h"
+
+/* ---------- private constants */
+
+#define ANIMATION_COMPRESSION_QUANTIZED_MAXIMUM 65535.0f
+
+// Smallest-three components lie within [-1/sqrt(2), 1/sqrt(2)] and take 15 bits each
+#define ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT 0.70710678f
+#define ANIMATION_COMPRESSION_ROTATION_COMPONENT_MAXIMUM 32767.0f
+
+enum animation_track_type
+{
+    _animation_track_position,
+    _animation_track_rotation,
+    _animation_track_scaling,
+    NUMBER_OF_ANIMATION_TRACK_TYPES
+};
+
+/* ---------- private types */
+
+struct animation_track
+{
+    enum animation_track_type type;
+    int component_count;
+    float tolerance;
+
+    int key_count;
+    const float *key_times;
+    const float *key_values;
+};
+
+/* ---------- private prototypes */
+
+static void animation_compression_compute_range(
+    const struct animation_raw_channel *raw_channel,
+    enum animation_track_type type,
+    float *out_minimum,
+    float *out_extent);
+
+static void animation_compress_track(
+    const struct animation_channel *channel,
+    const struct animation_track *track,
+    int *out_key_count,
+    float **out_key_times,
+    uint16_t (**out_key_values)[3],
+    struct animation_compression_statistics *statistics);
+
+static void animation_track_encode(const struct animation_channel *channel, enum animation_track_type type, const float *value, uint16_t *out_value);
+static void animation_track_decode(const struct animation_channel *channel, enum animation_track_type type, const uint16_t *value, float *out_value);
+static void animation_track_interpolate(enum animation_track_type type, const float *a, const float *b, float t, float *out_value);
+static float animation_track_get_error(enum animation_track_type type, const float *a, const float *b);
+
+static float animation_quantize(float value, float minimum, float extent);
+static float animation_dequantize(uint16_t value, float minimum, float extent);
+
+/* ---------- public code */
+
+void animation_raw_channel_initialize(
+    struct animation_raw_channel *channel,
+    int position_key_count,
+    int rotation_key_count,
+    int scaling_key_count)
+{
+    assert(channel);
+    assert(position_key_count >= 0 && rotation_key_count >= 0 && scaling_key_count >= 0);
+
+    memset(channel, 0, sizeof(*channel));
+
+    // Key times live apart from key values so keyframe searches only touch the times
+    channel->position_key_count = position_key_count;
+    channel->position_key_times = malloc(position_key_count * sizeof(*channel->position_key_times));
+    channel->position_key_values = malloc(position_key_count * sizeof(*channel->position_key_values));
+    assert(!position_key_count || (channel->position_key_times && channel->position_key_values));
+
+    channel->rotation_key_count = rotation_key_count;
+    channel->rotation_key_times = malloc(rotation_key_count * sizeof(*channel->rotation_key_times));
+    channel->rotation_key_values = malloc(rotation_key_count * sizeof(*channel->rotation_key_values));
+    assert(!rotation_key_count || (channel->rotation_key_times && channel->rotation_key_values));
+
+    channel->scaling_key_count = scaling_key_count;
+    channel->scaling_key_times = malloc(scaling_key_count * sizeof(*channel->scaling_key_times));
+    channel->scaling_key_values = malloc(scaling_key_count * sizeof(*channel->scaling_key_values));
+    assert(!scaling_key_count || (channel->scaling_key_times && channel->scaling_key_values));
+}
+
+void animation_raw_channel_dispose(
+    struct animation_raw_channel *channel)
+{
+    assert(channel);
+
+    free(channel->position_key_times);
+    free(channel->position_key_values);
+    free(channel->rotation_key_times);
+    free(channel->rotation_key_values);
+    free(channel->scaling_key_times);
+    free(channel->scaling_key_values);
+
+    memset(channel, 0, sizeof(*channel));
+}
+
+void animation_compress(
+    struct animation_data *animation,
+    const struct animation_raw_channel *raw_channels,
+    const struct animation_compression_settings *settings,
+    struct animation_compression_statistics *statistics)
+{
+    assert(animation);
+    assert(!animation->channel_count || raw_channels);
+
+    const struct animation_compression_settings default_settings =
+    {
+        .position_tolerance = ANIMATION_COMPRESSION_DEFAULT_POSITION_TOLERANCE,
+        .rotation_tolerance = ANIMATION_COMPRESSION_DEFAULT_ROTATION_TOLERANCE,
+        .scaling_tolerance = ANIMATION_COMPRESSION_DEFAULT_SCALING_TOLERANCE,
+    };
+
+    if (!settings)
+        settings = &default_settings;
+
+    for (int channel_index = 0; channel_index < animation->channel_count; channel_index++)
+    {
+        struct animation_channel *channel = animation->channels + channel_index;
+        const struct animation_raw_channel *raw_channel = raw_channels + channel_index;
+
+        if (channel->type != _animation_channel_type_node)
+            continue;
+
+        animation_compression_compute_range(raw_channel, _animation_track_position, channel->position_range_minimum, channel->position_range_extent);
+        animation_compression_compute_range(raw_channel, _animation_track_scaling, channel->scaling_range_minimum, channel->scaling_range_extent);
+
+        if (statistics)
+            statistics->compressed_size += sizeof(channel->position_range_minimum) * 4;
+
+        struct animation_track position_track =
+        {
+            .type = _animation_track_position,
+            .component_count = 3,
+            .tolerance = settings->position_tolerance,
+            .key_count = raw_channel->position_key_count,
+            .key_times = raw_channel->position_key_times,
+            .key_values = (const float *)raw_channel->position_key_values,
+        };
+
+        struct animation_track rotation_track =
+        {
+            .type = _animation_track_rotation,
+            .component_count = 4,
+            .tolerance = settings->rotation_tolerance,
+            .key_count = raw_channel->rotation_key_count,
+            .key_times = raw_channel->rotation_key_times,
+            .key_values = (const float *)raw_channel->rotation_key_values,
+        };
+
+        struct animation_track scaling_track =
+        {
+            .type = _animation_track_scaling,
+            .component_count = 3,
+            .tolerance = settings->scaling_tolerance,
+            .key_count = raw_channel->scaling_key_count,
+            .key_times = raw_channel->scaling_key_times,
+            .key_values = (const float *)raw_channel->scaling_key_values,
+        };
+
+        animation_compress_track(channel, &position_track, &channel->position_key_count, &channel->position_key_times, &channel->position_key_values, statistics);
+        animation_compress_track(channel, &rotation_track, &channel->rotation_key_count, &channel->rotation_key_times, &channel->rotation_key_values, statistics);
+        animation_compress_track(channel, &scaling_track, &channel->scaling_key_count, &channel->scaling_key_times, &channel->scaling_key_values, statistics);
+    }
+}
+
+void animation_decode_position(
+    const struct animation_channel *channel,
+    const uint16_t *value,
+    float *out_position)
+{
+    for (int i = 0; i < 3; i++)
+        out_position[i] = animation_dequantize(value[i], channel->position_range_minimum[i], channel->position_range_extent[i]);
+}
+
+void animation_decode_rotation(
+    const uint16_t *value,
+    float *out_rotation)
+{
+    const float scale = (2.0f * ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT) / ANIMATION_COMPRESSION_ROTATION_COMPONENT_MAXIMUM;
+
+    float a = ((float)(value[0] & 0x7fff) * scale) - ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT;
+    float b = ((float)(value[1] & 0x7fff) * scale) - ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT;
+    float c = ((float)(value[2] & 0x7fff) * scale) - ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT;
+    float d = sqrtf(fmaxf(1.0f - ((a * a) + (b * b) + (c * c)), 0.0f));
+
+    // The index of the omitted largest component is split across the top bits of the first two words
+    switch ((value[0] >> 15) | ((value[1] >> 15) << 1))
+    {
+    case 0:
+        out_rotation[0] = d; out_rotation[1] = a; out_rotation[2] = b; out_rotation[3] = c;
+        break;
+
+    case 1:
+        out_rotation[0] = a; out_rotation[1] = d; out_rotation[2] = b; out_rotation[3] = c;
+        break;
+
+    case 2:
+        out_rotation[0] = a; out_rotation[1] = b; out_rotation[2] = d; out_rotation[3] = c;
+        break;
+
+    default:
+        out_rotation[0] = a; out_rotation[1] = b; out_rotation[2] = c; out_rotation[3] = d;
+        break;
+    }
+}
+
+void animation_decode_scaling(
+    const struct animation_channel *channel,
+    const uint16_t *value,
+    float *out_scale)
+{
+    for (int i = 0; i < 3; i++)
+        out_scale[i] = animation_dequantize(value[i], channel->scaling_range_minimum[i], channel->scaling_range_extent[i]);
+}
+
+/* ---------- private code */
+
+static void animation_compression_compute_range(
+    const struct animation_raw_channel *raw_channel,
+    enum animation_track_type type,
+    float *out_minimum,
+    float *out_extent)
+{
+    float minimum[3] = { INFINITY, INFINITY, INFINITY };
+    float maximum[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+    int key_count = type == _animation_track_position ? raw_channel->position_key_count : raw_channel->scaling_key_count;
+    float (*key_values)[3] = type == _animation_track_position ? raw_channel->position_key_values : raw_channel->scaling_key_values;
+
+    for (int key_index = 0; key_index < key_count; key_index++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            minimum[i] = fminf(minimum[i], key_values[key_index][i]);
+            maximum[i] = fmaxf(maximum[i], key_values[key_index][i]);
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        out_minimum[i] = minimum[i] <= maximum[i] ? minimum[i] : 0.0f;
+        out_extent[i] = minimum[i] <= maximum[i] ? maximum[i] - minimum[i] : 0.0f;
+    }
+}
+
+static void animation_compress_track(
+    const struct animation_channel *channel,
+    const struct animation_track *track,
+    int *out_key_count,
+    float **out_key_times,
+    uint16_t (**out_key_values)[3],
+    struct animation_compression_statistics *statistics)
+{
+    int key_count = track->key_count;
+    int stride = track->component_count;
+    float tolerance = track->tolerance;
+
+    if (track->type != _animation_track_rotation)
+    {
+        const float *extent = track->type == _animation_track_position ? channel->position_range_extent : channel->scaling_range_extent;
+
+        // Quantization alone can miss by up to a step, so a range too wide for the tolerance would otherwise keep every key
+        for (int i = 0; i < 3; i++)
+            tolerance = fmaxf(tolerance, extent[i] / ANIMATION_COMPRESSION_QUANTIZED_MAXIMUM);
+    }
+
+    // Reduce against the quantized keys so the tolerance bounds the error of what is actually stored
+    uint16_t (*encoded_values)[3] = malloc(key_count * sizeof(*encoded_values));
+    float *decoded_values = malloc(key_count * stride * sizeof(*decoded_values));
+    int *kept_key_indices = malloc(key_count * sizeof(*kept_key_indices));
+    assert(!key_count || (encoded_values && decoded_values && kept_key_indices));
+
+    for (int key_index = 0; key_index < key_count; key_index++)
+    {
+        animation_track_encode(channel, track->type, track->key_values + (key_index * stride), encoded_values[key_index]);
+        animation_track_decode(channel, track->type, encoded_values[key_index], decoded_values + (key_index * stride));
+    }
+
+    int kept_key_count = 0;
+
+    if (key_count > 0)
+    {
+        bool constant = true;
+
+        for (int key_index = 1; constant && key_index < key_count; key_index++)
+            constant = animation_track_get_error(track->type, decoded_values, track->key_values + (key_index * stride)) <= tolerance;
+
+        kept_key_indices[kept_key_count++] = 0;
+
+        if (!constant)
+        {
+            // Grow each segment from the last kept key until interpolating across it misses a key in between
+            int anchor_index = 0;
+
+            for (int end_index = 2; end_index < key_count; end_index++)
+            {
+                const float *anchor_value = decoded_values + (anchor_index * stride);
+                const float *end_value = decoded_values + (end_index * stride);
+                float anchor_time = track->key_times[anchor_index];
+                float duration = track->key_times[end_index] - anchor_time;
+
+                for (int key_index = anchor_index + 1; key_index < end_index; key_index++)
+                {
+                    float factor = duration > 0.0f ? (track->key_times[key_index] - anchor_time) / duration : 0.0f;
+
+                    float value[4];
+                    animation_track_interpolate(track->type, anchor_value, end_value, factor, value);
+
+                    if (animation_track_get_error(track->type, value, track->key_values + (key_index * stride)) > tolerance)
+                    {
+                        anchor_index = end_index - 1;
+                        kept_key_indices[kept_key_count++] = anchor_index;
+                        break;
+                    }
+                }
+            }
+
+            kept_key_indices[kept_key_count++] = key_count - 1;
+        }
+    }
+
+    *out_key_count = kept_key_count;
+    *out_key_times = malloc(kept_key_count * sizeof(**out_key_times));
+    *out_key_values = malloc(kept_key_count * sizeof(**out_key_values));
+    assert(!kept_key_count || (*out_key_times && *out_key_values));
+
+    for (int i = 0; i < kept_key_count; i++)
+    {
+        (*out_key_times)[i] = track->key_times[kept_key_indices[i]];
+        memcpy((*out_key_values)[i], encoded_values[kept_key_indices[i]], sizeof(**out_key_values));
+    }
+
+    if (statistics)
+    {
+        statistics->track_count++;
+        statistics->constant_track_count += kept_key_count == 1 && key_count > 1;
+        statistics->raw_key_count += key_count;
+        statistics->compressed_key_count += kept_key_count;
+        statistics->raw_size += key_count * (sizeof(float) + (stride * sizeof(float)));
+        statistics->compressed_size += kept_key_count * (sizeof(float) + sizeof(**out_key_values));
+
+        float *maximum_error =
+            track->type == _animation_track_position ? &statistics->maximum_position_error :
+            track->type == _animation_track_rotation ? &statistics->maximum_rotation_error :
+            &statistics->maximum_scaling_error;
+
+        // Measure the track as it will be sampled, at the time of every raw key
+        for (int key_index = 0, segment_index = 0; key_index < key_count; key_index++)
+        {
+            float time = track->key_times[key_index];
+
+            while (segment_index + 2 < kept_key_count && time >= (*out_key_times)[segment_index + 1])
+                segment_index++;
+
+            int next_segment_index = segment_index + 1 < kept_key_count ? segment_index + 1 : segment_index;
+            const float *a = decoded_values + (kept_key_indices[segment_index] * stride);
+            const float *b = decoded_values + (kept_key_indices[next_segment_index] * stride);
+            float duration = (*out_key_times)[next_segment_index] - (*out_key_times)[segment_index];
+            float factor = duration > 0.0f ? fminf(fmaxf((time - (*out_key_times)[segment_index]) / duration, 0.0f), 1.0f) : 0.0f;
+
+            float value[4];
+            animation_track_interpolate(track->type, a, b, factor, value);
+
+            *maximum_error = fmaxf(*maximum_error, animation_track_get_error(track->type, value, track->key_values + (key_index * stride)));
+        }
+    }
+
+    free(encoded_values);
+    free(decoded_values);
+    free(kept_key_indices);
+}
+
+static void animation_track_encode(
+    const struct animation_channel *channel,
+    enum animation_track_type type,
+    const float *value,
+    uint16_t *out_value)
+{
+    switch (type)
+    {
+    case _animation_track_position:
+        for (int i = 0; i < 3; i++)
+            out_value[i] = (uint16_t)animation_quantize(value[i], channel->position_range_minimum[i], channel->position_range_extent[i]);
+        break;
+
+    case _animation_track_scaling:
+        for (int i = 0; i < 3; i++)
+            out_value[i] = (uint16_t)animation_quantize(value[i], channel->scaling_range_minimum[i], channel->scaling_range_extent[i]);
+        break;
+
+    case _animation_track_rotation:
+    {
+        int largest_index = 0;
+        float length_squared = 0.0f;
+
+        for (int i = 0; i < 4; i++)
+        {
+            length_squared += value[i] * value[i];
+
+            if (fabsf(value[i]) > fabsf(value[largest_index]))
+                largest_index = i;
+        }
+
+        // q and -q are the same rotation, so flip to keep the omitted component positive
+        float scale = length_squared > 0.0f ? 1.0f / sqrtf(length_squared) : 0.0f;
+
+        if (value[largest_index] < 0.0f)
+            scale = -scale;
+
+        for (int i = 0, component_index = 0; i < 4; i++)
+        {
+            if (i == largest_index)
+                continue;
+
+            float component = fminf(fmaxf(value[i] * scale, -ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT), ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT);
+            component = (component + ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT) * (ANIMATION_COMPRESSION_ROTATION_COMPONENT_MAXIMUM / (2.0f * ANIMATION_COMPRESSION_ROTATION_COMPONENT_LIMIT));
+
+            out_value[component_index++] = (uint16_t)lrintf(component);
+        }
+
+        out_value[0] |= (uint16_t)((largest_index & 1) << 15);
+        out_value[1] |= (uint16_t)((largest_index >> 1) << 15);
+        break;
+    }
+
+    default:
+        assert(false);
+    }
+}
+
+static void animation_track_decode(
+    const struct animation_channel *channel,
+    enum animation_track_type type,
+    const uint16_t *value,
+    float *out_value)
+{
+    switch (type)
+    {
+    case _animation_track_position:
+        animation_decode_position(channel, value, out_value);
+        break;
+
+    case _animation_track_rotation:
+        animation_decode_rotation(value, out_value);
+        break;
+
+    case _animation_track_scaling:
+        animation_decode_scaling(channel, value, out_value);
+        break;
+
+    default:
+        assert(false);
+    }
+}
+
+static void animation_track_interpolate(
+    enum animation_track_type type,
+    const float *a,
+    const float *b,
+    float t,
+    float *out_value)
+{
+    if (type == _animation_track_rotation)
+    {
+        animation_quaternion_slerp(a, b, t, out_value);
+        return;
+    }
+
+    for (int i = 0; i < 3; i++)
+        out_value[i] = a[i] + ((b[i] - a[i]) * t);
+}
+
+static float animation_track_get_error(
+    enum animation_track_type type,
+    const float *a,
+    const float *b)
+{
+    if (type == _animation_track_rotation)
+    {
+        // The angle between the two rotations, which is the same for either sign of either quaternion
+        float dot = fabsf((a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]) + (a[3] * b[3]));
+        float length_product = sqrtf(((a[0] * a[0]) + (a[1] * a[1]) + (a[2] * a[2]) + (a[3] * a[3])) * ((b[0] * b[0]) + (b[1] * b[1]) + (b[2] * b[2]) + (b[3] * b[3])));
+
+        return length_product > 0.0f ? 2.0f * acosf(fminf(dot / length_product, 1.0f)) : 0.0f;
+    }
+
+    float error = 0.0f;
+
+    for (int i = 0; i < 3; i++)
+        error = fmaxf(error, fabsf(a[i] - b[i]));
+
+    return error;
+}
+
+static float animation_quantize(
+    float value,
+    float minimum,
+    float extent)
+{
+    if (extent <= 0.0f)
+        return 0.0f;
+
+    float quantized = ((value - minimum) / extent) * ANIMATION_COMPRESSION_QUANTIZED_MAXIMUM;
+
+    return (float)lrintf(fminf(fmaxf(quantized, 0.0f), ANIMATION_COMPRESSION_QUANTIZED_MAXIMUM));
+}
+
+static float animation_dequantize(
+    uint16_t value,
+    float minimum,
+    float extent)
+{
+    return minimum + ((float)value * (extent / ANIMATION_COMPRESSION_QUANTIZED_MAXIMUM));
+}
@@ -0,0 +1,90 @@
+/*
+ANIMATION_COMPRESSION.H
+    Animation clip compression declarations.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "animations/animation_data.h"
+
+/* ---------- constants */
+
+// Default reconstruction tolerances: model units for positions and scales, radians for rotations
+#define ANIMATION_COMPRESSION_DEFAULT_POSITION_TOLERANCE 0.0005f
+#define ANIMATION_COMPRESSION_DEFAULT_ROTATION_TOLERANCE 0.001f
+#define ANIMATION_COMPRESSION_DEFAULT_SCALING_TOLERANCE 0.0005f
+
+/* ---------- types */
+
+/**
+ * A node channel's uncompressed keys, as read from a source file.
+ */
+struct animation_raw_channel
+{
+    int position_key_count;
+    int rotation_key_count;
+    int scaling_key_count;
+    float *position_key_times;
+    float (*position_key_values)[3];
+    float *rotation_key_times;
+    float (*rotation_key_values)[4];
+    float *scaling_key_times;
+    float (*scaling_key_values)[3];
+};
+
+struct animation_compression_settings
+{
+    float position_tolerance;
+    float rotation_tolerance;
+    float scaling_tolerance;
+};
+
+/**
+ * Totals gathered while compressing, accumulated across calls so a whole model can be summarized.
+ */
+struct animation_compression_statistics
+{
+    int track_count;
+    int constant_track_count;
+    int raw_key_count;
+    int compressed_key_count;
+
+    size_t raw_size;
+    size_t compressed_size;
+
+    // The largest difference between a raw key and the compressed clip sampled at its time
+    float maximum_position_error;
+    float maximum_rotation_error;
+    float maximum_scaling_error;
+};
+
+/* ---------- prototypes/ANIMATION_COMPRESSION.C */
+
+/**
+ * Allocates arrays for a raw channel's keys.
+ */
+void animation_raw_channel_initialize(struct animation_raw_channel *channel, int position_key_count, int rotation_key_count, int scaling_key_count);
+void animation_raw_channel_dispose(struct animation_raw_channel *channel);
+
+/**
+ * Compresses the node channels of an animation. Keys that interpolation reproduces within tolerance are removed,
+ * tracks that never leave tolerance of one value keep a single key, rotations are stored as 48-bit smallest-three
+ * quaternions, and positions and scales are quantized to 16 bits within each track's own range. A track whose range is
+ * wider than 65535 times its tolerance cannot be stored within it, so its tolerance is raised to the quantization step.
+ * @param animation The animation to compress into. Its channels must be allocated, with their type and index set.
+ * @param raw_channels The raw keys of each of the animation's channels. Only node channels are read.
+ * @param settings The reconstruction tolerances, or NULL for the defaults.
+ * @param statistics Totals to add this animation's results to, or NULL.
+ */
+void animation_compress(
+    struct animation_data *animation,
+    const struct animation_raw_channel *raw_channels,
+    const struct animation_compression_settings *settings,
+    struct animation_compression_statistics *statistics);
+
+void animation_decode_position(const struct animation_channel *channel, const uint16_t *value, float *out_position);
+void animation_decode_rotation(const uint16_t *value, float *out_rotation);
+void animation_decode_scaling(const struct animation_channel *channel, const uint16_t *value, float *out_scale);
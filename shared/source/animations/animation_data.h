@@ -0,0 +1,99 @@
+/*
+ANIMATION_DATA.H
+    Animation data types and declarations.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+struct animation_data
+{
+    char *name;
+
+    float duration;
+    float ticks_per_second;
+
+    int channel_count;
+    struct animation_channel *channels;
+
+    // The index of the node channel animating each model node, or -1 if the node is not animated
+    int *node_channel_indices;
+
+    // The indices of the mesh and morph channels, which drive morph target weights instead of nodes
+    int morph_channel_count;
+    int *morph_channel_indices;
+
+    // Baked clips also hold every node channel resampled at a fixed rate, and are sampled from these frames
+    // instead of their keys. Frames are stored channel by channel: baked_frames[(channel_index * baked_frame_count) + frame_index]
+    int baked_frame_count;
+    float baked_frames_per_tick;
+    struct animation_baked_frame *baked_frames;
+};
+
+enum animation_channel_type
+{
+    _animation_channel_type_node,
+    _animation_channel_type_mesh,
+    _animation_channel_type_morph,
+    NUMBER_OF_ANIMATION_CHANNEL_TYPES
+};
+
+struct animation_channel
+{
+    enum animation_channel_type type;
+    union
+    {
+        int node_index;
+
+        // The model mesh whose morph targets the channel's keys index, or -1 if no mesh matched
+        int mesh_index;
+    };
+    int position_key_count;
+    int rotation_key_count;
+    int scaling_key_count;
+    int mesh_key_count;
+    int morph_key_count;
+
+    // Compressed keys, decoded by animation_compression.h. A track with a single key is constant.
+    float *position_key_times;
+    uint16_t (*position_key_values)[3];
+    float *rotation_key_times;
+    uint16_t (*rotation_key_values)[3];
+    float *scaling_key_times;
+    uint16_t (*scaling_key_values)[3];
+
+    // Position and scaling keys are quantized to 16 bits per component within these per-track ranges
+    float position_range_minimum[3];
+    float position_range_extent[3];
+    float scaling_range_minimum[3];
+    float scaling_range_extent[3];
+
+    struct animation_mesh_key *mesh_keys;
+    struct animation_morph_key *morph_keys;
+};
+
+struct animation_baked_frame
+{
+    float rotation[4];
+    float position[3];
+    float scale[3];
+};
+
+struct animation_mesh_key
+{
+    float time;
+
+    // The morph target the mesh switches to, or -1
+    int mesh_index;
+};
+
+struct animation_morph_key
+{
+    float time;
+    int count;
+
+    // The morph targets weighted by the key, or -1 for targets that were not imported
+    int *values;
+    float *weights;
+};
@@ -0,0 +1,109 @@
+/*
+ANIMATION_KEYS.C
+    Animation keyframe search code.
+*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "animations/animation_keys.h"
+
+/* ---------- public code */
+
+int animation_keys_search(
+    const float *key_times,
+    int key_count,
+    float time)
+{
+    assert(key_times);
+    assert(key_count > 0);
+
+    if (key_count == 1 || time < key_times[1])
+        return 0;
+
+    if (time >= key_times[key_count - 2])
+        return key_count - 2;
+
+    // Invariant: key_times[low] <= time < key_times[high]
+    int low = 1;
+    int high = key_count - 2;
+
+    while (high - low > 1)
+    {
+        int middle = low + ((high - low) / 2);
+
+        if (time < key_times[middle])
+            high = middle;
+        else
+            low = middle;
+    }
+
+    return low;
+}
+
+int animation_keys_find(
+    const float *key_times,
+    int key_count,
+    float time,
+    int *cursor)
+{
+    assert(key_times);
+    assert(key_count > 0);
+    assert(cursor);
+
+    int key_index = *cursor;
+
+    if (key_index < 0 || key_index > key_count - 2 || (key_index > 0 && time < key_times[key_index]))
+    {
+        // Seeking backwards, looping or an uninitialized cursor
+        key_index = animation_keys_search(key_times, key_count, time);
+    }
+    else
+    {
+        int step_count = 0;
+
+        while (key_index < key_count - 2 && time >= key_times[key_index + 1])
+        {
+            if (++step_count > ANIMATION_KEY_CURSOR_MAXIMUM_STEP_COUNT)
+            {
+                key_index = animation_keys_search(key_times, key_count, time);
+                break;
+            }
+
+            key_index++;
+        }
+    }
+
+    *cursor = key_index;
+
+    return key_index;
+}
+
+float animation_keys_get_interpolation_factor(
+    const float *key_times,
+    int key_count,
+    int key_index,
+    float time)
+{
+    assert(key_times);
+    assert(key_index >= 0 && key_index < key_count);
+
+    if (key_index + 1 >= key_count)
+        return 0.0f;
+
+    float start_time = key_times[key_index];
+    float duration = key_times[key_index + 1] - start_time;
+
+    if (duration <= 0.0f)
+        return 0.0f;
+
+    float factor = (time - start_time) / duration;
+
+    if (factor < 0.0f)
+        return 0.0f;
+
+    if (factor > 1.0f)
+        return 1.0f;
+
+    return factor;
+}
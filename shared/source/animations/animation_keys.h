@@ -0,0 +1,45 @@
+/*
+ANIMATION_KEYS.H
+    Animation keyframe search declarations.
+*/
+
+#pragma once
+
+/* ---------- constants */
+
+enum
+{
+    // How many keys a cursor may step forward before giving up and binary searching
+    ANIMATION_KEY_CURSOR_MAXIMUM_STEP_COUNT = 4,
+};
+
+/* ---------- prototypes/ANIMATION_KEYS.C */
+
+/**
+ * Finds the key interval containing a time using a binary search.
+ * @param key_times The ascending key times to search.
+ * @param key_count The number of key times. Must be at least 1.
+ * @param time The time to search for.
+ * @returns The index of the last key at or before the time, clamped to the range [0, key_count - 2] (or 0 for a single key).
+ */
+int animation_keys_search(const float *key_times, int key_count, float time);
+
+/**
+ * Finds the key interval containing a time, starting from the interval found on the previous call.
+ * Playback moving forward only steps the cursor; seeking or looping falls back to a binary search.
+ * @param key_times The ascending key times to search.
+ * @param key_count The number of key times. Must be at least 1.
+ * @param time The time to search for.
+ * @param cursor The address of the key index found on the previous call, which is updated with the result.
+ * @returns The index of the last key at or before the time, clamped the same way as animation_keys_search.
+ */
+int animation_keys_find(const float *key_times, int key_count, float time, int *cursor);
+
+/**
+ * Gets the interpolation factor of a time between a key and the key after it, clamped to [0, 1].
+ * @param key_times The ascending key times.
+ * @param key_count The number of key times.
+ * @param key_index The key index returned by animation_keys_search or animation_keys_find.
+ * @param time The time being sampled.
+ */
+float animation_keys_get_interpolation_factor(const float *key_times, int key_count, int key_index, float time);
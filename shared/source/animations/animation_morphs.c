@@ -0,0 +1,503 @@
+/*
+ANIMATION_MORPHS.C
+    Animation morph target code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "animations/animation_morphs.h"
+
+/* ---------- private types */
+
+// Target spans and accumulators are padded to ANIMATION_MORPH_VERTEX_COUNT_GRANULARITY vertices, so any of these widths divides them evenly.
+// Define ANIMATION_MORPHS_SCALAR to force the portable path.
+#if defined(__AVX__) && !defined(ANIMATION_MORPHS_SCALAR)
+
+#include <immintrin.h>
+
+#define ANIMATION_MORPH_VECTOR_WIDTH 8
+
+typedef __m256 animation_morph_vector;
+
+static inline animation_morph_vector animation_morph_vector_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void animation_morph_vector_store(float *p, animation_morph_vector a) { _mm256_storeu_ps(p, a); }
+static inline animation_morph_vector animation_morph_vector_set(float a) { return _mm256_set1_ps(a); }
+static inline animation_morph_vector animation_morph_vector_madd(animation_morph_vector a, animation_morph_vector b, animation_morph_vector c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+
+#elif (defined(__SSE__) || defined(_M_X64)) && !defined(ANIMATION_MORPHS_SCALAR)
+
+#include <xmmintrin.h>
+
+#define ANIMATION_MORPH_VECTOR_WIDTH 4
+
+typedef __m128 animation_morph_vector;
+
+static inline animation_morph_vector animation_morph_vector_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void animation_morph_vector_store(float *p, animation_morph_vector a) { _mm_storeu_ps(p, a); }
+static inline animation_morph_vector animation_morph_vector_set(float a) { return _mm_set1_ps(a); }
+static inline animation_morph_vector animation_morph_vector_madd(animation_morph_vector a, animation_morph_vector b, animation_morph_vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+#else
+
+#define ANIMATION_MORPH_VECTOR_WIDTH 1
+
+typedef float animation_morph_vector;
+
+static inline animation_morph_vector animation_morph_vector_load(const float *p) { return *p; }
+static inline void animation_morph_vector_store(float *p, animation_morph_vector a) { *p = a; }
+static inline animation_morph_vector animation_morph_vector_set(float a) { return a; }
+static inline animation_morph_vector animation_morph_vector_madd(animation_morph_vector a, animation_morph_vector b, animation_morph_vector c) { return (a * b) + c; }
+
+#endif
+
+static_assert(ANIMATION_MORPH_VERTEX_COUNT_GRANULARITY % ANIMATION_MORPH_VECTOR_WIDTH == 0);
+
+/* ---------- private prototypes */
+
+static inline int animation_morph_round_down(int vertex_index);
+static inline int animation_morph_round_up(int vertex_index);
+static inline bool animation_morph_delta_is_zero(const float *deltas, int vertex_index);
+
+static int animation_morph_keys_search(const struct animation_morph_key *keys, int key_count, float time);
+static void animation_morph_key_add_weights(const struct animation_morph_key *key, float weight, float *weights);
+
+/* ---------- public code */
+
+void animation_morph_set_build(
+    struct animation_morph_set *set,
+    int mesh_vertex_count,
+    int target_count,
+    const float *const *position_deltas,
+    const float *const *normal_deltas)
+{
+    assert(set);
+    assert(mesh_vertex_count >= 0);
+    assert(target_count >= 0);
+    assert(!target_count || (position_deltas && normal_deltas));
+
+    memset(set, 0, sizeof(*set));
+
+    // The set vertex of each mesh vertex any target moves, or -1
+    int *set_vertex_indices = malloc(mesh_vertex_count * sizeof(*set_vertex_indices));
+    assert(!mesh_vertex_count || set_vertex_indices);
+
+    for (int vertex_index = 0; vertex_index < mesh_vertex_count; vertex_index++)
+    {
+        set_vertex_indices[vertex_index] = -1;
+
+        for (int target_index = 0; target_index < target_count; target_index++)
+        {
+            if (!animation_morph_delta_is_zero(position_deltas[target_index], vertex_index) ||
+                !animation_morph_delta_is_zero(normal_deltas[target_index], vertex_index))
+            {
+                set_vertex_indices[vertex_index] = set->vertex_count++;
+                break;
+            }
+        }
+    }
+
+    set->padded_vertex_count = animation_morph_round_up(set->vertex_count);
+    set->vertex_indices = malloc(set->vertex_count * sizeof(*set->vertex_indices));
+    assert(!set->vertex_count || set->vertex_indices);
+
+    for (int vertex_index = 0; vertex_index < mesh_vertex_count; vertex_index++)
+    {
+        if (set_vertex_indices[vertex_index] != -1)
+            set->vertex_indices[set_vertex_indices[vertex_index]] = vertex_index;
+    }
+
+    set->target_count = target_count;
+    set->targets = calloc(target_count, sizeof(*set->targets));
+    assert(!target_count || set->targets);
+
+    for (int target_index = 0; target_index < target_count; target_index++)
+    {
+        struct animation_morph_target *target = set->targets + target_index;
+        const float *target_position_deltas = position_deltas[target_index];
+        const float *target_normal_deltas = normal_deltas[target_index];
+
+        int first_vertex_index = -1;
+        int last_vertex_index = -1;
+
+        for (int set_vertex_index = 0; set_vertex_index < set->vertex_count; set_vertex_index++)
+        {
+            int vertex_index = set->vertex_indices[set_vertex_index];
+
+            if (animation_morph_delta_is_zero(target_position_deltas, vertex_index) &&
+                animation_morph_delta_is_zero(target_normal_deltas, vertex_index))
+            {
+                continue;
+            }
+
+            if (first_vertex_index == -1)
+                first_vertex_index = set_vertex_index;
+
+            last_vertex_index = set_vertex_index;
+        }
+
+        // A target that moves nothing keeps an empty span and is never accumulated
+        if (first_vertex_index == -1)
+            continue;
+
+        target->vertex_start = animation_morph_round_down(first_vertex_index);
+        target->vertex_count = animation_morph_round_up(last_vertex_index + 1) - target->vertex_start;
+        target->deltas = calloc((size_t)target->vertex_count * NUMBER_OF_ANIMATION_MORPH_COMPONENTS, sizeof(*target->deltas));
+        assert(target->deltas);
+
+        int vertex_end = target->vertex_start + target->vertex_count;
+
+        for (int set_vertex_index = target->vertex_start; set_vertex_index < vertex_end && set_vertex_index < set->vertex_count; set_vertex_index++)
+        {
+            int vertex_index = set->vertex_indices[set_vertex_index];
+            float *deltas = target->deltas + (set_vertex_index - target->vertex_start);
+
+            for (int i = 0; i < 3; i++)
+            {
+                deltas[i * target->vertex_count] = target_position_deltas[(vertex_index * 3) + i];
+                deltas[(i + 3) * target->vertex_count] = target_normal_deltas ? target_normal_deltas[(vertex_index * 3) + i] : 0.0f;
+            }
+        }
+    }
+
+    free(set_vertex_indices);
+}
+
+void animation_morph_set_dispose(
+    struct animation_morph_set *set)
+{
+    assert(set);
+
+    for (int target_index = 0; target_index < set->target_count; target_index++)
+        free(set->targets[target_index].deltas);
+
+    free(set->vertex_indices);
+    free(set->targets);
+
+    memset(set, 0, sizeof(*set));
+}
+
+size_t animation_morph_set_get_size(
+    const struct animation_morph_set *set)
+{
+    assert(set);
+
+    size_t size = set->vertex_count * sizeof(*set->vertex_indices);
+
+    for (int target_index = 0; target_index < set->target_count; target_index++)
+        size += (size_t)set->targets[target_index].vertex_count * NUMBER_OF_ANIMATION_MORPH_COMPONENTS * sizeof(float);
+
+    return size;
+}
+
+void animation_morph_accumulator_initialize(
+    struct animation_morph_accumulator *accumulator,
+    const struct animation_morph_set *set)
+{
+    assert(accumulator);
+    assert(set);
+
+    memset(accumulator, 0, sizeof(*accumulator));
+
+    accumulator->padded_vertex_count = set->padded_vertex_count;
+    accumulator->deltas = calloc((size_t)set->padded_vertex_count * NUMBER_OF_ANIMATION_MORPH_COMPONENTS, sizeof(*accumulator->deltas));
+    assert(!set->padded_vertex_count || accumulator->deltas);
+
+    accumulator->target_count = set->target_count;
+    accumulator->weights = calloc(set->target_count, sizeof(*accumulator->weights));
+    assert(!set->target_count || accumulator->weights);
+}
+
+void animation_morph_accumulator_dispose(
+    struct animation_morph_accumulator *accumulator)
+{
+    assert(accumulator);
+
+    free(accumulator->deltas);
+    free(accumulator->weights);
+
+    memset(accumulator, 0, sizeof(*accumulator));
+}
+
+bool animation_morph_accumulate(
+    const struct animation_morph_set *set,
+    const float *weights,
+    struct animation_morph_accumulator *accumulator,
+    int *out_vertex_start,
+    int *out_vertex_end)
+{
+    assert(set);
+    assert(!set->target_count || weights);
+    assert(accumulator);
+    assert(accumulator->padded_vertex_count == set->padded_vertex_count);
+    assert(accumulator->target_count == set->target_count);
+    assert(out_vertex_start);
+    assert(out_vertex_end);
+
+    *out_vertex_start = 0;
+    *out_vertex_end = 0;
+
+    if (accumulator->accumulated && memcmp(accumulator->weights, weights, set->target_count * sizeof(*weights)) == 0)
+        return false;
+
+    memcpy(accumulator->weights, weights, set->target_count * sizeof(*weights));
+    accumulator->accumulated = true;
+
+    // Only the span the weighted targets cover is summed into
+    int vertex_start = set->padded_vertex_count;
+    int vertex_end = 0;
+
+    for (int target_index = 0; target_index < set->target_count; target_index++)
+    {
+        const struct animation_morph_target *target = set->targets + target_index;
+
+        if (weights[target_index] == 0.0f || !target->vertex_count)
+            continue;
+
+        if (vertex_start > target->vertex_start)
+            vertex_start = target->vertex_start;
+
+        if (vertex_end < target->vertex_start + target->vertex_count)
+            vertex_end = target->vertex_start + target->vertex_count;
+    }
+
+    // Whatever the previous targets moved has to be cleared and rewritten too
+    int changed_vertex_start = vertex_start;
+    int changed_vertex_end = vertex_end;
+
+    if (accumulator->applied_vertex_start < accumulator->applied_vertex_end)
+    {
+        if (changed_vertex_start > accumulator->applied_vertex_start)
+            changed_vertex_start = accumulator->applied_vertex_start;
+
+        if (changed_vertex_end < accumulator->applied_vertex_end)
+            changed_vertex_end = accumulator->applied_vertex_end;
+    }
+
+    if (changed_vertex_start >= changed_vertex_end)
+        return false;
+
+    int padded_vertex_count = accumulator->padded_vertex_count;
+
+    for (int component_index = 0; component_index < NUMBER_OF_ANIMATION_MORPH_COMPONENTS; component_index++)
+    {
+        float *deltas = accumulator->deltas + (component_index * padded_vertex_count);
+        memset(deltas + changed_vertex_start, 0, (changed_vertex_end - changed_vertex_start) * sizeof(*deltas));
+    }
+
+    for (int target_index = 0; target_index < set->target_count; target_index++)
+    {
+        const struct animation_morph_target *target = set->targets + target_index;
+
+        if (weights[target_index] == 0.0f || !target->vertex_count)
+            continue;
+
+        animation_morph_vector weight = animation_morph_vector_set(weights[target_index]);
+
+        for (int component_index = 0; component_index < NUMBER_OF_ANIMATION_MORPH_COMPONENTS; component_index++)
+        {
+            const float *target_deltas = target->deltas + (component_index * target->vertex_count);
+            float *deltas = accumulator->deltas + (component_index * padded_vertex_count) + target->vertex_start;
+
+            for (int i = 0; i < target->vertex_count; i += ANIMATION_MORPH_VECTOR_WIDTH)
+            {
+                animation_morph_vector delta = animation_morph_vector_madd(animation_morph_vector_load(target_deltas + i), weight, animation_morph_vector_load(deltas + i));
+                animation_morph_vector_store(deltas + i, delta);
+            }
+        }
+    }
+
+    accumulator->applied_vertex_start = vertex_start < vertex_end ? vertex_start : 0;
+    accumulator->applied_vertex_end = vertex_start < vertex_end ? vertex_end : 0;
+
+    *out_vertex_start = changed_vertex_start;
+    *out_vertex_end = changed_vertex_end;
+
+    return true;
+}
+
+void animation_morph_apply(
+    const struct animation_morph_set *set,
+    const struct animation_morph_accumulator *accumulator,
+    int vertex_start,
+    int vertex_end,
+    const void *base_vertices,
+    void *out_vertices,
+    size_t vertex_size,
+    size_t position_offset,
+    size_t normal_offset,
+    int *out_first_vertex,
+    int *out_vertex_count)
+{
+    assert(set);
+    assert(accumulator);
+    assert(vertex_start >= 0 && vertex_start <= vertex_end);
+    assert(base_vertices);
+    assert(out_vertices);
+    assert(out_first_vertex);
+    assert(out_vertex_count);
+
+    *out_first_vertex = 0;
+    *out_vertex_count = 0;
+
+    // Padding vertices past the set's own have no mesh vertex to write
+    if (vertex_end > set->vertex_count)
+        vertex_end = set->vertex_count;
+
+    if (vertex_start >= vertex_end)
+        return;
+
+    int padded_vertex_count = accumulator->padded_vertex_count;
+    const float *deltas[NUMBER_OF_ANIMATION_MORPH_COMPONENTS];
+
+    for (int component_index = 0; component_index < NUMBER_OF_ANIMATION_MORPH_COMPONENTS; component_index++)
+        deltas[component_index] = accumulator->deltas + (component_index * padded_vertex_count);
+
+    for (int set_vertex_index = vertex_start; set_vertex_index < vertex_end; set_vertex_index++)
+    {
+        size_t vertex_offset = set->vertex_indices[set_vertex_index] * vertex_size;
+
+        const float *base_position = (const float *)((const char *)base_vertices + vertex_offset + position_offset);
+        const float *base_normal = (const float *)((const char *)base_vertices + vertex_offset + normal_offset);
+        float *position = (float *)((char *)out_vertices + vertex_offset + position_offset);
+        float *normal = (float *)((char *)out_vertices + vertex_offset + normal_offset);
+
+        float length_squared = 0.0f;
+
+        for (int i = 0; i < 3; i++)
+        {
+            position[i] = base_position[i] + deltas[i][set_vertex_index];
+            normal[i] = base_normal[i] + deltas[i + 3][set_vertex_index];
+            length_squared += normal[i] * normal[i];
+        }
+
+        if (length_squared > 0.0f)
+        {
+            float inverse_length = 1.0f / sqrtf(length_squared);
+
+            for (int i = 0; i < 3; i++)
+                normal[i] *= inverse_length;
+        }
+        else
+        {
+            memcpy(normal, base_normal, 3 * sizeof(*normal));
+        }
+    }
+
+    // Set vertices ascend in mesh vertex order, so the written mesh vertices lie between the first and last
+    *out_first_vertex = set->vertex_indices[vertex_start];
+    *out_vertex_count = set->vertex_indices[vertex_end - 1] - *out_first_vertex + 1;
+}
+
+void animation_morph_channel_sample(
+    const struct animation_channel *channel,
+    float time,
+    float weight,
+    float *weights)
+{
+    assert(channel);
+    assert(weights);
+
+    if (channel->type == _animation_channel_type_mesh)
+    {
+        if (!channel->mesh_key_count)
+            return;
+
+        // Mesh keys hold until the next one, with the first key also holding before it
+        int key_index = 0;
+
+        while (key_index + 1 < channel->mesh_key_count && channel->mesh_keys[key_index + 1].time <= time)
+            key_index++;
+
+        int target_index = channel->mesh_keys[key_index].mesh_index;
+
+        if (target_index >= 0)
+            weights[target_index] += weight;
+
+        return;
+    }
+
+    assert(channel->type == _animation_channel_type_morph);
+
+    if (!channel->morph_key_count)
+        return;
+
+    int key_index = animation_morph_keys_search(channel->morph_keys, channel->morph_key_count, time);
+    const struct animation_morph_key *key = channel->morph_keys + key_index;
+
+    if (key_index + 1 >= channel->morph_key_count || time <= key->time)
+    {
+        animation_morph_key_add_weights(key, weight, weights);
+        return;
+    }
+
+    const struct animation_morph_key *next_key = key + 1;
+    float factor = (time - key->time) / (next_key->time - key->time);
+
+    if (factor > 1.0f)
+        factor = 1.0f;
+
+    animation_morph_key_add_weights(key, weight * (1.0f - factor), weights);
+    animation_morph_key_add_weights(next_key, weight * factor, weights);
+}
+
+/* ---------- private code */
+
+static inline int animation_morph_round_down(
+    int vertex_index)
+{
+    return vertex_index - (vertex_index % ANIMATION_MORPH_VERTEX_COUNT_GRANULARITY);
+}
+
+static inline int animation_morph_round_up(
+    int vertex_index)
+{
+    return animation_morph_round_down(vertex_index + ANIMATION_MORPH_VERTEX_COUNT_GRANULARITY - 1);
+}
+
+static inline bool animation_morph_delta_is_zero(
+    const float *deltas,
+    int vertex_index)
+{
+    if (!deltas)
+        return true;
+
+    const float *delta = deltas + (vertex_index * 3);
+    return delta[0] == 0.0f && delta[1] == 0.0f && delta[2] == 0.0f;
+}
+
+static int animation_morph_keys_search(
+    const struct animation_morph_key *keys,
+    int key_count,
+    float time)
+{
+    // The last key at or before the time, or the first key when the time precedes every key
+    int low = 0;
+    int high = key_count - 1;
+
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+
+        if (keys[middle].time <= time)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    return low;
+}
+
+static void animation_morph_key_add_weights(
+    const struct animation_morph_key *key,
+    float weight,
+    float *weights)
+{
+    for (int i = 0; i < key->count; i++)
+    {
+        if (key->values[i] >= 0)
+            weights[key->values[i]] += weight * key->weights[i];
+    }
+}
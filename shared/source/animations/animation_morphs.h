@@ -0,0 +1,147 @@
+/*
+ANIMATION_MORPHS.H
+    Animation morph target declarations.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "animations/animation_data.h"
+
+/* ---------- constants */
+
+enum
+{
+    // Target spans start and end on multiples of this many vertices so vectorized loops never need a scalar tail
+    ANIMATION_MORPH_VERTEX_COUNT_GRANULARITY = 8,
+
+    // Position x, y, z and normal x, y, z
+    NUMBER_OF_ANIMATION_MORPH_COMPONENTS = 6,
+};
+
+/* ---------- types */
+
+/**
+ * One morph target's deltas, stored for the span of its set's vertices between the first and last vertex it moves.
+ * Deltas are in structure-of-arrays form: vertex_count position x deltas, then y, z, and the same for the normal.
+ */
+struct animation_morph_target
+{
+    int vertex_start;
+    int vertex_count;
+    float *deltas;
+};
+
+/**
+ * The morph targets of a mesh. Only the vertices some target moves are stored, in ascending mesh vertex order,
+ * and each target only covers the span of them it moves.
+ */
+struct animation_morph_set
+{
+    int vertex_count;
+    int padded_vertex_count;
+    int *vertex_indices;
+
+    int target_count;
+    struct animation_morph_target *targets;
+};
+
+/**
+ * The weighted sum of a set's targets, in the same structure-of-arrays form as the targets.
+ */
+struct animation_morph_accumulator
+{
+    int padded_vertex_count;
+    float *deltas;
+
+    // The target weights last accumulated, so unchanged weights skip the accumulation entirely
+    int target_count;
+    bool accumulated;
+    float *weights;
+
+    // The span of set vertices the last accumulated targets moved, which has to be rewritten once they stop
+    int applied_vertex_start;
+    int applied_vertex_end;
+};
+
+/* ---------- prototypes/ANIMATION_MORPHS.C */
+
+/**
+ * Builds a sparse morph set from dense per-vertex deltas.
+ * @param set The morph set to build.
+ * @param mesh_vertex_count The number of vertices in the mesh, and in each delta array.
+ * @param target_count The number of targets.
+ * @param position_deltas Each target's position delta of every mesh vertex, three floats per vertex.
+ * @param normal_deltas Each target's normal delta of every mesh vertex, three floats per vertex. Entries may be NULL.
+ */
+void animation_morph_set_build(
+    struct animation_morph_set *set,
+    int mesh_vertex_count,
+    int target_count,
+    const float *const *position_deltas,
+    const float *const *normal_deltas);
+
+void animation_morph_set_dispose(struct animation_morph_set *set);
+
+/**
+ * Gets the number of bytes a morph set's vertex indices and deltas take.
+ */
+size_t animation_morph_set_get_size(const struct animation_morph_set *set);
+
+void animation_morph_accumulator_initialize(struct animation_morph_accumulator *accumulator, const struct animation_morph_set *set);
+void animation_morph_accumulator_dispose(struct animation_morph_accumulator *accumulator);
+
+/**
+ * Accumulates the weighted deltas of a set's targets. Targets with a weight of zero are skipped.
+ * @param set The morph set to accumulate.
+ * @param weights The weight of each target.
+ * @param accumulator The accumulator to write the summed deltas to.
+ * @param out_vertex_start The first set vertex whose delta may have changed.
+ * @param out_vertex_end One past the last set vertex whose delta may have changed.
+ * @return false if no vertex may have changed since the previous accumulation.
+ */
+bool animation_morph_accumulate(
+    const struct animation_morph_set *set,
+    const float *weights,
+    struct animation_morph_accumulator *accumulator,
+    int *out_vertex_start,
+    int *out_vertex_end);
+
+/**
+ * Writes base vertices with accumulated deltas added over a span of set vertices. Normals are renormalized.
+ * @param set The morph set the accumulator was accumulated from.
+ * @param accumulator The accumulated deltas.
+ * @param vertex_start The first set vertex to write.
+ * @param vertex_end One past the last set vertex to write.
+ * @param base_vertices The mesh's undeformed vertices.
+ * @param out_vertices The mesh vertices to write, with the same layout as the base vertices.
+ * @param vertex_size The size of one vertex in bytes.
+ * @param position_offset The offset of a vertex's three position floats.
+ * @param normal_offset The offset of a vertex's three normal floats.
+ * @param out_first_vertex The first mesh vertex written.
+ * @param out_vertex_count The number of mesh vertices from the first that may have been written.
+ */
+void animation_morph_apply(
+    const struct animation_morph_set *set,
+    const struct animation_morph_accumulator *accumulator,
+    int vertex_start,
+    int vertex_end,
+    const void *base_vertices,
+    void *out_vertices,
+    size_t vertex_size,
+    size_t position_offset,
+    size_t normal_offset,
+    int *out_first_vertex,
+    int *out_vertex_count);
+
+/**
+ * Adds the target weights of a mesh or morph channel at a time to a weight per target of the channel's mesh.
+ * Morph keys are interpolated; mesh keys switch fully to their target until the next key.
+ * @param channel The mesh or morph channel to sample.
+ * @param time The time to sample at, in ticks.
+ * @param weight The weight to scale the channel's target weights by.
+ * @param weights The weight of each target of the channel's mesh, added to.
+ */
+void animation_morph_channel_sample(const struct animation_channel *channel, float time, float weight, float *weights);
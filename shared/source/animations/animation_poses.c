@@ -0,0 +1,405 @@
+/*
+ANIMATION_POSES.C
+    Animation pose sampling code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_compression.h"
+#include "animations/animation_keys.h"
+#include "animations/animation_poses.h"
+#include "memory/heap.h"
+
+/* ---------- private constants */
+
+// Above this cosine the arc is short enough that a normalized lerp is indistinguishable from a slerp
+#define ANIMATION_QUATERNION_SLERP_THRESHOLD 0.9995f
+
+/* ---------- private code */
+
+static inline void animation_vector_lerp(
+    const float *a,
+    const float *b,
+    float t,
+    float *out_vector)
+{
+    out_vector[0] = a[0] + ((b[0] - a[0]) * t);
+    out_vector[1] = a[1] + ((b[1] - a[1]) * t);
+    out_vector[2] = a[2] + ((b[2] - a[2]) * t);
+}
+
+static void animation_channel_sample_vector(
+    const struct animation_channel *channel,
+    void (*decode)(const struct animation_channel *, const uint16_t *, float *),
+    int key_count,
+    const float *key_times,
+    const uint16_t (*key_values)[3],
+    float time,
+    int *key_cursor,
+    int *decoded_key_index,
+    float decoded_keys[2][3],
+    float *out_vector)
+{
+    if (key_count <= 0)
+        return;
+
+    int key_index = animation_keys_find(key_times, key_count, time, key_cursor);
+    int next_key_index = key_index + 1 < key_count ? key_index + 1 : key_index;
+
+    // Playback stays within one key interval for several frames, so keys are only decoded when it moves on
+    if (key_index != *decoded_key_index)
+    {
+        decode(channel, key_values[key_index], decoded_keys[0]);
+        decode(channel, key_values[next_key_index], decoded_keys[1]);
+        *decoded_key_index = key_index;
+    }
+
+    if (key_index == next_key_index)
+    {
+        // Constant track
+        memcpy(out_vector, decoded_keys[0], sizeof(decoded_keys[0]));
+        return;
+    }
+
+    float factor = animation_keys_get_interpolation_factor(key_times, key_count, key_index, time);
+    animation_vector_lerp(decoded_keys[0], decoded_keys[1], factor, out_vector);
+}
+
+/* ---------- public code */
+
+size_t animation_pose_buffer_get_storage_size(
+    int node_count)
+{
+    assert(node_count >= 0);
+
+    int padded_node_count = (node_count + ANIMATION_POSE_NODE_COUNT_GRANULARITY - 1) & ~(ANIMATION_POSE_NODE_COUNT_GRANULARITY - 1);
+
+    // position, rotation and scale components
+    return (size_t)padded_node_count * 10 * sizeof(float);
+}
+
+void animation_pose_buffer_initialize(
+    struct animation_pose_buffer *pose,
+    int node_count,
+    float *storage)
+{
+    assert(pose);
+    assert(node_count >= 0);
+
+    memset(pose, 0, sizeof(*pose));
+
+    pose->node_count = node_count;
+    pose->padded_node_count = (node_count + ANIMATION_POSE_NODE_COUNT_GRANULARITY - 1) & ~(ANIMATION_POSE_NODE_COUNT_GRANULARITY - 1);
+
+    if (!storage && pose->padded_node_count)
+    {
+        storage = heap_allocate(animation_pose_buffer_get_storage_size(node_count));
+        assert(storage);
+
+        pose->owns_storage = true;
+    }
+
+    float *component = storage;
+
+    for (int i = 0; i < 3; i++, component += pose->padded_node_count)
+        pose->position[i] = component;
+
+    for (int i = 0; i < 4; i++, component += pose->padded_node_count)
+        pose->rotation[i] = component;
+
+    for (int i = 0; i < 3; i++, component += pose->padded_node_count)
+        pose->scale[i] = component;
+
+    const struct animation_node_state identity_node_state =
+    {
+        .rotation = { 0.0f, 0.0f, 0.0f, 1.0f },
+        .position = { 0.0f, 0.0f, 0.0f },
+        .scale = { 1.0f, 1.0f, 1.0f },
+    };
+
+    for (int node_index = 0; node_index < pose->padded_node_count; node_index++)
+        animation_pose_buffer_set_node_state(pose, node_index, &identity_node_state);
+}
+
+void animation_pose_buffer_dispose(
+    struct animation_pose_buffer *pose)
+{
+    assert(pose);
+
+    if (pose->owns_storage)
+        free(pose->position[0]);
+
+    memset(pose, 0, sizeof(*pose));
+}
+
+void animation_pose_buffer_copy(
+    struct animation_pose_buffer *destination,
+    const struct animation_pose_buffer *source)
+{
+    assert(destination);
+    assert(source);
+    assert(destination->padded_node_count == source->padded_node_count);
+
+    if (source->padded_node_count)
+        memcpy(destination->position[0], source->position[0], animation_pose_buffer_get_storage_size(source->node_count));
+}
+
+void animation_pose_buffer_get_node_state(
+    const struct animation_pose_buffer *pose,
+    int node_index,
+    struct animation_node_state *out_node_state)
+{
+    assert(pose);
+    assert(node_index >= 0 && node_index < pose->padded_node_count);
+    assert(out_node_state);
+
+    for (int i = 0; i < 3; i++)
+    {
+        out_node_state->position[i] = pose->position[i][node_index];
+        out_node_state->scale[i] = pose->scale[i][node_index];
+    }
+
+    for (int i = 0; i < 4; i++)
+        out_node_state->rotation[i] = pose->rotation[i][node_index];
+}
+
+void animation_pose_buffer_set_node_state(
+    struct animation_pose_buffer *pose,
+    int node_index,
+    const struct animation_node_state *node_state)
+{
+    assert(pose);
+    assert(node_index >= 0 && node_index < pose->padded_node_count);
+    assert(node_state);
+
+    for (int i = 0; i < 3; i++)
+    {
+        pose->position[i][node_index] = node_state->position[i];
+        pose->scale[i][node_index] = node_state->scale[i];
+    }
+
+    for (int i = 0; i < 4; i++)
+        pose->rotation[i][node_index] = node_state->rotation[i];
+}
+
+void animation_pose_buffer_to_matrices(
+    const struct animation_pose_buffer *pose,
+    float (*out_matrices)[4][4])
+{
+    assert(pose);
+    assert(!pose->node_count || out_matrices);
+
+    for (int node_index = 0; node_index < pose->node_count; node_index++)
+    {
+        struct animation_node_state node_state;
+        animation_pose_buffer_get_node_state(pose, node_index, &node_state);
+        animation_node_state_to_matrix(&node_state, out_matrices[node_index]);
+    }
+}
+
+void animation_quaternion_slerp(
+    const float *a,
+    const float *b,
+    float t,
+    float *out_quaternion)
+{
+    float cos_theta = (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]) + (a[3] * b[3]);
+    float sign = 1.0f;
+
+    if (cos_theta < 0.0f)
+    {
+        cos_theta = -cos_theta;
+        sign = -1.0f;
+    }
+
+    float scale_a;
+    float scale_b;
+
+    if (cos_theta > ANIMATION_QUATERNION_SLERP_THRESHOLD)
+    {
+        scale_a = 1.0f - t;
+        scale_b = t;
+    }
+    else
+    {
+        float theta = acosf(cos_theta);
+        float inverse_sin_theta = 1.0f / sinf(theta);
+
+        scale_a = sinf((1.0f - t) * theta) * inverse_sin_theta;
+        scale_b = sinf(t * theta) * inverse_sin_theta;
+    }
+
+    scale_b *= sign;
+
+    float result[4];
+    float length_squared = 0.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        result[i] = (a[i] * scale_a) + (b[i] * scale_b);
+        length_squared += result[i] * result[i];
+    }
+
+    float inverse_length = length_squared > 0.0f ? 1.0f / sqrtf(length_squared) : 0.0f;
+
+    for (int i = 0; i < 4; i++)
+        out_quaternion[i] = result[i] * inverse_length;
+}
+
+void animation_channel_cursors_initialize(
+    struct animation_channel_cursor *cursors,
+    int count)
+{
+    assert(!count || cursors);
+
+    for (int cursor_index = 0; cursor_index < count; cursor_index++)
+    {
+        struct animation_channel_cursor *cursor = cursors + cursor_index;
+
+        cursor->position_key_index = 0;
+        cursor->rotation_key_index = 0;
+        cursor->scaling_key_index = 0;
+
+        cursor->decoded_position_key_index = -1;
+        cursor->decoded_rotation_key_index = -1;
+        cursor->decoded_scaling_key_index = -1;
+    }
+}
+
+void animation_channel_sample(
+    const struct animation_data *animation,
+    const struct animation_channel *channel,
+    float time,
+    struct animation_channel_cursor *cursor,
+    struct animation_node_state *node_state)
+{
+    assert(animation);
+    assert(channel);
+    assert(cursor);
+    assert(node_state);
+
+    animation_channel_sample_vector(
+        channel,
+        animation_decode_position,
+        channel->position_key_count,
+        channel->position_key_times,
+        channel->position_key_values,
+        time,
+        &cursor->position_key_index,
+        &cursor->decoded_position_key_index,
+        cursor->decoded_position_keys,
+        node_state->position);
+
+    if (channel->rotation_key_count > 0)
+    {
+        int key_index = animation_keys_find(channel->rotation_key_times, channel->rotation_key_count, time, &cursor->rotation_key_index);
+        int next_key_index = key_index + 1 < channel->rotation_key_count ? key_index + 1 : key_index;
+
+        if (key_index != cursor->decoded_rotation_key_index)
+        {
+            animation_decode_rotation(channel->rotation_key_values[key_index], cursor->decoded_rotation_keys[0]);
+            animation_decode_rotation(channel->rotation_key_values[next_key_index], cursor->decoded_rotation_keys[1]);
+            cursor->decoded_rotation_key_index = key_index;
+        }
+
+        if (key_index == next_key_index)
+        {
+            // Constant track
+            memcpy(node_state->rotation, cursor->decoded_rotation_keys[0], sizeof(node_state->rotation));
+        }
+        else
+        {
+            float factor = animation_keys_get_interpolation_factor(channel->rotation_key_times, channel->rotation_key_count, key_index, time);
+            animation_quaternion_slerp(cursor->decoded_rotation_keys[0], cursor->decoded_rotation_keys[1], factor, node_state->rotation);
+        }
+    }
+
+    animation_channel_sample_vector(
+        channel,
+        animation_decode_scaling,
+        channel->scaling_key_count,
+        channel->scaling_key_times,
+        channel->scaling_key_values,
+        time,
+        &cursor->scaling_key_index,
+        &cursor->decoded_scaling_key_index,
+        cursor->decoded_scaling_keys,
+        node_state->scale);
+}
+
+void animation_sample_pose(
+    const struct animation_data *animation,
+    const struct animation_pose_buffer *default_pose,
+    float time,
+    struct animation_channel_cursor *cursors,
+    const unsigned int *node_mask,
+    struct animation_pose_buffer *out_pose)
+{
+    assert(animation);
+    assert(default_pose);
+    assert(out_pose);
+    assert(default_pose->node_count == out_pose->node_count);
+    assert(!out_pose->node_count || cursors);
+
+    // Start from the default pose so nodes without a channel, and components without keys, need no further work
+    animation_pose_buffer_copy(out_pose, default_pose);
+
+    for (int node_index = 0; node_index < out_pose->node_count; node_index++)
+    {
+        int channel_index = animation->node_channel_indices[node_index];
+
+        if (channel_index == -1 || (node_mask && !BIT_VECTOR_TEST_BIT(node_mask, node_index)))
+            continue;
+
+        struct animation_node_state node_state;
+        animation_pose_buffer_get_node_state(out_pose, node_index, &node_state);
+        animation_channel_sample(animation, animation->channels + channel_index, time, cursors + node_index, &node_state);
+        animation_pose_buffer_set_node_state(out_pose, node_index, &node_state);
+    }
+}
+
+void animation_node_state_to_matrix(
+    const struct animation_node_state *node_state,
+    float out_matrix[4][4])
+{
+    assert(node_state);
+    assert(out_matrix);
+
+    float x = node_state->rotation[0];
+    float y = node_state->rotation[1];
+    float z = node_state->rotation[2];
+    float w = node_state->rotation[3];
+
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+
+    float scale_x = node_state->scale[0];
+    float scale_y = node_state->scale[1];
+    float scale_z = node_state->scale[2];
+
+    out_matrix[0][0] = (1.0f - (2.0f * (yy + zz))) * scale_x;
+    out_matrix[0][1] = (2.0f * (xy + wz)) * scale_x;
+    out_matrix[0][2] = (2.0f * (xz - wy)) * scale_x;
+    out_matrix[0][3] = 0.0f;
+
+    out_matrix[1][0] = (2.0f * (xy - wz)) * scale_y;
+    out_matrix[1][1] = (1.0f - (2.0f * (xx + zz))) * scale_y;
+    out_matrix[1][2] = (2.0f * (yz + wx)) * scale_y;
+    out_matrix[1][3] = 0.0f;
+
+    out_matrix[2][0] = (2.0f * (xz + wy)) * scale_z;
+    out_matrix[2][1] = (2.0f * (yz - wx)) * scale_z;
+    out_matrix[2][2] = (1.0f - (2.0f * (xx + yy))) * scale_z;
+    out_matrix[2][3] = 0.0f;
+
+    out_matrix[3][0] = node_state->position[0];
+    out_matrix[3][1] = node_state->position[1];
+    out_matrix[3][2] = node_state->position[2];
+    out_matrix[3][3] = 1.0f;
+}
@@ -0,0 +1,139 @@
+/*
+ANIMATION_POSES.H
+    Animation pose sampling declarations.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "animations/animation_data.h"
+
+/* ---------- constants */
+
+enum
+{
+    // Pose buffers pad their node count to a multiple of this so vectorized loops never need a scalar tail
+    ANIMATION_POSE_NODE_COUNT_GRANULARITY = 8,
+};
+
+/* ---------- types */
+
+/**
+ * A node's local transform in translation/rotation/scale form. The rotation is an (x, y, z, w) quaternion.
+ * Layout compatible with cglm's vec3 and versor types.
+ */
+struct animation_node_state
+{
+    _Alignas(16) float rotation[4];
+    float position[3];
+    float scale[3];
+};
+
+struct animation_channel_cursor
+{
+    int position_key_index;
+    int rotation_key_index;
+    int scaling_key_index;
+
+    // The key interval of each track last decoded from its compressed form, or -1, and its two decoded keys
+    int decoded_position_key_index;
+    int decoded_rotation_key_index;
+    int decoded_scaling_key_index;
+    float decoded_position_keys[2][3];
+    float decoded_rotation_keys[2][4];
+    float decoded_scaling_keys[2][3];
+};
+
+/**
+ * A pose in structure-of-arrays form: one contiguous array per component, indexed by node.
+ * Padding nodes past node_count hold an identity transform.
+ */
+struct animation_pose_buffer
+{
+    int node_count;
+    int padded_node_count;
+    bool owns_storage;
+
+    float *position[3];
+    float *rotation[4];
+    float *scale[3];
+};
+
+/* ---------- prototypes/ANIMATION_POSES.C */
+
+/**
+ * Gets the number of bytes of storage a pose buffer of a node count needs.
+ */
+size_t animation_pose_buffer_get_storage_size(int node_count);
+
+/**
+ * Initializes a pose buffer to the identity pose.
+ * @param pose The pose buffer to initialize.
+ * @param node_count The number of nodes in the pose.
+ * @param storage The memory to lay the pose out in, at least animation_pose_buffer_get_storage_size bytes,
+ * or NULL to allocate it.
+ */
+void animation_pose_buffer_initialize(struct animation_pose_buffer *pose, int node_count, float *storage);
+
+/**
+ * Frees a pose buffer's storage if it allocated it.
+ */
+void animation_pose_buffer_dispose(struct animation_pose_buffer *pose);
+
+/**
+ * Copies every node of a pose buffer to another of the same node count.
+ */
+void animation_pose_buffer_copy(struct animation_pose_buffer *destination, const struct animation_pose_buffer *source);
+
+void animation_pose_buffer_get_node_state(const struct animation_pose_buffer *pose, int node_index, struct animation_node_state *out_node_state);
+void animation_pose_buffer_set_node_state(struct animation_pose_buffer *pose, int node_index, const struct animation_node_state *node_state);
+
+/**
+ * Converts every node of a pose buffer to a column-major translation * rotation * scale matrix.
+ */
+void animation_pose_buffer_to_matrices(const struct animation_pose_buffer *pose, float (*out_matrices)[4][4]);
+
+/**
+ * Resets key cursors so their next search starts from the first key and nothing is taken as already decoded.
+ * Cursors must be initialized before their first sample and whenever they move to a different animation.
+ */
+void animation_channel_cursors_initialize(struct animation_channel_cursor *cursors, int count);
+
+/**
+ * Samples the keys of a node channel at a time, overwriting only the components the channel has keys for.
+ * @param animation The animation the channel belongs to, whose ranges decode its keys.
+ * @param channel The node channel to sample.
+ * @param time The time to sample at, in ticks.
+ * @param cursor The channel's key cursors, updated as the keys are searched.
+ * @param node_state The node state to write the sampled components to.
+ */
+void animation_channel_sample(const struct animation_data *animation, const struct animation_channel *channel, float time, struct animation_channel_cursor *cursor, struct animation_node_state *node_state);
+
+/**
+ * Samples a local pose for every node. Nodes the animation has no channel for take their default state.
+ * @param animation The animation to sample.
+ * @param default_pose The default state of each node.
+ * @param time The time to sample at, in ticks.
+ * @param cursors The key cursors of each node.
+ * @param node_mask A bit vector of the nodes to sample, or NULL to sample every node. Unsampled nodes take their default state.
+ * @param out_pose The pose buffer to write the pose to, with the same node count as the default pose.
+ */
+void animation_sample_pose(
+    const struct animation_data *animation,
+    const struct animation_pose_buffer *default_pose,
+    float time,
+    struct animation_channel_cursor *cursors,
+    const unsigned int *node_mask,
+    struct animation_pose_buffer *out_pose);
+
+/**
+ * Converts a node state to a column-major translation * rotation * scale matrix.
+ */
+void animation_node_state_to_matrix(const struct animation_node_state *node_state, float out_matrix[4][4]);
+
+/**
+ * Spherically interpolates between two unit quaternions along the shortest arc.
+ */
+void animation_quaternion_slerp(const float *a, const float *b, float t, float *out_quaternion);
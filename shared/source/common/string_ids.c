@@ -0,0 +1,183 @@
+/*
+STRING_IDS.C
+    Interned string identifier code.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/string_ids.h"
+#include "memory/dynamic_arrays.h"
+#include "memory/heap.h"
+
+/* ---------- private constants */
+
+enum
+{
+    MINIMUM_STRING_TABLE_CAPACITY = 256,
+};
+
+/* ---------- private types */
+
+struct string_table_entry
+{
+    unsigned int hash;
+    string_id id;
+};
+
+/* ---------- private variables */
+
+struct
+{
+    int capacity;
+    struct string_table_entry *entries;
+
+    DYNAMIC_ARRAY(char *) strings;
+} static string_id_globals;
+
+/* ---------- private code */
+
+static inline unsigned int string_id_hash(
+    const char *string,
+    int length)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)string[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static struct string_table_entry *string_id_probe(
+    const char *string,
+    int length,
+    unsigned int hash)
+{
+    if (!string_id_globals.capacity)
+        return NULL;
+
+    unsigned int mask = string_id_globals.capacity - 1;
+    unsigned int entry_index = hash & mask;
+
+    for (;;)
+    {
+        struct string_table_entry *entry = string_id_globals.entries + entry_index;
+
+        if (entry->id == INVALID_STRING_ID)
+            return entry;
+
+        if (entry->hash == hash)
+        {
+            const char *entry_string = string_id_globals.strings.elements[entry->id - 1];
+
+            if (strncmp(entry_string, string, length) == 0 && entry_string[length] == '\0')
+                return entry;
+        }
+
+        entry_index = (entry_index + 1) & mask;
+    }
+}
+
+static void string_id_grow_table(void)
+{
+    int old_capacity = string_id_globals.capacity;
+    struct string_table_entry *old_entries = string_id_globals.entries;
+
+    string_id_globals.capacity = old_capacity ? old_capacity * 2 : MINIMUM_STRING_TABLE_CAPACITY;
+    string_id_globals.entries = heap_allocate_zeroed(string_id_globals.capacity, sizeof(*string_id_globals.entries));
+    assert(string_id_globals.entries);
+
+    unsigned int mask = string_id_globals.capacity - 1;
+
+    for (int old_entry_index = 0; old_entry_index < old_capacity; old_entry_index++)
+    {
+        struct string_table_entry *old_entry = old_entries + old_entry_index;
+
+        if (old_entry->id == INVALID_STRING_ID)
+            continue;
+
+        unsigned int entry_index = old_entry->hash & mask;
+
+        while (string_id_globals.entries[entry_index].id != INVALID_STRING_ID)
+            entry_index = (entry_index + 1) & mask;
+
+        string_id_globals.entries[entry_index] = *old_entry;
+    }
+
+    free(old_entries);
+}
+
+/* ---------- public code */
+
+string_id string_id_intern(
+    const char *string)
+{
+    assert(string);
+    return string_id_intern_length(string, strlen(string));
+}
+
+string_id string_id_intern_length(
+    const char *string,
+    int length)
+{
+    assert(string);
+    assert(length >= 0);
+
+    // Keep the load factor at or below one half
+    if ((string_id_globals.strings.count + 1) * 2 > string_id_globals.capacity)
+        string_id_grow_table();
+
+    unsigned int hash = string_id_hash(string, length);
+    struct string_table_entry *entry = string_id_probe(string, length, hash);
+
+    if (entry->id != INVALID_STRING_ID)
+        return entry->id;
+
+    char *interned_string = strndup(string, length);
+    assert(interned_string);
+
+    dynamic_array_push(&string_id_globals.strings, &interned_string);
+
+    entry->hash = hash;
+    entry->id = string_id_globals.strings.count;
+
+    return entry->id;
+}
+
+string_id string_id_find(
+    const char *string)
+{
+    assert(string);
+
+    int length = strlen(string);
+    struct string_table_entry *entry = string_id_probe(string, length, string_id_hash(string, length));
+
+    return entry ? entry->id : INVALID_STRING_ID;
+}
+
+const char *string_id_get_string(
+    string_id id)
+{
+    if (id == INVALID_STRING_ID)
+        return NULL;
+
+    assert(id <= (string_id)string_id_globals.strings.count);
+    return string_id_globals.strings.elements[id - 1];
+}
+
+void string_ids_dispose(void)
+{
+    for (int string_index = 0; string_index < string_id_globals.strings.count; string_index++)
+        free(string_id_globals.strings.elements[string_index]);
+
+    dynamic_array_dispose(&string_id_globals.strings);
+    free(string_id_globals.entries);
+
+    memset(&string_id_globals, 0, sizeof(string_id_globals));
+}
@@ -0,0 +1,57 @@
+/*
+STRING_IDS.H
+    Interned string identifier declarations.
+*/
+
+#pragma once
+
+/* ---------- constants */
+
+enum
+{
+    INVALID_STRING_ID = 0,
+};
+
+/* ---------- types */
+
+/**
+ * A small integer uniquely identifying an interned string.
+ * Equal strings always intern to the same string_id, so ids can be compared and hashed in place of the strings themselves.
+ */
+typedef unsigned int string_id;
+
+/* ---------- prototypes/STRING_IDS.C */
+
+/**
+ * Interns a string, copying it into the string table the first time it is seen.
+ * @param string The UTF-8 string to intern.
+ * @returns The string_id of the interned string.
+ */
+string_id string_id_intern(const char *string);
+
+/**
+ * Interns the first length bytes of a string.
+ * @param string The UTF-8 string to intern.
+ * @param length The number of bytes of the string to intern.
+ * @returns The string_id of the interned string.
+ */
+string_id string_id_intern_length(const char *string, int length);
+
+/**
+ * Finds the string_id of a string without interning it.
+ * @param string The UTF-8 string to find.
+ * @returns The string_id of the string, or INVALID_STRING_ID if it has never been interned.
+ */
+string_id string_id_find(const char *string);
+
+/**
+ * Gets the interned string of a string_id.
+ * @param id The string_id of the string.
+ * @returns The address of the interned string, or NULL if the string_id is INVALID_STRING_ID.
+ */
+const char *string_id_get_string(string_id id);
+
+/**
+ * Frees every interned string, invalidating every string_id.
+ */
+void string_ids_dispose(void);
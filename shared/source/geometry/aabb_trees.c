@@ -0,0 +1,789 @@
+/*
+AABB_TREES.C
+    Dynamic bounding volume hierarchy code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "geometry/aabb_trees.h"
+
+/* ---------- private constants */
+
+enum
+{
+    // A leaf whose enlarged bounds reach this many margins past its bounds is refit to them
+    AABB_TREE_LOOSE_MARGIN_MULTIPLIER = 4,
+};
+
+enum aabb_tree_frustum_test
+{
+    _aabb_tree_frustum_outside,
+    _aabb_tree_frustum_intersecting,
+    _aabb_tree_frustum_inside,
+};
+
+/* ---------- private types */
+
+struct aabb_tree_frustum_query_entry
+{
+    int node_index;
+    bool inside;
+};
+
+/* ---------- private prototypes */
+
+static int aabb_tree_allocate_node(struct aabb_tree *tree);
+static void aabb_tree_free_node(struct aabb_tree *tree, int node_index);
+static void aabb_tree_insert_leaf(struct aabb_tree *tree, int leaf_index);
+static void aabb_tree_remove_leaf(struct aabb_tree *tree, int leaf_index);
+static void aabb_tree_refit_ancestors(struct aabb_tree *tree, int node_index);
+static int aabb_tree_balance(struct aabb_tree *tree, int node_index);
+static void aabb_tree_replace_child(struct aabb_tree *tree, int parent_index, int old_child_index, int new_child_index);
+static bool aabb_tree_needs_reinsert(const struct aabb_tree *tree, const struct aabb *enlarged_bounds, const struct aabb *bounds);
+static void aabb_tree_enlarge(const struct aabb *bounds, float margin, struct aabb *out_bounds);
+static float aabb_tree_get_cost(const struct aabb *bounds);
+static void aabb_tree_union(const struct aabb *a, const struct aabb *b, struct aabb *out_bounds);
+static enum aabb_tree_frustum_test aabb_tree_test_frustum(const struct frustum *frustum, const struct aabb *bounds);
+
+static inline bool aabb_tree_is_leaf(const struct aabb_tree_node *node)
+{
+    return node->child_indices[0] == -1;
+}
+
+static inline int aabb_tree_max(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+/* ---------- public code */
+
+void aabb_tree_initialize(
+    struct aabb_tree *tree,
+    float margin)
+{
+    assert(tree);
+    assert(margin >= 0.0f);
+
+    memset(tree, 0, sizeof(*tree));
+
+    tree->margin = margin;
+    tree->root_index = -1;
+    tree->free_index = -1;
+}
+
+void aabb_tree_dispose(
+    struct aabb_tree *tree)
+{
+    assert(tree);
+
+    dynamic_array_dispose(&tree->nodes);
+    dynamic_array_dispose(&tree->moved_proxy_indices);
+
+    tree->root_index = -1;
+    tree->free_index = -1;
+    tree->proxy_count = 0;
+}
+
+int aabb_tree_insert(
+    struct aabb_tree *tree,
+    const struct aabb *bounds,
+    int user_data)
+{
+    assert(tree);
+    assert(bounds && !aabb_is_empty(bounds));
+
+    int proxy_index = aabb_tree_allocate_node(tree);
+    struct aabb_tree_node *leaf = tree->nodes.elements + proxy_index;
+
+    aabb_tree_enlarge(bounds, tree->margin, &leaf->bounds);
+    leaf->height = 0;
+    leaf->user_data = user_data;
+
+    aabb_tree_insert_leaf(tree, proxy_index);
+    tree->proxy_count++;
+
+    return proxy_index;
+}
+
+void aabb_tree_remove(
+    struct aabb_tree *tree,
+    int proxy_index)
+{
+    assert(tree);
+    assert(proxy_index >= 0 && proxy_index < tree->nodes.count);
+    assert(aabb_tree_is_leaf(tree->nodes.elements + proxy_index) && tree->nodes.elements[proxy_index].height == 0);
+
+    aabb_tree_remove_leaf(tree, proxy_index);
+    aabb_tree_free_node(tree, proxy_index);
+    tree->proxy_count--;
+}
+
+bool aabb_tree_move(
+    struct aabb_tree *tree,
+    int proxy_index,
+    const struct aabb *bounds)
+{
+    assert(tree);
+    assert(proxy_index >= 0 && proxy_index < tree->nodes.count);
+    assert(bounds && !aabb_is_empty(bounds));
+
+    struct aabb_tree_node *leaf = tree->nodes.elements + proxy_index;
+    assert(aabb_tree_is_leaf(leaf) && leaf->height == 0);
+
+    if (!aabb_tree_needs_reinsert(tree, &leaf->bounds, bounds))
+        return false;
+
+    aabb_tree_remove_leaf(tree, proxy_index);
+
+    // Removing a leaf never reallocates the nodes
+    aabb_tree_enlarge(bounds, tree->margin, &leaf->bounds);
+    aabb_tree_insert_leaf(tree, proxy_index);
+
+    return true;
+}
+
+int aabb_tree_move_batch(
+    struct aabb_tree *tree,
+    int count,
+    const int *proxy_indices,
+    const struct aabb *bounds)
+{
+    assert(tree);
+    assert(!count || (proxy_indices && bounds));
+
+    dynamic_array_clear(&tree->moved_proxy_indices);
+
+    for (int i = 0; i < count; i++)
+    {
+        int proxy_index = proxy_indices[i];
+        assert(proxy_index >= 0 && proxy_index < tree->nodes.count);
+        assert(!aabb_is_empty(bounds + i));
+
+        struct aabb_tree_node *leaf = tree->nodes.elements + proxy_index;
+        assert(aabb_tree_is_leaf(leaf) && leaf->height == 0);
+
+        if (!aabb_tree_needs_reinsert(tree, &leaf->bounds, bounds + i))
+            continue;
+
+        aabb_tree_remove_leaf(tree, proxy_index);
+        aabb_tree_enlarge(bounds + i, tree->margin, &leaf->bounds);
+
+        dynamic_array_push(&tree->moved_proxy_indices, &proxy_index);
+    }
+
+    for (int i = 0; i < tree->moved_proxy_indices.count; i++)
+        aabb_tree_insert_leaf(tree, tree->moved_proxy_indices.elements[i]);
+
+    return tree->moved_proxy_indices.count;
+}
+
+int aabb_tree_get_user_data(
+    const struct aabb_tree *tree,
+    int proxy_index)
+{
+    assert(tree);
+    assert(proxy_index >= 0 && proxy_index < tree->nodes.count);
+
+    return tree->nodes.elements[proxy_index].user_data;
+}
+
+const struct aabb *aabb_tree_get_enlarged_bounds(
+    const struct aabb_tree *tree,
+    int proxy_index)
+{
+    assert(tree);
+    assert(proxy_index >= 0 && proxy_index < tree->nodes.count);
+
+    return &tree->nodes.elements[proxy_index].bounds;
+}
+
+int aabb_tree_get_height(
+    const struct aabb_tree *tree)
+{
+    assert(tree);
+
+    return tree->root_index == -1 ? 0 : tree->nodes.elements[tree->root_index].height;
+}
+
+void aabb_tree_query_aabb(
+    const struct aabb_tree *tree,
+    const struct aabb *bounds,
+    aabb_tree_query_callback callback,
+    void *data)
+{
+    assert(tree);
+    assert(bounds);
+    assert(callback);
+
+    if (tree->root_index == -1)
+        return;
+
+    int stack[AABB_TREE_MAXIMUM_QUERY_DEPTH];
+    int stack_count = 0;
+
+    stack[stack_count++] = tree->root_index;
+
+    while (stack_count)
+    {
+        const struct aabb_tree_node *node = tree->nodes.elements + stack[--stack_count];
+
+        if (!aabb_intersects_aabb(&node->bounds, bounds))
+            continue;
+
+        if (aabb_tree_is_leaf(node))
+        {
+            if (!callback(data, (int)(node - tree->nodes.elements), node->user_data))
+                return;
+
+            continue;
+        }
+
+        assert(stack_count + 2 <= AABB_TREE_MAXIMUM_QUERY_DEPTH);
+        stack[stack_count++] = node->child_indices[0];
+        stack[stack_count++] = node->child_indices[1];
+    }
+}
+
+void aabb_tree_query_sphere(
+    const struct aabb_tree *tree,
+    const struct bounding_sphere *sphere,
+    aabb_tree_query_callback callback,
+    void *data)
+{
+    assert(tree);
+    assert(sphere);
+    assert(callback);
+
+    if (tree->root_index == -1)
+        return;
+
+    float radius_squared = sphere->radius * sphere->radius;
+
+    int stack[AABB_TREE_MAXIMUM_QUERY_DEPTH];
+    int stack_count = 0;
+
+    stack[stack_count++] = tree->root_index;
+
+    while (stack_count)
+    {
+        const struct aabb_tree_node *node = tree->nodes.elements + stack[--stack_count];
+
+        // The squared distance from the sphere's center to the nearest point of the box
+        float distance_squared = 0.0f;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float offset = fmaxf(fmaxf(node->bounds.minimum[axis] - sphere->center[axis], sphere->center[axis] - node->bounds.maximum[axis]), 0.0f);
+            distance_squared += offset * offset;
+        }
+
+        if (distance_squared > radius_squared)
+            continue;
+
+        if (aabb_tree_is_leaf(node))
+        {
+            if (!callback(data, (int)(node - tree->nodes.elements), node->user_data))
+                return;
+
+            continue;
+        }
+
+        assert(stack_count + 2 <= AABB_TREE_MAXIMUM_QUERY_DEPTH);
+        stack[stack_count++] = node->child_indices[0];
+        stack[stack_count++] = node->child_indices[1];
+    }
+}
+
+void aabb_tree_query_frustum(
+    const struct aabb_tree *tree,
+    const struct frustum *frustum,
+    aabb_tree_query_callback callback,
+    void *data)
+{
+    assert(tree);
+    assert(frustum);
+    assert(callback);
+
+    if (tree->root_index == -1)
+        return;
+
+    struct aabb_tree_frustum_query_entry stack[AABB_TREE_MAXIMUM_QUERY_DEPTH];
+    int stack_count = 0;
+
+    stack[stack_count++] = (struct aabb_tree_frustum_query_entry){ tree->root_index, false };
+
+    while (stack_count)
+    {
+        struct aabb_tree_frustum_query_entry entry = stack[--stack_count];
+        const struct aabb_tree_node *node = tree->nodes.elements + entry.node_index;
+
+        // Everything below a node entirely inside the frustum is inside it too
+        if (!entry.inside)
+        {
+            enum aabb_tree_frustum_test test = aabb_tree_test_frustum(frustum, &node->bounds);
+
+            if (test == _aabb_tree_frustum_outside)
+                continue;
+
+            entry.inside = test == _aabb_tree_frustum_inside;
+        }
+
+        if (aabb_tree_is_leaf(node))
+        {
+            if (!callback(data, entry.node_index, node->user_data))
+                return;
+
+            continue;
+        }
+
+        assert(stack_count + 2 <= AABB_TREE_MAXIMUM_QUERY_DEPTH);
+        stack[stack_count++] = (struct aabb_tree_frustum_query_entry){ node->child_indices[0], entry.inside };
+        stack[stack_count++] = (struct aabb_tree_frustum_query_entry){ node->child_indices[1], entry.inside };
+    }
+}
+
+void aabb_tree_query_ray(
+    const struct aabb_tree *tree,
+    const float origin[3],
+    const float direction[3],
+    float maximum_distance,
+    aabb_tree_query_callback callback,
+    void *data)
+{
+    assert(tree);
+    assert(origin);
+    assert(direction);
+    assert(callback);
+
+    if (tree->root_index == -1)
+        return;
+
+    // Divisions by zero give infinities, which the slab test below handles
+    float inverse_direction[3];
+
+    for (int axis = 0; axis < 3; axis++)
+        inverse_direction[axis] = 1.0f / direction[axis];
+
+    int stack[AABB_TREE_MAXIMUM_QUERY_DEPTH];
+    int stack_count = 0;
+
+    stack[stack_count++] = tree->root_index;
+
+    while (stack_count)
+    {
+        const struct aabb_tree_node *node = tree->nodes.elements + stack[--stack_count];
+
+        float entry_distance = 0.0f;
+        float exit_distance = maximum_distance;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float near_distance = (node->bounds.minimum[axis] - origin[axis]) * inverse_direction[axis];
+            float far_distance = (node->bounds.maximum[axis] - origin[axis]) * inverse_direction[axis];
+
+            // fminf and fmaxf drop the NaN a ray starting exactly on a slab's face gives
+            entry_distance = fmaxf(entry_distance, fminf(near_distance, far_distance));
+            exit_distance = fminf(exit_distance, fmaxf(near_distance, far_distance));
+        }
+
+        if (entry_distance > exit_distance)
+            continue;
+
+        if (aabb_tree_is_leaf(node))
+        {
+            if (!callback(data, (int)(node - tree->nodes.elements), node->user_data))
+                return;
+
+            continue;
+        }
+
+        assert(stack_count + 2 <= AABB_TREE_MAXIMUM_QUERY_DEPTH);
+        stack[stack_count++] = node->child_indices[0];
+        stack[stack_count++] = node->child_indices[1];
+    }
+}
+
+/* ---------- private code */
+
+static int aabb_tree_allocate_node(
+    struct aabb_tree *tree)
+{
+    int node_index;
+
+    if (tree->free_index != -1)
+    {
+        node_index = tree->free_index;
+        tree->free_index = tree->nodes.elements[node_index].parent_index;
+    }
+    else
+    {
+        node_index = tree->nodes.count;
+        dynamic_array_push(&tree->nodes, NULL);
+    }
+
+    struct aabb_tree_node *node = tree->nodes.elements + node_index;
+
+    node->parent_index = -1;
+    node->child_indices[0] = -1;
+    node->child_indices[1] = -1;
+    node->height = 0;
+    node->user_data = -1;
+
+    return node_index;
+}
+
+static void aabb_tree_free_node(
+    struct aabb_tree *tree,
+    int node_index)
+{
+    struct aabb_tree_node *node = tree->nodes.elements + node_index;
+
+    node->parent_index = tree->free_index;
+    node->height = -1;
+
+    tree->free_index = node_index;
+}
+
+static void aabb_tree_insert_leaf(
+    struct aabb_tree *tree,
+    int leaf_index)
+{
+    if (tree->root_index == -1)
+    {
+        tree->root_index = leaf_index;
+        tree->nodes.elements[leaf_index].parent_index = -1;
+        return;
+    }
+
+    // Allocating the new parent may move the nodes
+    int parent_index = aabb_tree_allocate_node(tree);
+
+    struct aabb_tree_node *nodes = tree->nodes.elements;
+    const struct aabb *leaf_bounds = &nodes[leaf_index].bounds;
+
+    // Walk down towards the sibling that grows the tree's total surface area the least
+    int sibling_index = tree->root_index;
+
+    while (!aabb_tree_is_leaf(nodes + sibling_index))
+    {
+        struct aabb_tree_node *node = nodes + sibling_index;
+
+        struct aabb combined_bounds;
+        aabb_tree_union(&node->bounds, leaf_bounds, &combined_bounds);
+
+        float area = aabb_tree_get_cost(&node->bounds);
+        float combined_area = aabb_tree_get_cost(&combined_bounds);
+
+        // The cost of pairing the leaf with this node, and the cost every ancestor pays for the node growing
+        float cost = 2.0f * combined_area;
+        float inherited_cost = 2.0f * (combined_area - area);
+
+        float child_costs[2];
+
+        for (int child = 0; child < 2; child++)
+        {
+            struct aabb_tree_node *child_node = nodes + node->child_indices[child];
+
+            struct aabb child_combined_bounds;
+            aabb_tree_union(&child_node->bounds, leaf_bounds, &child_combined_bounds);
+
+            float child_combined_area = aabb_tree_get_cost(&child_combined_bounds);
+
+            if (aabb_tree_is_leaf(child_node))
+                child_costs[child] = child_combined_area + inherited_cost;
+            else
+                child_costs[child] = (child_combined_area - aabb_tree_get_cost(&child_node->bounds)) + inherited_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1])
+            break;
+
+        sibling_index = node->child_indices[child_costs[0] < child_costs[1] ? 0 : 1];
+    }
+
+    struct aabb_tree_node *sibling = nodes + sibling_index;
+    struct aabb_tree_node *parent = nodes + parent_index;
+    int old_parent_index = sibling->parent_index;
+
+    parent->parent_index = old_parent_index;
+    parent->child_indices[0] = sibling_index;
+    parent->child_indices[1] = leaf_index;
+    parent->height = sibling->height + 1;
+    aabb_tree_union(&sibling->bounds, leaf_bounds, &parent->bounds);
+
+    if (old_parent_index != -1)
+        aabb_tree_replace_child(tree, old_parent_index, sibling_index, parent_index);
+    else
+        tree->root_index = parent_index;
+
+    sibling->parent_index = parent_index;
+    nodes[leaf_index].parent_index = parent_index;
+
+    aabb_tree_refit_ancestors(tree, old_parent_index);
+}
+
+static void aabb_tree_remove_leaf(
+    struct aabb_tree *tree,
+    int leaf_index)
+{
+    struct aabb_tree_node *nodes = tree->nodes.elements;
+
+    if (leaf_index == tree->root_index)
+    {
+        tree->root_index = -1;
+        return;
+    }
+
+    int parent_index = nodes[leaf_index].parent_index;
+    struct aabb_tree_node *parent = nodes + parent_index;
+
+    int grandparent_index = parent->parent_index;
+    int sibling_index = parent->child_indices[parent->child_indices[0] == leaf_index ? 1 : 0];
+
+    // The sibling takes the parent's place
+    if (grandparent_index != -1)
+        aabb_tree_replace_child(tree, grandparent_index, parent_index, sibling_index);
+    else
+        tree->root_index = sibling_index;
+
+    nodes[sibling_index].parent_index = grandparent_index;
+    nodes[leaf_index].parent_index = -1;
+
+    aabb_tree_free_node(tree, parent_index);
+    aabb_tree_refit_ancestors(tree, grandparent_index);
+}
+
+static void aabb_tree_refit_ancestors(
+    struct aabb_tree *tree,
+    int node_index)
+{
+    struct aabb_tree_node *nodes = tree->nodes.elements;
+
+    while (node_index != -1)
+    {
+        node_index = aabb_tree_balance(tree, node_index);
+
+        struct aabb_tree_node *node = nodes + node_index;
+        struct aabb_tree_node *child0 = nodes + node->child_indices[0];
+        struct aabb_tree_node *child1 = nodes + node->child_indices[1];
+
+        node->height = 1 + aabb_tree_max(child0->height, child1->height);
+        aabb_tree_union(&child0->bounds, &child1->bounds, &node->bounds);
+
+        node_index = node->parent_index;
+    }
+}
+
+static int aabb_tree_balance(
+    struct aabb_tree *tree,
+    int a_index)
+{
+    struct aabb_tree_node *nodes = tree->nodes.elements;
+    struct aabb_tree_node *a = nodes + a_index;
+
+    if (aabb_tree_is_leaf(a) || a->height < 2)
+        return a_index;
+
+    int b_index = a->child_indices[0];
+    int c_index = a->child_indices[1];
+    struct aabb_tree_node *b = nodes + b_index;
+    struct aabb_tree_node *c = nodes + c_index;
+
+    int balance = c->height - b->height;
+
+    if (balance > 1)
+    {
+        // Rotate c above a, and give a whichever of c's children is shorter
+        int f_index = c->child_indices[0];
+        int g_index = c->child_indices[1];
+        struct aabb_tree_node *f = nodes + f_index;
+        struct aabb_tree_node *g = nodes + g_index;
+
+        c->child_indices[0] = a_index;
+        c->parent_index = a->parent_index;
+        a->parent_index = c_index;
+
+        if (c->parent_index != -1)
+            aabb_tree_replace_child(tree, c->parent_index, a_index, c_index);
+        else
+            tree->root_index = c_index;
+
+        if (f->height > g->height)
+        {
+            c->child_indices[1] = f_index;
+            a->child_indices[1] = g_index;
+            g->parent_index = a_index;
+
+            aabb_tree_union(&b->bounds, &g->bounds, &a->bounds);
+            aabb_tree_union(&a->bounds, &f->bounds, &c->bounds);
+
+            a->height = 1 + aabb_tree_max(b->height, g->height);
+            c->height = 1 + aabb_tree_max(a->height, f->height);
+        }
+        else
+        {
+            c->child_indices[1] = g_index;
+            a->child_indices[1] = f_index;
+            f->parent_index = a_index;
+
+            aabb_tree_union(&b->bounds, &f->bounds, &a->bounds);
+            aabb_tree_union(&a->bounds, &g->bounds, &c->bounds);
+
+            a->height = 1 + aabb_tree_max(b->height, f->height);
+            c->height = 1 + aabb_tree_max(a->height, g->height);
+        }
+
+        return c_index;
+    }
+
+    if (balance < -1)
+    {
+        // Rotate b above a, and give a whichever of b's children is shorter
+        int d_index = b->child_indices[0];
+        int e_index = b->child_indices[1];
+        struct aabb_tree_node *d = nodes + d_index;
+        struct aabb_tree_node *e = nodes + e_index;
+
+        b->child_indices[0] = a_index;
+        b->parent_index = a->parent_index;
+        a->parent_index = b_index;
+
+        if (b->parent_index != -1)
+            aabb_tree_replace_child(tree, b->parent_index, a_index, b_index);
+        else
+            tree->root_index = b_index;
+
+        if (d->height > e->height)
+        {
+            b->child_indices[1] = d_index;
+            a->child_indices[0] = e_index;
+            e->parent_index = a_index;
+
+            aabb_tree_union(&c->bounds, &e->bounds, &a->bounds);
+            aabb_tree_union(&a->bounds, &d->bounds, &b->bounds);
+
+            a->height = 1 + aabb_tree_max(c->height, e->height);
+            b->height = 1 + aabb_tree_max(a->height, d->height);
+        }
+        else
+        {
+            b->child_indices[1] = e_index;
+            a->child_indices[0] = d_index;
+            d->parent_index = a_index;
+
+            aabb_tree_union(&c->bounds, &d->bounds, &a->bounds);
+            aabb_tree_union(&a->bounds, &e->bounds, &b->bounds);
+
+            a->height = 1 + aabb_tree_max(c->height, d->height);
+            b->height = 1 + aabb_tree_max(a->height, e->height);
+        }
+
+        return b_index;
+    }
+
+    return a_index;
+}
+
+static void aabb_tree_replace_child(
+    struct aabb_tree *tree,
+    int parent_index,
+    int old_child_index,
+    int new_child_index)
+{
+    struct aabb_tree_node *parent = tree->nodes.elements + parent_index;
+
+    if (parent->child_indices[0] == old_child_index)
+    {
+        parent->child_indices[0] = new_child_index;
+    }
+    else
+    {
+        assert(parent->child_indices[1] == old_child_index);
+        parent->child_indices[1] = new_child_index;
+    }
+}
+
+static bool aabb_tree_needs_reinsert(
+    const struct aabb_tree *tree,
+    const struct aabb *enlarged_bounds,
+    const struct aabb *bounds)
+{
+    if (!aabb_contains_aabb(enlarged_bounds, bounds))
+        return true;
+
+    // A proxy that has shrunk a lot would otherwise be found by queries that miss it by far more than the margin
+    struct aabb loose_bounds;
+    aabb_tree_enlarge(bounds, tree->margin * AABB_TREE_LOOSE_MARGIN_MULTIPLIER, &loose_bounds);
+
+    return !aabb_contains_aabb(&loose_bounds, enlarged_bounds);
+}
+
+static void aabb_tree_enlarge(
+    const struct aabb *bounds,
+    float margin,
+    struct aabb *out_bounds)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        out_bounds->minimum[axis] = bounds->minimum[axis] - margin;
+        out_bounds->maximum[axis] = bounds->maximum[axis] + margin;
+    }
+}
+
+static float aabb_tree_get_cost(
+    const struct aabb *bounds)
+{
+    // Half the surface area, which is proportional to how likely a random ray or query is to hit the box
+    float x = bounds->maximum[0] - bounds->minimum[0];
+    float y = bounds->maximum[1] - bounds->minimum[1];
+    float z = bounds->maximum[2] - bounds->minimum[2];
+
+    return (x * y) + (y * z) + (z * x);
+}
+
+static void aabb_tree_union(
+    const struct aabb *a,
+    const struct aabb *b,
+    struct aabb *out_bounds)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        out_bounds->minimum[axis] = fminf(a->minimum[axis], b->minimum[axis]);
+        out_bounds->maximum[axis] = fmaxf(a->maximum[axis], b->maximum[axis]);
+    }
+}
+
+static enum aabb_tree_frustum_test aabb_tree_test_frustum(
+    const struct frustum *frustum,
+    const struct aabb *bounds)
+{
+    enum aabb_tree_frustum_test result = _aabb_tree_frustum_inside;
+
+    for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+    {
+        const float *plane = frustum->planes[plane_index];
+
+        // The distances of the corners farthest along and against the plane's normal
+        float far_distance = plane[3];
+        float near_distance = plane[3];
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float maximum = plane[axis] * bounds->maximum[axis];
+            float minimum = plane[axis] * bounds->minimum[axis];
+
+            far_distance += fmaxf(maximum, minimum);
+            near_distance += fminf(maximum, minimum);
+        }
+
+        if (far_distance < 0.0f)
+            return _aabb_tree_frustum_outside;
+
+        if (near_distance < 0.0f)
+            result = _aabb_tree_frustum_intersecting;
+    }
+
+    return result;
+}
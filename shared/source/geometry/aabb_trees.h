@@ -0,0 +1,134 @@
+/*
+AABB_TREES.H
+    Dynamic bounding volume hierarchy declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+
+#include "geometry/bounding_volumes.h"
+#include "geometry/frustums.h"
+#include "memory/dynamic_arrays.h"
+
+/* ---------- constants */
+
+enum
+{
+    // Deep enough for any tree the balancing allows to hold in memory
+    AABB_TREE_MAXIMUM_QUERY_DEPTH = 128,
+};
+
+/* ---------- types */
+
+/**
+ * A node of an AABB tree. Leaves hold one proxy each and have no children.
+ */
+struct aabb_tree_node
+{
+    // A leaf's enlarged bounds, or the union of a branch's children
+    struct aabb bounds;
+
+    // The parent node, or the next free node while the node is unused
+    int parent_index;
+    int child_indices[2];
+
+    // Zero for leaves and -1 for unused nodes
+    int height;
+
+    int user_data;
+};
+
+/**
+ * A binary tree of bounding boxes, rebalanced as proxies are inserted and removed.
+ * Each proxy's leaf stores its bounds enlarged by a margin, so a proxy that moves a little stays where it is in the tree.
+ */
+struct aabb_tree
+{
+    float margin;
+
+    int root_index;
+    int free_index;
+    int proxy_count;
+
+    DYNAMIC_ARRAY(struct aabb_tree_node) nodes;
+
+    // The proxies a batched move took out of the tree, put back once all of them have been moved
+    DYNAMIC_ARRAY(int) moved_proxy_indices;
+};
+
+/**
+ * Called for each proxy a query finds.
+ * @param data The data passed to the query.
+ * @param proxy_index The proxy found.
+ * @param user_data The user data the proxy was inserted with.
+ * @returns false to end the query.
+ */
+typedef bool (*aabb_tree_query_callback)(void *data, int proxy_index, int user_data);
+
+/* ---------- prototypes/AABB_TREES.C */
+
+/**
+ * Initializes an empty tree.
+ * @param tree The tree to initialize.
+ * @param margin How far past its bounds on every side each proxy can move without the tree being updated.
+ */
+void aabb_tree_initialize(struct aabb_tree *tree, float margin);
+void aabb_tree_dispose(struct aabb_tree *tree);
+
+/**
+ * Inserts a proxy into a tree.
+ * @param tree The tree to insert into.
+ * @param bounds The proxy's bounds, which must not be empty.
+ * @param user_data A value handed back by queries that find the proxy.
+ * @returns The proxy's index, which stays the same until the proxy is removed.
+ */
+int aabb_tree_insert(struct aabb_tree *tree, const struct aabb *bounds, int user_data);
+void aabb_tree_remove(struct aabb_tree *tree, int proxy_index);
+
+/**
+ * Updates the bounds of a proxy. The proxy is only reinserted when its bounds leave its enlarged bounds,
+ * or have shrunk far enough inside them that queries would find it too often.
+ * @returns true if the proxy was reinserted.
+ */
+bool aabb_tree_move(struct aabb_tree *tree, int proxy_index, const struct aabb *bounds);
+
+/**
+ * Updates the bounds of many proxies at once. Every proxy that has to be reinserted is removed before any is put back,
+ * so none of them is placed next to another's stale bounds.
+ * @param tree The tree to update.
+ * @param count The number of proxies.
+ * @param proxy_indices The proxies to update.
+ * @param bounds The new bounds of each proxy.
+ * @returns The number of proxies reinserted.
+ */
+int aabb_tree_move_batch(struct aabb_tree *tree, int count, const int *proxy_indices, const struct aabb *bounds);
+
+int aabb_tree_get_user_data(const struct aabb_tree *tree, int proxy_index);
+const struct aabb *aabb_tree_get_enlarged_bounds(const struct aabb_tree *tree, int proxy_index);
+int aabb_tree_get_height(const struct aabb_tree *tree);
+
+/*
+ * Queries report every proxy whose enlarged bounds pass the test, so they may report proxies up to the tree's margin
+ * away from what was asked for. Queries only read the tree, and may run on several threads at once.
+ */
+
+void aabb_tree_query_aabb(const struct aabb_tree *tree, const struct aabb *bounds, aabb_tree_query_callback callback, void *data);
+void aabb_tree_query_sphere(const struct aabb_tree *tree, const struct bounding_sphere *sphere, aabb_tree_query_callback callback, void *data);
+void aabb_tree_query_frustum(const struct aabb_tree *tree, const struct frustum *frustum, aabb_tree_query_callback callback, void *data);
+
+/**
+ * Reports the proxies a ray segment passes through, in no particular order.
+ * @param tree The tree to query.
+ * @param origin The start of the ray.
+ * @param direction The direction of the ray, which need not be normalized.
+ * @param maximum_distance How far along the ray to look, in multiples of the direction's length.
+ * @param callback Called for each proxy found.
+ * @param data Passed to the callback.
+ */
+void aabb_tree_query_ray(
+    const struct aabb_tree *tree,
+    const float origin[3],
+    const float direction[3],
+    float maximum_distance,
+    aabb_tree_query_callback callback,
+    void *data);
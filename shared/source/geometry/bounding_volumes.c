@@ -0,0 +1,253 @@
+/*
+BOUNDING_VOLUMES.C
+    Axis-aligned bounding box and bounding sphere code.
+*/
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+#include "geometry/bounding_volumes.h"
+
+/* ---------- public code */
+
+void aabb_clear(
+    struct aabb *aabb)
+{
+    assert(aabb);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        aabb->minimum[axis] = FLT_MAX;
+        aabb->maximum[axis] = -FLT_MAX;
+    }
+}
+
+bool aabb_is_empty(
+    const struct aabb *aabb)
+{
+    assert(aabb);
+    return aabb->minimum[0] > aabb->maximum[0] || aabb->minimum[1] > aabb->maximum[1] || aabb->minimum[2] > aabb->maximum[2];
+}
+
+void aabb_add_point(
+    struct aabb *aabb,
+    const float point[3])
+{
+    assert(aabb);
+    assert(point);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        aabb->minimum[axis] = fminf(aabb->minimum[axis], point[axis]);
+        aabb->maximum[axis] = fmaxf(aabb->maximum[axis], point[axis]);
+    }
+}
+
+void aabb_add_aabb(
+    struct aabb *aabb,
+    const struct aabb *other)
+{
+    assert(aabb);
+    assert(other);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        aabb->minimum[axis] = fminf(aabb->minimum[axis], other->minimum[axis]);
+        aabb->maximum[axis] = fmaxf(aabb->maximum[axis], other->maximum[axis]);
+    }
+}
+
+void aabb_add_points(
+    struct aabb *aabb,
+    const void *points,
+    size_t stride,
+    int count)
+{
+    assert(aabb);
+    assert(!count || points);
+
+    for (int point_index = 0; point_index < count; point_index++)
+        aabb_add_point(aabb, (const float *)((const char *)points + (point_index * stride)));
+}
+
+void aabb_transform(
+    const struct aabb *aabb,
+    const float matrix[4][4],
+    struct aabb *out_aabb)
+{
+    assert(aabb);
+    assert(matrix);
+    assert(out_aabb);
+
+    if (aabb_is_empty(aabb))
+    {
+        aabb_clear(out_aabb);
+        return;
+    }
+
+    // Each output axis starts at the translation and takes the smaller and larger of each input axis' contribution
+    struct aabb result;
+
+    for (int row = 0; row < 3; row++)
+    {
+        result.minimum[row] = result.maximum[row] = matrix[3][row];
+
+        for (int column = 0; column < 3; column++)
+        {
+            float a = matrix[column][row] * aabb->minimum[column];
+            float b = matrix[column][row] * aabb->maximum[column];
+
+            result.minimum[row] += fminf(a, b);
+            result.maximum[row] += fmaxf(a, b);
+        }
+    }
+
+    *out_aabb = result;
+}
+
+void aabb_get_center(
+    const struct aabb *aabb,
+    float out_center[3])
+{
+    assert(aabb);
+    assert(out_center);
+
+    for (int axis = 0; axis < 3; axis++)
+        out_center[axis] = (aabb->minimum[axis] + aabb->maximum[axis]) * 0.5f;
+}
+
+void aabb_get_extents(
+    const struct aabb *aabb,
+    float out_extents[3])
+{
+    assert(aabb);
+    assert(out_extents);
+
+    for (int axis = 0; axis < 3; axis++)
+        out_extents[axis] = (aabb->maximum[axis] - aabb->minimum[axis]) * 0.5f;
+}
+
+bool aabb_intersects_aabb(
+    const struct aabb *aabb,
+    const struct aabb *other)
+{
+    assert(aabb);
+    assert(other);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (aabb->minimum[axis] > other->maximum[axis] || aabb->maximum[axis] < other->minimum[axis])
+            return false;
+    }
+
+    return true;
+}
+
+bool aabb_contains_aabb(
+    const struct aabb *aabb,
+    const struct aabb *other)
+{
+    assert(aabb);
+    assert(other);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (other->minimum[axis] < aabb->minimum[axis] || other->maximum[axis] > aabb->maximum[axis])
+            return false;
+    }
+
+    return true;
+}
+
+void bounding_sphere_from_aabb(
+    const struct aabb *aabb,
+    struct bounding_sphere *out_sphere)
+{
+    assert(aabb);
+    assert(out_sphere);
+
+    if (aabb_is_empty(aabb))
+    {
+        *out_sphere = (struct bounding_sphere){ 0 };
+        return;
+    }
+
+    float extents[3];
+    aabb_get_center(aabb, out_sphere->center);
+    aabb_get_extents(aabb, extents);
+
+    out_sphere->radius = sqrtf((extents[0] * extents[0]) + (extents[1] * extents[1]) + (extents[2] * extents[2]));
+}
+
+void bounding_sphere_from_points(
+    const void *points,
+    size_t stride,
+    int count,
+    struct bounding_sphere *out_sphere)
+{
+    assert(out_sphere);
+
+    struct aabb aabb;
+    aabb_clear(&aabb);
+    aabb_add_points(&aabb, points, stride, count);
+
+    if (aabb_is_empty(&aabb))
+    {
+        *out_sphere = (struct bounding_sphere){ 0 };
+        return;
+    }
+
+    aabb_get_center(&aabb, out_sphere->center);
+
+    float radius_squared = 0.0f;
+
+    for (int point_index = 0; point_index < count; point_index++)
+    {
+        const float *point = (const float *)((const char *)points + (point_index * stride));
+
+        float dx = point[0] - out_sphere->center[0];
+        float dy = point[1] - out_sphere->center[1];
+        float dz = point[2] - out_sphere->center[2];
+
+        radius_squared = fmaxf(radius_squared, (dx * dx) + (dy * dy) + (dz * dz));
+    }
+
+    out_sphere->radius = sqrtf(radius_squared);
+}
+
+void bounding_sphere_transform(
+    const struct bounding_sphere *sphere,
+    const float matrix[4][4],
+    struct bounding_sphere *out_sphere)
+{
+    assert(sphere);
+    assert(matrix);
+    assert(out_sphere);
+
+    float center[3];
+    float scale_squared = 0.0f;
+
+    for (int row = 0; row < 3; row++)
+    {
+        center[row] = matrix[3][row] +
+            (matrix[0][row] * sphere->center[0]) +
+            (matrix[1][row] * sphere->center[1]) +
+            (matrix[2][row] * sphere->center[2]);
+    }
+
+    for (int column = 0; column < 3; column++)
+    {
+        float axis_scale_squared =
+            (matrix[column][0] * matrix[column][0]) +
+            (matrix[column][1] * matrix[column][1]) +
+            (matrix[column][2] * matrix[column][2]);
+
+        scale_squared = fmaxf(scale_squared, axis_scale_squared);
+    }
+
+    out_sphere->center[0] = center[0];
+    out_sphere->center[1] = center[1];
+    out_sphere->center[2] = center[2];
+    out_sphere->radius = sphere->radius * sqrtf(scale_squared);
+}
@@ -0,0 +1,83 @@
+/*
+BOUNDING_VOLUMES.H
+    Axis-aligned bounding box and bounding sphere declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ---------- types */
+
+/**
+ * An axis-aligned bounding box. An empty box has every minimum above its maximum.
+ * Layout compatible with a pair of cglm vec3s.
+ */
+struct aabb
+{
+    float minimum[3];
+    float maximum[3];
+};
+
+/**
+ * A bounding sphere. Layout compatible with a cglm vec4 of the center and radius.
+ */
+struct bounding_sphere
+{
+    float center[3];
+    float radius;
+};
+
+/* ---------- prototypes/BOUNDING_VOLUMES.C */
+
+void aabb_clear(struct aabb *aabb);
+bool aabb_is_empty(const struct aabb *aabb);
+
+void aabb_add_point(struct aabb *aabb, const float point[3]);
+void aabb_add_aabb(struct aabb *aabb, const struct aabb *other);
+
+/**
+ * Adds a number of points to a box.
+ * @param aabb The box to grow.
+ * @param points The address of the first point's three floats.
+ * @param stride The number of bytes from one point to the next.
+ * @param count The number of points.
+ */
+void aabb_add_points(struct aabb *aabb, const void *points, size_t stride, int count);
+
+/**
+ * Computes the box around a transformed box. Empty boxes stay empty.
+ * @param aabb The box to transform.
+ * @param matrix An affine column-major matrix, laid out like a cglm mat4.
+ * @param out_aabb The transformed box, which may be the box being transformed.
+ */
+void aabb_transform(const struct aabb *aabb, const float matrix[4][4], struct aabb *out_aabb);
+
+void aabb_get_center(const struct aabb *aabb, float out_center[3]);
+void aabb_get_extents(const struct aabb *aabb, float out_extents[3]);
+
+bool aabb_intersects_aabb(const struct aabb *aabb, const struct aabb *other);
+bool aabb_contains_aabb(const struct aabb *aabb, const struct aabb *other);
+
+/**
+ * Gets the sphere around a box, with a radius of zero for an empty box.
+ */
+void bounding_sphere_from_aabb(const struct aabb *aabb, struct bounding_sphere *out_sphere);
+
+/**
+ * Computes a sphere around a number of points, centered on their bounding box, which is usually tighter than the
+ * sphere around the box itself.
+ * @param points The address of the first point's three floats.
+ * @param stride The number of bytes from one point to the next.
+ * @param count The number of points.
+ * @param out_sphere The sphere around the points.
+ */
+void bounding_sphere_from_points(const void *points, size_t stride, int count, struct bounding_sphere *out_sphere);
+
+/**
+ * Computes the sphere around a transformed sphere, scaling the radius by the matrix's largest axis scale.
+ * @param sphere The sphere to transform.
+ * @param matrix An affine column-major matrix, laid out like a cglm mat4.
+ * @param out_sphere The transformed sphere, which may be the sphere being transformed.
+ */
+void bounding_sphere_transform(const struct bounding_sphere *sphere, const float matrix[4][4], struct bounding_sphere *out_sphere);
@@ -0,0 +1,236 @@
+/*
+FRUSTUMS.C
+    View frustum code.
+*/
+
+#include <assert.h>
+#include <math.h>
+
+#include "geometry/frustums.h"
+
+/* ---------- private types */
+
+// Define FRUSTUMS_SCALAR to force the portable path.
+#if defined(__AVX__) && !defined(FRUSTUMS_SCALAR)
+
+#include <immintrin.h>
+
+#define FRUSTUM_VECTOR_WIDTH 8
+
+typedef __m256 frustum_vector;
+
+static inline frustum_vector frustum_vector_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline frustum_vector frustum_vector_set(float a) { return _mm256_set1_ps(a); }
+static inline frustum_vector frustum_vector_add(frustum_vector a, frustum_vector b) { return _mm256_add_ps(a, b); }
+static inline frustum_vector frustum_vector_mul(frustum_vector a, frustum_vector b) { return _mm256_mul_ps(a, b); }
+static inline frustum_vector frustum_vector_or(frustum_vector a, frustum_vector b) { return _mm256_or_ps(a, b); }
+static inline frustum_vector frustum_vector_zero(void) { return _mm256_setzero_ps(); }
+
+// All bits set in each lane where a + b < 0
+static inline frustum_vector frustum_vector_outside(frustum_vector a, frustum_vector b)
+{
+    return _mm256_cmp_ps(_mm256_add_ps(a, b), _mm256_setzero_ps(), _CMP_LT_OQ);
+}
+
+static inline int frustum_vector_mask(frustum_vector a) { return _mm256_movemask_ps(a); }
+
+#elif (defined(__SSE__) || defined(_M_X64)) && !defined(FRUSTUMS_SCALAR)
+
+#include <xmmintrin.h>
+
+#define FRUSTUM_VECTOR_WIDTH 4
+
+typedef __m128 frustum_vector;
+
+static inline frustum_vector frustum_vector_load(const float *p) { return _mm_loadu_ps(p); }
+static inline frustum_vector frustum_vector_set(float a) { return _mm_set1_ps(a); }
+static inline frustum_vector frustum_vector_add(frustum_vector a, frustum_vector b) { return _mm_add_ps(a, b); }
+static inline frustum_vector frustum_vector_mul(frustum_vector a, frustum_vector b) { return _mm_mul_ps(a, b); }
+static inline frustum_vector frustum_vector_or(frustum_vector a, frustum_vector b) { return _mm_or_ps(a, b); }
+static inline frustum_vector frustum_vector_zero(void) { return _mm_setzero_ps(); }
+
+// All bits set in each lane where a + b < 0
+static inline frustum_vector frustum_vector_outside(frustum_vector a, frustum_vector b)
+{
+    return _mm_cmplt_ps(_mm_add_ps(a, b), _mm_setzero_ps());
+}
+
+static inline int frustum_vector_mask(frustum_vector a) { return _mm_movemask_ps(a); }
+
+#else
+
+#define FRUSTUM_VECTOR_WIDTH 1
+
+typedef float frustum_vector;
+
+static inline frustum_vector frustum_vector_load(const float *p) { return *p; }
+static inline frustum_vector frustum_vector_set(float a) { return a; }
+static inline frustum_vector frustum_vector_add(frustum_vector a, frustum_vector b) { return a + b; }
+static inline frustum_vector frustum_vector_mul(frustum_vector a, frustum_vector b) { return a * b; }
+static inline frustum_vector frustum_vector_or(frustum_vector a, frustum_vector b) { return (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f; }
+static inline frustum_vector frustum_vector_zero(void) { return 0.0f; }
+
+// Non-zero where a + b < 0
+static inline frustum_vector frustum_vector_outside(frustum_vector a, frustum_vector b)
+{
+    return (a + b < 0.0f) ? 1.0f : 0.0f;
+}
+
+static inline int frustum_vector_mask(frustum_vector a) { return a != 0.0f; }
+
+#endif
+
+/* ---------- private prototypes */
+
+static float frustum_get_plane_distance(const float plane[4], const float point[3]);
+
+/* ---------- public code */
+
+void frustum_from_matrix(
+    struct frustum *out_frustum,
+    const float matrix[4][4])
+{
+    assert(out_frustum);
+    assert(matrix);
+
+    // Each plane is the last row of the matrix plus or minus one of the others
+    for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+    {
+        int row = plane_index / 2;
+        float sign = (plane_index % 2) ? -1.0f : 1.0f;
+
+        float *plane = out_frustum->planes[plane_index];
+
+        for (int column = 0; column < 4; column++)
+            plane[column] = matrix[column][3] + (sign * matrix[column][row]);
+
+        float length = sqrtf((plane[0] * plane[0]) + (plane[1] * plane[1]) + (plane[2] * plane[2]));
+
+        if (length > 0.0f)
+        {
+            for (int component = 0; component < 4; component++)
+                plane[component] /= length;
+        }
+    }
+}
+
+bool frustum_test_sphere(
+    const struct frustum *frustum,
+    const struct bounding_sphere *sphere)
+{
+    assert(frustum);
+    assert(sphere);
+
+    for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+    {
+        if (frustum_get_plane_distance(frustum->planes[plane_index], sphere->center) < -sphere->radius)
+            return false;
+    }
+
+    return true;
+}
+
+bool frustum_test_aabb(
+    const struct frustum *frustum,
+    const struct aabb *aabb)
+{
+    assert(frustum);
+    assert(aabb);
+
+    if (aabb_is_empty(aabb))
+        return false;
+
+    for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+    {
+        const float *plane = frustum->planes[plane_index];
+
+        // The corner farthest along the plane's normal
+        float corner[3];
+
+        for (int axis = 0; axis < 3; axis++)
+            corner[axis] = plane[axis] >= 0.0f ? aabb->maximum[axis] : aabb->minimum[axis];
+
+        if (frustum_get_plane_distance(plane, corner) < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+int frustum_test_spheres(
+    const struct frustum *frustum,
+    const float *centers_x,
+    const float *centers_y,
+    const float *centers_z,
+    const float *radii,
+    int count,
+    bool *out_visible)
+{
+    assert(frustum);
+    assert(!count || (centers_x && centers_y && centers_z && radii && out_visible));
+
+    frustum_vector plane_vectors[NUMBER_OF_FRUSTUM_PLANES][4];
+
+    for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+    {
+        for (int component = 0; component < 4; component++)
+            plane_vectors[plane_index][component] = frustum_vector_set(frustum->planes[plane_index][component]);
+    }
+
+    int visible_count = 0;
+    int sphere_index = 0;
+
+    for (; sphere_index + FRUSTUM_VECTOR_WIDTH <= count; sphere_index += FRUSTUM_VECTOR_WIDTH)
+    {
+        frustum_vector x = frustum_vector_load(centers_x + sphere_index);
+        frustum_vector y = frustum_vector_load(centers_y + sphere_index);
+        frustum_vector z = frustum_vector_load(centers_z + sphere_index);
+        frustum_vector radius = frustum_vector_load(radii + sphere_index);
+
+        frustum_vector outside = frustum_vector_zero();
+
+        for (int plane_index = 0; plane_index < NUMBER_OF_FRUSTUM_PLANES; plane_index++)
+        {
+            frustum_vector *plane = plane_vectors[plane_index];
+
+            frustum_vector distance = frustum_vector_add(
+                frustum_vector_add(frustum_vector_mul(plane[0], x), frustum_vector_mul(plane[1], y)),
+                frustum_vector_add(frustum_vector_mul(plane[2], z), plane[3]));
+
+            outside = frustum_vector_or(outside, frustum_vector_outside(distance, radius));
+        }
+
+        int outside_mask = frustum_vector_mask(outside);
+
+        for (int lane = 0; lane < FRUSTUM_VECTOR_WIDTH; lane++)
+        {
+            bool visible = !(outside_mask & (1 << lane));
+
+            out_visible[sphere_index + lane] = visible;
+            visible_count += visible;
+        }
+    }
+
+    for (; sphere_index < count; sphere_index++)
+    {
+        struct bounding_sphere sphere =
+        {
+            .center = { centers_x[sphere_index], centers_y[sphere_index], centers_z[sphere_index] },
+            .radius = radii[sphere_index],
+        };
+
+        out_visible[sphere_index] = frustum_test_sphere(frustum, &sphere);
+        visible_count += out_visible[sphere_index];
+    }
+
+    return visible_count;
+}
+
+/* ---------- private code */
+
+static float frustum_get_plane_distance(
+    const float plane[4],
+    const float point[3])
+{
+    return (plane[0] * point[0]) + (plane[1] * point[1]) + (plane[2] * point[2]) + plane[3];
+}
@@ -0,0 +1,66 @@
+/*
+FRUSTUMS.H
+    View frustum declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+
+#include "geometry/bounding_volumes.h"
+
+/* ---------- constants */
+
+enum frustum_plane
+{
+    _frustum_plane_left,
+    _frustum_plane_right,
+    _frustum_plane_bottom,
+    _frustum_plane_top,
+    _frustum_plane_near,
+    _frustum_plane_far,
+    NUMBER_OF_FRUSTUM_PLANES
+};
+
+/* ---------- types */
+
+/**
+ * The planes bounding a view volume. Each plane is a unit normal pointing into the volume followed by its distance,
+ * so a point is inside a plane when dot(normal, point) + distance >= 0.
+ */
+struct frustum
+{
+    float planes[NUMBER_OF_FRUSTUM_PLANES][4];
+};
+
+/* ---------- prototypes/FRUSTUMS.C */
+
+/**
+ * Extracts the planes of the volume a matrix projects into OpenGL clip space.
+ * @param matrix A column-major projection times view matrix, laid out like a cglm mat4.
+ * @param out_frustum The frustum to write.
+ */
+void frustum_from_matrix(struct frustum *out_frustum, const float matrix[4][4]);
+
+bool frustum_test_sphere(const struct frustum *frustum, const struct bounding_sphere *sphere);
+bool frustum_test_aabb(const struct frustum *frustum, const struct aabb *aabb);
+
+/**
+ * Tests spheres in structure-of-arrays form against a frustum, several at a time.
+ * Spheres that straddle a plane count as visible; the test is conservative near the frustum's corners.
+ * @param frustum The frustum to test against.
+ * @param centers_x The x coordinate of each sphere's center.
+ * @param centers_y The y coordinate of each sphere's center.
+ * @param centers_z The z coordinate of each sphere's center.
+ * @param radii The radius of each sphere.
+ * @param count The number of spheres.
+ * @param out_visible Whether each sphere is at least partly inside the frustum.
+ * @returns The number of visible spheres.
+ */
+int frustum_test_spheres(
+    const struct frustum *frustum,
+    const float *centers_x,
+    const float *centers_y,
+    const float *centers_z,
+    const float *radii,
+    int count,
+    bool *out_visible);
@@ -0,0 +1,697 @@
+/*
+JOBS.C
+    Work-stealing job system code.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/common.h"
+#include "jobs/jobs.h"
+#include "memory/heap.h"
+#include "profiler/profiler.h"
+
+/* ---------- private constants */
+
+enum
+{
+    JOB_QUEUE_MASK = JOB_QUEUE_CAPACITY - 1,
+    JOB_WORKER_SPIN_COUNT = 64,
+};
+
+static_assert((JOB_QUEUE_CAPACITY & JOB_QUEUE_MASK) == 0, "JOB_QUEUE_CAPACITY must be a power of two");
+
+/* ---------- private types */
+
+struct job
+{
+    job_function function;
+    job_range_function range_function;
+    void *data;
+    int start_index;
+    int end_index;
+    struct job_counter *counter;
+};
+
+struct job_batch
+{
+    struct job_batch *next;
+    int job_count;
+    struct job jobs[];
+};
+
+/**
+ * A lock-protected double-ended ring of jobs.
+ * The owning thread pushes and pops at the tail so it works on its most recent (cache-hot) jobs first,
+ * while other threads steal the oldest jobs from the head.
+ */
+struct job_queue
+{
+    atomic_flag lock;
+    atomic_uint head;
+    atomic_uint tail;
+    struct job jobs[JOB_QUEUE_CAPACITY];
+};
+
+/* ---------- private variables */
+
+struct
+{
+    bool initialized;
+
+    int worker_count;
+    pthread_t worker_threads[MAXIMUM_NUMBER_OF_JOB_WORKERS];
+
+    // One queue for the main thread followed by one per worker thread
+    struct job_queue *queues;
+    struct job_queue *main_thread_queue;
+
+    atomic_int queued_job_count;
+    atomic_int sleeping_worker_count;
+    atomic_bool shutting_down;
+
+    pthread_mutex_t sleep_mutex;
+    pthread_cond_t sleep_condition;
+} static job_globals;
+
+static _Thread_local int job_thread_index = -1;
+static _Thread_local unsigned int job_thread_random_state;
+
+/* ---------- private prototypes */
+
+static void job_execute(struct job *job);
+static void job_submit_multiple(struct job *jobs, int job_count);
+
+/* ---------- private code */
+
+static inline void job_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static inline void job_spin_lock(
+    atomic_flag *lock)
+{
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire))
+        job_cpu_relax();
+}
+
+static inline void job_spin_unlock(
+    atomic_flag *lock)
+{
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+static inline unsigned int job_random_next(void)
+{
+    // xorshift32
+    unsigned int x = job_thread_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return job_thread_random_state = x;
+}
+
+static inline bool job_queue_is_empty(
+    struct job_queue *queue)
+{
+    return atomic_load_explicit(&queue->head, memory_order_relaxed) == atomic_load_explicit(&queue->tail, memory_order_relaxed);
+}
+
+static bool job_queue_push(
+    struct job_queue *queue,
+    const struct job *job)
+{
+    job_spin_lock(&queue->lock);
+
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (tail - head == JOB_QUEUE_CAPACITY)
+    {
+        job_spin_unlock(&queue->lock);
+        return false;
+    }
+
+    queue->jobs[tail & JOB_QUEUE_MASK] = *job;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_relaxed);
+
+    job_spin_unlock(&queue->lock);
+
+    return true;
+}
+
+static bool job_queue_pop(
+    struct job_queue *queue,
+    struct job *out_job)
+{
+    if (job_queue_is_empty(queue))
+        return false;
+
+    job_spin_lock(&queue->lock);
+
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (tail == head)
+    {
+        job_spin_unlock(&queue->lock);
+        return false;
+    }
+
+    *out_job = queue->jobs[--tail & JOB_QUEUE_MASK];
+    atomic_store_explicit(&queue->tail, tail, memory_order_relaxed);
+
+    job_spin_unlock(&queue->lock);
+
+    return true;
+}
+
+static bool job_queue_steal(
+    struct job_queue *queue,
+    struct job *out_job)
+{
+    if (job_queue_is_empty(queue))
+        return false;
+
+    job_spin_lock(&queue->lock);
+
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (tail == head)
+    {
+        job_spin_unlock(&queue->lock);
+        return false;
+    }
+
+    *out_job = queue->jobs[head & JOB_QUEUE_MASK];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_relaxed);
+
+    job_spin_unlock(&queue->lock);
+
+    return true;
+}
+
+static inline struct job_queue *job_get_thread_queue(void)
+{
+    // Threads outside of the job system share the main thread's queue
+    return job_globals.queues + (job_thread_index > 0 ? job_thread_index : 0);
+}
+
+static bool job_try_get(
+    struct job *out_job)
+{
+    int queue_count = job_globals.worker_count + 1;
+
+    if (job_thread_index >= 0 && job_queue_pop(job_globals.queues + job_thread_index, out_job))
+    {
+        atomic_fetch_sub(&job_globals.queued_job_count, 1);
+        return true;
+    }
+
+    // Start stealing from a random queue so thieves don't all pile onto the same victim
+    int first_queue_index = job_random_next() % queue_count;
+
+    for (int i = 0; i < queue_count; i++)
+    {
+        int queue_index = (first_queue_index + i) % queue_count;
+
+        if (queue_index == job_thread_index)
+            continue;
+
+        if (job_queue_steal(job_globals.queues + queue_index, out_job))
+        {
+            atomic_fetch_sub(&job_globals.queued_job_count, 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void job_wake_workers(
+    int job_count)
+{
+    if (atomic_load(&job_globals.sleeping_worker_count) == 0)
+        return;
+
+    pthread_mutex_lock(&job_globals.sleep_mutex);
+
+    if (job_count == 1)
+        pthread_cond_signal(&job_globals.sleep_condition);
+    else
+        pthread_cond_broadcast(&job_globals.sleep_condition);
+
+    pthread_mutex_unlock(&job_globals.sleep_mutex);
+}
+
+static void job_counter_decrement(
+    struct job_counter *counter)
+{
+    for (;;)
+    {
+        int value = atomic_load(&counter->value);
+        assert(value > 0);
+
+        // Only the decrement that could reach zero needs the lock, so it can release any waiting jobs
+        // before a waiting thread is allowed to return and let the counter go out of scope
+        if (value > 1)
+        {
+            if (atomic_compare_exchange_weak(&counter->value, &value, value - 1))
+                return;
+
+            continue;
+        }
+
+        job_spin_lock(&counter->lock);
+
+        struct job_batch *batches = NULL;
+
+        if (atomic_fetch_sub(&counter->value, 1) == 1)
+        {
+            batches = counter->waiting_batches;
+            counter->waiting_batches = NULL;
+        }
+
+        job_spin_unlock(&counter->lock);
+
+        while (batches)
+        {
+            struct job_batch *batch = batches;
+            batches = batch->next;
+
+            job_submit_multiple(batch->jobs, batch->job_count);
+            free(batch);
+        }
+
+        return;
+    }
+}
+
+static void job_execute(
+    struct job *job)
+{
+    if (job->range_function)
+        job->range_function(job->data, job->start_index, job->end_index);
+    else
+        job->function(job->data);
+
+    if (job->counter)
+        job_counter_decrement(job->counter);
+}
+
+static void job_submit_multiple(
+    struct job *jobs,
+    int job_count)
+{
+    if (!job_globals.initialized)
+    {
+        for (int job_index = 0; job_index < job_count; job_index++)
+            job_execute(jobs + job_index);
+
+        return;
+    }
+
+    struct job_queue *queue = job_get_thread_queue();
+    int queued_job_count = 0;
+
+    for (int job_index = 0; job_index < job_count; job_index++)
+    {
+        if (job_queue_push(queue, jobs + job_index))
+        {
+            atomic_fetch_add(&job_globals.queued_job_count, 1);
+            queued_job_count++;
+        }
+        else
+        {
+            // The queue is full, so run the job right away rather than dropping it
+            job_execute(jobs + job_index);
+        }
+    }
+
+    if (queued_job_count)
+        job_wake_workers(queued_job_count);
+}
+
+static void job_make_from_declarations(
+    struct job *out_jobs,
+    const struct job_declaration *declarations,
+    int declaration_count,
+    struct job_counter *counter)
+{
+    for (int declaration_index = 0; declaration_index < declaration_count; declaration_index++)
+    {
+        const struct job_declaration *declaration = declarations + declaration_index;
+        assert(declaration->function);
+
+        out_jobs[declaration_index] = (struct job)
+        {
+            .function = declaration->function,
+            .data = declaration->data,
+            .counter = counter,
+        };
+    }
+}
+
+static void *job_worker_main(
+    void *parameter)
+{
+    job_thread_index = (int)(intptr_t)parameter;
+    job_thread_random_state = 0x9e3779b9u * (unsigned int)job_thread_index;
+
+    char thread_name[MAXIMUM_PROFILER_THREAD_NAME_LENGTH];
+    snprintf(thread_name, sizeof(thread_name), "job worker %i", job_thread_index);
+    profiler_set_thread_name(thread_name);
+
+    struct job job;
+
+    while (!atomic_load(&job_globals.shutting_down))
+    {
+        bool found_job = false;
+
+        for (int spin_index = 0; spin_index < JOB_WORKER_SPIN_COUNT; spin_index++)
+        {
+            if ((found_job = job_try_get(&job)))
+                break;
+
+            job_cpu_relax();
+        }
+
+        if (found_job)
+        {
+            job_execute(&job);
+            continue;
+        }
+
+        pthread_mutex_lock(&job_globals.sleep_mutex);
+        atomic_fetch_add(&job_globals.sleeping_worker_count, 1);
+
+        while (!atomic_load(&job_globals.shutting_down) && atomic_load(&job_globals.queued_job_count) == 0)
+            pthread_cond_wait(&job_globals.sleep_condition, &job_globals.sleep_mutex);
+
+        atomic_fetch_sub(&job_globals.sleeping_worker_count, 1);
+        pthread_mutex_unlock(&job_globals.sleep_mutex);
+    }
+
+    return NULL;
+}
+
+/* ---------- public code */
+
+void jobs_initialize(
+    int worker_count)
+{
+    assert(!job_globals.initialized);
+    memset(&job_globals, 0, sizeof(job_globals));
+
+    if (worker_count < 0)
+        worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    if (worker_count < 0)
+        worker_count = 0;
+
+    if (worker_count > MAXIMUM_NUMBER_OF_JOB_WORKERS)
+        worker_count = MAXIMUM_NUMBER_OF_JOB_WORKERS;
+
+    job_globals.worker_count = worker_count;
+
+    job_globals.queues = calloc(worker_count + 1, sizeof(*job_globals.queues));
+    assert(job_globals.queues);
+
+    job_globals.main_thread_queue = calloc(1, sizeof(*job_globals.main_thread_queue));
+    assert(job_globals.main_thread_queue);
+
+    pthread_mutex_init(&job_globals.sleep_mutex, NULL);
+    pthread_cond_init(&job_globals.sleep_condition, NULL);
+
+    job_thread_index = 0;
+    job_thread_random_state = 0x9e3779b9u;
+
+    job_globals.initialized = true;
+
+    for (int worker_index = 0; worker_index < worker_count; worker_index++)
+    {
+        int result = pthread_create(&job_globals.worker_threads[worker_index], NULL, job_worker_main, (void *)(intptr_t)(worker_index + 1));
+        assert(result == 0);
+        (void)result;
+    }
+}
+
+void jobs_dispose(void)
+{
+    if (!job_globals.initialized)
+        return;
+
+    assert(jobs_get_thread_index() == 0);
+
+    // Finish anything still queued so no job is silently dropped
+    struct job job;
+
+    while (job_try_get(&job))
+        job_execute(&job);
+
+    jobs_execute_main_thread_jobs();
+
+    pthread_mutex_lock(&job_globals.sleep_mutex);
+    atomic_store(&job_globals.shutting_down, true);
+    pthread_cond_broadcast(&job_globals.sleep_condition);
+    pthread_mutex_unlock(&job_globals.sleep_mutex);
+
+    for (int worker_index = 0; worker_index < job_globals.worker_count; worker_index++)
+        pthread_join(job_globals.worker_threads[worker_index], NULL);
+
+    pthread_cond_destroy(&job_globals.sleep_condition);
+    pthread_mutex_destroy(&job_globals.sleep_mutex);
+
+    free(job_globals.queues);
+    free(job_globals.main_thread_queue);
+
+    memset(&job_globals, 0, sizeof(job_globals));
+    job_thread_index = -1;
+}
+
+int jobs_get_worker_count(void)
+{
+    return job_globals.worker_count;
+}
+
+int jobs_get_thread_index(void)
+{
+    return job_thread_index;
+}
+
+void job_counter_initialize(
+    struct job_counter *counter)
+{
+    assert(counter);
+
+    atomic_init(&counter->value, 0);
+    atomic_flag_clear(&counter->lock);
+    counter->waiting_batches = NULL;
+}
+
+bool job_counter_is_done(
+    struct job_counter *counter)
+{
+    assert(counter);
+    return atomic_load(&counter->value) == 0;
+}
+
+void jobs_run(
+    const struct job_declaration *declarations,
+    int declaration_count,
+    struct job_counter *counter)
+{
+    assert(declarations || !declaration_count);
+
+    if (counter)
+        atomic_fetch_add(&counter->value, declaration_count);
+
+    // Submit in fixed-size chunks to keep the temporary job array on the stack
+    struct job jobs[64];
+
+    for (int start_index = 0; start_index < declaration_count; start_index += NUMBER_OF(jobs))
+    {
+        int job_count = declaration_count - start_index;
+
+        if (job_count > (int)NUMBER_OF(jobs))
+            job_count = NUMBER_OF(jobs);
+
+        job_make_from_declarations(jobs, declarations + start_index, job_count, counter);
+        job_submit_multiple(jobs, job_count);
+    }
+}
+
+void jobs_run_after(
+    struct job_counter *dependency,
+    const struct job_declaration *declarations,
+    int declaration_count,
+    struct job_counter *counter)
+{
+    assert(dependency);
+    assert(declarations || !declaration_count);
+
+    if (!declaration_count)
+        return;
+
+    if (counter)
+        atomic_fetch_add(&counter->value, declaration_count);
+
+    struct job_batch *batch = heap_allocate(sizeof(*batch) + (declaration_count * sizeof(*batch->jobs)));
+    assert(batch);
+
+    batch->next = NULL;
+    batch->job_count = declaration_count;
+    job_make_from_declarations(batch->jobs, declarations, declaration_count, counter);
+
+    job_spin_lock(&dependency->lock);
+
+    if (atomic_load(&dependency->value) != 0)
+    {
+        batch->next = dependency->waiting_batches;
+        dependency->waiting_batches = batch;
+        batch = NULL;
+    }
+
+    job_spin_unlock(&dependency->lock);
+
+    // The dependency had already finished, so the jobs can run right away
+    if (batch)
+    {
+        job_submit_multiple(batch->jobs, batch->job_count);
+        free(batch);
+    }
+}
+
+void jobs_run_range(
+    int count,
+    int batch_size,
+    job_range_function function,
+    void *data,
+    struct job_counter *counter)
+{
+    assert(count >= 0);
+    assert(batch_size > 0);
+    assert(function);
+
+    int job_count = (count + batch_size - 1) / batch_size;
+
+    if (counter)
+        atomic_fetch_add(&counter->value, job_count);
+
+    struct job jobs[64];
+    int pending_job_count = 0;
+
+    for (int start_index = 0; start_index < count; start_index += batch_size)
+    {
+        int end_index = start_index + batch_size;
+
+        if (end_index > count)
+            end_index = count;
+
+        jobs[pending_job_count++] = (struct job)
+        {
+            .range_function = function,
+            .data = data,
+            .start_index = start_index,
+            .end_index = end_index,
+            .counter = counter,
+        };
+
+        if (pending_job_count == (int)NUMBER_OF(jobs))
+        {
+            job_submit_multiple(jobs, pending_job_count);
+            pending_job_count = 0;
+        }
+    }
+
+    if (pending_job_count)
+        job_submit_multiple(jobs, pending_job_count);
+}
+
+void jobs_parallel_for(
+    int count,
+    int batch_size,
+    job_range_function function,
+    void *data)
+{
+    struct job_counter counter;
+    job_counter_initialize(&counter);
+
+    jobs_run_range(count, batch_size, function, data, &counter);
+    jobs_wait(&counter);
+}
+
+void jobs_run_on_main_thread(
+    const struct job_declaration *declarations,
+    int declaration_count,
+    struct job_counter *counter)
+{
+    assert(declarations || !declaration_count);
+
+    if (counter)
+        atomic_fetch_add(&counter->value, declaration_count);
+
+    for (int declaration_index = 0; declaration_index < declaration_count; declaration_index++)
+    {
+        struct job job;
+        job_make_from_declarations(&job, declarations + declaration_index, 1, counter);
+
+        if (!job_globals.initialized || job_thread_index == 0)
+        {
+            job_execute(&job);
+            continue;
+        }
+
+        // Wait for the main thread to make room rather than running GL work on this thread
+        while (!job_queue_push(job_globals.main_thread_queue, &job))
+            job_cpu_relax();
+    }
+}
+
+void jobs_execute_main_thread_jobs(void)
+{
+    if (!job_globals.initialized)
+        return;
+
+    assert(job_thread_index == 0);
+
+    struct job job;
+
+    while (job_queue_steal(job_globals.main_thread_queue, &job))
+        job_execute(&job);
+}
+
+void jobs_wait(
+    struct job_counter *counter)
+{
+    assert(counter);
+
+    struct job job;
+
+    while (atomic_load(&counter->value) > 0)
+    {
+        if (job_thread_index == 0)
+            jobs_execute_main_thread_jobs();
+
+        if (job_globals.initialized && job_try_get(&job))
+            job_execute(&job);
+        else
+            job_cpu_relax();
+    }
+
+    // Make sure the thread that brought the counter to zero has let go of it before the caller can reuse it
+    job_spin_lock(&counter->lock);
+    job_spin_unlock(&counter->lock);
+}
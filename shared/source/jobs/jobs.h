@@ -0,0 +1,128 @@
+/*
+JOBS.H
+    Work-stealing job system declarations.
+*/
+
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/* ---------- constants */
+
+enum
+{
+    MAXIMUM_NUMBER_OF_JOB_WORKERS = 64,
+    JOB_QUEUE_CAPACITY = 4096,
+};
+
+/* ---------- types */
+
+typedef void (*job_function)(void *data);
+typedef void (*job_range_function)(void *data, int start_index, int end_index);
+
+struct job_declaration
+{
+    job_function function;
+    void *data;
+};
+
+/**
+ * Tracks the number of unfinished jobs submitted against it.
+ * Jobs can be deferred until a counter reaches zero by submitting them with jobs_run_after.
+ */
+struct job_counter
+{
+    atomic_int value;
+    atomic_flag lock;
+    struct job_batch *waiting_batches;
+};
+
+/* ---------- prototypes/JOBS.C */
+
+/**
+ * Starts the job system's worker threads. The calling thread becomes the main thread.
+ * @param worker_count The number of worker threads to start, or -1 to start one less than the number of online processors.
+ */
+void jobs_initialize(int worker_count);
+
+/**
+ * Waits for every worker thread to finish its current job and stops them.
+ */
+void jobs_dispose(void);
+
+/**
+ * Gets the number of worker threads, not including the main thread.
+ */
+int jobs_get_worker_count(void);
+
+/**
+ * Gets the index of the calling thread: 0 for the main thread, 1 and up for worker threads, or -1 for any other thread.
+ */
+int jobs_get_thread_index(void);
+
+/**
+ * Initializes a job counter to zero.
+ * @param counter The address of the job counter.
+ */
+void job_counter_initialize(struct job_counter *counter);
+
+/**
+ * Determines whether every job submitted against a job counter has finished.
+ * @param counter The address of the job counter.
+ */
+bool job_counter_is_done(struct job_counter *counter);
+
+/**
+ * Submits jobs to the calling thread's queue, where idle workers can steal them.
+ * @param declarations The address of the jobs to run.
+ * @param declaration_count The number of jobs to run.
+ * @param counter The address of the job counter to track the jobs with, or NULL.
+ */
+void jobs_run(const struct job_declaration *declarations, int declaration_count, struct job_counter *counter);
+
+/**
+ * Submits jobs that will not start until a dependency counter reaches zero.
+ * @param dependency The address of the job counter the jobs depend on.
+ * @param declarations The address of the jobs to run.
+ * @param declaration_count The number of jobs to run.
+ * @param counter The address of the job counter to track the jobs with, or NULL.
+ */
+void jobs_run_after(struct job_counter *dependency, const struct job_declaration *declarations, int declaration_count, struct job_counter *counter);
+
+/**
+ * Splits an index range into batches and submits one job per batch.
+ * @param count The number of indices in the range.
+ * @param batch_size The maximum number of indices in each job.
+ * @param function The function to call for each batch of indices.
+ * @param data The data to pass to each call of the function.
+ * @param counter The address of the job counter to track the jobs with, or NULL.
+ */
+void jobs_run_range(int count, int batch_size, job_range_function function, void *data, struct job_counter *counter);
+
+/**
+ * Runs a function over an index range in parallel and waits for it to finish.
+ * @param count The number of indices in the range.
+ * @param batch_size The maximum number of indices in each job.
+ * @param function The function to call for each batch of indices.
+ * @param data The data to pass to each call of the function.
+ */
+void jobs_parallel_for(int count, int batch_size, job_range_function function, void *data);
+
+/**
+ * Submits jobs that may only run on the main thread, such as those that make GL calls.
+ * @param declarations The address of the jobs to run.
+ * @param declaration_count The number of jobs to run.
+ * @param counter The address of the job counter to track the jobs with, or NULL.
+ */
+void jobs_run_on_main_thread(const struct job_declaration *declarations, int declaration_count, struct job_counter *counter);
+
+/**
+ * Runs every job currently in the main thread queue. Must be called from the main thread.
+ */
+void jobs_execute_main_thread_jobs(void);
+
+/**
+ * Executes queued jobs on the calling thread until every job submitted against a job counter has finished.
+ * @param counter The address of the job counter.
+ */
+void jobs_wait(struct job_counter *counter);
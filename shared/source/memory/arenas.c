@@ -0,0 +1,234 @@
+/*
+ARENAS.C
+    Linear arena allocator code.
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory/arenas.h"
+#include "memory/heap.h"
+
+/* ---------- private variables */
+
+static struct memory_arena frame_arena;
+
+/* ---------- private code */
+
+static inline size_t memory_align_up(
+    size_t value,
+    size_t alignment)
+{
+    assert(alignment && (alignment & (alignment - 1)) == 0);
+    return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+static void memory_arena_free_overflow_blocks(
+    struct memory_arena *arena)
+{
+    while (arena->overflow_blocks)
+    {
+        struct memory_arena_block *block = arena->overflow_blocks;
+        arena->overflow_blocks = block->next;
+        free(block);
+    }
+}
+
+static void *memory_arena_allocate_overflow(
+    struct memory_arena *arena,
+    size_t size,
+    size_t alignment)
+{
+    size_t header_size = memory_align_up(sizeof(struct memory_arena_block), alignment);
+
+    struct memory_arena_block *block = heap_allocate(header_size + size);
+    assert(block);
+
+    block->next = arena->overflow_blocks;
+    block->size = size;
+    arena->overflow_blocks = block;
+
+    arena->overflow_used += memory_align_up(size, alignment);
+    arena->heap_allocation_count++;
+
+    return (char *)block + header_size;
+}
+
+/* ---------- public code */
+
+void memory_arena_initialize(
+    struct memory_arena *arena,
+    size_t size)
+{
+    assert(arena);
+    memset(arena, 0, sizeof(*arena));
+
+    arena->size = size;
+    arena->base = heap_allocate(size);
+    assert(arena->base);
+}
+
+void memory_arena_dispose(
+    struct memory_arena *arena)
+{
+    assert(arena);
+
+    memory_arena_free_overflow_blocks(arena);
+    free(arena->base);
+
+    memset(arena, 0, sizeof(*arena));
+}
+
+void memory_arena_reset(
+    struct memory_arena *arena)
+{
+    assert(arena);
+
+    size_t total_used = arena->used + arena->overflow_used;
+
+    if (total_used > arena->peak_used)
+        arena->peak_used = total_used;
+
+    memory_arena_free_overflow_blocks(arena);
+
+    // Grow the backing block to fit the previous high-water mark so it doesn't overflow again
+    if (arena->peak_used > arena->size)
+    {
+        size_t size = arena->size ? arena->size : DEFAULT_MEMORY_ARENA_ALIGNMENT;
+
+        while (size < arena->peak_used)
+            size *= 2;
+
+        free(arena->base);
+        arena->base = heap_allocate(size);
+        assert(arena->base);
+
+        arena->size = size;
+    }
+
+    arena->used = 0;
+    arena->overflow_used = 0;
+    arena->heap_allocation_count = 0;
+}
+
+void *memory_arena_allocate(
+    struct memory_arena *arena,
+    size_t size,
+    size_t alignment)
+{
+    assert(arena);
+
+    uintptr_t base_address = (uintptr_t)arena->base;
+    size_t offset = memory_align_up(base_address + arena->used, alignment) - base_address;
+
+    if (!arena->base || offset + size > arena->size)
+        return memory_arena_allocate_overflow(arena, size, alignment);
+
+    arena->used = offset + size;
+
+    return arena->base + offset;
+}
+
+char *memory_arena_format(
+    struct memory_arena *arena,
+    const char *fmt,
+    ...)
+{
+    va_list va;
+    va_start(va, fmt);
+
+    char *result = memory_arena_vformat(arena, fmt, va);
+
+    va_end(va);
+
+    return result;
+}
+
+char *memory_arena_vformat(
+    struct memory_arena *arena,
+    const char *fmt,
+    va_list va)
+{
+    assert(arena);
+    assert(fmt);
+
+    // Format straight into the free space of the arena, only retrying when it doesn't fit
+    size_t available_size = arena->base ? arena->size - arena->used : 0;
+
+    va_list va_copied;
+    va_copy(va_copied, va);
+    int length = vsnprintf(available_size ? arena->base + arena->used : NULL, available_size, fmt, va_copied);
+    va_end(va_copied);
+
+    assert(length >= 0);
+
+    if ((size_t)length < available_size)
+    {
+        char *result = arena->base + arena->used;
+        arena->used += length + 1;
+        return result;
+    }
+
+    char *result = memory_arena_allocate(arena, length + 1, 1);
+    vsnprintf(result, length + 1, fmt, va);
+
+    return result;
+}
+
+int memory_arena_get_heap_allocation_count(
+    struct memory_arena *arena)
+{
+    assert(arena);
+    return arena->heap_allocation_count;
+}
+
+void frame_arena_initialize(
+    size_t size)
+{
+    memory_arena_initialize(&frame_arena, size);
+}
+
+void frame_arena_dispose(void)
+{
+    memory_arena_dispose(&frame_arena);
+}
+
+void frame_arena_reset(void)
+{
+    memory_arena_reset(&frame_arena);
+}
+
+struct memory_arena *frame_arena_get(void)
+{
+    return &frame_arena;
+}
+
+void *frame_arena_allocate(
+    size_t size)
+{
+    return memory_arena_allocate(&frame_arena, size, DEFAULT_MEMORY_ARENA_ALIGNMENT);
+}
+
+char *frame_arena_format(
+    const char *fmt,
+    ...)
+{
+    va_list va;
+    va_start(va, fmt);
+
+    char *result = memory_arena_vformat(&frame_arena, fmt, va);
+
+    va_end(va);
+
+    return result;
+}
+
+char *frame_arena_vformat(
+    const char *fmt,
+    va_list va)
+{
+    return memory_arena_vformat(&frame_arena, fmt, va);
+}
@@ -0,0 +1,105 @@
+/*
+ARENAS.H
+    Linear arena allocator declarations.
+*/
+
+#pragma once
+#include <stdarg.h>
+#include <stddef.h>
+
+/* ---------- constants */
+
+enum
+{
+    DEFAULT_MEMORY_ARENA_ALIGNMENT = 16,
+    DEFAULT_FRAME_ARENA_SIZE = 1024 * 1024,
+};
+
+/* ---------- types */
+
+struct memory_arena_block
+{
+    struct memory_arena_block *next;
+    size_t size;
+};
+
+struct memory_arena
+{
+    size_t size;
+    size_t used;
+    size_t overflow_used;
+    size_t peak_used;
+    char *base;
+
+    struct memory_arena_block *overflow_blocks;
+
+    int heap_allocation_count;
+};
+
+/* ---------- prototypes/ARENAS.C */
+
+/**
+ * Initializes a linear arena backed by a single heap block of the supplied size.
+ * @param arena The address of the arena.
+ * @param size The size in bytes of the arena's backing block.
+ */
+void memory_arena_initialize(struct memory_arena *arena, size_t size);
+
+/**
+ * Frees all memory owned by an arena.
+ * @param arena The address of the arena.
+ */
+void memory_arena_dispose(struct memory_arena *arena);
+
+/**
+ * Releases every allocation made from an arena at once.
+ * If the previous allocations overflowed the backing block, the backing block is grown to fit them so later resets stay within it.
+ * @param arena The address of the arena.
+ */
+void memory_arena_reset(struct memory_arena *arena);
+
+/**
+ * Allocates memory from an arena by bumping its offset, falling back to a counted heap block when the arena is full.
+ * @param arena The address of the arena.
+ * @param size The size in bytes of the allocation.
+ * @param alignment The alignment in bytes of the allocation, which must be a power of two.
+ * @returns The address of the allocation, which stays valid until the arena is reset.
+ */
+void *memory_arena_allocate(struct memory_arena *arena, size_t size, size_t alignment);
+
+/**
+ * Formats a string into memory allocated from an arena.
+ * @returns The address of the formatted string, which stays valid until the arena is reset.
+ */
+char *memory_arena_format(struct memory_arena *arena, const char *fmt, ...);
+char *memory_arena_vformat(struct memory_arena *arena, const char *fmt, va_list va);
+
+/**
+ * Gets the number of heap allocations an arena has made since it was last reset.
+ */
+int memory_arena_get_heap_allocation_count(struct memory_arena *arena);
+
+/**
+ * Initializes the per-frame scratch arena.
+ * @param size The size in bytes of the per-frame scratch arena.
+ */
+void frame_arena_initialize(size_t size);
+void frame_arena_dispose(void);
+
+/**
+ * Releases every per-frame scratch allocation. Called once at the start of every frame.
+ */
+void frame_arena_reset(void);
+
+struct memory_arena *frame_arena_get(void);
+
+/**
+ * Allocates per-frame scratch memory that stays valid until the next call to frame_arena_reset.
+ */
+void *frame_arena_allocate(size_t size);
+
+/**
+ * Formats a per-frame scratch string that stays valid until the next call to frame_arena_reset.
+ */
+char *frame_arena_format(const char *fmt, ...);
+char *frame_arena_vformat(const char *fmt, va_list va);
@@ -0,0 +1,142 @@
+/*
+DYNAMIC_ARRAYS.C
+    Amortized-growth dynamic array code.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory/dynamic_arrays.h"
+#include "memory/heap.h"
+
+/* ---------- private constants */
+
+enum
+{
+    MINIMUM_DYNAMIC_ARRAY_CAPACITY = 8,
+};
+
+/* ---------- private prototypes */
+
+static void dynamic_array_set_capacity(
+    struct dynamic_array *array,
+    size_t element_size,
+    int capacity);
+
+/* ---------- public code */
+
+void dynamic_array_reserve_generic(
+    struct dynamic_array *array,
+    size_t element_size,
+    int minimum_capacity)
+{
+    assert(array);
+    assert(element_size);
+    assert(minimum_capacity >= 0);
+
+    if (minimum_capacity > array->capacity)
+        dynamic_array_set_capacity(array, element_size, minimum_capacity);
+}
+
+void *dynamic_array_push_generic(
+    struct dynamic_array *array,
+    size_t element_size,
+    const void *element)
+{
+    return dynamic_array_push_multiple_generic(array, element_size, element, 1);
+}
+
+void *dynamic_array_push_multiple_generic(
+    struct dynamic_array *array,
+    size_t element_size,
+    const void *elements,
+    int element_count)
+{
+    assert(array);
+    assert(element_size);
+    assert(element_count >= 0);
+
+    int required_capacity = array->count + element_count;
+    assert(required_capacity >= array->count);
+
+    if (required_capacity > array->capacity)
+    {
+        int capacity = array->capacity ? array->capacity : MINIMUM_DYNAMIC_ARRAY_CAPACITY;
+
+        while (capacity < required_capacity)
+            capacity *= 2;
+
+        dynamic_array_set_capacity(array, element_size, capacity);
+    }
+
+    char *result = (char *)array->elements + (array->count * element_size);
+
+    if (elements)
+        memcpy(result, elements, element_count * element_size);
+    else
+        memset(result, 0, element_count * element_size);
+
+    array->count += element_count;
+
+    return result;
+}
+
+void dynamic_array_shrink_to_fit_generic(
+    struct dynamic_array *array,
+    size_t element_size)
+{
+    assert(array);
+
+    if (array->capacity == array->count)
+        return;
+
+    if (array->count == 0)
+    {
+        dynamic_array_dispose_generic(array);
+        return;
+    }
+
+    dynamic_array_set_capacity(array, element_size, array->count);
+}
+
+void dynamic_array_release_generic(
+    struct dynamic_array *array,
+    size_t element_size,
+    int *out_count,
+    void **out_elements)
+{
+    assert(out_count);
+    assert(out_elements);
+
+    dynamic_array_shrink_to_fit_generic(array, element_size);
+
+    *out_count = array->count;
+    *out_elements = array->elements;
+
+    memset(array, 0, sizeof(*array));
+}
+
+void dynamic_array_dispose_generic(
+    struct dynamic_array *array)
+{
+    assert(array);
+
+    free(array->elements);
+    memset(array, 0, sizeof(*array));
+}
+
+/* ---------- private code */
+
+static void dynamic_array_set_capacity(
+    struct dynamic_array *array,
+    size_t element_size,
+    int capacity)
+{
+    assert(capacity >= array->count);
+
+    array->elements = heap_reallocate(array->elements, capacity * element_size);
+    assert(array->elements);
+
+    array->capacity = capacity;
+}
@@ -0,0 +1,98 @@
+/*
+DYNAMIC_ARRAYS.H
+    Amortized-growth dynamic array declarations.
+*/
+
+#pragma once
+#include <stddef.h>
+
+/* ---------- macros */
+
+/**
+ * Declares an anonymous dynamic array structure holding elements of the supplied type.
+ * The layout of every DYNAMIC_ARRAY(type) matches struct dynamic_array, so the generic functions below can operate on it.
+ */
+#define DYNAMIC_ARRAY(type) struct { int count; int capacity; type *elements; }
+
+#define DYNAMIC_ARRAY_ELEMENT_SIZE(array) sizeof(*(array)->elements)
+
+#define dynamic_array_reserve(array, minimum_capacity) \
+    dynamic_array_reserve_generic((struct dynamic_array *)(array), DYNAMIC_ARRAY_ELEMENT_SIZE(array), (minimum_capacity))
+
+#define dynamic_array_push(array, element) \
+    ((typeof((array)->elements))dynamic_array_push_generic((struct dynamic_array *)(array), DYNAMIC_ARRAY_ELEMENT_SIZE(array), (1 ? (element) : (array)->elements)))
+
+#define dynamic_array_push_multiple(array, source, element_count) \
+    ((typeof((array)->elements))dynamic_array_push_multiple_generic((struct dynamic_array *)(array), DYNAMIC_ARRAY_ELEMENT_SIZE(array), (1 ? (source) : (array)->elements), (element_count)))
+
+#define dynamic_array_shrink_to_fit(array) \
+    dynamic_array_shrink_to_fit_generic((struct dynamic_array *)(array), DYNAMIC_ARRAY_ELEMENT_SIZE(array))
+
+#define dynamic_array_release(array, out_count, out_elements) \
+    dynamic_array_release_generic((struct dynamic_array *)(array), DYNAMIC_ARRAY_ELEMENT_SIZE(array), (out_count), (void **)(typeof((array)->elements) *)(out_elements))
+
+#define dynamic_array_clear(array) \
+    ((array)->count = 0)
+
+#define dynamic_array_dispose(array) \
+    dynamic_array_dispose_generic((struct dynamic_array *)(array))
+
+/* ---------- types */
+
+struct dynamic_array
+{
+    int count;
+    int capacity;
+    void *elements;
+};
+
+/* ---------- prototypes/DYNAMIC_ARRAYS.C */
+
+/**
+ * Ensures the supplied dynamic array can hold at least the supplied number of elements without reallocating.
+ * @param array The address of the dynamic array.
+ * @param element_size The size of the elements in the dynamic array.
+ * @param minimum_capacity The minimum number of elements the dynamic array should be able to hold.
+ */
+void dynamic_array_reserve_generic(struct dynamic_array *array, size_t element_size, int minimum_capacity);
+
+/**
+ * Pushes an element to the end of a dynamic array, growing its capacity geometrically when full.
+ * @param array The address of the dynamic array.
+ * @param element_size The size of the elements in the dynamic array.
+ * @param element The address of the element to push, or NULL to push a zero-filled element.
+ * @returns The address of the newly-pushed element inside of the dynamic array.
+ */
+void *dynamic_array_push_generic(struct dynamic_array *array, size_t element_size, const void *element);
+
+/**
+ * Pushes multiple contiguous elements to the end of a dynamic array.
+ * @param array The address of the dynamic array.
+ * @param element_size The size of the elements in the dynamic array.
+ * @param elements The address of the elements to push, or NULL to push zero-filled elements.
+ * @param element_count The number of elements to push.
+ * @returns The address of the first newly-pushed element inside of the dynamic array.
+ */
+void *dynamic_array_push_multiple_generic(struct dynamic_array *array, size_t element_size, const void *elements, int element_count);
+
+/**
+ * Reallocates the storage of a dynamic array so its capacity matches its count.
+ * @param array The address of the dynamic array.
+ * @param element_size The size of the elements in the dynamic array.
+ */
+void dynamic_array_shrink_to_fit_generic(struct dynamic_array *array, size_t element_size);
+
+/**
+ * Shrinks a dynamic array to fit and transfers ownership of its elements to a count/address pair, leaving the dynamic array empty.
+ * @param array The address of the dynamic array.
+ * @param element_size The size of the elements in the dynamic array.
+ * @param out_count The address to store the element count at.
+ * @param out_elements The address to store the elements address at.
+ */
+void dynamic_array_release_generic(struct dynamic_array *array, size_t element_size, int *out_count, void **out_elements);
+
+/**
+ * Frees the storage of a dynamic array and resets it to an empty state.
+ * @param array The address of the dynamic array.
+ */
+void dynamic_array_dispose_generic(struct dynamic_array *array);
@@ -0,0 +1,176 @@
+/*
+HANDLE_POOLS.C
+    Generational handle pool code.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "memory/handle_pools.h"
+#include "memory/heap.h"
+
+/* ---------- private code */
+
+static inline void *handle_pool_get_slot(
+    struct handle_pool *pool,
+    int index)
+{
+    char *block = pool->blocks.elements[index / pool->block_size];
+    return block + ((index % pool->block_size) * pool->element_size);
+}
+
+static int handle_pool_add_slot(
+    struct handle_pool *pool)
+{
+    assert(pool->slot_count < MAXIMUM_NUMBER_OF_HANDLE_POOL_SLOTS);
+
+    int index = pool->slot_count++;
+
+    if (index / pool->block_size >= pool->blocks.count)
+    {
+        void *block = heap_allocate(pool->block_size * pool->element_size);
+        assert(block);
+
+        dynamic_array_push(&pool->blocks, &block);
+    }
+
+    dynamic_array_push(&pool->generations, NULL);
+
+    int word_count = BIT_VECTOR_LENGTH_IN_WORDS(pool->slot_count);
+
+    if (pool->slots_in_use.count < word_count)
+        dynamic_array_push_multiple(&pool->slots_in_use, NULL, word_count - pool->slots_in_use.count);
+
+    return index;
+}
+
+/* ---------- public code */
+
+void handle_pool_initialize(
+    struct handle_pool *pool,
+    size_t element_size,
+    int block_size)
+{
+    assert(pool);
+    assert(element_size);
+    assert(block_size > 0);
+
+    memset(pool, 0, sizeof(*pool));
+
+    pool->element_size = element_size;
+    pool->block_size = block_size;
+}
+
+void handle_pool_dispose(
+    struct handle_pool *pool)
+{
+    assert(pool);
+
+    for (int block_index = 0; block_index < pool->blocks.count; block_index++)
+        free(pool->blocks.elements[block_index]);
+
+    dynamic_array_dispose(&pool->blocks);
+    dynamic_array_dispose(&pool->generations);
+    dynamic_array_dispose(&pool->slots_in_use);
+    dynamic_array_dispose(&pool->free_slots);
+
+    pool->count = 0;
+    pool->slot_count = 0;
+}
+
+int handle_pool_allocate(
+    struct handle_pool *pool)
+{
+    assert(pool);
+
+    int index;
+
+    if (pool->free_slots.count)
+        index = pool->free_slots.elements[--pool->free_slots.count];
+    else
+        index = handle_pool_add_slot(pool);
+
+    assert(!BIT_VECTOR_TEST_BIT(pool->slots_in_use.elements, index));
+    BIT_VECTOR_SET_BIT(pool->slots_in_use.elements, index, true);
+
+    memset(handle_pool_get_slot(pool, index), 0, pool->element_size);
+
+    pool->count++;
+
+    return HANDLE_NEW(index, pool->generations.elements[index]);
+}
+
+void handle_pool_free(
+    struct handle_pool *pool,
+    int handle)
+{
+    assert(handle_pool_is_valid(pool, handle));
+
+    int index = HANDLE_INDEX(handle);
+
+    // Bump the generation so any handles still referring to this slot are detected as stale
+    pool->generations.elements[index] = (pool->generations.elements[index] + 1) & HANDLE_GENERATION_MASK;
+    BIT_VECTOR_SET_BIT(pool->slots_in_use.elements, index, false);
+
+    dynamic_array_push(&pool->free_slots, &index);
+
+    pool->count--;
+}
+
+bool handle_pool_is_valid(
+    struct handle_pool *pool,
+    int handle)
+{
+    assert(pool);
+
+    if (handle < 0)
+        return false;
+
+    int index = HANDLE_INDEX(handle);
+
+    return index < pool->slot_count
+        && BIT_VECTOR_TEST_BIT(pool->slots_in_use.elements, index)
+        && pool->generations.elements[index] == HANDLE_GENERATION(handle);
+}
+
+void *handle_pool_get(
+    struct handle_pool *pool,
+    int handle)
+{
+    if (!handle_pool_is_valid(pool, handle))
+        return NULL;
+
+    return handle_pool_get_slot(pool, HANDLE_INDEX(handle));
+}
+
+int handle_pool_iterate(
+    struct handle_pool *pool,
+    int handle)
+{
+    assert(pool);
+
+    int index = handle == -1 ? 0 : HANDLE_INDEX(handle) + 1;
+
+    while (index < pool->slot_count)
+    {
+        // Mask off the bits below the current index and skip over empty words
+        unsigned int word = pool->slots_in_use.elements[BIT_VECTOR_WORD_INDEX(index)] >> BIT_VECTOR_WORD_BIT_INDEX(index);
+
+        if (!word)
+        {
+            index = (BIT_VECTOR_WORD_INDEX(index) + 1) * WORD_BIT;
+            continue;
+        }
+
+        index += __builtin_ctz(word);
+
+        if (index >= pool->slot_count)
+            break;
+
+        return HANDLE_NEW(index, pool->generations.elements[index]);
+    }
+
+    return -1;
+}
@@ -0,0 +1,108 @@
+/*
+HANDLE_POOLS.H
+    Generational handle pool declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "memory/dynamic_arrays.h"
+
+/* ---------- constants */
+
+enum
+{
+    HANDLE_INDEX_BITS = 20,
+    HANDLE_GENERATION_BITS = 11,
+
+    MAXIMUM_NUMBER_OF_HANDLE_POOL_SLOTS = 1 << HANDLE_INDEX_BITS,
+    HANDLE_INDEX_MASK = MAXIMUM_NUMBER_OF_HANDLE_POOL_SLOTS - 1,
+    HANDLE_GENERATION_MASK = (1 << HANDLE_GENERATION_BITS) - 1,
+
+    DEFAULT_HANDLE_POOL_BLOCK_SIZE = 64,
+};
+
+/* ---------- macros */
+
+/**
+ * Handles pack a slot index into their low bits and the slot's generation above it.
+ * Handles are never negative, so -1 stays available as the "no handle" value.
+ */
+#define HANDLE_NEW(index, generation) ((int)((((unsigned int)(generation) & HANDLE_GENERATION_MASK) << HANDLE_INDEX_BITS) | ((unsigned int)(index) & HANDLE_INDEX_MASK)))
+#define HANDLE_INDEX(handle) ((int)((unsigned int)(handle) & HANDLE_INDEX_MASK))
+#define HANDLE_GENERATION(handle) ((int)(((unsigned int)(handle) >> HANDLE_INDEX_BITS) & HANDLE_GENERATION_MASK))
+
+/* ---------- types */
+
+/**
+ * Pooled storage addressed by generational handles.
+ * Elements live in fixed-size blocks that are never moved, so element addresses stay valid until the element is freed.
+ */
+struct handle_pool
+{
+    size_t element_size;
+    int block_size;
+
+    int count;
+    int slot_count;
+
+    DYNAMIC_ARRAY(void *) blocks;
+    DYNAMIC_ARRAY(unsigned short) generations;
+    DYNAMIC_ARRAY(unsigned int) slots_in_use;
+    DYNAMIC_ARRAY(int) free_slots;
+};
+
+/* ---------- prototypes/HANDLE_POOLS.C */
+
+/**
+ * Initializes an empty handle pool.
+ * @param pool The address of the handle pool.
+ * @param element_size The size of the elements in the handle pool.
+ * @param block_size The number of elements in each storage block of the handle pool.
+ */
+void handle_pool_initialize(struct handle_pool *pool, size_t element_size, int block_size);
+
+/**
+ * Frees all storage owned by a handle pool, invalidating every handle it has handed out.
+ * @param pool The address of the handle pool.
+ */
+void handle_pool_dispose(struct handle_pool *pool);
+
+/**
+ * Allocates a zero-filled element from a handle pool, reusing the most recently freed slot when one is available.
+ * @param pool The address of the handle pool.
+ * @returns The handle of the newly-allocated element.
+ */
+int handle_pool_allocate(struct handle_pool *pool);
+
+/**
+ * Returns an element to a handle pool. Every existing handle to the element becomes stale.
+ * @param pool The address of the handle pool.
+ * @param handle The handle of the element to free.
+ */
+void handle_pool_free(struct handle_pool *pool, int handle);
+
+/**
+ * Determines whether a handle refers to a live element of a handle pool.
+ * @param pool The address of the handle pool.
+ * @param handle The handle to test.
+ * @returns true if the handle is live, or false if it is -1, out of range or stale.
+ */
+bool handle_pool_is_valid(struct handle_pool *pool, int handle);
+
+/**
+ * Gets the address of the element referred to by a handle.
+ * @param pool The address of the handle pool.
+ * @param handle The handle of the element.
+ * @returns The address of the element, or NULL if the handle is not valid.
+ */
+void *handle_pool_get(struct handle_pool *pool, int handle);
+
+/**
+ * Finds the next live element of a handle pool in slot order.
+ * @param pool The address of the handle pool.
+ * @param handle The handle returned by the previous call, or -1 to start from the first slot.
+ * @returns The handle of the next live element, or -1 if there are none left.
+ */
+int handle_pool_iterate(struct handle_pool *pool, int handle);
@@ -0,0 +1,147 @@
+/*
+HASH_MAPS.C
+    Open-addressing hash map code.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory/hash_maps.h"
+#include "memory/heap.h"
+
+/* ---------- private constants */
+
+enum
+{
+    MINIMUM_HASH_MAP_CAPACITY = 16,
+};
+
+/* ---------- private code */
+
+static inline unsigned int hash_map_hash_key(
+    unsigned int key)
+{
+    // Keys are often small sequential ids, so mix the bits before masking
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
+
+    return key;
+}
+
+static struct hash_map_entry *hash_map_probe(
+    const struct hash_map *map,
+    unsigned int key)
+{
+    unsigned int mask = map->capacity - 1;
+    unsigned int entry_index = hash_map_hash_key(key) & mask;
+
+    for (;;)
+    {
+        struct hash_map_entry *entry = map->entries + entry_index;
+
+        if (entry->key == key || entry->key == 0)
+            return entry;
+
+        entry_index = (entry_index + 1) & mask;
+    }
+}
+
+static void hash_map_set_capacity(
+    struct hash_map *map,
+    int capacity)
+{
+    struct hash_map old_map = *map;
+
+    map->capacity = capacity;
+    map->entries = heap_allocate_zeroed(capacity, sizeof(*map->entries));
+    assert(map->entries);
+
+    for (int entry_index = 0; entry_index < old_map.capacity; entry_index++)
+    {
+        struct hash_map_entry *old_entry = old_map.entries + entry_index;
+
+        if (old_entry->key)
+            *hash_map_probe(map, old_entry->key) = *old_entry;
+    }
+
+    free(old_map.entries);
+}
+
+/* ---------- public code */
+
+void hash_map_reserve(
+    struct hash_map *map,
+    int minimum_count)
+{
+    assert(map);
+    assert(minimum_count >= 0);
+
+    // Keep the load factor at or below one half
+    int capacity = map->capacity ? map->capacity : MINIMUM_HASH_MAP_CAPACITY;
+
+    while (capacity < minimum_count * 2)
+        capacity *= 2;
+
+    if (capacity > map->capacity)
+        hash_map_set_capacity(map, capacity);
+}
+
+int hash_map_insert(
+    struct hash_map *map,
+    unsigned int key,
+    int value)
+{
+    assert(map);
+    assert(key);
+
+    hash_map_reserve(map, map->count + 1);
+
+    struct hash_map_entry *entry = hash_map_probe(map, key);
+
+    if (entry->key)
+        return entry->value;
+
+    entry->key = key;
+    entry->value = value;
+    map->count++;
+
+    return value;
+}
+
+int hash_map_find(
+    const struct hash_map *map,
+    unsigned int key)
+{
+    assert(map);
+
+    if (!key || !map->count)
+        return -1;
+
+    struct hash_map_entry *entry = hash_map_probe(map, key);
+
+    return entry->key ? entry->value : -1;
+}
+
+void hash_map_clear(
+    struct hash_map *map)
+{
+    assert(map);
+
+    if (map->entries)
+        memset(map->entries, 0, map->capacity * sizeof(*map->entries));
+
+    map->count = 0;
+}
+
+void hash_map_dispose(
+    struct hash_map *map)
+{
+    assert(map);
+
+    free(map->entries);
+    memset(map, 0, sizeof(*map));
+}
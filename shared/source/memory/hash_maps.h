@@ -0,0 +1,64 @@
+/*
+HASH_MAPS.H
+    Open-addressing hash map declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+
+/* ---------- types */
+
+struct hash_map_entry
+{
+    unsigned int key;
+    int value;
+};
+
+/**
+ * A linear-probing hash map from non-zero integer keys to integer values.
+ * A key of zero marks an empty entry.
+ */
+struct hash_map
+{
+    int count;
+    int capacity;
+    struct hash_map_entry *entries;
+};
+
+/* ---------- prototypes/HASH_MAPS.C */
+
+/**
+ * Ensures a hash map can hold at least the supplied number of entries without rehashing.
+ * @param map The address of the hash map.
+ * @param minimum_count The minimum number of entries the hash map should be able to hold.
+ */
+void hash_map_reserve(struct hash_map *map, int minimum_count);
+
+/**
+ * Inserts a key into a hash map if it is not already present.
+ * @param map The address of the hash map.
+ * @param key The non-zero key to insert.
+ * @param value The value to associate with the key.
+ * @returns The value associated with the key, which is the existing value if the key was already present.
+ */
+int hash_map_insert(struct hash_map *map, unsigned int key, int value);
+
+/**
+ * Finds the value associated with a key in a hash map.
+ * @param map The address of the hash map.
+ * @param key The key to find.
+ * @returns The value associated with the key, or -1 if the key is not present.
+ */
+int hash_map_find(const struct hash_map *map, unsigned int key);
+
+/**
+ * Removes every entry from a hash map without freeing its storage.
+ * @param map The address of the hash map.
+ */
+void hash_map_clear(struct hash_map *map);
+
+/**
+ * Frees the storage of a hash map and resets it to an empty state.
+ * @param map The address of the hash map.
+ */
+void hash_map_dispose(struct hash_map *map);
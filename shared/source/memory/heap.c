@@ -0,0 +1,43 @@
+/*
+HEAP.C
+    Counted heap allocation code.
+*/
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "memory/heap.h"
+
+/* ---------- private variables */
+
+static atomic_uint heap_allocation_count;
+
+/* ---------- public code */
+
+void *heap_allocate(
+    size_t size)
+{
+    atomic_fetch_add_explicit(&heap_allocation_count, 1, memory_order_relaxed);
+    return malloc(size);
+}
+
+void *heap_allocate_zeroed(
+    size_t count,
+    size_t size)
+{
+    atomic_fetch_add_explicit(&heap_allocation_count, 1, memory_order_relaxed);
+    return calloc(count, size);
+}
+
+void *heap_reallocate(
+    void *address,
+    size_t size)
+{
+    atomic_fetch_add_explicit(&heap_allocation_count, 1, memory_order_relaxed);
+    return realloc(address, size);
+}
+
+unsigned int heap_get_allocation_count(void)
+{
+    return atomic_load_explicit(&heap_allocation_count, memory_order_relaxed);
+}
@@ -0,0 +1,23 @@
+/*
+HEAP.H
+    Counted heap allocation declarations.
+*/
+
+#pragma once
+#include <stddef.h>
+
+/* ---------- prototypes/HEAP.C */
+
+/**
+ * Wraps malloc, calloc and realloc, counting every call. Code that can run during a frame allocates through these,
+ * so the shell can show that a steady-state frame makes no heap allocations. Memory they return is released with free.
+ */
+void *heap_allocate(size_t size);
+void *heap_allocate_zeroed(size_t count, size_t size);
+void *heap_reallocate(void *address, size_t size);
+
+/**
+ * Gets the number of counted heap allocations made since startup, on every thread.
+ * The count wraps around, so only the difference between two calls is meaningful.
+ */
+unsigned int heap_get_allocation_count(void);
@@ -0,0 +1,358 @@
+/*
+PROFILER.C
+    Scoped CPU profiler code.
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "profiler/profiler.h"
+#include "memory/heap.h"
+
+/* ---------- private constants */
+
+enum
+{
+    PROFILER_THREAD_EVENT_MASK = PROFILER_THREAD_EVENT_CAPACITY - 1,
+    PROFILER_FRAME_ZONE_TABLE_SIZE = MAXIMUM_NUMBER_OF_PROFILER_FRAME_ZONES * 2,
+};
+
+static_assert((PROFILER_THREAD_EVENT_CAPACITY & PROFILER_THREAD_EVENT_MASK) == 0, "PROFILER_THREAD_EVENT_CAPACITY must be a power of two");
+
+/* ---------- private types */
+
+struct profiler_event
+{
+    const char *name;
+    uint64_t start_time;
+    uint64_t end_time;
+};
+
+/**
+ * A single-writer ring of completed zones. Only the owning thread writes events;
+ * readers snapshot the write count and read back at most one ring's worth of events.
+ */
+struct profiler_thread_buffer
+{
+    int thread_index;
+    char name[MAXIMUM_PROFILER_THREAD_NAME_LENGTH];
+
+    _Atomic uint64_t event_count;
+    uint64_t aggregated_event_count;
+
+    struct profiler_event events[PROFILER_THREAD_EVENT_CAPACITY];
+};
+
+/* ---------- private variables */
+
+struct
+{
+    atomic_bool disabled;
+
+    pthread_mutex_t thread_mutex;
+    atomic_int thread_count;
+    struct profiler_thread_buffer *threads[MAXIMUM_NUMBER_OF_PROFILER_THREADS];
+
+    int frame_zone_count;
+    struct profiler_frame_zone frame_zones[MAXIMUM_NUMBER_OF_PROFILER_FRAME_ZONES];
+    short frame_zone_table[PROFILER_FRAME_ZONE_TABLE_SIZE];
+
+    int last_frame_zone_count;
+    struct profiler_frame_zone last_frame_zones[MAXIMUM_NUMBER_OF_PROFILER_FRAME_ZONES];
+} static profiler_globals =
+{
+    .thread_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static _Thread_local struct profiler_thread_buffer *profiler_thread_buffer;
+static _Thread_local bool profiler_thread_buffer_unavailable;
+
+/* ---------- private code */
+
+static struct profiler_thread_buffer *profiler_get_thread_buffer(void)
+{
+    if (profiler_thread_buffer || profiler_thread_buffer_unavailable)
+        return profiler_thread_buffer;
+
+    struct profiler_thread_buffer *buffer = heap_allocate_zeroed(1, sizeof(*buffer));
+    assert(buffer);
+
+    pthread_mutex_lock(&profiler_globals.thread_mutex);
+
+    int thread_index = atomic_load(&profiler_globals.thread_count);
+
+    if (thread_index < MAXIMUM_NUMBER_OF_PROFILER_THREADS)
+    {
+        buffer->thread_index = thread_index;
+        snprintf(buffer->name, sizeof(buffer->name), "thread %i", thread_index);
+
+        profiler_globals.threads[thread_index] = buffer;
+        atomic_store(&profiler_globals.thread_count, thread_index + 1);
+    }
+    else
+    {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    pthread_mutex_unlock(&profiler_globals.thread_mutex);
+
+    profiler_thread_buffer = buffer;
+    profiler_thread_buffer_unavailable = !buffer;
+
+    return buffer;
+}
+
+static void profiler_aggregate_event(
+    const struct profiler_event *event)
+{
+    // Zone names are almost always string literals, so key the table on the name address
+    unsigned int hash = (unsigned int)(((uintptr_t)event->name >> 3) * 2654435761u);
+    unsigned int table_index = hash % PROFILER_FRAME_ZONE_TABLE_SIZE;
+
+    for (;;)
+    {
+        short zone_index = profiler_globals.frame_zone_table[table_index];
+
+        if (zone_index == 0)
+        {
+            if (profiler_globals.frame_zone_count == MAXIMUM_NUMBER_OF_PROFILER_FRAME_ZONES)
+                return;
+
+            zone_index = ++profiler_globals.frame_zone_count;
+            profiler_globals.frame_zone_table[table_index] = zone_index;
+            profiler_globals.frame_zones[zone_index - 1] = (struct profiler_frame_zone){ .name = event->name };
+        }
+
+        struct profiler_frame_zone *zone = profiler_globals.frame_zones + zone_index - 1;
+
+        if (zone->name == event->name)
+        {
+            uint64_t duration = event->end_time - event->start_time;
+
+            zone->call_count++;
+            zone->total_time += duration;
+
+            if (duration > zone->maximum_time)
+                zone->maximum_time = duration;
+
+            return;
+        }
+
+        table_index = (table_index + 1) % PROFILER_FRAME_ZONE_TABLE_SIZE;
+    }
+}
+
+static void profiler_write_json_string(
+    FILE *stream,
+    const char *string)
+{
+    fputc('"', stream);
+
+    for (const char *c = string; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', stream);
+
+        if ((unsigned char)*c >= 0x20)
+            fputc(*c, stream);
+    }
+
+    fputc('"', stream);
+}
+
+/* ---------- public code */
+
+void profiler_set_enabled(
+    bool enabled)
+{
+    atomic_store(&profiler_globals.disabled, !enabled);
+}
+
+bool profiler_is_enabled(void)
+{
+    return !atomic_load_explicit(&profiler_globals.disabled, memory_order_relaxed);
+}
+
+void profiler_set_thread_name(
+    const char *name)
+{
+    assert(name);
+
+    struct profiler_thread_buffer *buffer = profiler_get_thread_buffer();
+
+    if (buffer)
+        snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+}
+
+uint64_t profiler_get_time(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return ((uint64_t)time.tv_sec * 1000000000ull) + (uint64_t)time.tv_nsec;
+}
+
+struct profiler_zone profiler_zone_begin(
+    const char *name)
+{
+    if (!profiler_is_enabled())
+        return (struct profiler_zone){ NULL, 0 };
+
+    return (struct profiler_zone){ name, profiler_get_time() };
+}
+
+void profiler_zone_end(
+    struct profiler_zone *zone)
+{
+    if (!zone->name)
+        return;
+
+    uint64_t end_time = profiler_get_time();
+    struct profiler_thread_buffer *buffer = profiler_get_thread_buffer();
+
+    if (!buffer)
+        return;
+
+    uint64_t event_count = atomic_load_explicit(&buffer->event_count, memory_order_relaxed);
+
+    buffer->events[event_count & PROFILER_THREAD_EVENT_MASK] = (struct profiler_event)
+    {
+        .name = zone->name,
+        .start_time = zone->start_time,
+        .end_time = end_time,
+    };
+
+    atomic_store_explicit(&buffer->event_count, event_count + 1, memory_order_release);
+}
+
+void profiler_end_frame(void)
+{
+    profiler_globals.frame_zone_count = 0;
+    memset(profiler_globals.frame_zone_table, 0, sizeof(profiler_globals.frame_zone_table));
+
+    int thread_count = atomic_load(&profiler_globals.thread_count);
+
+    for (int thread_index = 0; thread_index < thread_count; thread_index++)
+    {
+        struct profiler_thread_buffer *buffer = profiler_globals.threads[thread_index];
+
+        uint64_t event_count = atomic_load_explicit(&buffer->event_count, memory_order_acquire);
+        uint64_t first_event_index = buffer->aggregated_event_count;
+
+        // Skip anything the ring has already overwritten
+        if (event_count - first_event_index > PROFILER_THREAD_EVENT_CAPACITY)
+            first_event_index = event_count - PROFILER_THREAD_EVENT_CAPACITY;
+
+        for (uint64_t event_index = first_event_index; event_index < event_count; event_index++)
+            profiler_aggregate_event(buffer->events + (event_index & PROFILER_THREAD_EVENT_MASK));
+
+        buffer->aggregated_event_count = event_count;
+    }
+
+    profiler_globals.last_frame_zone_count = profiler_globals.frame_zone_count;
+    memcpy(profiler_globals.last_frame_zones, profiler_globals.frame_zones, profiler_globals.frame_zone_count * sizeof(*profiler_globals.frame_zones));
+}
+
+const struct profiler_frame_zone *profiler_get_frame_zones(
+    int *out_zone_count)
+{
+    assert(out_zone_count);
+
+    *out_zone_count = profiler_globals.last_frame_zone_count;
+    return profiler_globals.last_frame_zones;
+}
+
+bool profiler_write_chrome_trace(
+    const char *file_path)
+{
+    assert(file_path);
+
+    FILE *stream = fopen(file_path, "w");
+
+    if (!stream)
+    {
+        fprintf(stderr, "ERROR: failed to open \"%s\" for writing\n", file_path);
+        return false;
+    }
+
+    int thread_count = atomic_load(&profiler_globals.thread_count);
+
+    // Find the earliest surviving event so timestamps start near zero
+    uint64_t base_time = UINT64_MAX;
+
+    for (int thread_index = 0; thread_index < thread_count; thread_index++)
+    {
+        struct profiler_thread_buffer *buffer = profiler_globals.threads[thread_index];
+        uint64_t event_count = atomic_load_explicit(&buffer->event_count, memory_order_acquire);
+        uint64_t first_event_index = event_count > PROFILER_THREAD_EVENT_CAPACITY ? event_count - PROFILER_THREAD_EVENT_CAPACITY : 0;
+
+        for (uint64_t event_index = first_event_index; event_index < event_count; event_index++)
+        {
+            uint64_t start_time = buffer->events[event_index & PROFILER_THREAD_EVENT_MASK].start_time;
+
+            if (start_time < base_time)
+                base_time = start_time;
+        }
+    }
+
+    fputs("{\"traceEvents\":[\n", stream);
+
+    bool first_event = true;
+
+    for (int thread_index = 0; thread_index < thread_count; thread_index++)
+    {
+        struct profiler_thread_buffer *buffer = profiler_globals.threads[thread_index];
+
+        fprintf(stream, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":", first_event ? "" : ",\n", buffer->thread_index);
+        profiler_write_json_string(stream, buffer->name);
+        fputs("}}", stream);
+        first_event = false;
+
+        uint64_t event_count = atomic_load_explicit(&buffer->event_count, memory_order_acquire);
+        uint64_t first_event_index = event_count > PROFILER_THREAD_EVENT_CAPACITY ? event_count - PROFILER_THREAD_EVENT_CAPACITY : 0;
+
+        for (uint64_t event_index = first_event_index; event_index < event_count; event_index++)
+        {
+            const struct profiler_event *event = buffer->events + (event_index & PROFILER_THREAD_EVENT_MASK);
+
+            fputs(",\n{\"name\":", stream);
+            profiler_write_json_string(stream, event->name);
+            fprintf(stream, ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%i}",
+                (double)(event->start_time - base_time) / 1000.0,
+                (double)(event->end_time - event->start_time) / 1000.0,
+                buffer->thread_index);
+        }
+    }
+
+    fputs("\n]}\n", stream);
+    fclose(stream);
+
+    return true;
+}
+
+void profiler_dispose(void)
+{
+    pthread_mutex_lock(&profiler_globals.thread_mutex);
+
+    int thread_count = atomic_load(&profiler_globals.thread_count);
+
+    for (int thread_index = 0; thread_index < thread_count; thread_index++)
+    {
+        free(profiler_globals.threads[thread_index]);
+        profiler_globals.threads[thread_index] = NULL;
+    }
+
+    atomic_store(&profiler_globals.thread_count, 0);
+
+    pthread_mutex_unlock(&profiler_globals.thread_mutex);
+
+    // Only the calling thread's cached buffer can be cleared here; other threads must have stopped recording
+    profiler_thread_buffer = NULL;
+    profiler_thread_buffer_unavailable = false;
+}
@@ -0,0 +1,107 @@
+/*
+PROFILER.H
+    Scoped CPU profiler declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ---------- constants */
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+enum
+{
+    PROFILER_THREAD_EVENT_CAPACITY = 1 << 16,
+    MAXIMUM_NUMBER_OF_PROFILER_THREADS = 72,
+    MAXIMUM_NUMBER_OF_PROFILER_FRAME_ZONES = 256,
+    MAXIMUM_PROFILER_THREAD_NAME_LENGTH = 32,
+};
+
+/* ---------- macros */
+
+#define PROFILER_CONCATENATE_INNER(a, b) a##b
+#define PROFILER_CONCATENATE(a, b) PROFILER_CONCATENATE_INNER(a, b)
+
+#if PROFILER_ENABLED
+
+/**
+ * Opens a profiler zone that closes automatically when the enclosing scope exits.
+ * The name must point to storage that outlives the profiler, such as a string literal.
+ */
+#define PROFILER_ZONE(name) \
+    struct profiler_zone PROFILER_CONCATENATE(profiler_zone_, __LINE__) __attribute__((cleanup(profiler_zone_end))) = profiler_zone_begin(name)
+
+#define PROFILER_FUNCTION() PROFILER_ZONE(__func__)
+
+#else
+
+#define PROFILER_ZONE(name) ((void)0)
+#define PROFILER_FUNCTION() ((void)0)
+
+#endif
+
+/* ---------- types */
+
+struct profiler_zone
+{
+    const char *name;
+    uint64_t start_time;
+};
+
+struct profiler_frame_zone
+{
+    const char *name;
+    int call_count;
+    uint64_t total_time;
+    uint64_t maximum_time;
+};
+
+/* ---------- prototypes/PROFILER.C */
+
+/**
+ * Enables or disables event recording. Zones opened while disabled cost one branch.
+ */
+void profiler_set_enabled(bool enabled);
+bool profiler_is_enabled(void);
+
+/**
+ * Names the calling thread in exported traces.
+ */
+void profiler_set_thread_name(const char *name);
+
+/**
+ * Gets the profiler's monotonic clock in nanoseconds.
+ */
+uint64_t profiler_get_time(void);
+
+struct profiler_zone profiler_zone_begin(const char *name);
+void profiler_zone_end(struct profiler_zone *zone);
+
+/**
+ * Aggregates every zone recorded since the previous call into per-name totals for the frame that just ended.
+ * Called once per frame by the main loop.
+ */
+void profiler_end_frame(void);
+
+/**
+ * Gets the aggregated zones of the last completed frame.
+ * @param out_zone_count The address to store the number of aggregated zones at.
+ * @returns The address of the aggregated zones, which stays valid until the next call to profiler_end_frame.
+ */
+const struct profiler_frame_zone *profiler_get_frame_zones(int *out_zone_count);
+
+/**
+ * Writes every event still held in the thread ring buffers to a Chrome trace_event JSON file.
+ * @param file_path The path of the file to write.
+ * @returns true if the file was written, otherwise false.
+ */
+bool profiler_write_chrome_trace(const char *file_path);
+
+/**
+ * Frees every thread ring buffer.
+ */
+void profiler_dispose(void);
@@ -0,0 +1,473 @@
+/*
+BENCHMARK_AABB_TREES.C
+    Dynamic bounding volume hierarchy benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "geometry/aabb_trees.h"
+#include "geometry/frustums.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_STATIC_OBJECT_COUNT = 100000,
+
+    // One moving object for every this many static ones
+    BENCHMARK_MOVING_OBJECT_RATIO = 10,
+
+    BENCHMARK_TREE_FRAME_COUNT = 60,
+    BENCHMARK_TREE_QUERY_COUNT = 1000,
+    BENCHMARK_TREE_FRUSTUM_QUERY_COUNT = 100,
+};
+
+// Sized so every object count keeps the same density
+#define BENCHMARK_TREE_VOLUME_PER_OBJECT 1000.0f
+
+#define BENCHMARK_TREE_MARGIN 0.5f
+#define BENCHMARK_TREE_MAXIMUM_SPEED 0.1f
+#define BENCHMARK_TREE_QUERY_RADIUS 20.0f
+#define BENCHMARK_TREE_RAY_LENGTH 200.0f
+#define BENCHMARK_TREE_FAR_CLIP 200.0f
+
+#define BENCHMARK_TREE_PI 3.14159265f
+
+/* ---------- private types */
+
+struct benchmark_object
+{
+    float center[3];
+    float extents[3];
+    float velocity[3];
+    struct aabb bounds;
+    int proxy_index;
+};
+
+enum benchmark_query_type
+{
+    _benchmark_query_aabb,
+    _benchmark_query_sphere,
+    _benchmark_query_ray,
+    _benchmark_query_frustum,
+    NUMBER_OF_BENCHMARK_QUERY_TYPES
+};
+
+// One query, shared by the tree and the brute force scan so both answer exactly the same question
+struct benchmark_query
+{
+    enum benchmark_query_type type;
+
+    struct aabb bounds;
+    struct bounding_sphere sphere;
+    float origin[3];
+    float direction[3];
+    struct frustum frustum;
+};
+
+struct benchmark_query_context
+{
+    const struct benchmark_object *objects;
+    const struct benchmark_query *query;
+    int hit_count;
+};
+
+/* ---------- private code */
+
+static float benchmark_random_range(
+    float minimum,
+    float maximum)
+{
+    return minimum + ((maximum - minimum) * benchmark_random());
+}
+
+static void benchmark_update_bounds(
+    struct benchmark_object *object)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        object->bounds.minimum[axis] = object->center[axis] - object->extents[axis];
+        object->bounds.maximum[axis] = object->center[axis] + object->extents[axis];
+    }
+}
+
+static void benchmark_build_view_projection(
+    const float eye[3],
+    float yaw,
+    float out_matrix[4][4])
+{
+    // A perspective camera at the eye, turned about the y axis and looking down -z when the yaw is zero
+    float focal_length = 1.0f / tanf(BENCHMARK_TREE_PI / 6.0f);
+    float near_clip = 0.1f;
+
+    float projection[4][4] = { 0 };
+    projection[0][0] = focal_length;
+    projection[1][1] = focal_length;
+    projection[2][2] = (BENCHMARK_TREE_FAR_CLIP + near_clip) / (near_clip - BENCHMARK_TREE_FAR_CLIP);
+    projection[2][3] = -1.0f;
+    projection[3][2] = (2.0f * BENCHMARK_TREE_FAR_CLIP * near_clip) / (near_clip - BENCHMARK_TREE_FAR_CLIP);
+
+    const float rows[3][3] =
+    {
+        { cosf(yaw), 0.0f, sinf(yaw) },
+        { 0.0f, 1.0f, 0.0f },
+        { -sinf(yaw), 0.0f, cosf(yaw) },
+    };
+
+    float view[4][4] = { 0 };
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+            view[column][row] = rows[row][column];
+
+        view[3][row] = -((rows[row][0] * eye[0]) + (rows[row][1] * eye[1]) + (rows[row][2] * eye[2]));
+    }
+
+    view[3][3] = 1.0f;
+
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+            out_matrix[column][row] = (projection[0][row] * view[column][0]) + (projection[1][row] * view[column][1]) + (projection[2][row] * view[column][2]) + (projection[3][row] * view[column][3]);
+    }
+}
+
+static void benchmark_build_query(
+    enum benchmark_query_type type,
+    float world_size,
+    struct benchmark_query *out_query)
+{
+    memset(out_query, 0, sizeof(*out_query));
+    out_query->type = type;
+
+    float point[3];
+
+    for (int axis = 0; axis < 3; axis++)
+        point[axis] = benchmark_random_range(0.0f, world_size);
+
+    switch (type)
+    {
+    case _benchmark_query_aabb:
+        for (int axis = 0; axis < 3; axis++)
+        {
+            out_query->bounds.minimum[axis] = point[axis] - BENCHMARK_TREE_QUERY_RADIUS;
+            out_query->bounds.maximum[axis] = point[axis] + BENCHMARK_TREE_QUERY_RADIUS;
+        }
+        break;
+
+    case _benchmark_query_sphere:
+        memcpy(out_query->sphere.center, point, sizeof(point));
+        out_query->sphere.radius = BENCHMARK_TREE_QUERY_RADIUS;
+        break;
+
+    case _benchmark_query_ray:
+    {
+        memcpy(out_query->origin, point, sizeof(point));
+
+        float length = 0.0f;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            out_query->direction[axis] = benchmark_random_range(-1.0f, 1.0f);
+            length += out_query->direction[axis] * out_query->direction[axis];
+        }
+
+        length = sqrtf(length);
+
+        for (int axis = 0; axis < 3; axis++)
+            out_query->direction[axis] /= length;
+        break;
+    }
+
+    case _benchmark_query_frustum:
+    {
+        float view_projection[4][4];
+        benchmark_build_view_projection(point, benchmark_random_range(0.0f, 2.0f * BENCHMARK_TREE_PI), view_projection);
+        frustum_from_matrix(&out_query->frustum, view_projection);
+        break;
+    }
+
+    default:
+        assert(false);
+        break;
+    }
+}
+
+static bool benchmark_query_hits(
+    const struct benchmark_query *query,
+    const struct aabb *bounds)
+{
+    switch (query->type)
+    {
+    case _benchmark_query_aabb:
+        return aabb_intersects_aabb(bounds, &query->bounds);
+
+    case _benchmark_query_sphere:
+    {
+        float distance_squared = 0.0f;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float offset = fmaxf(fmaxf(bounds->minimum[axis] - query->sphere.center[axis], query->sphere.center[axis] - bounds->maximum[axis]), 0.0f);
+            distance_squared += offset * offset;
+        }
+
+        return distance_squared <= query->sphere.radius * query->sphere.radius;
+    }
+
+    case _benchmark_query_ray:
+    {
+        float entry_distance = 0.0f;
+        float exit_distance = BENCHMARK_TREE_RAY_LENGTH;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float inverse_direction = 1.0f / query->direction[axis];
+            float near_distance = (bounds->minimum[axis] - query->origin[axis]) * inverse_direction;
+            float far_distance = (bounds->maximum[axis] - query->origin[axis]) * inverse_direction;
+
+            entry_distance = fmaxf(entry_distance, fminf(near_distance, far_distance));
+            exit_distance = fminf(exit_distance, fmaxf(near_distance, far_distance));
+        }
+
+        return entry_distance <= exit_distance;
+    }
+
+    case _benchmark_query_frustum:
+        return frustum_test_aabb(&query->frustum, bounds);
+
+    default:
+        assert(false);
+        return false;
+    }
+}
+
+static bool benchmark_query_callback(
+    void *data,
+    int proxy_index,
+    int user_data)
+{
+    (void)proxy_index;
+
+    // The tree reports candidates by their enlarged bounds; count the ones the object's own bounds confirm
+    struct benchmark_query_context *context = data;
+
+    if (benchmark_query_hits(context->query, &context->objects[user_data].bounds))
+        context->hit_count++;
+
+    return true;
+}
+
+static int benchmark_query_tree(
+    const struct aabb_tree *tree,
+    const struct benchmark_object *objects,
+    const struct benchmark_query *query)
+{
+    struct benchmark_query_context context = { objects, query, 0 };
+
+    switch (query->type)
+    {
+    case _benchmark_query_aabb:
+        aabb_tree_query_aabb(tree, &query->bounds, benchmark_query_callback, &context);
+        break;
+
+    case _benchmark_query_sphere:
+        aabb_tree_query_sphere(tree, &query->sphere, benchmark_query_callback, &context);
+        break;
+
+    case _benchmark_query_ray:
+        aabb_tree_query_ray(tree, query->origin, query->direction, BENCHMARK_TREE_RAY_LENGTH, benchmark_query_callback, &context);
+        break;
+
+    case _benchmark_query_frustum:
+        aabb_tree_query_frustum(tree, &query->frustum, benchmark_query_callback, &context);
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+
+    return context.hit_count;
+}
+
+static int benchmark_query_brute_force(
+    const struct benchmark_object *objects,
+    int object_count,
+    const struct benchmark_query *query)
+{
+    int hit_count = 0;
+
+    for (int object_index = 0; object_index < object_count; object_index++)
+        hit_count += benchmark_query_hits(query, &objects[object_index].bounds);
+
+    return hit_count;
+}
+
+static void benchmark_run_queries(
+    const struct aabb_tree *tree,
+    const struct benchmark_object *objects,
+    int object_count,
+    float world_size)
+{
+    static const char *const query_type_names[NUMBER_OF_BENCHMARK_QUERY_TYPES] =
+    {
+        [_benchmark_query_aabb] = "aabb",
+        [_benchmark_query_sphere] = "sphere",
+        [_benchmark_query_ray] = "ray",
+        [_benchmark_query_frustum] = "frustum",
+    };
+
+    printf("%8s %8s %16s %16s %10s %12s\n", "query", "count", "tree", "brute force", "speedup", "hits/query");
+
+    for (enum benchmark_query_type type = 0; type < NUMBER_OF_BENCHMARK_QUERY_TYPES; type++)
+    {
+        int query_count = type == _benchmark_query_frustum ? BENCHMARK_TREE_FRUSTUM_QUERY_COUNT : BENCHMARK_TREE_QUERY_COUNT;
+
+        struct benchmark_query *queries = malloc(query_count * sizeof(*queries));
+        assert(queries);
+
+        for (int query_index = 0; query_index < query_count; query_index++)
+            benchmark_build_query(type, world_size, queries + query_index);
+
+        int tree_hit_count = 0;
+        double start_time = benchmark_get_seconds();
+
+        for (int query_index = 0; query_index < query_count; query_index++)
+            tree_hit_count += benchmark_query_tree(tree, objects, queries + query_index);
+
+        double tree_seconds = benchmark_get_seconds() - start_time;
+
+        int brute_force_hit_count = 0;
+        start_time = benchmark_get_seconds();
+
+        for (int query_index = 0; query_index < query_count; query_index++)
+            brute_force_hit_count += benchmark_query_brute_force(objects, object_count, queries + query_index);
+
+        double brute_force_seconds = benchmark_get_seconds() - start_time;
+
+        printf("%8s %8i %10.4f ms/q %10.4f ms/q %9.1fx %12.1f  %s\n",
+            query_type_names[type],
+            query_count,
+            (tree_seconds * 1000.0) / (double)query_count,
+            (brute_force_seconds * 1000.0) / (double)query_count,
+            brute_force_seconds / tree_seconds,
+            (double)tree_hit_count / (double)query_count,
+            tree_hit_count == brute_force_hit_count ? "matches brute force" : "DIFFERS FROM BRUTE FORCE");
+
+        free(queries);
+    }
+}
+
+/* ---------- public code */
+
+int benchmark_aabb_trees_execute(
+    int argc,
+    const char **argv)
+{
+    int static_object_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_STATIC_OBJECT_COUNT;
+    assert(static_object_count > 0);
+
+    int moving_object_count = static_object_count / BENCHMARK_MOVING_OBJECT_RATIO;
+    int object_count = static_object_count + moving_object_count;
+
+    float world_size = cbrtf(BENCHMARK_TREE_VOLUME_PER_OBJECT * (float)object_count);
+
+    srand(1);
+
+    // The moving objects come last
+    struct benchmark_object *objects = calloc(object_count, sizeof(*objects));
+    int *moved_proxy_indices = malloc(moving_object_count * sizeof(*moved_proxy_indices));
+    struct aabb *moved_bounds = malloc(moving_object_count * sizeof(*moved_bounds));
+    assert(objects && (!moving_object_count || (moved_proxy_indices && moved_bounds)));
+
+    for (int object_index = 0; object_index < object_count; object_index++)
+    {
+        struct benchmark_object *object = objects + object_index;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            object->center[axis] = benchmark_random_range(0.0f, world_size);
+            object->extents[axis] = benchmark_random_range(0.25f, 2.0f);
+
+            if (object_index >= static_object_count)
+                object->velocity[axis] = benchmark_random_range(-BENCHMARK_TREE_MAXIMUM_SPEED, BENCHMARK_TREE_MAXIMUM_SPEED);
+        }
+
+        benchmark_update_bounds(object);
+    }
+
+    printf("%i static and %i moving objects in a %.0f unit cube, margin %.2f\n",
+        static_object_count,
+        moving_object_count,
+        world_size,
+        BENCHMARK_TREE_MARGIN);
+
+    struct aabb_tree tree;
+    aabb_tree_initialize(&tree, BENCHMARK_TREE_MARGIN);
+
+    double start_time = benchmark_get_seconds();
+
+    for (int object_index = 0; object_index < object_count; object_index++)
+        objects[object_index].proxy_index = aabb_tree_insert(&tree, &objects[object_index].bounds, object_index);
+
+    double build_seconds = benchmark_get_seconds() - start_time;
+
+    printf("build:  %10.3f ms, height %i, %i nodes\n", build_seconds * 1000.0, aabb_tree_get_height(&tree), tree.nodes.count);
+
+    benchmark_run_queries(&tree, objects, object_count, world_size);
+
+    // Move every moving object each frame, bouncing off the sides of the world, and update the tree in one batch
+    int reinserted_count = 0;
+    double update_seconds = 0.0;
+
+    for (int frame_index = 0; frame_index < BENCHMARK_TREE_FRAME_COUNT; frame_index++)
+    {
+        for (int moving_index = 0; moving_index < moving_object_count; moving_index++)
+        {
+            struct benchmark_object *object = objects + static_object_count + moving_index;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                object->center[axis] += object->velocity[axis];
+
+                if (object->center[axis] < 0.0f || object->center[axis] > world_size)
+                    object->velocity[axis] = -object->velocity[axis];
+            }
+
+            benchmark_update_bounds(object);
+
+            moved_proxy_indices[moving_index] = object->proxy_index;
+            moved_bounds[moving_index] = object->bounds;
+        }
+
+        start_time = benchmark_get_seconds();
+        reinserted_count += aabb_tree_move_batch(&tree, moving_object_count, moved_proxy_indices, moved_bounds);
+        update_seconds += benchmark_get_seconds() - start_time;
+    }
+
+    printf("update: %10.3f ms/frame over %i frames, %.1f of %i moving objects reinserted per frame, height %i\n",
+        (update_seconds * 1000.0) / (double)BENCHMARK_TREE_FRAME_COUNT,
+        BENCHMARK_TREE_FRAME_COUNT,
+        (double)reinserted_count / (double)BENCHMARK_TREE_FRAME_COUNT,
+        moving_object_count,
+        aabb_tree_get_height(&tree));
+
+    // The tree should answer as well after all that movement as it did when freshly built
+    benchmark_run_queries(&tree, objects, object_count, world_size);
+
+    aabb_tree_dispose(&tree);
+
+    free(objects);
+    free(moved_proxy_indices);
+    free(moved_bounds);
+
+    return 0;
+}
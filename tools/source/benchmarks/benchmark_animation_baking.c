@@ -0,0 +1,208 @@
+/*
+BENCHMARK_ANIMATION_BAKING.C
+    Baked animation clip benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_baking.h"
+#include "animations/animation_compression.h"
+#include "animations/animation_poses.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_BAKING_INSTANCE_COUNT = 256,
+    BENCHMARK_BAKING_BONE_COUNT = 64,
+
+    // A four second clip with unevenly spaced keys, as key reduction leaves them
+    BENCHMARK_BAKING_KEY_COUNT = 48,
+    BENCHMARK_BAKING_FRAME_COUNT = 200,
+};
+
+#define BENCHMARK_BAKING_DURATION 120.0f
+
+/* ---------- private variables */
+
+static volatile float benchmark_baking_sink;
+
+/* ---------- private code */
+
+static float benchmark_get_instance_time(
+    int instance_index,
+    int frame_index)
+{
+    // Every instance plays the clip at 90 fps from its own phase, as a crowd would
+    float phase = (BENCHMARK_BAKING_DURATION * (float)instance_index) / (float)DEFAULT_BENCHMARK_BAKING_INSTANCE_COUNT;
+    return fmodf(phase + ((float)frame_index / 3.0f), BENCHMARK_BAKING_DURATION);
+}
+
+/* ---------- public code */
+
+int benchmark_animation_baking_execute(
+    int argc,
+    const char **argv)
+{
+    int instance_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_BAKING_INSTANCE_COUNT;
+    assert(instance_count > 0);
+
+    srand(1);
+
+    struct animation_data animation;
+    memset(&animation, 0, sizeof(animation));
+
+    animation.duration = BENCHMARK_BAKING_DURATION;
+    animation.ticks_per_second = 30.0f;
+    animation.channel_count = BENCHMARK_BAKING_BONE_COUNT;
+    animation.channels = calloc(BENCHMARK_BAKING_BONE_COUNT, sizeof(*animation.channels));
+    animation.node_channel_indices = malloc(BENCHMARK_BAKING_BONE_COUNT * sizeof(*animation.node_channel_indices));
+
+    struct animation_raw_channel *raw_channels = calloc(BENCHMARK_BAKING_BONE_COUNT, sizeof(*raw_channels));
+    assert(animation.channels && animation.node_channel_indices && raw_channels);
+
+    struct benchmark_clip_description clip =
+    {
+        .key_count = BENCHMARK_BAKING_KEY_COUNT,
+        .duration = BENCHMARK_BAKING_DURATION,
+        .jitter_key_times = true,
+        .animate_positions = true,
+    };
+
+    for (int bone_index = 0; bone_index < BENCHMARK_BAKING_BONE_COUNT; bone_index++)
+    {
+        animation.channels[bone_index].type = _animation_channel_type_node;
+        animation.channels[bone_index].node_index = bone_index;
+        animation.node_channel_indices[bone_index] = bone_index;
+
+        benchmark_build_raw_channel(raw_channels + bone_index, &clip, bone_index);
+    }
+
+    struct animation_compression_statistics statistics;
+    memset(&statistics, 0, sizeof(statistics));
+    animation_compress(&animation, raw_channels, NULL, &statistics);
+
+    struct animation_pose_buffer default_pose;
+    animation_pose_buffer_initialize(&default_pose, BENCHMARK_BAKING_BONE_COUNT, NULL);
+
+    double start_time = benchmark_get_seconds();
+    animation_bake(&animation, &default_pose, ANIMATION_BAKING_DEFAULT_FRAMES_PER_SECOND);
+    double baking_seconds = benchmark_get_seconds() - start_time;
+
+    // Keyed playback needs cursors per instance; baked playback needs none
+    size_t keyed_size = statistics.compressed_size;
+    size_t cursor_size = (size_t)instance_count * BENCHMARK_BAKING_BONE_COUNT * sizeof(struct animation_channel_cursor);
+    size_t baked_size = animation_get_baked_size(&animation);
+
+    printf("baked %i bones into %i frames at %.0f Hz in %.3f ms\n",
+        BENCHMARK_BAKING_BONE_COUNT, animation.baked_frame_count, ANIMATION_BAKING_DEFAULT_FRAMES_PER_SECOND, baking_seconds * 1000.0);
+    printf("memory for %i instances:\n", instance_count);
+    printf("    keyed: %8zu bytes of keys + %8zu bytes of cursors\n", keyed_size, cursor_size);
+    printf("    baked: %8zu bytes of frames (%.2fx the keys)\n", baked_size, (double)baked_size / (double)keyed_size);
+
+    struct animation_channel_cursor *cursors = malloc(cursor_size);
+    struct animation_pose_buffer keyed_pose;
+    struct animation_pose_buffer baked_pose;
+    assert(cursors);
+
+    animation_pose_buffer_initialize(&keyed_pose, BENCHMARK_BAKING_BONE_COUNT, NULL);
+    animation_pose_buffer_initialize(&baked_pose, BENCHMARK_BAKING_BONE_COUNT, NULL);
+    animation_channel_cursors_initialize(cursors, instance_count * BENCHMARK_BAKING_BONE_COUNT);
+
+    // Measure how far the baked frames stray from the keys between frames
+    float maximum_position_error = 0.0f;
+    float maximum_rotation_error = 0.0f;
+
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        float time = benchmark_get_instance_time(instance_index, 0);
+        struct animation_channel_cursor *instance_cursors = cursors + (instance_index * BENCHMARK_BAKING_BONE_COUNT);
+
+        animation_sample_pose(&animation, &default_pose, time, instance_cursors, NULL, &keyed_pose);
+        animation_sample_baked_pose(&animation, &default_pose, time, NULL, &baked_pose);
+
+        for (int bone_index = 0; bone_index < BENCHMARK_BAKING_BONE_COUNT; bone_index++)
+        {
+            float dot = 0.0f;
+
+            for (int i = 0; i < 3; i++)
+                maximum_position_error = fmaxf(maximum_position_error, fabsf(keyed_pose.position[i][bone_index] - baked_pose.position[i][bone_index]));
+
+            for (int i = 0; i < 4; i++)
+                dot += keyed_pose.rotation[i][bone_index] * baked_pose.rotation[i][bone_index];
+
+            maximum_rotation_error = fmaxf(maximum_rotation_error, 2.0f * acosf(fminf(fabsf(dot), 1.0f)));
+        }
+    }
+
+    printf("    maximum baked error: %.6f units, %.6f radians\n", maximum_position_error, maximum_rotation_error);
+
+    printf("sampling %i instances over %i frames:\n", instance_count, BENCHMARK_BAKING_FRAME_COUNT);
+
+    double keyed_seconds = 0.0;
+    double baked_seconds = 0.0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        animation_channel_cursors_initialize(cursors, instance_count * BENCHMARK_BAKING_BONE_COUNT);
+        start_time = benchmark_get_seconds();
+
+        for (int frame_index = 0; frame_index < BENCHMARK_BAKING_FRAME_COUNT; frame_index++)
+        {
+            for (int instance_index = 0; instance_index < instance_count; instance_index++)
+            {
+                float time = benchmark_get_instance_time(instance_index, frame_index);
+
+                if (pass == 0)
+                {
+                    struct animation_channel_cursor *instance_cursors = cursors + (instance_index * BENCHMARK_BAKING_BONE_COUNT);
+                    animation_sample_pose(&animation, &default_pose, time, instance_cursors, NULL, &keyed_pose);
+                    benchmark_baking_sink += keyed_pose.rotation[0][instance_index % BENCHMARK_BAKING_BONE_COUNT];
+                }
+                else
+                {
+                    animation_sample_baked_pose(&animation, &default_pose, time, NULL, &baked_pose);
+                    benchmark_baking_sink += baked_pose.rotation[0][instance_index % BENCHMARK_BAKING_BONE_COUNT];
+                }
+            }
+        }
+
+        double seconds = (benchmark_get_seconds() - start_time) / (double)BENCHMARK_BAKING_FRAME_COUNT;
+        *(pass == 0 ? &keyed_seconds : &baked_seconds) = seconds;
+    }
+
+    printf("    keyed: %8.3f us/frame\n", keyed_seconds * 1000000.0);
+    printf("    baked: %8.3f us/frame (%.2fx)\n", baked_seconds * 1000000.0, keyed_seconds / baked_seconds);
+
+    for (int bone_index = 0; bone_index < BENCHMARK_BAKING_BONE_COUNT; bone_index++)
+    {
+        struct animation_channel *channel = animation.channels + bone_index;
+
+        animation_raw_channel_dispose(raw_channels + bone_index);
+
+        free(channel->position_key_times);
+        free(channel->position_key_values);
+        free(channel->rotation_key_times);
+        free(channel->rotation_key_values);
+        free(channel->scaling_key_times);
+        free(channel->scaling_key_values);
+    }
+
+    animation_unbake(&animation);
+    animation_pose_buffer_dispose(&default_pose);
+    animation_pose_buffer_dispose(&keyed_pose);
+    animation_pose_buffer_dispose(&baked_pose);
+
+    free(animation.channels);
+    free(animation.node_channel_indices);
+    free(raw_channels);
+    free(cursors);
+
+    return 0;
+}
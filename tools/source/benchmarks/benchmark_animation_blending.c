@@ -0,0 +1,240 @@
+/*
+BENCHMARK_ANIMATION_BLENDING.C
+    Animation pose blending benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_blending.h"
+#include "animations/animation_poses.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    BENCHMARK_BLEND_FRAME_COUNT = 4000,
+
+    // Three clips crossfading over the base pose with an additive layer on top, like a locomotion blend with an aim offset
+    BENCHMARK_BLEND_OVERRIDE_LAYER_COUNT = 3,
+    BENCHMARK_BLEND_LAYER_COUNT = BENCHMARK_BLEND_OVERRIDE_LAYER_COUNT + 1,
+};
+
+static const int benchmark_blend_node_counts[] = { 32, 64, 128, 256 };
+
+/* ---------- private types */
+
+struct benchmark_blend_skeleton
+{
+    int node_count;
+
+    struct animation_pose_buffer base_pose;
+    struct animation_pose_buffer layer_poses[BENCHMARK_BLEND_LAYER_COUNT];
+    struct animation_pose_buffer blended_pose;
+
+    // The same layer poses in the per-node layout they were blended from before
+    struct animation_node_state *layer_node_states[BENCHMARK_BLEND_LAYER_COUNT];
+    struct animation_node_state *blended_node_states;
+};
+
+/* ---------- private variables */
+
+static volatile float benchmark_blend_sink;
+
+/* ---------- private code */
+
+static void benchmark_random_node_state(
+    struct animation_node_state *out_node_state)
+{
+    float length_squared = 0.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        out_node_state->rotation[i] = (benchmark_random() * 2.0f) - 1.0f;
+        length_squared += out_node_state->rotation[i] * out_node_state->rotation[i];
+    }
+
+    for (int i = 0; i < 4; i++)
+        out_node_state->rotation[i] /= sqrtf(length_squared);
+
+    for (int i = 0; i < 3; i++)
+    {
+        out_node_state->position[i] = benchmark_random();
+        out_node_state->scale[i] = 0.5f + benchmark_random();
+    }
+}
+
+static void benchmark_blend_skeleton_initialize(
+    struct benchmark_blend_skeleton *skeleton,
+    int node_count)
+{
+    memset(skeleton, 0, sizeof(*skeleton));
+
+    skeleton->node_count = node_count;
+
+    animation_pose_buffer_initialize(&skeleton->base_pose, node_count, NULL);
+    animation_pose_buffer_initialize(&skeleton->blended_pose, node_count, NULL);
+
+    skeleton->blended_node_states = calloc(node_count, sizeof(*skeleton->blended_node_states));
+    assert(skeleton->blended_node_states);
+
+    for (int node_index = 0; node_index < node_count; node_index++)
+    {
+        struct animation_node_state node_state;
+        benchmark_random_node_state(&node_state);
+        animation_pose_buffer_set_node_state(&skeleton->base_pose, node_index, &node_state);
+    }
+
+    for (int layer_index = 0; layer_index < BENCHMARK_BLEND_LAYER_COUNT; layer_index++)
+    {
+        struct animation_pose_buffer *pose = skeleton->layer_poses + layer_index;
+        animation_pose_buffer_initialize(pose, node_count, NULL);
+
+        skeleton->layer_node_states[layer_index] = calloc(node_count, sizeof(*skeleton->layer_node_states[layer_index]));
+        assert(skeleton->layer_node_states[layer_index]);
+
+        for (int node_index = 0; node_index < node_count; node_index++)
+        {
+            struct animation_node_state *node_state = skeleton->layer_node_states[layer_index] + node_index;
+            benchmark_random_node_state(node_state);
+            animation_pose_buffer_set_node_state(pose, node_index, node_state);
+        }
+    }
+}
+
+static void benchmark_blend_skeleton_dispose(
+    struct benchmark_blend_skeleton *skeleton)
+{
+    animation_pose_buffer_dispose(&skeleton->base_pose);
+    animation_pose_buffer_dispose(&skeleton->blended_pose);
+
+    for (int layer_index = 0; layer_index < BENCHMARK_BLEND_LAYER_COUNT; layer_index++)
+    {
+        animation_pose_buffer_dispose(skeleton->layer_poses + layer_index);
+        free(skeleton->layer_node_states[layer_index]);
+    }
+
+    free(skeleton->blended_node_states);
+}
+
+static void benchmark_vector_lerp(
+    const float *a,
+    const float *b,
+    float t,
+    float *out_vector)
+{
+    for (int i = 0; i < 3; i++)
+        out_vector[i] = a[i] + ((b[i] - a[i]) * t);
+}
+
+static void benchmark_blend_per_node(
+    struct benchmark_blend_skeleton *skeleton,
+    const float *weights)
+{
+    // The blend before layers: one node at a time across every clip, mixing each into the running total at half its weight
+    for (int node_index = 0; node_index < skeleton->node_count; node_index++)
+    {
+        struct animation_node_state *total_node_state = skeleton->blended_node_states + node_index;
+
+        for (int layer_index = 0; layer_index < BENCHMARK_BLEND_LAYER_COUNT; layer_index++)
+        {
+            const struct animation_node_state *node_state = skeleton->layer_node_states[layer_index] + node_index;
+
+            if (layer_index == 0)
+            {
+                *total_node_state = *node_state;
+                continue;
+            }
+
+            float factor = 0.5f * weights[layer_index];
+            benchmark_vector_lerp(node_state->position, total_node_state->position, factor, total_node_state->position);
+            animation_quaternion_slerp(node_state->rotation, total_node_state->rotation, factor, total_node_state->rotation);
+            benchmark_vector_lerp(node_state->scale, total_node_state->scale, factor, total_node_state->scale);
+        }
+    }
+
+    benchmark_blend_sink += skeleton->blended_node_states[skeleton->node_count - 1].rotation[0];
+}
+
+static void benchmark_blend_layered(
+    struct benchmark_blend_skeleton *skeleton,
+    const float *weights)
+{
+    struct animation_blend_layer layers[BENCHMARK_BLEND_LAYER_COUNT];
+
+    for (int layer_index = 0; layer_index < BENCHMARK_BLEND_LAYER_COUNT; layer_index++)
+    {
+        layers[layer_index] = (struct animation_blend_layer)
+        {
+            .pose = skeleton->layer_poses + layer_index,
+            .weight = weights[layer_index],
+            .mode = layer_index < BENCHMARK_BLEND_OVERRIDE_LAYER_COUNT ? _animation_blend_mode_override : _animation_blend_mode_additive,
+        };
+    }
+
+    animation_pose_blend(layers, BENCHMARK_BLEND_LAYER_COUNT, &skeleton->base_pose, &skeleton->blended_pose);
+
+    benchmark_blend_sink += skeleton->blended_pose.rotation[0][skeleton->node_count - 1];
+}
+
+static double benchmark_run(
+    struct benchmark_blend_skeleton *skeleton,
+    void (*blend)(struct benchmark_blend_skeleton *, const float *))
+{
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < BENCHMARK_BLEND_FRAME_COUNT; frame_index++)
+    {
+        // Crossfade weights that change every frame so nothing can be hoisted out of the loop
+        float phase = (float)frame_index / (float)BENCHMARK_BLEND_FRAME_COUNT;
+        float weights[BENCHMARK_BLEND_LAYER_COUNT] = { 1.0f - phase, phase, 0.5f, 0.25f + (0.5f * phase) };
+
+        blend(skeleton, weights);
+    }
+
+    return (benchmark_get_seconds() - start_time) / (double)BENCHMARK_BLEND_FRAME_COUNT;
+}
+
+/* ---------- public code */
+
+int benchmark_animation_blending_execute(
+    int argc,
+    const char **argv)
+{
+    int node_count = argc > 0 ? atoi(argv[0]) : 0;
+    assert(node_count >= 0);
+
+    srand(1);
+
+    printf("blending %i override layers and 1 additive layer, %i frames per skeleton size\n", BENCHMARK_BLEND_OVERRIDE_LAYER_COUNT, BENCHMARK_BLEND_FRAME_COUNT);
+    printf("%8s %22s %22s %10s\n", "nodes", "per-node", "layered", "speedup");
+
+    for (int size_index = 0; size_index < (int)NUMBER_OF(benchmark_blend_node_counts); size_index++)
+    {
+        int skeleton_node_count = node_count ? node_count : benchmark_blend_node_counts[size_index];
+
+        struct benchmark_blend_skeleton skeleton;
+        benchmark_blend_skeleton_initialize(&skeleton, skeleton_node_count);
+
+        double per_node_seconds = benchmark_run(&skeleton, benchmark_blend_per_node);
+        double layered_seconds = benchmark_run(&skeleton, benchmark_blend_layered);
+
+        printf("%8i %16.3f us/skel %16.3f us/skel %9.2fx\n",
+            skeleton_node_count,
+            per_node_seconds * 1000000.0,
+            layered_seconds * 1000000.0,
+            per_node_seconds / layered_seconds);
+
+        benchmark_blend_skeleton_dispose(&skeleton);
+
+        if (node_count)
+            break;
+    }
+
+    return 0;
+}
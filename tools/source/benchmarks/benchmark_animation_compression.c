@@ -0,0 +1,173 @@
+/*
+BENCHMARK_ANIMATION_COMPRESSION.C
+    Animation clip compression benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_compression.h"
+#include "animations/animation_keys.h"
+#include "animations/animation_poses.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_COMPRESSION_BONE_COUNT = 64,
+
+    // A two second clip baked at 30 Hz, as exporters write them
+    BENCHMARK_COMPRESSION_KEY_COUNT = 61,
+    BENCHMARK_COMPRESSION_FRAME_COUNT = 20000,
+};
+
+/* ---------- private variables */
+
+static volatile float benchmark_compression_sink;
+
+/* ---------- private code */
+
+static void benchmark_sample_raw_channel(
+    const struct animation_raw_channel *raw_channel,
+    float time,
+    struct animation_channel_cursor *cursor,
+    struct animation_node_state *node_state)
+{
+    // Sampling as it was before compression: full float keys, lerped and slerped directly
+    int key_index = animation_keys_find(raw_channel->position_key_times, raw_channel->position_key_count, time, &cursor->position_key_index);
+    float factor = animation_keys_get_interpolation_factor(raw_channel->position_key_times, raw_channel->position_key_count, key_index, time);
+
+    for (int i = 0; i < 3; i++)
+    {
+        float a = raw_channel->position_key_values[key_index][i];
+        node_state->position[i] = a + ((raw_channel->position_key_values[key_index + 1][i] - a) * factor);
+    }
+
+    key_index = animation_keys_find(raw_channel->rotation_key_times, raw_channel->rotation_key_count, time, &cursor->rotation_key_index);
+    factor = animation_keys_get_interpolation_factor(raw_channel->rotation_key_times, raw_channel->rotation_key_count, key_index, time);
+    animation_quaternion_slerp(raw_channel->rotation_key_values[key_index], raw_channel->rotation_key_values[key_index + 1], factor, node_state->rotation);
+
+    key_index = animation_keys_find(raw_channel->scaling_key_times, raw_channel->scaling_key_count, time, &cursor->scaling_key_index);
+    factor = animation_keys_get_interpolation_factor(raw_channel->scaling_key_times, raw_channel->scaling_key_count, key_index, time);
+
+    for (int i = 0; i < 3; i++)
+    {
+        float a = raw_channel->scaling_key_values[key_index][i];
+        node_state->scale[i] = a + ((raw_channel->scaling_key_values[key_index + 1][i] - a) * factor);
+    }
+}
+
+/* ---------- public code */
+
+int benchmark_animation_compression_execute(
+    int argc,
+    const char **argv)
+{
+    int bone_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_COMPRESSION_BONE_COUNT;
+    assert(bone_count > 0);
+
+    srand(1);
+
+    struct animation_data animation;
+    memset(&animation, 0, sizeof(animation));
+
+    animation.duration = (float)(BENCHMARK_COMPRESSION_KEY_COUNT - 1);
+    animation.ticks_per_second = 30.0f;
+    animation.channel_count = bone_count;
+    animation.channels = calloc(bone_count, sizeof(*animation.channels));
+
+    struct animation_raw_channel *raw_channels = calloc(bone_count, sizeof(*raw_channels));
+    struct animation_channel_cursor *cursors = calloc(bone_count, sizeof(*cursors));
+    struct animation_node_state *node_states = calloc(bone_count, sizeof(*node_states));
+    assert(animation.channels && raw_channels && cursors && node_states);
+
+    // Every track keyed every frame, with the root walking forward
+    struct benchmark_clip_description clip =
+    {
+        .key_count = BENCHMARK_COMPRESSION_KEY_COUNT,
+        .duration = (float)(BENCHMARK_COMPRESSION_KEY_COUNT - 1),
+        .animate_positions = true,
+        .animate_scaling = true,
+        .root_speed = 0.02f,
+    };
+
+    for (int bone_index = 0; bone_index < bone_count; bone_index++)
+    {
+        animation.channels[bone_index].type = _animation_channel_type_node;
+        animation.channels[bone_index].node_index = bone_index;
+
+        benchmark_build_raw_channel(raw_channels + bone_index, &clip, bone_index);
+    }
+
+    struct animation_compression_statistics statistics;
+    memset(&statistics, 0, sizeof(statistics));
+
+    double start_time = benchmark_get_seconds();
+    animation_compress(&animation, raw_channels, NULL, &statistics);
+    double compression_seconds = benchmark_get_seconds() - start_time;
+
+    printf("compressed %i bones of %i keys in %.3f ms\n", bone_count, BENCHMARK_COMPRESSION_KEY_COUNT, compression_seconds * 1000.0);
+    printf("    tracks: %i (%i constant)\n", statistics.track_count, statistics.constant_track_count);
+    printf("    keys: %i -> %i\n", statistics.raw_key_count, statistics.compressed_key_count);
+    printf("    size: %zu -> %zu bytes (%.2fx)\n", statistics.raw_size, statistics.compressed_size, (double)statistics.raw_size / (double)statistics.compressed_size);
+    printf("    maximum error: %.6f units, %.6f radians, %.6f scale\n", statistics.maximum_position_error, statistics.maximum_rotation_error, statistics.maximum_scaling_error);
+
+    // Playback at 90 fps, three frames per key
+    printf("sampling %i frames:\n", BENCHMARK_COMPRESSION_FRAME_COUNT);
+
+    double raw_seconds = 0.0;
+    double compressed_seconds = 0.0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        animation_channel_cursors_initialize(cursors, bone_count);
+        start_time = benchmark_get_seconds();
+
+        for (int frame_index = 0; frame_index < BENCHMARK_COMPRESSION_FRAME_COUNT; frame_index++)
+        {
+            float time = fmodf((float)frame_index / 3.0f, animation.duration);
+
+            for (int bone_index = 0; bone_index < bone_count; bone_index++)
+            {
+                if (pass == 0)
+                    benchmark_sample_raw_channel(raw_channels + bone_index, time, cursors + bone_index, node_states + bone_index);
+                else
+                    animation_channel_sample(&animation, animation.channels + bone_index, time, cursors + bone_index, node_states + bone_index);
+            }
+
+            benchmark_compression_sink += node_states[frame_index % bone_count].rotation[0];
+        }
+
+        double seconds = (benchmark_get_seconds() - start_time) / (double)BENCHMARK_COMPRESSION_FRAME_COUNT;
+        *(pass == 0 ? &raw_seconds : &compressed_seconds) = seconds;
+    }
+
+    printf("    raw:        %8.3f us/frame\n", raw_seconds * 1000000.0);
+    printf("    compressed: %8.3f us/frame (%.2fx)\n", compressed_seconds * 1000000.0, raw_seconds / compressed_seconds);
+
+    for (int bone_index = 0; bone_index < bone_count; bone_index++)
+    {
+        struct animation_channel *channel = animation.channels + bone_index;
+
+        animation_raw_channel_dispose(raw_channels + bone_index);
+
+        free(channel->position_key_times);
+        free(channel->position_key_values);
+        free(channel->rotation_key_times);
+        free(channel->rotation_key_values);
+        free(channel->scaling_key_times);
+        free(channel->scaling_key_values);
+    }
+
+    free(animation.channels);
+    free(raw_channels);
+    free(cursors);
+    free(node_states);
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*
+BENCHMARK_ANIMATION_KEYS.C
+    Animation keyframe sampling benchmark.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common/common.h"
+#include "animations/animation_keys.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_KEY_COUNT = 4096,
+    BENCHMARK_CHANNEL_COUNT = 64,
+
+    // Playback advances roughly a third of a key per frame, like a 30 Hz clip played at 90 fps
+    BENCHMARK_FRAMES_PER_KEY = 3,
+};
+
+/* ---------- private types */
+
+// The interleaved layout keys were stored in before times were split out
+struct benchmark_interleaved_key
+{
+    float time;
+    float position[3];
+};
+
+struct benchmark_channel
+{
+    struct benchmark_interleaved_key *interleaved_keys;
+    float *key_times;
+    float (*key_values)[3];
+    int cursor;
+};
+
+/* ---------- private variables */
+
+static volatile float benchmark_sample_sink;
+
+/* ---------- private code */
+
+static inline void benchmark_sample_lerp(
+    const float *a,
+    const float *b,
+    float factor)
+{
+    benchmark_sample_sink += a[0] + ((b[0] - a[0]) * factor) + a[1] + a[2];
+}
+
+static void benchmark_sample_linear(
+    struct benchmark_channel *channel,
+    int key_count,
+    float time)
+{
+    // Scan from the first key every time, as the animation manager used to
+    int key_index = 0;
+
+    while (key_index < key_count - 2 && time >= channel->interleaved_keys[key_index + 1].time)
+        key_index++;
+
+    struct benchmark_interleaved_key *key = channel->interleaved_keys + key_index;
+    struct benchmark_interleaved_key *next_key = key + 1;
+
+    float factor = (time - key->time) / (next_key->time - key->time);
+    benchmark_sample_lerp(key->position, next_key->position, factor);
+}
+
+static void benchmark_sample_search(
+    struct benchmark_channel *channel,
+    int key_count,
+    float time)
+{
+    int key_index = animation_keys_search(channel->key_times, key_count, time);
+    float factor = animation_keys_get_interpolation_factor(channel->key_times, key_count, key_index, time);
+
+    benchmark_sample_lerp(channel->key_values[key_index], channel->key_values[key_index + 1], factor);
+}
+
+static void benchmark_sample_cursor(
+    struct benchmark_channel *channel,
+    int key_count,
+    float time)
+{
+    int key_index = animation_keys_find(channel->key_times, key_count, time, &channel->cursor);
+    float factor = animation_keys_get_interpolation_factor(channel->key_times, key_count, key_index, time);
+
+    benchmark_sample_lerp(channel->key_values[key_index], channel->key_values[key_index + 1], factor);
+}
+
+static double benchmark_run(
+    const char *name,
+    void (*sample)(struct benchmark_channel *, int, float),
+    struct benchmark_channel *channels,
+    int key_count,
+    const float *frame_times,
+    int frame_count)
+{
+    for (int channel_index = 0; channel_index < BENCHMARK_CHANNEL_COUNT; channel_index++)
+        channels[channel_index].cursor = 0;
+
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < frame_count; frame_index++)
+    {
+        for (int channel_index = 0; channel_index < BENCHMARK_CHANNEL_COUNT; channel_index++)
+            sample(channels + channel_index, key_count, frame_times[frame_index]);
+    }
+
+    double seconds = benchmark_get_seconds() - start_time;
+    int sample_count = frame_count * BENCHMARK_CHANNEL_COUNT;
+
+    printf("%-28s %10.3f ms %10.2f ns/sample\n", name, seconds * 1000.0, (seconds * 1000000000.0) / (double)sample_count);
+
+    return seconds;
+}
+
+/* ---------- public code */
+
+int benchmark_animation_keys_execute(
+    int argc,
+    const char **argv)
+{
+    int key_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_KEY_COUNT;
+    assert(key_count >= 2);
+
+    srand(1);
+
+    struct benchmark_channel channels[BENCHMARK_CHANNEL_COUNT];
+
+    for (int channel_index = 0; channel_index < BENCHMARK_CHANNEL_COUNT; channel_index++)
+    {
+        struct benchmark_channel *channel = channels + channel_index;
+
+        channel->interleaved_keys = malloc(key_count * sizeof(*channel->interleaved_keys));
+        channel->key_times = malloc(key_count * sizeof(*channel->key_times));
+        channel->key_values = malloc(key_count * sizeof(*channel->key_values));
+        assert(channel->interleaved_keys && channel->key_times && channel->key_values);
+
+        // Unevenly spaced keys, as exported clips with reduced keys tend to be
+        float time = 0.0f;
+
+        for (int key_index = 0; key_index < key_count; key_index++)
+        {
+            float value = (float)rand() / (float)RAND_MAX;
+
+            channel->interleaved_keys[key_index] = (struct benchmark_interleaved_key){ time, { value, value, value } };
+            channel->key_times[key_index] = time;
+            channel->key_values[key_index][0] = value;
+            channel->key_values[key_index][1] = value;
+            channel->key_values[key_index][2] = value;
+
+            time += 0.5f + ((float)rand() / (float)RAND_MAX);
+        }
+    }
+
+    // Channels end at slightly different times; sampling past a channel's last key clamps to its last interval
+    float duration = channels[0].key_times[key_count - 1];
+    int frame_count = key_count * BENCHMARK_FRAMES_PER_KEY;
+
+    float *playback_times = malloc(frame_count * sizeof(*playback_times));
+    float *seek_times = malloc(frame_count * sizeof(*seek_times));
+    assert(playback_times && seek_times);
+
+    for (int frame_index = 0; frame_index < frame_count; frame_index++)
+    {
+        playback_times[frame_index] = (duration * (float)frame_index) / (float)frame_count;
+        seek_times[frame_index] = duration * ((float)rand() / (float)RAND_MAX);
+    }
+
+    printf("sampling %i channels of %i keys over %i frames\n", BENCHMARK_CHANNEL_COUNT, key_count, frame_count);
+
+    printf("forward playback:\n");
+    double linear_seconds = benchmark_run("    linear scan", benchmark_sample_linear, channels, key_count, playback_times, frame_count);
+    benchmark_run("    binary search", benchmark_sample_search, channels, key_count, playback_times, frame_count);
+    double cursor_seconds = benchmark_run("    cursor", benchmark_sample_cursor, channels, key_count, playback_times, frame_count);
+
+    printf("random seeking:\n");
+    benchmark_run("    linear scan", benchmark_sample_linear, channels, key_count, seek_times, frame_count);
+    benchmark_run("    binary search", benchmark_sample_search, channels, key_count, seek_times, frame_count);
+    benchmark_run("    cursor", benchmark_sample_cursor, channels, key_count, seek_times, frame_count);
+
+    printf("cursor playback speedup over linear scan: %.1fx\n", linear_seconds / cursor_seconds);
+
+    for (int channel_index = 0; channel_index < BENCHMARK_CHANNEL_COUNT; channel_index++)
+    {
+        free(channels[channel_index].interleaved_keys);
+        free(channels[channel_index].key_times);
+        free(channels[channel_index].key_values);
+    }
+
+    free(playback_times);
+    free(seek_times);
+
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*
+BENCHMARK_ANIMATION_MORPHS.C
+    Morph target evaluation benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_morphs.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    BENCHMARK_MORPH_FRAME_COUNT = 32,
+
+    // A head mesh whose face region sits in the middle of its vertices, with a facial rig's worth of targets
+    BENCHMARK_MORPH_VERTEX_COUNT = 8000,
+    BENCHMARK_MORPH_FACE_VERTEX_START = 2500,
+    BENCHMARK_MORPH_FACE_VERTEX_COUNT = 3000,
+    BENCHMARK_MORPH_TARGET_COUNT = 52,
+};
+
+static const int benchmark_morph_face_counts[] = { 64, 256, 1024 };
+
+#define BENCHMARK_MORPH_PI 3.14159265f
+
+/* ---------- private types */
+
+// The same layout as the game's rigid vertices
+struct benchmark_morph_vertex
+{
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+    float tangent[3];
+    float bitangent[3];
+};
+
+struct benchmark_morph_mesh
+{
+    struct benchmark_morph_vertex *base_vertices;
+
+    // Every target's deltas for every vertex, interleaved position and normal, as they were stored before
+    float (*dense_deltas)[BENCHMARK_MORPH_VERTEX_COUNT][NUMBER_OF_ANIMATION_MORPH_COMPONENTS];
+
+    struct animation_morph_set set;
+};
+
+struct benchmark_morph_face
+{
+    struct benchmark_morph_vertex *vertices;
+    struct animation_morph_accumulator accumulator;
+    float weights[BENCHMARK_MORPH_TARGET_COUNT];
+};
+
+/* ---------- private variables */
+
+static volatile float benchmark_morph_sink;
+
+/* ---------- private code */
+
+static void benchmark_morph_mesh_initialize(
+    struct benchmark_morph_mesh *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+
+    mesh->base_vertices = calloc(BENCHMARK_MORPH_VERTEX_COUNT, sizeof(*mesh->base_vertices));
+    mesh->dense_deltas = calloc(BENCHMARK_MORPH_TARGET_COUNT, sizeof(*mesh->dense_deltas));
+    assert(mesh->base_vertices && mesh->dense_deltas);
+
+    for (int vertex_index = 0; vertex_index < BENCHMARK_MORPH_VERTEX_COUNT; vertex_index++)
+    {
+        struct benchmark_morph_vertex *vertex = mesh->base_vertices + vertex_index;
+
+        float angle = (2.0f * BENCHMARK_MORPH_PI * (float)vertex_index) / (float)BENCHMARK_MORPH_VERTEX_COUNT;
+
+        vertex->position[0] = cosf(angle);
+        vertex->position[1] = sinf(angle * 7.0f) * 0.5f;
+        vertex->position[2] = sinf(angle);
+
+        vertex->normal[0] = cosf(angle);
+        vertex->normal[2] = sinf(angle);
+    }
+
+    float *position_deltas[BENCHMARK_MORPH_TARGET_COUNT];
+    float *normal_deltas[BENCHMARK_MORPH_TARGET_COUNT];
+
+    for (int target_index = 0; target_index < BENCHMARK_MORPH_TARGET_COUNT; target_index++)
+    {
+        position_deltas[target_index] = calloc(BENCHMARK_MORPH_VERTEX_COUNT * 3, sizeof(float));
+        normal_deltas[target_index] = calloc(BENCHMARK_MORPH_VERTEX_COUNT * 3, sizeof(float));
+        assert(position_deltas[target_index] && normal_deltas[target_index]);
+
+        // Each target moves one cluster of the face, fading out towards its edge
+        int radius = 40 + (rand() % 160);
+        int center = BENCHMARK_MORPH_FACE_VERTEX_START + radius + (rand() % (BENCHMARK_MORPH_FACE_VERTEX_COUNT - (2 * radius)));
+        float direction[3] = { benchmark_random() - 0.5f, benchmark_random() - 0.5f, benchmark_random() - 0.5f };
+
+        for (int vertex_index = center - radius; vertex_index < center + radius; vertex_index++)
+        {
+            float falloff = 1.0f - (fabsf((float)(vertex_index - center)) / (float)radius);
+
+            for (int i = 0; i < 3; i++)
+            {
+                position_deltas[target_index][(vertex_index * 3) + i] = direction[i] * falloff * 0.05f;
+                normal_deltas[target_index][(vertex_index * 3) + i] = direction[i] * falloff * 0.2f;
+
+                mesh->dense_deltas[target_index][vertex_index][i] = position_deltas[target_index][(vertex_index * 3) + i];
+                mesh->dense_deltas[target_index][vertex_index][i + 3] = normal_deltas[target_index][(vertex_index * 3) + i];
+            }
+        }
+    }
+
+    animation_morph_set_build(&mesh->set, BENCHMARK_MORPH_VERTEX_COUNT, BENCHMARK_MORPH_TARGET_COUNT, (const float *const *)position_deltas, (const float *const *)normal_deltas);
+
+    for (int target_index = 0; target_index < BENCHMARK_MORPH_TARGET_COUNT; target_index++)
+    {
+        free(position_deltas[target_index]);
+        free(normal_deltas[target_index]);
+    }
+}
+
+static void benchmark_morph_mesh_dispose(
+    struct benchmark_morph_mesh *mesh)
+{
+    free(mesh->base_vertices);
+    free(mesh->dense_deltas);
+    animation_morph_set_dispose(&mesh->set);
+}
+
+static void benchmark_morph_faces_initialize(
+    struct benchmark_morph_face *faces,
+    int face_count,
+    struct benchmark_morph_mesh *mesh)
+{
+    for (int face_index = 0; face_index < face_count; face_index++)
+    {
+        struct benchmark_morph_face *face = faces + face_index;
+
+        face->vertices = malloc(BENCHMARK_MORPH_VERTEX_COUNT * sizeof(*face->vertices));
+        assert(face->vertices);
+        memcpy(face->vertices, mesh->base_vertices, BENCHMARK_MORPH_VERTEX_COUNT * sizeof(*face->vertices));
+
+        animation_morph_accumulator_initialize(&face->accumulator, &mesh->set);
+    }
+}
+
+static void benchmark_morph_faces_dispose(
+    struct benchmark_morph_face *faces,
+    int face_count)
+{
+    for (int face_index = 0; face_index < face_count; face_index++)
+    {
+        free(faces[face_index].vertices);
+        animation_morph_accumulator_dispose(&faces[face_index].accumulator);
+    }
+}
+
+static void benchmark_morph_set_weights(
+    struct benchmark_morph_face *face,
+    int face_index,
+    int frame_index)
+{
+    // Each face talks through its own phase, with about a fifth of its targets weighted at any moment
+    for (int target_index = 0; target_index < BENCHMARK_MORPH_TARGET_COUNT; target_index++)
+    {
+        float phase = (float)((face_index * 7) + (target_index * 13)) * 0.37f;
+        float weight = sinf(phase + ((float)frame_index * 0.2f)) - 0.8f;
+
+        face->weights[target_index] = weight > 0.0f ? weight * 5.0f : 0.0f;
+    }
+}
+
+static size_t benchmark_morph_dense(
+    struct benchmark_morph_mesh *mesh,
+    struct benchmark_morph_face *face)
+{
+    // Restore the base mesh, add every weighted target over every vertex, renormalize and upload it all
+    memcpy(face->vertices, mesh->base_vertices, BENCHMARK_MORPH_VERTEX_COUNT * sizeof(*face->vertices));
+
+    for (int target_index = 0; target_index < BENCHMARK_MORPH_TARGET_COUNT; target_index++)
+    {
+        float weight = face->weights[target_index];
+
+        if (weight == 0.0f)
+            continue;
+
+        for (int vertex_index = 0; vertex_index < BENCHMARK_MORPH_VERTEX_COUNT; vertex_index++)
+        {
+            const float *delta = mesh->dense_deltas[target_index][vertex_index];
+            struct benchmark_morph_vertex *vertex = face->vertices + vertex_index;
+
+            for (int i = 0; i < 3; i++)
+            {
+                vertex->position[i] += delta[i] * weight;
+                vertex->normal[i] += delta[i + 3] * weight;
+            }
+        }
+    }
+
+    for (int vertex_index = 0; vertex_index < BENCHMARK_MORPH_VERTEX_COUNT; vertex_index++)
+    {
+        float *normal = face->vertices[vertex_index].normal;
+        float length = sqrtf((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+
+        if (length > 0.0f)
+        {
+            for (int i = 0; i < 3; i++)
+                normal[i] /= length;
+        }
+    }
+
+    benchmark_morph_sink += face->vertices[BENCHMARK_MORPH_FACE_VERTEX_START].position[0];
+
+    return BENCHMARK_MORPH_VERTEX_COUNT * sizeof(*face->vertices);
+}
+
+static size_t benchmark_morph_sparse(
+    struct benchmark_morph_mesh *mesh,
+    struct benchmark_morph_face *face)
+{
+    int vertex_start;
+    int vertex_end;
+
+    if (!animation_morph_accumulate(&mesh->set, face->weights, &face->accumulator, &vertex_start, &vertex_end))
+        return 0;
+
+    int first_vertex;
+    int vertex_count;
+
+    animation_morph_apply(
+        &mesh->set,
+        &face->accumulator,
+        vertex_start,
+        vertex_end,
+        mesh->base_vertices,
+        face->vertices,
+        sizeof(*face->vertices),
+        offsetof(struct benchmark_morph_vertex, position),
+        offsetof(struct benchmark_morph_vertex, normal),
+        &first_vertex,
+        &vertex_count);
+
+    benchmark_morph_sink += face->vertices[BENCHMARK_MORPH_FACE_VERTEX_START].position[0];
+
+    return vertex_count * sizeof(*face->vertices);
+}
+
+static double benchmark_run(
+    struct benchmark_morph_mesh *mesh,
+    struct benchmark_morph_face *faces,
+    int face_count,
+    size_t (*morph)(struct benchmark_morph_mesh *, struct benchmark_morph_face *),
+    double *out_upload_bytes)
+{
+    double upload_bytes = 0.0;
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < BENCHMARK_MORPH_FRAME_COUNT; frame_index++)
+    {
+        for (int face_index = 0; face_index < face_count; face_index++)
+        {
+            benchmark_morph_set_weights(faces + face_index, face_index, frame_index);
+            upload_bytes += (double)morph(mesh, faces + face_index);
+        }
+    }
+
+    double seconds = benchmark_get_seconds() - start_time;
+
+    *out_upload_bytes = upload_bytes / (double)(BENCHMARK_MORPH_FRAME_COUNT * face_count);
+
+    return seconds / (double)BENCHMARK_MORPH_FRAME_COUNT;
+}
+
+static float benchmark_morph_get_maximum_error(
+    struct benchmark_morph_face *a,
+    struct benchmark_morph_face *b)
+{
+    float maximum_error = 0.0f;
+
+    for (int vertex_index = 0; vertex_index < BENCHMARK_MORPH_VERTEX_COUNT; vertex_index++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            maximum_error = fmaxf(maximum_error, fabsf(a->vertices[vertex_index].position[i] - b->vertices[vertex_index].position[i]));
+            maximum_error = fmaxf(maximum_error, fabsf(a->vertices[vertex_index].normal[i] - b->vertices[vertex_index].normal[i]));
+        }
+    }
+
+    return maximum_error;
+}
+
+/* ---------- public code */
+
+int benchmark_animation_morphs_execute(
+    int argc,
+    const char **argv)
+{
+    int face_count = argc > 0 ? atoi(argv[0]) : 0;
+    assert(face_count >= 0);
+
+    srand(1);
+
+    struct benchmark_morph_mesh mesh;
+    benchmark_morph_mesh_initialize(&mesh);
+
+    size_t dense_size = sizeof(*mesh.dense_deltas) * BENCHMARK_MORPH_TARGET_COUNT;
+    size_t sparse_size = animation_morph_set_get_size(&mesh.set);
+
+    printf("%i vertices, %i targets: dense %zu bytes, sparse %zu bytes over %i vertices (%.1fx smaller)\n",
+        BENCHMARK_MORPH_VERTEX_COUNT,
+        BENCHMARK_MORPH_TARGET_COUNT,
+        dense_size,
+        sparse_size,
+        mesh.set.vertex_count,
+        (double)dense_size / (double)sparse_size);
+
+    printf("%i frames per face count\n", BENCHMARK_MORPH_FRAME_COUNT);
+    printf("%8s %18s %18s %10s %16s %16s %10s\n", "faces", "dense", "sparse", "speedup", "dense upload", "sparse upload", "error");
+
+    for (int count_index = 0; count_index < (int)NUMBER_OF(benchmark_morph_face_counts); count_index++)
+    {
+        int run_face_count = face_count ? face_count : benchmark_morph_face_counts[count_index];
+
+        struct benchmark_morph_face *dense_faces = calloc(run_face_count, sizeof(*dense_faces));
+        struct benchmark_morph_face *sparse_faces = calloc(run_face_count, sizeof(*sparse_faces));
+        assert(dense_faces && sparse_faces);
+
+        benchmark_morph_faces_initialize(dense_faces, run_face_count, &mesh);
+        benchmark_morph_faces_initialize(sparse_faces, run_face_count, &mesh);
+
+        double dense_upload_bytes;
+        double sparse_upload_bytes;
+        double dense_seconds = benchmark_run(&mesh, dense_faces, run_face_count, benchmark_morph_dense, &dense_upload_bytes);
+        double sparse_seconds = benchmark_run(&mesh, sparse_faces, run_face_count, benchmark_morph_sparse, &sparse_upload_bytes);
+
+        // Both ran the same weights, so every face should have come out the same
+        float maximum_error = 0.0f;
+
+        for (int face_index = 0; face_index < run_face_count; face_index++)
+            maximum_error = fmaxf(maximum_error, benchmark_morph_get_maximum_error(dense_faces + face_index, sparse_faces + face_index));
+
+        printf("%8i %12.3f ms/fr %12.3f ms/fr %9.2fx %10.0f B/face %10.0f B/face %10.2g\n",
+            run_face_count,
+            dense_seconds * 1000.0,
+            sparse_seconds * 1000.0,
+            dense_seconds / sparse_seconds,
+            dense_upload_bytes,
+            sparse_upload_bytes,
+            maximum_error);
+
+        benchmark_morph_faces_dispose(dense_faces, run_face_count);
+        benchmark_morph_faces_dispose(sparse_faces, run_face_count);
+        free(dense_faces);
+        free(sparse_faces);
+
+        if (face_count)
+            break;
+    }
+
+    benchmark_morph_mesh_dispose(&mesh);
+
+    return 0;
+}
@@ -0,0 +1,368 @@
+/*
+BENCHMARK_ANIMATION_POSES.C
+    Animation pose evaluation benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "animations/animation_compression.h"
+#include "animations/animation_poses.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    BENCHMARK_POSE_KEY_COUNT = 64,
+    BENCHMARK_POSE_FRAME_COUNT = 2000,
+
+    // One in this many nodes has no channel and keeps its default state
+    BENCHMARK_POSE_UNANIMATED_NODE_INTERVAL = 8,
+};
+
+static const int benchmark_pose_node_counts[] = { 32, 64, 128, 256 };
+
+/* ---------- private types */
+
+struct benchmark_skeleton
+{
+    int node_count;
+    struct animation_node_state *default_node_states;
+    struct animation_pose_buffer default_pose;
+    struct animation_data animation;
+
+    struct animation_channel_cursor *cursors;
+    struct animation_node_state *node_states;
+    struct animation_pose_buffer pose;
+    float (*local_matrices)[4][4];
+};
+
+/* ---------- private variables */
+
+static volatile float benchmark_pose_sink;
+
+/* ---------- private code */
+
+static void benchmark_random_quaternion(
+    float *out_quaternion)
+{
+    float length_squared = 0.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        out_quaternion[i] = (benchmark_random() * 2.0f) - 1.0f;
+        length_squared += out_quaternion[i] * out_quaternion[i];
+    }
+
+    for (int i = 0; i < 4; i++)
+        out_quaternion[i] /= sqrtf(length_squared);
+}
+
+static void benchmark_skeleton_initialize(
+    struct benchmark_skeleton *skeleton,
+    int node_count)
+{
+    memset(skeleton, 0, sizeof(*skeleton));
+
+    skeleton->node_count = node_count;
+    skeleton->default_node_states = calloc(node_count, sizeof(*skeleton->default_node_states));
+    skeleton->cursors = calloc(node_count, sizeof(*skeleton->cursors));
+    skeleton->node_states = calloc(node_count, sizeof(*skeleton->node_states));
+    skeleton->local_matrices = calloc(node_count, sizeof(*skeleton->local_matrices));
+    skeleton->animation.node_channel_indices = malloc(node_count * sizeof(*skeleton->animation.node_channel_indices));
+    skeleton->animation.channels = calloc(node_count, sizeof(*skeleton->animation.channels));
+
+    struct animation_raw_channel *raw_channels = calloc(node_count, sizeof(*raw_channels));
+    assert(raw_channels);
+    assert(skeleton->default_node_states && skeleton->cursors && skeleton->node_states && skeleton->local_matrices);
+    assert(skeleton->animation.node_channel_indices && skeleton->animation.channels);
+
+    animation_pose_buffer_initialize(&skeleton->default_pose, node_count, NULL);
+    animation_pose_buffer_initialize(&skeleton->pose, node_count, NULL);
+
+    skeleton->animation.duration = (float)(BENCHMARK_POSE_KEY_COUNT - 1);
+    skeleton->animation.ticks_per_second = 30.0f;
+
+    for (int node_index = 0; node_index < node_count; node_index++)
+    {
+        struct animation_node_state *default_node_state = skeleton->default_node_states + node_index;
+        benchmark_random_quaternion(default_node_state->rotation);
+        default_node_state->position[1] = 1.0f;
+        default_node_state->scale[0] = default_node_state->scale[1] = default_node_state->scale[2] = 1.0f;
+        animation_pose_buffer_set_node_state(&skeleton->default_pose, node_index, default_node_state);
+
+        if (node_index % BENCHMARK_POSE_UNANIMATED_NODE_INTERVAL == BENCHMARK_POSE_UNANIMATED_NODE_INTERVAL - 1)
+        {
+            skeleton->animation.node_channel_indices[node_index] = -1;
+            continue;
+        }
+
+        int channel_index = skeleton->animation.channel_count++;
+        skeleton->animation.node_channel_indices[node_index] = channel_index;
+
+        struct animation_channel *channel = skeleton->animation.channels + channel_index;
+        channel->type = _animation_channel_type_node;
+        channel->node_index = node_index;
+
+        struct animation_raw_channel *raw_channel = raw_channels + channel_index;
+        animation_raw_channel_initialize(raw_channel, BENCHMARK_POSE_KEY_COUNT, BENCHMARK_POSE_KEY_COUNT, BENCHMARK_POSE_KEY_COUNT);
+
+        for (int key_index = 0; key_index < BENCHMARK_POSE_KEY_COUNT; key_index++)
+        {
+            raw_channel->position_key_times[key_index] = (float)key_index;
+            raw_channel->rotation_key_times[key_index] = (float)key_index;
+            raw_channel->scaling_key_times[key_index] = (float)key_index;
+
+            for (int i = 0; i < 3; i++)
+            {
+                raw_channel->position_key_values[key_index][i] = benchmark_random();
+                raw_channel->scaling_key_values[key_index][i] = 1.0f;
+            }
+
+            benchmark_random_quaternion(raw_channel->rotation_key_values[key_index]);
+        }
+    }
+
+    animation_compress(&skeleton->animation, raw_channels, NULL, NULL);
+
+    for (int channel_index = 0; channel_index < skeleton->animation.channel_count; channel_index++)
+        animation_raw_channel_dispose(raw_channels + channel_index);
+
+    free(raw_channels);
+}
+
+static void benchmark_skeleton_dispose(
+    struct benchmark_skeleton *skeleton)
+{
+    for (int channel_index = 0; channel_index < skeleton->animation.channel_count; channel_index++)
+    {
+        struct animation_channel *channel = skeleton->animation.channels + channel_index;
+        free(channel->position_key_times);
+        free(channel->position_key_values);
+        free(channel->rotation_key_times);
+        free(channel->rotation_key_values);
+        free(channel->scaling_key_times);
+        free(channel->scaling_key_values);
+    }
+
+    free(skeleton->animation.channels);
+    free(skeleton->animation.node_channel_indices);
+    free(skeleton->default_node_states);
+    animation_pose_buffer_dispose(&skeleton->default_pose);
+    animation_pose_buffer_dispose(&skeleton->pose);
+    free(skeleton->cursors);
+    free(skeleton->node_states);
+    free(skeleton->local_matrices);
+}
+
+static void benchmark_matrix_identity(
+    float out_matrix[4][4])
+{
+    memset(out_matrix, 0, sizeof(float[4][4]));
+    out_matrix[0][0] = out_matrix[1][1] = out_matrix[2][2] = out_matrix[3][3] = 1.0f;
+}
+
+static void benchmark_matrix_multiply(
+    float a[4][4],
+    float b[4][4],
+    float out_matrix[4][4])
+{
+    float result[4][4];
+
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            result[column][row] =
+                (a[0][row] * b[column][0]) +
+                (a[1][row] * b[column][1]) +
+                (a[2][row] * b[column][2]) +
+                (a[3][row] * b[column][3]);
+        }
+    }
+
+    memcpy(out_matrix, result, sizeof(result));
+}
+
+static void benchmark_matrix_to_quaternion(
+    float m[4][4],
+    float *out_quaternion)
+{
+    float trace = m[0][0] + m[1][1] + m[2][2];
+
+    if (trace > 0.0f)
+    {
+        float r = sqrtf(1.0f + trace);
+        float inverse_r = 0.5f / r;
+        out_quaternion[0] = (m[1][2] - m[2][1]) * inverse_r;
+        out_quaternion[1] = (m[2][0] - m[0][2]) * inverse_r;
+        out_quaternion[2] = (m[0][1] - m[1][0]) * inverse_r;
+        out_quaternion[3] = 0.5f * r;
+    }
+    else if (m[0][0] >= m[1][1] && m[0][0] >= m[2][2])
+    {
+        float r = sqrtf(1.0f - m[1][1] - m[2][2] + m[0][0]);
+        float inverse_r = 0.5f / r;
+        out_quaternion[0] = 0.5f * r;
+        out_quaternion[1] = (m[0][1] + m[1][0]) * inverse_r;
+        out_quaternion[2] = (m[0][2] + m[2][0]) * inverse_r;
+        out_quaternion[3] = (m[1][2] - m[2][1]) * inverse_r;
+    }
+    else if (m[1][1] >= m[2][2])
+    {
+        float r = sqrtf(1.0f - m[0][0] - m[2][2] + m[1][1]);
+        float inverse_r = 0.5f / r;
+        out_quaternion[0] = (m[0][1] + m[1][0]) * inverse_r;
+        out_quaternion[1] = 0.5f * r;
+        out_quaternion[2] = (m[1][2] + m[2][1]) * inverse_r;
+        out_quaternion[3] = (m[2][0] - m[0][2]) * inverse_r;
+    }
+    else
+    {
+        float r = sqrtf(1.0f - m[0][0] - m[1][1] + m[2][2]);
+        float inverse_r = 0.5f / r;
+        out_quaternion[0] = (m[0][2] + m[2][0]) * inverse_r;
+        out_quaternion[1] = (m[1][2] + m[2][1]) * inverse_r;
+        out_quaternion[2] = 0.5f * r;
+        out_quaternion[3] = (m[0][1] - m[1][0]) * inverse_r;
+    }
+}
+
+static void benchmark_node_state_to_matrices(
+    const struct animation_node_state *node_state,
+    float out_position_matrix[4][4],
+    float out_rotation_matrix[4][4],
+    float out_scaling_matrix[4][4])
+{
+    struct animation_node_state rotation_only = *node_state;
+    memset(rotation_only.position, 0, sizeof(rotation_only.position));
+    rotation_only.scale[0] = rotation_only.scale[1] = rotation_only.scale[2] = 1.0f;
+    animation_node_state_to_matrix(&rotation_only, out_rotation_matrix);
+
+    benchmark_matrix_identity(out_position_matrix);
+    out_position_matrix[3][0] = node_state->position[0];
+    out_position_matrix[3][1] = node_state->position[1];
+    out_position_matrix[3][2] = node_state->position[2];
+
+    benchmark_matrix_identity(out_scaling_matrix);
+    out_scaling_matrix[0][0] = node_state->scale[0];
+    out_scaling_matrix[1][1] = node_state->scale[1];
+    out_scaling_matrix[2][2] = node_state->scale[2];
+}
+
+static void benchmark_evaluate_matrix_round_trip(
+    struct benchmark_skeleton *skeleton,
+    float time)
+{
+    // The pipeline before poses stayed in TRS form: compose three matrices per node, decompose them back
+    // into a node state, then compose three matrices again once the pose is blended
+    for (int node_index = 0; node_index < skeleton->node_count; node_index++)
+    {
+        struct animation_node_state *node_state = skeleton->node_states + node_index;
+        *node_state = skeleton->default_node_states[node_index];
+
+        int channel_index = skeleton->animation.node_channel_indices[node_index];
+
+        if (channel_index != -1)
+        {
+            animation_channel_sample(&skeleton->animation, skeleton->animation.channels + channel_index, time, skeleton->cursors + node_index, node_state);
+
+            float position_matrix[4][4], rotation_matrix[4][4], scaling_matrix[4][4], local_matrix[4][4];
+            benchmark_node_state_to_matrices(node_state, position_matrix, rotation_matrix, scaling_matrix);
+            benchmark_matrix_multiply(rotation_matrix, scaling_matrix, local_matrix);
+            benchmark_matrix_multiply(position_matrix, local_matrix, local_matrix);
+
+            for (int i = 0; i < 3; i++)
+            {
+                node_state->position[i] = local_matrix[3][i];
+
+                float length = sqrtf(
+                    (local_matrix[i][0] * local_matrix[i][0]) +
+                    (local_matrix[i][1] * local_matrix[i][1]) +
+                    (local_matrix[i][2] * local_matrix[i][2]));
+
+                node_state->scale[i] = length;
+
+                for (int j = 0; j < 3; j++)
+                    rotation_matrix[i][j] = local_matrix[i][j] / length;
+            }
+
+            benchmark_matrix_to_quaternion(rotation_matrix, node_state->rotation);
+        }
+
+        float position_matrix[4][4], rotation_matrix[4][4], scaling_matrix[4][4];
+        benchmark_node_state_to_matrices(node_state, position_matrix, rotation_matrix, scaling_matrix);
+        benchmark_matrix_multiply(position_matrix, rotation_matrix, skeleton->local_matrices[node_index]);
+        benchmark_matrix_multiply(skeleton->local_matrices[node_index], scaling_matrix, skeleton->local_matrices[node_index]);
+    }
+}
+
+static void benchmark_evaluate_trs(
+    struct benchmark_skeleton *skeleton,
+    float time)
+{
+    animation_sample_pose(&skeleton->animation, &skeleton->default_pose, time, skeleton->cursors, NULL, &skeleton->pose);
+    animation_pose_buffer_to_matrices(&skeleton->pose, skeleton->local_matrices);
+}
+
+static double benchmark_run(
+    struct benchmark_skeleton *skeleton,
+    void (*evaluate)(struct benchmark_skeleton *, float))
+{
+    animation_channel_cursors_initialize(skeleton->cursors, skeleton->node_count);
+
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < BENCHMARK_POSE_FRAME_COUNT; frame_index++)
+    {
+        float time = fmodf((float)frame_index * 0.25f, skeleton->animation.duration);
+        evaluate(skeleton, time);
+        benchmark_pose_sink += skeleton->local_matrices[frame_index % skeleton->node_count][3][0];
+    }
+
+    return (benchmark_get_seconds() - start_time) / (double)BENCHMARK_POSE_FRAME_COUNT;
+}
+
+/* ---------- public code */
+
+int benchmark_animation_poses_execute(
+    int argc,
+    const char **argv)
+{
+    int node_count = argc > 0 ? atoi(argv[0]) : 0;
+    assert(node_count >= 0);
+
+    srand(1);
+
+    printf("evaluating one clip of %i keys per channel, %i frames per skeleton size\n", BENCHMARK_POSE_KEY_COUNT, BENCHMARK_POSE_FRAME_COUNT);
+    printf("%8s %22s %22s %10s\n", "nodes", "matrix round trip", "trs", "speedup");
+
+    for (int size_index = 0; size_index < (int)NUMBER_OF(benchmark_pose_node_counts); size_index++)
+    {
+        int skeleton_node_count = node_count ? node_count : benchmark_pose_node_counts[size_index];
+
+        struct benchmark_skeleton skeleton;
+        benchmark_skeleton_initialize(&skeleton, skeleton_node_count);
+
+        double round_trip_seconds = benchmark_run(&skeleton, benchmark_evaluate_matrix_round_trip);
+        double trs_seconds = benchmark_run(&skeleton, benchmark_evaluate_trs);
+
+        printf("%8i %16.3f us/skel %16.3f us/skel %9.2fx\n",
+            skeleton_node_count,
+            round_trip_seconds * 1000000.0,
+            trs_seconds * 1000000.0,
+            round_trip_seconds / trs_seconds);
+
+        benchmark_skeleton_dispose(&skeleton);
+
+        if (node_count)
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,381 @@
+/*
+BENCHMARK_ANIMATION_UPDATE.C
+    Parallel animation update benchmark.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/common.h"
+#include "animations/animation_blending.h"
+#include "animations/animation_compression.h"
+#include "animations/animation_poses.h"
+#include "jobs/jobs.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    // A grunt-sized skeleton playing one looping clip
+    BENCHMARK_UPDATE_BONE_COUNT = 32,
+    BENCHMARK_UPDATE_KEY_COUNT = 61,
+    BENCHMARK_UPDATE_FRAME_COUNT = 30,
+
+    // Matches OBJECT_UPDATE_BATCH_SIZE in the game
+    BENCHMARK_UPDATE_BATCH_SIZE = 8,
+
+    // Matches ANIMATION_POSE_CACHE_BUCKETS_PER_SECOND in the game
+    BENCHMARK_UPDATE_BUCKETS_PER_SECOND = 30,
+};
+
+/* ---------- private types */
+
+// The per-object state an animation manager updates
+struct benchmark_instance
+{
+    float time;
+    struct animation_channel_cursor *cursors;
+    struct animation_pose_buffer pose;
+    struct animation_pose_buffer blended_pose;
+    float (*node_transforms)[4][4];
+};
+
+struct benchmark_update_context
+{
+    const struct animation_data *animation;
+    const struct animation_pose_buffer *default_pose;
+    const int *node_parent_indices;
+    struct benchmark_instance *instances;
+    float delta_ticks;
+};
+
+/* ---------- private code */
+
+static void benchmark_matrix_multiply(
+    const float a[4][4],
+    const float b[4][4],
+    float out_matrix[4][4])
+{
+    float result[4][4];
+
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+            result[column][row] = (a[0][row] * b[column][0]) + (a[1][row] * b[column][1]) + (a[2][row] * b[column][2]) + (a[3][row] * b[column][3]);
+    }
+
+    memcpy(out_matrix, result, sizeof(result));
+}
+
+static void benchmark_reset_instances(
+    struct benchmark_instance *instances,
+    int instance_count,
+    float duration)
+{
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        // Spread the instances over the clip, as a crowd would be
+        instances[instance_index].time = fmodf((float)instance_index * 7.31f, duration);
+        animation_channel_cursors_initialize(instances[instance_index].cursors, BENCHMARK_UPDATE_BONE_COUNT);
+    }
+}
+
+static void benchmark_evaluate_instance(
+    const struct benchmark_update_context *context,
+    struct benchmark_instance *instance,
+    float time)
+{
+    // The same work animation_manager_update does for an object with one active clip
+    animation_sample_pose(context->animation, context->default_pose, time, instance->cursors, NULL, &instance->pose);
+
+    struct animation_blend_layer layer = { &instance->pose, 1.0f, _animation_blend_mode_override };
+    animation_pose_blend(&layer, 1, context->default_pose, &instance->blended_pose);
+    animation_pose_buffer_to_matrices(&instance->blended_pose, instance->node_transforms);
+
+    for (int node_index = 0; node_index < BENCHMARK_UPDATE_BONE_COUNT; node_index++)
+    {
+        int parent_node_index = context->node_parent_indices[node_index];
+
+        if (parent_node_index != -1)
+            benchmark_matrix_multiply(instance->node_transforms[parent_node_index], instance->node_transforms[node_index], instance->node_transforms[node_index]);
+    }
+}
+
+static void benchmark_update_batch(
+    void *data,
+    int start_index,
+    int end_index)
+{
+    const struct benchmark_update_context *context = data;
+    const struct animation_data *animation = context->animation;
+
+    for (int instance_index = start_index; instance_index < end_index; instance_index++)
+    {
+        struct benchmark_instance *instance = context->instances + instance_index;
+
+        instance->time = fmodf(instance->time + (animation->ticks_per_second * context->delta_ticks), animation->duration);
+        benchmark_evaluate_instance(context, instance, instance->time);
+    }
+}
+
+static double benchmark_run_pose_cache(
+    const struct benchmark_update_context *context,
+    int instance_count,
+    int *out_evaluation_count)
+{
+    const struct animation_data *animation = context->animation;
+    float ticks_per_bucket = animation->ticks_per_second / (float)BENCHMARK_UPDATE_BUCKETS_PER_SECOND;
+    int bucket_count = (int)(animation->duration / ticks_per_bucket) + 1;
+
+    // The frame each bucket was last evaluated in, and the instance that evaluated it
+    int *bucket_frames = malloc(bucket_count * sizeof(*bucket_frames));
+    int *bucket_sources = malloc(bucket_count * sizeof(*bucket_sources));
+    const float (**shared_transforms)[4][4] = malloc(instance_count * sizeof(*shared_transforms));
+    assert(bucket_frames && bucket_sources && shared_transforms);
+
+    for (int bucket_index = 0; bucket_index < bucket_count; bucket_index++)
+        bucket_frames[bucket_index] = -1;
+
+    // Snap every desynchronization offset to a bucket, as animation_manager_set_sharing_poses does
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        struct benchmark_instance *instance = context->instances + instance_index;
+        instance->time = floorf(instance->time / ticks_per_bucket) * ticks_per_bucket;
+    }
+
+    int evaluation_count = 0;
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < BENCHMARK_UPDATE_FRAME_COUNT; frame_index++)
+    {
+        for (int instance_index = 0; instance_index < instance_count; instance_index++)
+        {
+            struct benchmark_instance *instance = context->instances + instance_index;
+
+            instance->time = fmodf(instance->time + (animation->ticks_per_second * context->delta_ticks), animation->duration);
+
+            int bucket_index = (int)floorf(instance->time / ticks_per_bucket);
+
+            if (bucket_frames[bucket_index] != frame_index)
+            {
+                bucket_frames[bucket_index] = frame_index;
+                bucket_sources[bucket_index] = instance_index;
+
+                benchmark_evaluate_instance(context, instance, fminf((float)bucket_index * ticks_per_bucket, animation->duration));
+                evaluation_count++;
+            }
+
+            shared_transforms[instance_index] = (const float (*)[4][4])context->instances[bucket_sources[bucket_index]].node_transforms;
+        }
+    }
+
+    double seconds = (benchmark_get_seconds() - start_time) / (double)BENCHMARK_UPDATE_FRAME_COUNT;
+
+    free(bucket_frames);
+    free(bucket_sources);
+    free(shared_transforms);
+
+    *out_evaluation_count = evaluation_count / BENCHMARK_UPDATE_FRAME_COUNT;
+
+    return seconds;
+}
+
+static unsigned int benchmark_hash_instances(
+    const struct benchmark_instance *instances,
+    int instance_count)
+{
+    unsigned int hash = 2166136261u;
+
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        const unsigned char *bytes = (const unsigned char *)instances[instance_index].node_transforms;
+
+        for (size_t i = 0; i < BENCHMARK_UPDATE_BONE_COUNT * sizeof(*instances->node_transforms); i++)
+            hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static void benchmark_run_instance_count(
+    struct benchmark_update_context *context,
+    int instance_count,
+    int maximum_worker_count)
+{
+    struct benchmark_instance *instances = calloc(instance_count, sizeof(*instances));
+    assert(instances);
+
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        struct benchmark_instance *instance = instances + instance_index;
+
+        instance->cursors = malloc(BENCHMARK_UPDATE_BONE_COUNT * sizeof(*instance->cursors));
+        instance->node_transforms = malloc(BENCHMARK_UPDATE_BONE_COUNT * sizeof(*instance->node_transforms));
+        assert(instance->cursors && instance->node_transforms);
+
+        animation_pose_buffer_initialize(&instance->pose, BENCHMARK_UPDATE_BONE_COUNT, NULL);
+        animation_pose_buffer_initialize(&instance->blended_pose, BENCHMARK_UPDATE_BONE_COUNT, NULL);
+    }
+
+    context->instances = instances;
+
+    printf("%i instances of %i bones over %i frames:\n", instance_count, BENCHMARK_UPDATE_BONE_COUNT, BENCHMARK_UPDATE_FRAME_COUNT);
+
+    // The serial reference every threaded run has to reproduce exactly
+    benchmark_reset_instances(instances, instance_count, context->animation->duration);
+    double start_time = benchmark_get_seconds();
+
+    for (int frame_index = 0; frame_index < BENCHMARK_UPDATE_FRAME_COUNT; frame_index++)
+        benchmark_update_batch(context, 0, instance_count);
+
+    double serial_seconds = (benchmark_get_seconds() - start_time) / (double)BENCHMARK_UPDATE_FRAME_COUNT;
+    unsigned int serial_hash = benchmark_hash_instances(instances, instance_count);
+
+    printf("    serial:     %10.3f ms/frame\n", serial_seconds * 1000.0);
+
+    for (int worker_count = 0; worker_count <= maximum_worker_count; worker_count++)
+    {
+        jobs_initialize(worker_count);
+        benchmark_reset_instances(instances, instance_count, context->animation->duration);
+
+        start_time = benchmark_get_seconds();
+
+        for (int frame_index = 0; frame_index < BENCHMARK_UPDATE_FRAME_COUNT; frame_index++)
+            jobs_parallel_for(instance_count, BENCHMARK_UPDATE_BATCH_SIZE, benchmark_update_batch, context);
+
+        double seconds = (benchmark_get_seconds() - start_time) / (double)BENCHMARK_UPDATE_FRAME_COUNT;
+
+        jobs_dispose();
+
+        bool matches = benchmark_hash_instances(instances, instance_count) == serial_hash;
+
+        printf("    %2i threads: %10.3f ms/frame %6.2fx  %s\n",
+            worker_count + 1,
+            seconds * 1000.0,
+            serial_seconds / seconds,
+            matches ? "matches serial" : "DIFFERS FROM SERIAL");
+    }
+
+    // Instances in the same time bucket share one evaluated pose
+    benchmark_reset_instances(instances, instance_count, context->animation->duration);
+
+    int evaluation_count;
+    double pose_cache_seconds = benchmark_run_pose_cache(context, instance_count, &evaluation_count);
+
+    printf("    pose cache: %10.3f ms/frame %6.2fx  %i poses evaluated per frame\n",
+        pose_cache_seconds * 1000.0,
+        serial_seconds / pose_cache_seconds,
+        evaluation_count);
+
+    for (int instance_index = 0; instance_index < instance_count; instance_index++)
+    {
+        struct benchmark_instance *instance = instances + instance_index;
+
+        animation_pose_buffer_dispose(&instance->pose);
+        animation_pose_buffer_dispose(&instance->blended_pose);
+        free(instance->cursors);
+        free(instance->node_transforms);
+    }
+
+    free(instances);
+}
+
+/* ---------- public code */
+
+int benchmark_animation_update_execute(
+    int argc,
+    const char **argv)
+{
+    int instance_count = argc > 0 ? atoi(argv[0]) : 0;
+    assert(argc == 0 || instance_count > 0);
+
+    srand(1);
+
+    struct animation_data animation;
+    memset(&animation, 0, sizeof(animation));
+
+    animation.duration = (float)(BENCHMARK_UPDATE_KEY_COUNT - 1);
+    animation.ticks_per_second = 30.0f;
+    animation.channel_count = BENCHMARK_UPDATE_BONE_COUNT;
+    animation.channels = calloc(BENCHMARK_UPDATE_BONE_COUNT, sizeof(*animation.channels));
+    animation.node_channel_indices = malloc(BENCHMARK_UPDATE_BONE_COUNT * sizeof(*animation.node_channel_indices));
+
+    struct animation_raw_channel *raw_channels = calloc(BENCHMARK_UPDATE_BONE_COUNT, sizeof(*raw_channels));
+    int *node_parent_indices = malloc(BENCHMARK_UPDATE_BONE_COUNT * sizeof(*node_parent_indices));
+    assert(animation.channels && animation.node_channel_indices && raw_channels && node_parent_indices);
+
+    // Only rotations are keyed
+    struct benchmark_clip_description clip =
+    {
+        .key_count = BENCHMARK_UPDATE_KEY_COUNT,
+        .duration = (float)(BENCHMARK_UPDATE_KEY_COUNT - 1),
+    };
+
+    for (int bone_index = 0; bone_index < BENCHMARK_UPDATE_BONE_COUNT; bone_index++)
+    {
+        animation.channels[bone_index].type = _animation_channel_type_node;
+        animation.channels[bone_index].node_index = bone_index;
+        animation.node_channel_indices[bone_index] = bone_index;
+
+        // A spine with a short limb branching off every fourth bone
+        node_parent_indices[bone_index] = bone_index == 0 ? -1 : (bone_index % 4 ? bone_index - 1 : bone_index - 4);
+
+        benchmark_build_raw_channel(raw_channels + bone_index, &clip, bone_index);
+    }
+
+    animation_compress(&animation, raw_channels, NULL, NULL);
+
+    struct animation_pose_buffer default_pose;
+    animation_pose_buffer_initialize(&default_pose, BENCHMARK_UPDATE_BONE_COUNT, NULL);
+
+    struct benchmark_update_context context =
+    {
+        .animation = &animation,
+        .default_pose = &default_pose,
+        .node_parent_indices = node_parent_indices,
+        .delta_ticks = 1.0f / 60.0f,
+    };
+
+    int maximum_worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    if (maximum_worker_count < 0)
+        maximum_worker_count = 0;
+
+    if (instance_count)
+    {
+        benchmark_run_instance_count(&context, instance_count, maximum_worker_count);
+    }
+    else
+    {
+        benchmark_run_instance_count(&context, 1000, maximum_worker_count);
+        benchmark_run_instance_count(&context, 10000, maximum_worker_count);
+    }
+
+    for (int bone_index = 0; bone_index < BENCHMARK_UPDATE_BONE_COUNT; bone_index++)
+    {
+        struct animation_channel *channel = animation.channels + bone_index;
+
+        animation_raw_channel_dispose(raw_channels + bone_index);
+
+        free(channel->position_key_times);
+        free(channel->position_key_values);
+        free(channel->rotation_key_times);
+        free(channel->rotation_key_values);
+        free(channel->scaling_key_times);
+        free(channel->scaling_key_values);
+    }
+
+    animation_pose_buffer_dispose(&default_pose);
+
+    free(animation.channels);
+    free(animation.node_channel_indices);
+    free(raw_channels);
+    free(node_parent_indices);
+
+    return 0;
+}
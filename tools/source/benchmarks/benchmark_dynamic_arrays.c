@@ -0,0 +1,160 @@
+/*
+BENCHMARK_DYNAMIC_ARRAYS.C
+    Dynamic array push throughput benchmark.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "memory/dynamic_arrays.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_VERTEX_COUNT = 1000000,
+};
+
+/* ---------- private types */
+
+// Same layout as the game's skinned vertex
+struct benchmark_vertex
+{
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+    float tangent[3];
+    float bitangent[3];
+    int node_indices[4];
+    float node_weights[4];
+};
+
+/* ---------- private code */
+
+static inline void benchmark_vertex_make(
+    int vertex_index,
+    struct benchmark_vertex *out_vertex)
+{
+    memset(out_vertex, 0, sizeof(*out_vertex));
+    out_vertex->position[0] = (float)vertex_index;
+    out_vertex->node_indices[0] = vertex_index & 0xFF;
+    out_vertex->node_weights[0] = 1.0f;
+}
+
+static void benchmark_print_result(
+    const char *name,
+    int vertex_count,
+    int index_count,
+    double seconds)
+{
+    printf("%-28s %10.3f ms %12.2f M pushes/s\n",
+        name,
+        seconds * 1000.0,
+        ((double)(vertex_count + index_count) / seconds) / 1000000.0);
+}
+
+/* ---------- public code */
+
+int benchmark_dynamic_arrays_execute(
+    int argc,
+    const char **argv)
+{
+    int vertex_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_VERTEX_COUNT;
+    assert(vertex_count > 0);
+
+    int index_count = vertex_count * 3;
+
+    printf("pushing %i vertices (%zu bytes each) and %i indices\n", vertex_count, sizeof(struct benchmark_vertex), index_count);
+
+    // mempush: one realloc per element
+    {
+        int out_vertex_count = 0;
+        struct benchmark_vertex *vertices = NULL;
+        int out_index_count = 0;
+        int *indices = NULL;
+
+        double start_time = benchmark_get_seconds();
+
+        for (int vertex_index = 0; vertex_index < vertex_count; vertex_index++)
+        {
+            struct benchmark_vertex vertex;
+            benchmark_vertex_make(vertex_index, &vertex);
+            mempush(&out_vertex_count, (void **)&vertices, &vertex, sizeof(vertex), realloc);
+        }
+
+        for (int index = 0; index < index_count; index++)
+        {
+            int vertex_index = index % vertex_count;
+            mempush(&out_index_count, (void **)&indices, &vertex_index, sizeof(vertex_index), realloc);
+        }
+
+        benchmark_print_result("mempush", vertex_count, index_count, benchmark_get_seconds() - start_time);
+
+        free(vertices);
+        free(indices);
+    }
+
+    // dynamic array: geometric growth
+    {
+        DYNAMIC_ARRAY(struct benchmark_vertex) vertices = { 0 };
+        DYNAMIC_ARRAY(int) indices = { 0 };
+
+        double start_time = benchmark_get_seconds();
+
+        for (int vertex_index = 0; vertex_index < vertex_count; vertex_index++)
+        {
+            struct benchmark_vertex vertex;
+            benchmark_vertex_make(vertex_index, &vertex);
+            dynamic_array_push(&vertices, &vertex);
+        }
+
+        for (int index = 0; index < index_count; index++)
+        {
+            int vertex_index = index % vertex_count;
+            dynamic_array_push(&indices, &vertex_index);
+        }
+
+        dynamic_array_shrink_to_fit(&vertices);
+        dynamic_array_shrink_to_fit(&indices);
+
+        benchmark_print_result("dynamic_array_push", vertex_count, index_count, benchmark_get_seconds() - start_time);
+
+        dynamic_array_dispose(&vertices);
+        dynamic_array_dispose(&indices);
+    }
+
+    // dynamic array: reserved up front, as the model importer does
+    {
+        DYNAMIC_ARRAY(struct benchmark_vertex) vertices = { 0 };
+        DYNAMIC_ARRAY(int) indices = { 0 };
+
+        double start_time = benchmark_get_seconds();
+
+        dynamic_array_reserve(&vertices, vertex_count);
+        dynamic_array_reserve(&indices, index_count);
+
+        for (int vertex_index = 0; vertex_index < vertex_count; vertex_index++)
+        {
+            struct benchmark_vertex vertex;
+            benchmark_vertex_make(vertex_index, &vertex);
+            dynamic_array_push(&vertices, &vertex);
+        }
+
+        for (int index = 0; index < index_count; index++)
+        {
+            int vertex_index = index % vertex_count;
+            dynamic_array_push(&indices, &vertex_index);
+        }
+
+        benchmark_print_result("dynamic_array_push reserved", vertex_count, index_count, benchmark_get_seconds() - start_time);
+
+        dynamic_array_dispose(&vertices);
+        dynamic_array_dispose(&indices);
+    }
+
+    return 0;
+}
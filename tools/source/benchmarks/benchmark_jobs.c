@@ -0,0 +1,321 @@
+/*
+BENCHMARK_JOBS.C
+    Job system throughput benchmark and stress test.
+*/
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/common.h"
+#include "jobs/jobs.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+enum
+{
+    DEFAULT_BENCHMARK_JOB_COUNT = 1000000,
+    DEFAULT_STRESS_ITERATION_COUNT = 200,
+
+    BENCHMARK_JOB_BATCH_SIZE = 1024,
+    BENCHMARK_JOB_WORK_ITERATIONS = 256,
+
+    STRESS_FAN_OUT_COUNT = 64,
+    STRESS_CHAIN_LENGTH = 32,
+    STRESS_RANGE_COUNT = 100000,
+};
+
+/* ---------- private types */
+
+struct stress_fan_out_data
+{
+    atomic_int *total;
+    int depth;
+};
+
+struct stress_chain_data
+{
+    int *values;
+    int index;
+};
+
+/* ---------- private variables */
+
+static atomic_uint benchmark_job_sink;
+
+/* ---------- private code */
+
+static void benchmark_job_work(
+    void *data)
+{
+    // A small, fixed amount of arithmetic so the benchmark measures scheduling overhead rather than nothing at all
+    unsigned int value = (unsigned int)(size_t)data;
+
+    for (int i = 0; i < BENCHMARK_JOB_WORK_ITERATIONS; i++)
+        value = value * 1664525u + 1013904223u;
+
+    atomic_fetch_add_explicit(&benchmark_job_sink, value & 1, memory_order_relaxed);
+}
+
+static void benchmark_job_range_work(
+    void *data,
+    int start_index,
+    int end_index)
+{
+    (void)data;
+
+    for (int index = start_index; index < end_index; index++)
+        benchmark_job_work((void *)(size_t)index);
+}
+
+static double benchmark_jobs_run(
+    int job_count)
+{
+    struct job_declaration declarations[BENCHMARK_JOB_BATCH_SIZE];
+
+    for (int i = 0; i < BENCHMARK_JOB_BATCH_SIZE; i++)
+        declarations[i] = (struct job_declaration){ benchmark_job_work, (void *)(size_t)i };
+
+    struct job_counter counter;
+    job_counter_initialize(&counter);
+
+    double start_time = benchmark_get_seconds();
+
+    for (int submitted_count = 0; submitted_count < job_count; submitted_count += BENCHMARK_JOB_BATCH_SIZE)
+    {
+        int batch_count = job_count - submitted_count;
+
+        if (batch_count > BENCHMARK_JOB_BATCH_SIZE)
+            batch_count = BENCHMARK_JOB_BATCH_SIZE;
+
+        jobs_run(declarations, batch_count, &counter);
+
+        // Keep the main thread's queue from overflowing by helping out between batches
+        if (submitted_count % (JOB_QUEUE_CAPACITY / 2) == 0)
+            jobs_wait(&counter);
+    }
+
+    jobs_wait(&counter);
+
+    return benchmark_get_seconds() - start_time;
+}
+
+static void stress_fan_out_job(
+    void *data)
+{
+    struct stress_fan_out_data *fan_out = data;
+
+    atomic_fetch_add(fan_out->total, 1);
+
+    if (fan_out->depth == 0)
+        return;
+
+    // Jobs spawning and waiting on jobs from worker threads
+    struct stress_fan_out_data child_data = { fan_out->total, fan_out->depth - 1 };
+    struct stress_fan_out_data *children = malloc(sizeof(*children) * 2);
+    assert(children);
+
+    children[0] = child_data;
+    children[1] = child_data;
+
+    struct job_counter child_counter;
+    job_counter_initialize(&child_counter);
+
+    struct job_declaration declarations[2] =
+    {
+        { stress_fan_out_job, children + 0 },
+        { stress_fan_out_job, children + 1 },
+    };
+
+    jobs_run(declarations, 2, &child_counter);
+    jobs_wait(&child_counter);
+
+    free(children);
+}
+
+static void stress_chain_job(
+    void *data)
+{
+    struct stress_chain_data *chain = data;
+
+    // Each link may only run once the previous one has written its value
+    chain->values[chain->index] = chain->index == 0 ? 1 : chain->values[chain->index - 1] + 1;
+}
+
+static void stress_range_job(
+    void *data,
+    int start_index,
+    int end_index)
+{
+    int *values = data;
+
+    for (int index = start_index; index < end_index; index++)
+        values[index] += index;
+}
+
+static void stress_main_thread_job(
+    void *data)
+{
+    atomic_int *count = data;
+
+    assert(jobs_get_thread_index() == 0);
+    atomic_fetch_add(count, 1);
+}
+
+static void stress_main_thread_producer_job(
+    void *data)
+{
+    struct job_declaration declaration = { stress_main_thread_job, data };
+    jobs_run_on_main_thread(&declaration, 1, NULL);
+}
+
+static void stress_jobs_iteration(void)
+{
+    // Nested fan-out: 2^(depth + 1) - 1 jobs per root
+    {
+        atomic_int total = 0;
+        int depth = 6;
+
+        struct job_counter counter;
+        job_counter_initialize(&counter);
+
+        struct stress_fan_out_data roots[STRESS_FAN_OUT_COUNT];
+        struct job_declaration declarations[STRESS_FAN_OUT_COUNT];
+
+        for (int i = 0; i < STRESS_FAN_OUT_COUNT; i++)
+        {
+            roots[i] = (struct stress_fan_out_data){ &total, depth };
+            declarations[i] = (struct job_declaration){ stress_fan_out_job, roots + i };
+        }
+
+        jobs_run(declarations, STRESS_FAN_OUT_COUNT, &counter);
+        jobs_wait(&counter);
+
+        assert(atomic_load(&total) == STRESS_FAN_OUT_COUNT * ((1 << (depth + 1)) - 1));
+    }
+
+    // Dependency chain: each link waits on the previous link's counter
+    {
+        int values[STRESS_CHAIN_LENGTH];
+        memset(values, 0, sizeof(values));
+
+        struct stress_chain_data links[STRESS_CHAIN_LENGTH];
+        struct job_counter counters[STRESS_CHAIN_LENGTH];
+
+        for (int i = 0; i < STRESS_CHAIN_LENGTH; i++)
+        {
+            links[i] = (struct stress_chain_data){ values, i };
+            job_counter_initialize(counters + i);
+        }
+
+        struct job_declaration declaration = { stress_chain_job, links + 0 };
+        jobs_run(&declaration, 1, counters + 0);
+
+        for (int i = 1; i < STRESS_CHAIN_LENGTH; i++)
+        {
+            declaration = (struct job_declaration){ stress_chain_job, links + i };
+            jobs_run_after(counters + i - 1, &declaration, 1, counters + i);
+        }
+
+        jobs_wait(counters + STRESS_CHAIN_LENGTH - 1);
+
+        for (int i = 0; i < STRESS_CHAIN_LENGTH; i++)
+            assert(values[i] == i + 1);
+    }
+
+    // Parallel-for over a range with uneven batches
+    {
+        int *values = calloc(STRESS_RANGE_COUNT, sizeof(*values));
+        assert(values);
+
+        jobs_parallel_for(STRESS_RANGE_COUNT, 333, stress_range_job, values);
+
+        for (int index = 0; index < STRESS_RANGE_COUNT; index++)
+            assert(values[index] == index);
+
+        free(values);
+    }
+
+    // Worker jobs that hand work back to the main thread
+    {
+        atomic_int count = 0;
+
+        struct job_counter counter;
+        job_counter_initialize(&counter);
+
+        struct job_declaration declarations[STRESS_FAN_OUT_COUNT];
+
+        for (int i = 0; i < STRESS_FAN_OUT_COUNT; i++)
+            declarations[i] = (struct job_declaration){ stress_main_thread_producer_job, &count };
+
+        jobs_run(declarations, STRESS_FAN_OUT_COUNT, &counter);
+        jobs_wait(&counter);
+
+        while (atomic_load(&count) != STRESS_FAN_OUT_COUNT)
+            jobs_execute_main_thread_jobs();
+    }
+}
+
+/* ---------- public code */
+
+int benchmark_jobs_execute(
+    int argc,
+    const char **argv)
+{
+    int job_count = argc > 0 ? atoi(argv[0]) : DEFAULT_BENCHMARK_JOB_COUNT;
+    assert(job_count > 0);
+
+    int maximum_worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    if (maximum_worker_count < 0)
+        maximum_worker_count = 0;
+
+    printf("running %i jobs of %i iterations each\n", job_count, BENCHMARK_JOB_WORK_ITERATIONS);
+
+    for (int worker_count = 0; worker_count <= maximum_worker_count; worker_count++)
+    {
+        jobs_initialize(worker_count);
+
+        double run_seconds = benchmark_jobs_run(job_count);
+
+        double start_time = benchmark_get_seconds();
+        jobs_parallel_for(job_count, 256, benchmark_job_range_work, NULL);
+        double parallel_for_seconds = benchmark_get_seconds() - start_time;
+
+        jobs_dispose();
+
+        printf("%2i threads: jobs_run %10.3f M jobs/s   jobs_parallel_for %10.3f M indices/s\n",
+            worker_count + 1,
+            ((double)job_count / run_seconds) / 1000000.0,
+            ((double)job_count / parallel_for_seconds) / 1000000.0);
+    }
+
+    return 0;
+}
+
+int stress_jobs_execute(
+    int argc,
+    const char **argv)
+{
+    int iteration_count = argc > 0 ? atoi(argv[0]) : DEFAULT_STRESS_ITERATION_COUNT;
+    assert(iteration_count > 0);
+
+    jobs_initialize(-1);
+
+    printf("stressing the job system with %i workers for %i iterations\n", jobs_get_worker_count(), iteration_count);
+
+    double start_time = benchmark_get_seconds();
+
+    for (int iteration_index = 0; iteration_index < iteration_count; iteration_index++)
+        stress_jobs_iteration();
+
+    jobs_dispose();
+
+    printf("passed in %.3f ms\n", (benchmark_get_seconds() - start_time) * 1000.0);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+BENCHMARKS.C
+    Tool benchmark command code.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "animations/animation_compression.h"
+#include "benchmarks/benchmarks.h"
+
+/* ---------- private constants */
+
+#define BENCHMARK_PI 3.14159265f
+
+/* ---------- public code */
+
+double benchmark_get_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1000000000.0);
+}
+
+float benchmark_random(void)
+{
+    return (float)rand() / (float)RAND_MAX;
+}
+
+void benchmark_build_raw_channel(
+    struct animation_raw_channel *raw_channel,
+    const struct benchmark_clip_description *clip,
+    int bone_index)
+{
+    assert(raw_channel);
+    assert(clip && clip->key_count > 1 && clip->duration > 0.0f);
+
+    int position_key_count = clip->animate_positions ? clip->key_count : 1;
+    int scaling_key_count = clip->animate_scaling ? clip->key_count : 1;
+
+    animation_raw_channel_initialize(raw_channel, position_key_count, clip->key_count, scaling_key_count);
+
+    float axis[3] = { benchmark_random() - 0.5f, benchmark_random() - 0.5f, benchmark_random() - 0.5f };
+    float axis_length = sqrtf((axis[0] * axis[0]) + (axis[1] * axis[1]) + (axis[2] * axis[2]));
+    float amplitude = benchmark_random() * 0.8f;
+    float phase = benchmark_random() * 2.0f * BENCHMARK_PI;
+    float bone_length = 0.1f + (benchmark_random() * 0.3f);
+
+    float time_step = clip->duration / (float)(clip->key_count - 1);
+
+    for (int key_index = 0; key_index < clip->key_count; key_index++)
+    {
+        float time = (float)key_index * time_step;
+
+        // Keep the first and last keys on the clip's ends
+        if (clip->jitter_key_times && key_index > 0 && key_index < clip->key_count - 1)
+            time += (benchmark_random() - 0.5f) * time_step * 0.5f;
+
+        float cycle = (2.0f * BENCHMARK_PI * time) / clip->duration;
+
+        float half_angle = 0.5f * amplitude * sinf(cycle + phase);
+        float sin_half_angle = sinf(half_angle) / axis_length;
+
+        raw_channel->rotation_key_times[key_index] = time;
+        raw_channel->rotation_key_values[key_index][0] = axis[0] * sin_half_angle;
+        raw_channel->rotation_key_values[key_index][1] = axis[1] * sin_half_angle;
+        raw_channel->rotation_key_values[key_index][2] = axis[2] * sin_half_angle;
+        raw_channel->rotation_key_values[key_index][3] = cosf(half_angle);
+
+        if (key_index < position_key_count)
+        {
+            // Only the root moves; every other bone keeps its length, as in most skeletal clips
+            bool moves = clip->animate_positions && bone_index == 0;
+
+            raw_channel->position_key_times[key_index] = time;
+            raw_channel->position_key_values[key_index][0] = 0.0f;
+            raw_channel->position_key_values[key_index][1] = moves ? 1.0f + (0.05f * sinf(2.0f * cycle)) : bone_length;
+            raw_channel->position_key_values[key_index][2] = moves ? clip->root_speed * time : 0.0f;
+        }
+
+        if (key_index < scaling_key_count)
+        {
+            raw_channel->scaling_key_times[key_index] = time;
+            raw_channel->scaling_key_values[key_index][0] = 1.0f;
+            raw_channel->scaling_key_values[key_index][1] = 1.0f;
+            raw_channel->scaling_key_values[key_index][2] = 1.0f;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+BENCHMARKS.H
+    Tool benchmark command declarations.
+*/
+
+#pragma once
+#include <stdbool.h>
+
+/* ---------- types */
+
+struct animation_raw_channel;
+
+/**
+ * The shape of the synthetic clips animation benchmarks build: every bone swings about a random axis
+ * through one sine cycle over the clip.
+ */
+struct benchmark_clip_description
+{
+    int key_count;
+
+    // Keys are spread evenly from zero to the duration, in ticks
+    float duration;
+
+    // Whether inner key times are moved by up to a quarter of a key apart, as sampled source data would be
+    bool jitter_key_times;
+
+    // Whether positions and scales get a key per rotation key; otherwise each gets one constant key
+    bool animate_positions;
+    bool animate_scaling;
+
+    // How far the root travels along z per tick when positions are animated
+    float root_speed;
+};
+
+/* ---------- prototypes/BENCHMARKS.C */
+
+double benchmark_get_seconds(void);
+
+/**
+ * Gets a pseudo-random number between zero and one from rand, so benchmarks seeded with srand repeat exactly.
+ */
+float benchmark_random(void);
+
+/**
+ * Builds one bone's channel of a synthetic clip.
+ * @param raw_channel The channel to initialize and fill in.
+ * @param clip The shape of the clip.
+ * @param bone_index The bone the channel drives. The root bobs up and down when positions are animated.
+ */
+void benchmark_build_raw_channel(struct animation_raw_channel *raw_channel, const struct benchmark_clip_description *clip, int bone_index);
+
+/* ---------- prototypes/BENCHMARK_DYNAMIC_ARRAYS.C */
+
+int benchmark_dynamic_arrays_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_JOBS.C */
+
+int benchmark_jobs_execute(int argc, const char **argv);
+int stress_jobs_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_KEYS.C */
+
+int benchmark_animation_keys_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_POSES.C */
+
+int benchmark_animation_poses_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_BLENDING.C */
+
+int benchmark_animation_blending_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_COMPRESSION.C */
+
+int benchmark_animation_compression_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_BAKING.C */
+
+int benchmark_animation_baking_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_UPDATE.C */
+
+int benchmark_animation_update_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_ANIMATION_MORPHS.C */
+
+int benchmark_animation_morphs_execute(int argc, const char **argv);
+
+/* ---------- prototypes/BENCHMARK_AABB_TREES.C */
+
+int benchmark_aabb_trees_execute(int argc, const char **argv);
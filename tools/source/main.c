@@ -10,12 +10,68 @@
 
 #include "common/common.h"
 #include "commands/commands.h"
+#include "benchmarks/benchmarks.h"
 
 const struct command_parameter_definition compile_model_parameters[] =
 {
     { "path", _command_parameter_string, 0 },
 };
 
+const struct command_parameter_definition benchmark_dynamic_arrays_parameters[] =
+{
+    { "vertex count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_jobs_parameters[] =
+{
+    { "job count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition stress_jobs_parameters[] =
+{
+    { "iteration count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_keys_parameters[] =
+{
+    { "key count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_poses_parameters[] =
+{
+    { "node count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_blending_parameters[] =
+{
+    { "node count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_compression_parameters[] =
+{
+    { "bone count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_baking_parameters[] =
+{
+    { "instance count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_update_parameters[] =
+{
+    { "instance count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_animation_morphs_parameters[] =
+{
+    { "face count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
+const struct command_parameter_definition benchmark_aabb_trees_parameters[] =
+{
+    { "static object count", _command_parameter_int, BIT(_command_parameter_optional_bit) },
+};
+
 static int compile_model_execute(int argc, const char **argv);
 
 static const struct command_definition command_definitions[] =
@@ -26,7 +82,84 @@ static const struct command_definition command_definitions[] =
         NUMBER_OF(compile_model_parameters),
         compile_model_parameters,
         compile_model_execute,
-    }
+    },
+    {
+        "benchmark dynamic arrays",
+        "Compares mempush against dynamic array push throughput on a million-vertex mesh.",
+        NUMBER_OF(benchmark_dynamic_arrays_parameters),
+        benchmark_dynamic_arrays_parameters,
+        benchmark_dynamic_arrays_execute,
+    },
+    {
+        "benchmark jobs",
+        "Measures job system throughput in jobs per second with 1 to N threads.",
+        NUMBER_OF(benchmark_jobs_parameters),
+        benchmark_jobs_parameters,
+        benchmark_jobs_execute,
+    },
+    {
+        "stress jobs",
+        "Stress tests nested jobs, dependencies, parallel-for and main thread jobs on every worker.",
+        NUMBER_OF(stress_jobs_parameters),
+        stress_jobs_parameters,
+        stress_jobs_execute,
+    },
+    {
+        "benchmark animation keys",
+        "Compares linear, binary search and cursor keyframe sampling on long clips.",
+        NUMBER_OF(benchmark_animation_keys_parameters),
+        benchmark_animation_keys_parameters,
+        benchmark_animation_keys_execute,
+    },
+    {
+        "benchmark animation poses",
+        "Compares per-skeleton pose evaluation through matrix round trips against staying in TRS form.",
+        NUMBER_OF(benchmark_animation_poses_parameters),
+        benchmark_animation_poses_parameters,
+        benchmark_animation_poses_execute,
+    },
+    {
+        "benchmark animation blending",
+        "Compares the per-node clip blend against layered structure-of-arrays pose blending.",
+        NUMBER_OF(benchmark_animation_blending_parameters),
+        benchmark_animation_blending_parameters,
+        benchmark_animation_blending_execute,
+    },
+    {
+        "benchmark animation compression",
+        "Reports clip compression ratio and error, and compares raw against compressed keyframe sampling.",
+        NUMBER_OF(benchmark_animation_compression_parameters),
+        benchmark_animation_compression_parameters,
+        benchmark_animation_compression_execute,
+    },
+    {
+        "benchmark animation baking",
+        "Compares the memory and sampling cost of keyed and baked clips played by many instances.",
+        NUMBER_OF(benchmark_animation_baking_parameters),
+        benchmark_animation_baking_parameters,
+        benchmark_animation_baking_execute,
+    },
+    {
+        "benchmark animation update",
+        "Measures how the per-object animation update scales across threads and with a shared pose cache.",
+        NUMBER_OF(benchmark_animation_update_parameters),
+        benchmark_animation_update_parameters,
+        benchmark_animation_update_execute,
+    },
+    {
+        "benchmark animation morphs",
+        "Compares dense and sparse morph target evaluation, and the vertex bytes uploaded, across many morphing faces.",
+        NUMBER_OF(benchmark_animation_morphs_parameters),
+        benchmark_animation_morphs_parameters,
+        benchmark_animation_morphs_execute,
+    },
+    {
+        "benchmark aabb trees",
+        "Measures AABB tree build, batched update and query costs with static and moving objects, against brute force.",
+        NUMBER_OF(benchmark_aabb_trees_parameters),
+        benchmark_aabb_trees_parameters,
+        benchmark_aabb_trees_execute,
+    },
 };
 
 enum